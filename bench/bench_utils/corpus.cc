@@ -0,0 +1,21 @@
+#include "bench_utils/corpus.h"
+
+#include "generator/generator.h"
+
+namespace bench {
+
+std::string make_corpus(std::size_t size) {
+  generator::Options options;
+  options.size = size;
+  return generator::generate(options);
+}
+
+std::string make_arithmetic_corpus(std::size_t size) {
+  generator::Options options;
+  options.size = size;
+  options.max_nesting_depth = 1;
+  options.max_expression_depth = 8;
+  return generator::generate(options);
+}
+
+}  // namespace bench
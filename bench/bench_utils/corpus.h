@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace bench {
+
+/// Return a program of roughly `size` bytes from generator::Generator, with
+/// the features that go through the whole pipeline without errors. The
+/// program is always the same for a given size.
+std::string make_corpus(std::size_t size);
+
+/// Like make_corpus, but most of the program is made of large arithmetic
+/// expressions.
+std::string make_arithmetic_corpus(std::size_t size);
+
+}  // namespace bench
@@ -0,0 +1,145 @@
+#include "bench_utils/pipeline.h"
+
+#include "ast/ast.h"
+#include "lexer/lexer.h"
+#include "name_resolution/visitor.h"
+#include "parser/parser.h"
+#include "transform/add_return.h"
+#include "transform/constant_folder.h"
+#include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
+#include "util/logging.h"
+#include "util/time_report.h"
+#include "visitor/visitor.h"
+
+namespace bench {
+
+namespace {
+
+template <typename Visitor>
+void run_pass(ast::Module* module) {
+  Visitor visitor;
+  module->accept(visitor);
+  const auto& errors = visitor.error_list().errors();
+  CHECK(errors.empty()) << errors.front().to_string();
+}
+
+/// Counts every node it visits.
+class NodeCounter : public ast::ASTVisitor {
+ public:
+  std::size_t count() const { return count_; }
+
+  void visit(ast::Assignment* node) override { count_and_visit(node); }
+  void visit(ast::BinaryOp* node) override { count_and_visit(node); }
+  void visit(ast::BlockStatement* node) override { count_and_visit(node); }
+  void visit(ast::BooleanConstant* node) override { count_and_visit(node); }
+  void visit(ast::BuiltinType* node) override { count_and_visit(node); }
+  void visit(ast::FunctionArgumentDeclaration* node) override {
+    count_and_visit(node);
+  }
+  void visit(ast::FunctionCall* node) override { count_and_visit(node); }
+  void visit(ast::FunctionDeclaration* node) override {
+    count_and_visit(node);
+  }
+  void visit(ast::IfStatement* node) override { count_and_visit(node); }
+  void visit(ast::IntConstant* node) override { count_and_visit(node); }
+  void visit(ast::LocalVariableDeclaration* node) override {
+    count_and_visit(node);
+  }
+  void visit(ast::Module* node) override { count_and_visit(node); }
+  void visit(ast::ReturnStatement* node) override { count_and_visit(node); }
+  void visit(ast::ValueStatement* node) override { count_and_visit(node); }
+  void visit(ast::VariableReference* node) override { count_and_visit(node); }
+
+ private:
+  template <typename Node>
+  void count_and_visit(Node* node) {
+    ++count_;
+    ASTVisitor::visit(node);
+  }
+
+  std::size_t count_ = 0;
+};
+
+}  // namespace
+
+void corpus_sizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("bytes")->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+}
+
+std::size_t lex(const std::string& source) {
+  auto lexer = lexer::from_string(source);
+  std::size_t tokens = 0;
+  while (true) {
+    auto token = lexer.get_next_token();
+    CHECK(token.is_ok()) << token.error_or_die().to_string();
+    ++tokens;
+    if (token.value_or_die().type() == lexer::TokenType::END_OF_FILE)
+      return tokens;
+  }
+}
+
+std::unique_ptr<ast::Module> parse(const std::string& source) {
+  auto lexer = lexer::from_string(source);
+  parser::Parser parser(&lexer);
+  auto result = parser.parse();
+  CHECK(result.is_ok()) << result.to_string();
+  return result.consume_value_or_die();
+}
+
+void resolve(ast::Module* module) {
+  transform::FunctionValueBodyTransformer transformer;
+  module->accept(transformer);
+  run_pass<name_resolution::NameResolver>(module);
+}
+
+void typecheck(ast::Module* module) {
+  run_pass<typechecker::TypeChecker>(module);
+  run_pass<transform::VoidFunctionReturnAdder>(module);
+}
+
+void fold_constants(ast::Module* module) {
+  run_pass<transform::ConstantFolder>(module);
+}
+
+std::unique_ptr<ast::Module> analyze(const std::string& source) {
+  auto module = parse(source);
+  resolve(module.get());
+  typecheck(module.get());
+  fold_constants(module.get());
+  return module;
+}
+
+std::size_t count_nodes(ast::Module* module) {
+  NodeCounter counter;
+  module->accept(counter);
+  return counter.count();
+}
+
+ThroughputCounters::ThroughputCounters(std::size_t bytes, std::size_t nodes)
+    : bytes_(bytes),
+      nodes_(nodes),
+      last_allocation_count_(util::allocation_count()) {}
+
+void ThroughputCounters::pause(benchmark::State* state) {
+  state->PauseTiming();
+  allocations_ += util::allocation_count() - last_allocation_count_;
+}
+
+void ThroughputCounters::resume(benchmark::State* state) {
+  last_allocation_count_ = util::allocation_count();
+  state->ResumeTiming();
+}
+
+void ThroughputCounters::report(benchmark::State* state) const {
+  const auto iterations = static_cast<double>(state->iterations());
+  const double allocations =
+      allocations_ + (util::allocation_count() - last_allocation_count_);
+  state->SetBytesProcessed(state->iterations() * bytes_);
+  state->counters["nodes"] = nodes_;
+  state->counters["nodes/s"] = benchmark::Counter(
+      iterations * nodes_, benchmark::Counter::kIsRate);
+  state->counters["allocs/node"] = allocations / (iterations * nodes_);
+}
+
+}  // namespace bench
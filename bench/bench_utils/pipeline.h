@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "ast/module.h"
+
+namespace bench {
+
+/// Run the benchmark on a small, a medium and a huge corpus (see
+/// make_corpus), with the size in bytes as argument.
+void corpus_sizes(benchmark::internal::Benchmark* benchmark);
+
+/// Each stage of the pipeline expects the module to have gone through the
+/// previous ones. They abort the benchmark on errors.
+
+/// Lex the whole source, and return the number of tokens.
+std::size_t lex(const std::string& source);
+
+/// Parse the source into a module.
+std::unique_ptr<ast::Module> parse(const std::string& source);
+
+/// Transform the value bodies of functions and resolve the names.
+void resolve(ast::Module* module);
+
+/// Check the types, and add the missing returns.
+void typecheck(ast::Module* module);
+
+/// Fold the constant expressions and branches.
+void fold_constants(ast::Module* module);
+
+/// Parse, resolve, typecheck the source and fold its constants: the module is
+/// ready for code generation.
+std::unique_ptr<ast::Module> analyze(const std::string& source);
+
+/// Number of AST nodes in the module.
+std::size_t count_nodes(ast::Module* module);
+
+/// Measures the throughput and the allocations of a benchmark.
+///
+/// Example:
+/// ThroughputCounters counters(source.size(), count_nodes(module));
+/// while (state.KeepRunning()) {
+///   counters.pause(&state);
+///   auto input = prepare();
+///   counters.resume(&state);
+///   run(input);
+/// }
+/// counters.report(&state);
+class ThroughputCounters {
+ public:
+  ThroughputCounters(std::size_t bytes, std::size_t nodes);
+
+  /// Pause the timing of the benchmark, to prepare its input: the
+  /// allocations until resume() are not counted.
+  void pause(benchmark::State* state);
+  void resume(benchmark::State* state);
+
+  /// Set the bytes/s, nodes/s and allocations per node of the benchmark, for
+  /// all the iterations since the construction.
+  void report(benchmark::State* state) const;
+
+ private:
+  std::size_t bytes_;
+  std::size_t nodes_;
+  // Allocations done while not paused.
+  std::uint64_t allocations_ = 0;
+  std::uint64_t last_allocation_count_;
+};
+
+}  // namespace bench
@@ -0,0 +1,14 @@
+#include <gflags/gflags.h>
+
+#include "benchmark/benchmark.h"
+
+#include "codegen/codegen.h"
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  codegen::LLVMInitializer llvm_initializer;
+  ::benchmark::RunSpecifiedBenchmarks();
+  gflags::ShutDownCommandLineFlags();
+  return 0;
+}
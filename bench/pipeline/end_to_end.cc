@@ -0,0 +1,38 @@
+#include <sstream>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "bench_utils/corpus.h"
+#include "bench_utils/pipeline.h"
+#include "codegen/codegen.h"
+#include "pretty_printer/pretty_printer.h"
+
+namespace {
+
+/// Everything gracc does for a file, from the source to the printed IR.
+void BM_EndToEnd(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  bench::ThroughputCounters counters(
+      source.size(), bench::count_nodes(bench::parse(source).get()));
+  while (state.KeepRunning()) {
+    auto module = bench::analyze(source);
+    std::ostringstream ast_out;
+    ast::PrettyPrinterVisitor printer(ast_out);
+    module->accept(printer);
+    codegen::CodeGenerator generator("bench");
+    module->accept(generator);
+    benchmark::DoNotOptimize(generator.verify());
+    std::string ir;
+    llvm::raw_string_ostream ir_out(ir);
+    generator.print(ir_out);
+    benchmark::DoNotOptimize(ir_out.str().size());
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_EndToEnd)
+    ->Apply(bench::corpus_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,77 @@
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "bench_utils/pipeline.h"
+#include "codegen/codegen.h"
+#include "codegen/optimizer.h"
+
+namespace {
+
+// A reduction over a counted loop: the loop vectorizer should turn it into
+// vector operations.
+const char k_reduction[] = R"(
+public fun checksum(val n: Int32) : Int32 {
+  mut sum : Int32 = 0;
+  for (i : Int32 in 0..n) {
+    sum += (i * i) ^ (i |> 3);
+  }
+  return sum;
+}
+)";
+
+// A sum over a slice, indexed by a range loop over its length: the bounds
+// checks are left out, so that it can be vectorized too.
+const char k_slice_sum[] = R"(
+public fun sum(val xs: [Int32]) : Int32 {
+  mut total : Int32 = 0;
+  for (i in 0..xs.length) {
+    total += xs[i];
+  }
+  return total;
+}
+)";
+
+// Whether the IR of the module has vector types.
+bool is_vectorized(codegen::CodeGenerator* generator) {
+  std::string ir;
+  llvm::raw_string_ostream out(ir);
+  generator->print(out);
+  return out.str().find(" x i32>") != std::string::npos;
+}
+
+// Optimize the source at -O2, and fail if it is not vectorized.
+void optimize_loop(benchmark::State* state, const std::string& source) {
+  const auto module = bench::analyze(source);
+  bench::ThroughputCounters counters(source.size(),
+                                     bench::count_nodes(module.get()));
+  bool vectorized = true;
+  while (state->KeepRunning()) {
+    counters.pause(state);
+    std::unique_ptr<codegen::CodeGenerator> generator(
+        new codegen::CodeGenerator("bench"));
+    module->accept(*generator);
+    counters.resume(state);
+    codegen::optimize(&generator->get_module(), 2);
+    counters.pause(state);
+    vectorized = vectorized && is_vectorized(generator.get());
+    generator.reset();
+    counters.resume(state);
+  }
+  counters.report(state);
+  if (!vectorized) state->SkipWithError("The loop was not vectorized");
+}
+
+void BM_OptimizeReduction(benchmark::State& state) {  // NOLINT
+  optimize_loop(&state, k_reduction);
+}
+BENCHMARK(BM_OptimizeReduction);
+
+void BM_OptimizeSliceSum(benchmark::State& state) {  // NOLINT
+  optimize_loop(&state, k_slice_sum);
+}
+BENCHMARK(BM_OptimizeSliceSum);
+
+}  // namespace
@@ -0,0 +1,143 @@
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "bench_utils/corpus.h"
+#include "bench_utils/pipeline.h"
+#include "codegen/codegen.h"
+#include "pretty_printer/pretty_printer.h"
+
+namespace {
+
+void BM_Lex(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  bench::ThroughputCounters counters(
+      source.size(), bench::count_nodes(bench::parse(source).get()));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(bench::lex(source));
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_Lex)->Apply(bench::corpus_sizes);
+
+void BM_Parse(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  bench::ThroughputCounters counters(
+      source.size(), bench::count_nodes(bench::parse(source).get()));
+  while (state.KeepRunning()) {
+    auto module = bench::parse(source);
+    // Don't count the destruction of the AST.
+    counters.pause(&state);
+    module.reset();
+    counters.resume(&state);
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_Parse)->Apply(bench::corpus_sizes);
+
+void BM_Resolve(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  bench::ThroughputCounters counters(
+      source.size(), bench::count_nodes(bench::parse(source).get()));
+  while (state.KeepRunning()) {
+    counters.pause(&state);
+    auto module = bench::parse(source);
+    counters.resume(&state);
+    bench::resolve(module.get());
+    counters.pause(&state);
+    module.reset();
+    counters.resume(&state);
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_Resolve)->Apply(bench::corpus_sizes);
+
+void BM_Typecheck(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  bench::ThroughputCounters counters(
+      source.size(), bench::count_nodes(bench::parse(source).get()));
+  while (state.KeepRunning()) {
+    counters.pause(&state);
+    auto module = bench::parse(source);
+    bench::resolve(module.get());
+    counters.resume(&state);
+    bench::typecheck(module.get());
+    counters.pause(&state);
+    module.reset();
+    counters.resume(&state);
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_Typecheck)->Apply(bench::corpus_sizes);
+
+void BM_Codegen(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  const auto module = bench::analyze(source);
+  bench::ThroughputCounters counters(source.size(),
+                                     bench::count_nodes(module.get()));
+  while (state.KeepRunning()) {
+    std::unique_ptr<codegen::CodeGenerator> generator(
+        new codegen::CodeGenerator("bench"));
+    module->accept(*generator);
+    // Don't count the destruction of the LLVM module.
+    counters.pause(&state);
+    generator.reset();
+    counters.resume(&state);
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_Codegen)->Apply(bench::corpus_sizes);
+
+void BM_CodegenArithmetic(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_arithmetic_corpus(state.range(0));
+  const auto module = bench::analyze(source);
+  bench::ThroughputCounters counters(source.size(),
+                                     bench::count_nodes(module.get()));
+  while (state.KeepRunning()) {
+    std::unique_ptr<codegen::CodeGenerator> generator(
+        new codegen::CodeGenerator("bench"));
+    module->accept(*generator);
+    counters.pause(&state);
+    generator.reset();
+    counters.resume(&state);
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_CodegenArithmetic)->Apply(bench::corpus_sizes);
+
+void BM_PrettyPrint(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  const auto module = bench::analyze(source);
+  bench::ThroughputCounters counters(source.size(),
+                                     bench::count_nodes(module.get()));
+  while (state.KeepRunning()) {
+    std::ostringstream out;
+    ast::PrettyPrinterVisitor printer(out);
+    module->accept(printer);
+    benchmark::DoNotOptimize(out.tellp());
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_PrettyPrint)->Apply(bench::corpus_sizes);
+
+void BM_PrintIR(benchmark::State& state) {  // NOLINT
+  const auto source = bench::make_corpus(state.range(0));
+  const auto module = bench::analyze(source);
+  codegen::CodeGenerator generator("bench");
+  module->accept(generator);
+  bench::ThroughputCounters counters(source.size(),
+                                     bench::count_nodes(module.get()));
+  while (state.KeepRunning()) {
+    std::string ir;
+    llvm::raw_string_ostream out(ir);
+    generator.print(out);
+    benchmark::DoNotOptimize(out.str().size());
+  }
+  counters.report(&state);
+}
+BENCHMARK(BM_PrintIR)->Apply(bench::corpus_sizes);
+
+}  // namespace
@@ -0,0 +1,155 @@
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "util/option.h"
+#include "util/variant.h"
+
+namespace {
+
+using TrivialVariant = Variant<int, bool, double>;
+using StringVariant = Variant<int, std::string>;
+using PointerVariant = Variant<int, std::unique_ptr<int>>;
+
+constexpr int k_num_values = 1024;
+
+template <typename V>
+std::vector<V> make_values() {
+  std::vector<V> values;
+  values.reserve(k_num_values);
+  for (int i = 0; i < k_num_values; ++i) values.emplace_back(i);
+  return values;
+}
+
+template <typename V>
+void BM_VariantConstruct(benchmark::State& state) {  // NOLINT
+  while (state.KeepRunning()) {
+    for (int i = 0; i < k_num_values; ++i) {
+      V v(i);
+      benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK_TEMPLATE(BM_VariantConstruct, TrivialVariant);
+BENCHMARK_TEMPLATE(BM_VariantConstruct, StringVariant);
+BENCHMARK_TEMPLATE(BM_VariantConstruct, PointerVariant);
+
+template <typename V>
+void BM_VariantCopy(benchmark::State& state) {  // NOLINT
+  const auto values = make_values<V>();
+  std::vector<V> copies(k_num_values);
+  while (state.KeepRunning()) {
+    for (int i = 0; i < k_num_values; ++i) copies[i] = values[i];
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK_TEMPLATE(BM_VariantCopy, TrivialVariant);
+BENCHMARK_TEMPLATE(BM_VariantCopy, StringVariant);
+
+template <typename V>
+void BM_VariantMove(benchmark::State& state) {  // NOLINT
+  auto values = make_values<V>();
+  std::vector<V> moved(k_num_values);
+  while (state.KeepRunning()) {
+    for (int i = 0; i < k_num_values; ++i) {
+      moved[i] = std::move(values[i]);
+      values[i] = std::move(moved[i]);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values * 2);
+}
+BENCHMARK_TEMPLATE(BM_VariantMove, TrivialVariant);
+BENCHMARK_TEMPLATE(BM_VariantMove, StringVariant);
+BENCHMARK_TEMPLATE(BM_VariantMove, PointerVariant);
+
+template <typename V>
+void BM_VariantGet(benchmark::State& state) {  // NOLINT
+  const auto values = make_values<V>();
+  while (state.KeepRunning()) {
+    int sum = 0;
+    for (const auto& v : values) {
+      if (v.template is<int>()) sum += v.template get<int>();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK_TEMPLATE(BM_VariantGet, TrivialVariant);
+BENCHMARK_TEMPLATE(BM_VariantGet, StringVariant);
+
+template <typename T>
+void BM_OptionCopy(benchmark::State& state) {  // NOLINT
+  std::vector<Option<T>> values(k_num_values);
+  for (int i = 0; i < k_num_values; i += 2) values[i] = T();
+  std::vector<Option<T>> copies(k_num_values);
+  while (state.KeepRunning()) {
+    for (int i = 0; i < k_num_values; ++i) copies[i] = values[i];
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK_TEMPLATE(BM_OptionCopy, int);
+BENCHMARK_TEMPLATE(BM_OptionCopy, int*);
+BENCHMARK_TEMPLATE(BM_OptionCopy, std::string);
+
+void BM_OptionMovePointer(benchmark::State& state) {  // NOLINT
+  std::vector<Option<std::unique_ptr<int>>> values(k_num_values);
+  for (int i = 0; i < k_num_values; i += 2)
+    values[i] = std::make_unique<int>(i);
+  std::vector<Option<std::unique_ptr<int>>> moved(k_num_values);
+  while (state.KeepRunning()) {
+    for (int i = 0; i < k_num_values; ++i) {
+      moved[i] = std::move(values[i]);
+      values[i] = std::move(moved[i]);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values * 2);
+}
+BENCHMARK(BM_OptionMovePointer);
+
+// Sets one option in state.range(0), or a random half of them for 0: how
+// predictable the branch on is_ok() is matters more than the check itself.
+void BM_OptionDereference(benchmark::State& state) {  // NOLINT
+  std::vector<int> ints(k_num_values, 1);
+  std::vector<Option<int*>> values(k_num_values);
+  std::minstd_rand random(42);
+  for (int i = 0; i < k_num_values; ++i) {
+    bool set = state.range(0) == 0 ? random() % 2 == 0
+                                   : i % state.range(0) == 0;
+    if (set) values[i] = &ints[i];
+  }
+  while (state.KeepRunning()) {
+    int sum = 0;
+    for (const auto& v : values) {
+      if (v.is_ok()) sum += *v.value_or_die();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK(BM_OptionDereference)
+    ->ArgName("set_one_in")
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(0);
+
+void BM_OptionValueOr(benchmark::State& state) {  // NOLINT
+  std::vector<Option<int>> values(k_num_values);
+  for (int i = 0; i < k_num_values; i += 2) values[i] = i;
+  while (state.KeepRunning()) {
+    int sum = 0;
+    for (auto& v : values) sum += v.value_or(1);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * k_num_values);
+}
+BENCHMARK(BM_OptionValueOr);
+
+}  // namespace
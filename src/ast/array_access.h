@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+
+#include "ast/ast.h"
+#include "ast/value.h"
+#include "util/option.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `array[index]`, for an array or a slice. The index is checked against the
+/// length at runtime.
+class ArrayIndex : public Value {
+ public:
+  ArrayIndex(lexer::Range location, std::unique_ptr<Value> base,
+             std::unique_ptr<Value> index)
+      : Value(std::move(location), NodeType::ARRAY_INDEX),
+        base_(std::move(base)),
+        index_(std::move(index)) {}
+
+  std::unique_ptr<Value>& base() { return base_; }
+  std::unique_ptr<Value>& index() { return index_; }
+
+  ~ArrayIndex() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<Value> base_;
+  std::unique_ptr<Value> index_;
+};
+
+/// `array[begin..end]`: the slice of the elements from `begin` included to
+/// `end` excluded. Without `begin`, it starts at the first element, and
+/// without `end`, it goes to the last one.
+class ArraySlice : public Value {
+ public:
+  ArraySlice(lexer::Range location, std::unique_ptr<Value> base,
+             Option<std::unique_ptr<Value>> begin,
+             Option<std::unique_ptr<Value>> end)
+      : Value(std::move(location), NodeType::ARRAY_SLICE),
+        base_(std::move(base)),
+        begin_(std::move(begin)),
+        end_(std::move(end)) {}
+
+  std::unique_ptr<Value>& base() { return base_; }
+  Option<std::unique_ptr<Value>>& begin() { return begin_; }
+  Option<std::unique_ptr<Value>>& end() { return end_; }
+
+  ~ArraySlice() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<Value> base_;
+  Option<std::unique_ptr<Value>> begin_;
+  Option<std::unique_ptr<Value>> end_;
+};
+
+/// `array.length`: the number of elements of an array or a slice, as an
+/// Int64.
+class ArrayLength : public Value {
+ public:
+  ArrayLength(lexer::Range location, std::unique_ptr<Value> base)
+      : Value(std::move(location), NodeType::ARRAY_LENGTH),
+        base_(std::move(base)) {}
+
+  std::unique_ptr<Value>& base() { return base_; }
+
+  ~ArrayLength() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<Value> base_;
+};
+
+}  // namespace ast
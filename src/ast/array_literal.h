@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ast/ast.h"
+#include "ast/value.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `[a, b, c]`: an array with the values as elements.
+class ArrayLiteral : public Value {
+ public:
+  using ElementList = std::vector<std::unique_ptr<Value>>;
+  ArrayLiteral(lexer::Range location, ElementList elements)
+      : Value(std::move(location), NodeType::ARRAY_LITERAL),
+        elements_(std::move(elements)) {}
+
+  ElementList& elements() { return elements_; }
+
+  ~ArrayLiteral() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  ElementList elements_;
+};
+
+}  // namespace ast
@@ -0,0 +1,76 @@
+#include "ast/array_type.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "ast/builtin_type.h"
+
+namespace ast {
+
+namespace {
+
+Identifier make_id(const std::string& name) {
+  return Identifier(name, internals::builtin_range, true, false);
+}
+
+}  // namespace
+
+ArrayType::ArrayType(const TypeDeclaration* element, std::uint64_t size)
+    : TypeDeclaration(internals::builtin_range, NodeType::ARRAY_TYPE,
+                      make_id("[" + element->id().to_string() + "; " +
+                              std::to_string(size) + "]")),
+      element_(element),
+      size_(size) {}
+
+SliceType::SliceType(const TypeDeclaration* element)
+    : TypeDeclaration(internals::builtin_range, NodeType::SLICE_TYPE,
+                      make_id("[" + element->id().to_string() + "]")),
+      element_(element) {}
+
+namespace types {
+
+namespace {
+// The files of a build are compiled in parallel.
+std::mutex unique_types_mutex;
+}  // namespace
+
+const ArrayType* array_of(const TypeDeclaration* element, std::uint64_t size) {
+  std::lock_guard<std::mutex> lock(unique_types_mutex);
+  static std::map<std::pair<const TypeDeclaration*, std::uint64_t>,
+                  std::unique_ptr<ArrayType>>
+      arrays;
+  auto& array = arrays[{element, size}];
+  if (array == nullptr) array = std::make_unique<ArrayType>(element, size);
+  return array.get();
+}
+
+const SliceType* slice_of(const TypeDeclaration* element) {
+  std::lock_guard<std::mutex> lock(unique_types_mutex);
+  static std::map<const TypeDeclaration*, std::unique_ptr<SliceType>> slices;
+  auto& slice = slices[element];
+  if (slice == nullptr) slice = std::make_unique<SliceType>(element);
+  return slice.get();
+}
+
+const ArrayType* as_array(const TypeDeclaration* type) {
+  if (type->node_type() != NodeType::ARRAY_TYPE) return nullptr;
+  return static_cast<const ArrayType*>(type);
+}
+
+const SliceType* as_slice(const TypeDeclaration* type) {
+  if (type->node_type() != NodeType::SLICE_TYPE) return nullptr;
+  return static_cast<const SliceType*>(type);
+}
+
+const TypeDeclaration* element_type(const TypeDeclaration* type) {
+  if (auto array = as_array(type)) return array->element();
+  if (auto slice = as_slice(type)) return slice->element();
+  return nullptr;
+}
+
+}  // namespace types
+
+}  // namespace ast
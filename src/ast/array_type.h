@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ast/type_declaration.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `[Element; size]`: `size` elements, contiguous in memory. An array is a
+/// value: it is copied when assigned or passed to a function.
+class ArrayType : public TypeDeclaration {
+ public:
+  ArrayType(const TypeDeclaration* element, std::uint64_t size);
+
+  const TypeDeclaration* element() const { return element_; }
+  std::uint64_t size() const { return size_; }
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  const TypeDeclaration* element_;
+  std::uint64_t size_;
+};
+
+/// `[Element]`: a view of contiguous elements of an array, as a pointer to
+/// the first one and a length. The elements can't be assigned through it.
+class SliceType : public TypeDeclaration {
+ public:
+  explicit SliceType(const TypeDeclaration* element);
+
+  const TypeDeclaration* element() const { return element_; }
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  const TypeDeclaration* element_;
+};
+
+namespace types {
+
+/// The array and slice types are unique, so that they can be compared by
+/// declaration like the other types.
+const ArrayType* array_of(const TypeDeclaration* element, std::uint64_t size);
+const SliceType* slice_of(const TypeDeclaration* element);
+
+/// The type as an array (or slice) type, or nullptr if it is not one.
+const ArrayType* as_array(const TypeDeclaration* type);
+const SliceType* as_slice(const TypeDeclaration* type);
+
+/// The type of the elements of an array or slice type, nullptr for the other
+/// types.
+const TypeDeclaration* element_type(const TypeDeclaration* type);
+
+}  // namespace types
+
+}  // namespace ast
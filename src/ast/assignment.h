@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+
+#include "ast/ast.h"
+#include "ast/binary_operation.h"
+#include "ast/statement.h"
+#include "ast/value.h"
+#include "ast/variable_reference.h"
+#include "util/option.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `variable = value;`, or `variable[index] = value;` for an element of an
+/// array. The compound assignments (`+=`, ...) are parsed as
+/// `variable = variable + value;`, with their operator kept for the printer.
+class Assignment : public Statement {
+ public:
+  Assignment(lexer::Range location, std::unique_ptr<VariableReference> target,
+             std::unique_ptr<Value> value,
+             Option<std::unique_ptr<Value>> index = none,
+             Option<BinaryOperator> compound_operator = none)
+      : Statement(std::move(location), NodeType::ASSIGNMENT),
+        target_(std::move(target)),
+        index_(std::move(index)),
+        value_(std::move(value)),
+        compound_operator_(compound_operator) {}
+
+  VariableReference& target() { return *target_; }
+
+  /// The index of the assigned element, if the target is an element.
+  Option<std::unique_ptr<Value>>& index() { return index_; }
+
+  const std::unique_ptr<Value>& value() const { return value_; }
+  std::unique_ptr<Value>& value() { return value_; }
+
+  /// The operator of `variable op= value;', whose value() is
+  /// `variable op value'.
+  const Option<BinaryOperator>& compound_operator() const {
+    return compound_operator_;
+  }
+
+  ~Assignment() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<VariableReference> target_;
+  Option<std::unique_ptr<Value>> index_;
+  std::unique_ptr<Value> value_;
+  Option<BinaryOperator> compound_operator_;
+};
+
+}  // namespace ast
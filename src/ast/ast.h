@@ -6,11 +6,18 @@ namespace ast {
 
 // Tag to get the type of a node.
 enum class NodeType {
+  ARRAY_INDEX,
+  ARRAY_LENGTH,
+  ARRAY_LITERAL,
+  ARRAY_SLICE,
+  ARRAY_TYPE,
   ASSIGNMENT,
   BINARY_OP,
   BLOCK_STATEMENT,
   BOOLEAN_CONSTANT,
+  BREAK_STATEMENT,
   BUILTIN_TYPE,
+  CONTINUE_STATEMENT,
   FOR_BLOCK,
   FUNCTION_ARGUMENT_DECLARATION,
   FUNCTION_CALL,
@@ -22,6 +29,7 @@ enum class NodeType {
   MODULE,
   RETURN_STATEMENT,
   SCOPE_BLOCK,
+  SLICE_TYPE,
   UNARY_OP,
   VALUE_STATEMENT,
   VARIABLE_DESTRUCTION,
@@ -58,29 +66,37 @@ class ASTNode {
 };
 
 /// Concrete node classes.
+class ArrayIndex;
+class ArrayLength;
+class ArrayLiteral;
+class ArraySlice;
+class ArrayType;
 class Assignment;
 class BlockStatement;
 class BinaryOp;
 class BooleanConstant;
+class BreakStatement;
 class BuiltinType;
-// class ForBlock;
+class ContinueStatement;
+class ForBlock;
 class FunctionArgumentDeclaration;
 class FunctionCall;
 class FunctionDeclaration;
 class IfStatement;
-// class ImportStatement;
+class ImportStatement;
 class IntConstant;
 class LocalVariableDeclaration;
 class Module;
 class ReturnStatement;
 // class ScopeBlock;
+class SliceType;
 // class UnaryOp;
 class ValueStatement;
 class VariableDestruction;
 class VariableReference;
 // class WhenBlock;
 // class WhenCase;
-// class WhileBlock;
+class WhileBlock;
 
 /// Abstract node classes.
 class Declaration;
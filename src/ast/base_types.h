@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>  // hash
+#include <memory>
 #include <string>
 
 #include "lexer/token.h"
@@ -24,6 +26,7 @@ class Identifier {
   const lexer::Range& location() const { return location_; }
 
   bool is_uppercase() const { return is_uppercase_; }
+  bool is_absolute() const { return absolute_; }
 
  private:
   std::string name_;
@@ -40,9 +43,21 @@ class Type {
  public:
   explicit Type(Identifier id) : id_(std::move(id)) {}
   explicit Type(const TypeDeclaration* decl) : type_(decl) {}
+  /// The array `[element; size]`, or the slice `[element]` without a size, as
+  /// written: the name resolution finds the declaration of the element.
+  Type(Identifier id, Type element, Option<std::uint64_t> size)
+      : id_(std::move(id)),
+        element_(std::make_shared<const Type>(std::move(element))),
+        size_(std::move(size)) {}
 
   bool is_resolved() const { return type_.is_ok(); }
 
+  /// The element of an array or slice type as written, nullptr for the other
+  /// types.
+  const Type* element() const { return element_.get(); }
+  /// The size of an array type as written, none for a slice.
+  const Option<std::uint64_t>& size() const { return size_; }
+
   void set_resolution(const TypeDeclaration* decl) { type_ = decl; }
 
   const TypeDeclaration* get_declaration() const {
@@ -58,6 +73,8 @@ class Type {
  private:
   Option<Identifier> id_;
   Option<const TypeDeclaration*> type_;
+  std::shared_ptr<const Type> element_;
+  Option<std::uint64_t> size_;
 };
 
 inline bool operator==(const Type& t1, const Type& t2) {
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <memory>
 
 #include "ast/ast.h"
@@ -24,6 +26,15 @@ class BinaryOp : public Value {
 
   Value& right_value() { return *right_; }
 
+  /// Whether the operation is in parentheses in the source, e.g.
+  /// `(a * b) ^ c', for the printer to keep them.
+  bool is_parenthesized() const { return parenthesized_; }
+  void set_parenthesized(bool parenthesized) { parenthesized_ = parenthesized; }
+
+  /// The owners of the operands, for the transformations replacing them.
+  std::unique_ptr<Value>& left_value_ptr() { return left_; }
+  std::unique_ptr<Value>& right_value_ptr() { return right_; }
+
   ~BinaryOp() override = default;
 
  private:
@@ -31,5 +42,6 @@ class BinaryOp : public Value {
   std::unique_ptr<Value> left_;
   BinaryOperator op_;
   std::unique_ptr<Value> right_;
+  bool parenthesized_ = false;
 };
 }  // namespace ast
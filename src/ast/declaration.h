@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "ast/ast.h"
 #include "ast/base_types.h"
 #include "ast/statement.h"
@@ -23,4 +25,17 @@ class Declaration : public Statement {
   Identifier id_;
   Option<Type> type_;
 };
+
+/// Name of the node if it is a declaration, empty otherwise.
+inline const std::string& declaration_name(const ASTNode& node) {
+  static const std::string empty;
+  switch (node.node_type()) {
+    case NodeType::FUNCTION_ARGUMENT_DECLARATION:
+    case NodeType::FUNCTION_DECLARATION:
+    case NodeType::LOCAL_VARIABLE_DECLARATION:
+      return static_cast<const Declaration&>(node).id().to_string();
+    default:
+      return empty;
+  }
+}
 }  // namespace ast
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+
+#include "ast/ast.h"
+#include "ast/block_statement.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/statement.h"
+#include "ast/value.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `for (i in begin..end)`: the variable goes from `begin` included to `end`
+/// excluded, by steps of 1. Both bounds are evaluated once, before the loop,
+/// and the variable is immutable: the number of iterations is known when the
+/// loop starts.
+class ForBlock : public Statement {
+ public:
+  ForBlock(lexer::Range location,
+           std::unique_ptr<LocalVariableDeclaration> variable,
+           std::unique_ptr<Value> begin, std::unique_ptr<Value> end,
+           std::unique_ptr<BlockStatement> body)
+      : Statement(std::move(location), NodeType::FOR_BLOCK),
+        variable_(std::move(variable)),
+        begin_(std::move(begin)),
+        end_(std::move(end)),
+        body_(std::move(body)) {}
+
+  LocalVariableDeclaration* variable() { return variable_.get(); }
+
+  const std::unique_ptr<Value>& begin() const { return begin_; }
+  std::unique_ptr<Value>& begin() { return begin_; }
+  const std::unique_ptr<Value>& end() const { return end_; }
+  std::unique_ptr<Value>& end() { return end_; }
+  const std::unique_ptr<BlockStatement>& body() const { return body_; }
+
+  ~ForBlock() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<LocalVariableDeclaration> variable_;
+  std::unique_ptr<Value> begin_;
+  std::unique_ptr<Value> end_;
+  std::unique_ptr<BlockStatement> body_;
+};
+
+}  // namespace ast
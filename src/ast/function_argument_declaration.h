@@ -11,10 +11,12 @@ class FunctionArgumentDeclaration : public VariableDeclaration {
  public:
   FunctionArgumentDeclaration(lexer::Range location, Identifier id,
                               Option<Type> type,
-                              Option<std::unique_ptr<Value>> value, bool mut)
-      : VariableDeclaration(
-            std::move(location), NodeType::FUNCTION_ARGUMENT_DECLARATION,
-            std::move(id), std::move(type), std::move(value), mut) {}
+                              Option<std::unique_ptr<Value>> value, bool mut,
+                              bool constant = false)
+      : VariableDeclaration(std::move(location),
+                            NodeType::FUNCTION_ARGUMENT_DECLARATION,
+                            std::move(id), std::move(type), std::move(value),
+                            mut, constant) {}
 
  private:
   void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
@@ -4,7 +4,10 @@
 #include <vector>
 
 #include "ast/base_types.h"
+#include "ast/function_declaration.h"
 #include "ast/value.h"
+#include "ast/variable_reference.h"
+#include "util/option.h"
 #include "visitor/visitor.h"
 
 namespace ast {
@@ -22,6 +25,16 @@ class FunctionCall : public Value {
 
   ArgumentList& arguments() { return args_; }
 
+  /// The called function, if the base is a resolved reference to a function.
+  Option<FunctionDeclaration*> function() {
+    if (base_->node_type() != NodeType::VARIABLE_REFERENCE) return none;
+    auto& resolution = static_cast<VariableReference&>(*base_).resolution();
+    if (!resolution.is_ok() || resolution.value_or_die()->node_type() !=
+                                   NodeType::FUNCTION_DECLARATION)
+      return none;
+    return static_cast<FunctionDeclaration*>(resolution.value_or_die());
+  }
+
  private:
   void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
   std::unique_ptr<Value> base_;
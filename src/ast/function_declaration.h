@@ -13,6 +13,16 @@
 
 namespace ast {
 
+/// The qualifiers written before `fun`, e.g. `public pure fun f() = 3;`.
+struct FunctionQualifiers {
+  /// Visible outside of the module. Functions are private by default.
+  bool is_public = false;
+  /// Doesn't read the mutable global variables, nor call impure functions.
+  bool is_pure = false;
+  /// Defined (as public) in another module: the declaration has no body.
+  bool is_extern = false;
+};
+
 class FunctionDeclaration : public Declaration {
  public:
   using ArgumentList =
@@ -21,18 +31,22 @@ class FunctionDeclaration : public Declaration {
   using StatementsBody = std::unique_ptr<BlockStatement>;
   FunctionDeclaration(lexer::Range location, Identifier id,
                       ArgumentList arguments, Option<Type> type,
-                      StatementsBody body)
+                      StatementsBody body,
+                      FunctionQualifiers qualifiers = FunctionQualifiers())
       : Declaration(std::move(location), NodeType::FUNCTION_DECLARATION,
                     std::move(id), std::move(type)),
         arguments_(std::move(arguments)),
-        body_(std::move(body)) {}
+        body_(std::move(body)),
+        qualifiers_(qualifiers) {}
 
   FunctionDeclaration(lexer::Range location, Identifier id,
-                      ArgumentList arguments, Option<Type> type, ValueBody body)
+                      ArgumentList arguments, Option<Type> type, ValueBody body,
+                      FunctionQualifiers qualifiers = FunctionQualifiers())
       : Declaration(std::move(location), NodeType::FUNCTION_DECLARATION,
                     std::move(id), std::move(type)),
         arguments_(std::move(arguments)),
-        body_(std::move(body)) {}
+        body_(std::move(body)),
+        qualifiers_(qualifiers) {}
 
   const std::string& name() { return id().to_string(); }
 
@@ -40,10 +54,16 @@ class FunctionDeclaration : public Declaration {
 
   Variant<StatementsBody, ValueBody>& body() { return body_; }
 
+  bool is_public() const { return qualifiers_.is_public; }
+  bool is_pure() const { return qualifiers_.is_pure; }
+  bool is_extern() const { return qualifiers_.is_extern; }
+
   ~FunctionDeclaration() override = default;
 
   void accept_body(ASTVisitor& visitor) {
     if (body_.is<StatementsBody>()) {
+      // The extern functions have no body.
+      if (is_extern()) return;
       body_.get_unchecked<StatementsBody>()->accept(visitor);
     } else {
       body_.get_unchecked<ValueBody>()->accept(visitor);
@@ -55,6 +75,7 @@ class FunctionDeclaration : public Declaration {
 
   ArgumentList arguments_;
   Variant<StatementsBody, ValueBody> body_;
+  FunctionQualifiers qualifiers_;
 };
 
 }  // namespace ast
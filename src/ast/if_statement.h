@@ -24,6 +24,7 @@ class IfStatement : public Statement {
         else_statement_(std::move(else_statement)) {}
 
   const std::unique_ptr<Value>& condition() const { return condition_; }
+  std::unique_ptr<Value>& condition() { return condition_; }
   const std::unique_ptr<BlockStatement>& body() const { return body_; }
   const Option<std::unique_ptr<BlockStatement>>& else_statement() const {
     return else_statement_;
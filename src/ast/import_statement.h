@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ast/ast.h"
+#include "ast/base_types.h"
+#include "ast/statement.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `import math;`: the public functions of the module `math` can be called,
+/// with the declarations of its precompiled interface.
+class ImportStatement : public Statement {
+ public:
+  ImportStatement(lexer::Range location, Identifier module)
+      : Statement(std::move(location), NodeType::IMPORT_STATEMENT),
+        module_(std::move(module)) {}
+
+  const Identifier& module() const { return module_; }
+
+  ~ImportStatement() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  Identifier module_;
+};
+
+}  // namespace ast
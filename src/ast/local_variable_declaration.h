@@ -12,10 +12,12 @@ class LocalVariableDeclaration : public VariableDeclaration {
  public:
   LocalVariableDeclaration(lexer::Range location, Identifier id,
                            Option<Type> type,
-                           Option<std::unique_ptr<Value>> value, bool mut)
+                           Option<std::unique_ptr<Value>> value, bool mut,
+                           bool constant = false)
       : VariableDeclaration(std::move(location),
                             NodeType::LOCAL_VARIABLE_DECLARATION, std::move(id),
-                            std::move(type), std::move(value), mut) {}
+                            std::move(type), std::move(value), mut, constant) {
+  }
 
   ~LocalVariableDeclaration() override = default;
 
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ast/ast.h"
+#include "ast/statement.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+/// `break;`: leave the innermost loop.
+class BreakStatement : public Statement {
+ public:
+  explicit BreakStatement(lexer::Range location)
+      : Statement(std::move(location), NodeType::BREAK_STATEMENT) {}
+
+  ~BreakStatement() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+};
+
+/// `continue;`: go to the next iteration of the innermost loop.
+class ContinueStatement : public Statement {
+ public:
+  explicit ContinueStatement(lexer::Range location)
+      : Statement(std::move(location), NodeType::CONTINUE_STATEMENT) {}
+
+  ~ContinueStatement() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+};
+
+}  // namespace ast
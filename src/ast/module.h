@@ -20,6 +20,11 @@ class Module : public ASTNode {
     return top_level_declarations_;
   }
 
+  /// Give up the declarations, e.g. to keep them apart.
+  Declarations release_declarations() {
+    return std::move(top_level_declarations_);
+  }
+
  private:
   void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
   Declarations top_level_declarations_;
@@ -17,6 +17,7 @@ class ReturnStatement : public Statement {
         value_(std::move(value)) {}
 
   const Option<std::unique_ptr<Value>>& value() const { return value_; }
+  Option<std::unique_ptr<Value>>& value() { return value_; }
 
   ~ReturnStatement() override = default;
 
@@ -9,6 +9,7 @@ class TypeDeclaration : ASTNode {
   TypeDeclaration(lexer::Range location, NodeType node_type, Identifier id)
       : ASTNode(std::move(location), node_type), id_(std::move(id)) {}
   const Identifier& id() const { return id_; }
+  using ASTNode::node_type;
 
  private:
   Identifier id_;
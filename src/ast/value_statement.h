@@ -13,6 +13,7 @@ class ValueStatement : public Statement {
         value_(std::move(value)) {}
 
   const std::unique_ptr<Value>& value() const { return value_; }
+  std::unique_ptr<Value>& value() { return value_; }
 
   ~ValueStatement() override = default;
 
@@ -12,23 +12,27 @@ class VariableDeclaration : public Declaration {
  public:
   VariableDeclaration(lexer::Range location, NodeType node_type, Identifier id,
                       Option<Type> type, Option<std::unique_ptr<Value>> value,
-                      bool mut)
+                      bool mut, bool constant = false)
       : Declaration(std::move(location), node_type, std::move(id),
                     std::move(type)),
         value_(std::move(value)),
-        mut_(mut) {
-    assert(type.is_ok() || value.is_ok());
-  }
+        mut_(mut),
+        constant_(constant) {}
 
   bool is_mutable() const { return mut_; }
 
+  /// Declared with `constant`: its value is computed at compile time.
+  bool is_constant() const { return constant_; }
+
   const Option<std::unique_ptr<Value>>& value() const { return value_; }
+  Option<std::unique_ptr<Value>>& value() { return value_; }
 
   ~VariableDeclaration() override = default;
 
  private:
   Option<std::unique_ptr<Value>> value_;
   bool mut_;
+  bool constant_;
 };
 
 }  // namespace ast
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+
+#include "ast/ast.h"
+#include "ast/block_statement.h"
+#include "ast/statement.h"
+#include "ast/value.h"
+#include "visitor/visitor.h"
+
+namespace ast {
+
+class WhileBlock : public Statement {
+ public:
+  WhileBlock(lexer::Range location, std::unique_ptr<Value> condition,
+             std::unique_ptr<BlockStatement> body)
+      : Statement(std::move(location), NodeType::WHILE_BLOCK),
+        condition_(std::move(condition)),
+        body_(std::move(body)) {}
+
+  const std::unique_ptr<Value>& condition() const { return condition_; }
+  std::unique_ptr<Value>& condition() { return condition_; }
+  const std::unique_ptr<BlockStatement>& body() const { return body_; }
+
+  ~WhileBlock() override = default;
+
+ private:
+  void accept_impl(ASTVisitor& visitor) override { visitor.visit(this); }
+
+  std::unique_ptr<Value> condition_;
+  std::unique_ptr<BlockStatement> body_;
+};
+
+}  // namespace ast
@@ -0,0 +1,284 @@
+#include "build/builder.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "build/files.h"
+#include "build/imports.h"
+#include "util/logging.h"
+#include "util/option.h"
+#include "util/trace.h"
+
+namespace build {
+
+namespace {
+
+using Node = BuildGraph::Node;
+
+/// What the build knows of a source file before compiling anything.
+struct SourceState {
+  FileStamp stamp;
+  std::uint64_t source_hash = 0;
+  /// Whether the source changed since it was last compiled.
+  bool changed = true;
+};
+
+enum class NodeState { PENDING, UP_TO_DATE, COMPILED, FAILED };
+
+/// Runs the compilations of a build, each once its dependencies are done.
+class Build {
+ public:
+  Build(const BuildGraph& graph, std::vector<SourceState> sources,
+        BuildDatabase* database, Compiler* compiler)
+      : graph_(graph),
+        sources_(std::move(sources)),
+        database_(database),
+        compiler_(compiler),
+        remaining_(graph.size()),
+        states_(graph.size(), NodeState::PENDING),
+        interface_hashes_(graph.size()) {}
+
+  BuildSummary run(unsigned int jobs);
+
+ private:
+  /// Take the ready nodes until all of them are done.
+  void work();
+  /// Compile the node if it is not up to date.
+  NodeState process(Node node);
+  /// Whether the outputs of the node are missing or were compiled from other
+  /// sources or interfaces than the current ones.
+  bool needs_compilation(Node node, const Option<FileRecord>& record);
+  /// The hash of an interface imported by the node: the one written by its
+  /// dependency, or the contents of the file out of the build, hashed once
+  /// per build. None if it can't be read. The caller holds the mutex.
+  Option<std::uint64_t> interface_hash(Node node, const std::string& path);
+  /// The record of the node after its compilation, with the interfaces that
+  /// it imported. The caller holds the mutex.
+  FileRecord make_record(Node node, std::vector<ImportRecord> imports);
+
+  const BuildGraph& graph_;
+  const std::vector<SourceState> sources_;
+  BuildDatabase* database_;
+  Compiler* compiler_;
+
+  // Protects the database and everything below.
+  std::mutex mutex_;
+  std::condition_variable ready_changed_;
+  // The nodes whose dependencies are done, by priority.
+  std::priority_queue<std::pair<std::uint64_t, Node>> ready_;
+  // The number of dependencies of each node that are not done.
+  std::vector<std::size_t> remaining_;
+  std::vector<NodeState> states_;
+  // Set when the node is done, before its dependents are ready.
+  std::vector<std::uint64_t> interface_hashes_;
+  // The interfaces out of the build, e.g. in --import_path, by path: most
+  // files import the same ones.
+  std::unordered_map<std::string, Option<std::uint64_t>> external_hashes_;
+  std::size_t done_ = 0;
+};
+
+BuildSummary Build::run(unsigned int jobs) {
+  for (Node node = 0; node < graph_.size(); ++node) {
+    remaining_[node] = graph_.dependencies(node).size();
+    if (remaining_[node] == 0) ready_.emplace(graph_.priority(node), node);
+  }
+  auto thread_count = std::min<std::size_t>(jobs, graph_.size());
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < thread_count; ++i) {
+    workers.emplace_back([this, i]() {
+      if (util::Tracer::active() != nullptr)
+        util::Tracer::active()->set_thread_name("build worker " +
+                                                std::to_string(i));
+      work();
+    });
+  }
+  work();
+  for (auto& worker : workers) worker.join();
+
+  BuildSummary summary;
+  for (auto state : states_) {
+    if (state == NodeState::COMPILED) ++summary.compiled;
+    if (state == NodeState::UP_TO_DATE) ++summary.up_to_date;
+    if (state == NodeState::FAILED) ++summary.failed;
+  }
+  return summary;
+}
+
+void Build::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    ready_changed_.wait(
+        lock, [this]() { return !ready_.empty() || done_ == graph_.size(); });
+    if (ready_.empty()) return;
+    auto node = ready_.top().second;
+    ready_.pop();
+
+    lock.unlock();
+    auto state = process(node);
+    lock.lock();
+
+    states_[node] = state;
+    ++done_;
+    for (auto dependent : graph_.dependents(node)) {
+      if (--remaining_[dependent] == 0)
+        ready_.emplace(graph_.priority(dependent), dependent);
+    }
+    ready_changed_.notify_all();
+  }
+}
+
+NodeState Build::process(Node node) {
+  const auto& path = graph_.source(node).path;
+  for (auto dependency : graph_.dependencies(node)) {
+    // Its interface can't be imported.
+    if (states_[dependency] == NodeState::FAILED) return NodeState::FAILED;
+  }
+
+  Option<FileRecord> record;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = database_->find(path);
+    if (found != nullptr) record = *found;
+  }
+  if (!needs_compilation(node, record)) {
+    interface_hashes_[node] = record.value_or_die().interface_hash;
+    // The file was touched: it is not hashed again next time.
+    if (record.value_or_die().stamp != sources_[node].stamp) {
+      record.value_or_die().stamp = sources_[node].stamp;
+      std::lock_guard<std::mutex> lock(mutex_);
+      database_->set(path, record.consume_value_or_die());
+    }
+    return NodeState::UP_TO_DATE;
+  }
+
+  LOG(DEBUG) << "Compiling " << path;
+  std::vector<ImportRecord> imports;
+  bool success = compiler_->compile(path, &imports);
+  Option<std::uint64_t> interface_hash;
+  if (success) {
+    auto hash = hash_file(compiler_->interface_path(path));
+    if (hash.is_ok()) {
+      interface_hash = hash.value_or_die();
+    } else {
+      LOG(ERROR) << "No interface written for " << path << ": "
+                 << hash.error_or_die().to_string();
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!interface_hash.is_ok()) {
+    // Compiled again by the next build.
+    database_->erase(path);
+    return NodeState::FAILED;
+  }
+  interface_hashes_[node] = interface_hash.value_or_die();
+  database_->set(path, make_record(node, std::move(imports)));
+  return NodeState::COMPILED;
+}
+
+Option<std::uint64_t> Build::interface_hash(Node node,
+                                             const std::string& path) {
+  for (auto dependency : graph_.dependencies(node)) {
+    if (compiler_->interface_path(graph_.source(dependency).path) == path)
+      return interface_hashes_[dependency];
+  }
+  auto found = external_hashes_.find(path);
+  if (found != external_hashes_.end()) return found->second;
+  Option<std::uint64_t> result;
+  auto hash = hash_file(path);
+  if (hash.is_ok()) result = hash.value_or_die();
+  external_hashes_.emplace(path, result);
+  return result;
+}
+
+bool Build::needs_compilation(Node node, const Option<FileRecord>& record) {
+  if (sources_[node].changed || !record.is_ok()) return true;
+  for (const auto& output : compiler_->outputs(graph_.source(node).path)) {
+    if (!file_stamp(output).is_ok()) return true;
+  }
+  // The imported interfaces are the ones it was compiled with.
+  const auto& imports = record.value_or_die().imports;
+  for (auto dependency : graph_.dependencies(node)) {
+    auto module = module_name(graph_.source(dependency).path);
+    if (std::none_of(std::begin(imports), std::end(imports),
+                     [&module](const ImportRecord& import) {
+                       return import.module == module;
+                     }))
+      return true;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& import : imports) {
+    auto hash = interface_hash(node, import.path);
+    if (!hash.is_ok() || hash.value_or_die() != import.hash) return true;
+  }
+  return false;
+}
+
+FileRecord Build::make_record(Node node, std::vector<ImportRecord> imports) {
+  FileRecord record;
+  record.stamp = sources_[node].stamp;
+  record.source_hash = sources_[node].source_hash;
+  record.interface_hash = interface_hashes_[node];
+  for (auto& import : imports) {
+    // An unreadable interface doesn't match any hash: the file is compiled
+    // again by the next build.
+    import.hash = interface_hash(node, import.path).value_or(0);
+    record.imports.push_back(std::move(import));
+  }
+  return record;
+}
+
+}  // namespace
+
+ErrorOr<BuildSummary> run_build(const std::vector<std::string>& sources,
+                                const BuildOptions& options,
+                                Compiler* compiler) {
+  CHECK(options.jobs > 0) << "The build needs at least one job";
+  auto database = BuildDatabase::load(options.database, options.configuration);
+
+  // Only the sources that changed are read, to find their imports.
+  std::vector<Source> graph_sources;
+  std::vector<SourceState> states;
+  for (const auto& path : sources) {
+    auto stamp = file_stamp(path);
+    if (!stamp.is_ok()) return GenericError("Could not find " + path);
+    SourceState state;
+    state.stamp = stamp.value_or_die();
+    Source source;
+    source.path = path;
+    source.cost = state.stamp.size + 1;
+
+    auto record = database.find(path);
+    if (record != nullptr && record->stamp == state.stamp) {
+      state.source_hash = record->source_hash;
+      state.changed = false;
+    } else {
+      RETURN_OR_MOVE(state.source_hash, hash_file(path));
+      state.changed =
+          record == nullptr || record->source_hash != state.source_hash;
+    }
+    if (state.changed) {
+      source.imports = scan_imports(path);
+    } else {
+      for (const auto& import : record->imports)
+        source.imports.push_back(import.module);
+    }
+    graph_sources.push_back(std::move(source));
+    states.push_back(state);
+  }
+  RETURN_OR_MOVE(auto graph, BuildGraph::create(std::move(graph_sources)));
+
+  auto summary =
+      Build(graph, std::move(states), &database, compiler).run(options.jobs);
+  auto saved = database.save(options.database);
+  if (!saved.is_ok()) return GenericError(saved.error_or_die().to_string());
+  return summary;
+}
+
+}  // namespace build
@@ -0,0 +1,68 @@
+#pragma once
+
+/// This file contains the build mode: the source files are compiled in the
+/// order of their imports, and only when they changed since the previous
+/// build, or when the interfaces that they import changed.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "build/database.h"
+#include "build/graph.h"
+#include "error/error.h"
+
+namespace build {
+
+/// Compiles the source files for the build. It is called from several threads
+/// at once.
+class Compiler {
+ public:
+  virtual ~Compiler() = default;
+
+  /// Compile the source, and write its interface and its other outputs. Print
+  /// the errors, and return false if there were some. Add the module and the
+  /// path of each interface that the source imported to `imports', in the
+  /// build or not: the build hashes them.
+  virtual bool compile(const std::string& source,
+                       std::vector<ImportRecord>* imports) = 0;
+  /// The interface written when compiling the source.
+  virtual std::string interface_path(const std::string& source) const = 0;
+  /// All the files written when compiling the source.
+  virtual std::vector<std::string> outputs(const std::string& source) const = 0;
+};
+
+struct BuildOptions {
+  /// The file of the BuildDatabase.
+  std::string database;
+  /// Everything that changes the outputs of the compilation, besides the
+  /// sources, e.g. the flags. All the files are compiled again when it
+  /// changes.
+  std::string configuration;
+  /// The number of files compiled at once.
+  unsigned int jobs = 1;
+};
+
+struct BuildSummary {
+  std::size_t compiled = 0;
+  std::size_t up_to_date = 0;
+  /// The files with errors, and the files that import them.
+  std::size_t failed = 0;
+};
+
+/// Build the sources: a file is compiled after the files of the modules it
+/// imports, if its source, its imported interfaces or its outputs changed
+/// since the last build recorded in the database. The interfaces out of the
+/// build, e.g. of the --import_path, are hashed again by each build.
+///
+/// The files are compiled in parallel, the ones on the critical path (see
+/// BuildGraph::priority) first. After an error, the files that don't depend
+/// on the failed one are still compiled.
+///
+/// Returns an error if the build can't start, e.g. if the imports have a
+/// cycle.
+ErrorOr<BuildSummary> run_build(const std::vector<std::string>& sources,
+                                const BuildOptions& options,
+                                Compiler* compiler);
+
+}  // namespace build
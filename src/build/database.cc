@@ -0,0 +1,104 @@
+#include "build/database.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "util/mapped_file.h"
+
+namespace build {
+
+namespace {
+
+constexpr char k_header[] = "gracc-build-db 2";
+
+// The fields of a line, separated by tabs.
+std::vector<std::string> split_fields(const std::string& line) {
+  std::vector<std::string> fields;
+  std::istringstream stream(line);
+  std::string field;
+  while (std::getline(stream, field, '\t')) fields.push_back(field);
+  return fields;
+}
+
+// The number, in the base. False if it is not one.
+template <typename Integer>
+bool parse_number(const std::string& text, int base, Integer* value) {
+  if (text.empty()) return false;
+  char* end = nullptr;
+  *value = static_cast<Integer>(std::strtoull(text.c_str(), &end, base));
+  return *end == '\0';
+}
+
+// path, mtime, size, source hash, interface hash, then module=hash=path for
+// each import.
+bool parse_record(const std::vector<std::string>& fields, FileRecord* record) {
+  if (fields.size() < 5 ||
+      !parse_number(fields[1], 10, &record->stamp.mtime_ns) ||
+      !parse_number(fields[2], 10, &record->stamp.size) ||
+      !parse_number(fields[3], 16, &record->source_hash) ||
+      !parse_number(fields[4], 16, &record->interface_hash))
+    return false;
+  for (std::size_t i = 5; i < fields.size(); ++i) {
+    // The path may contain '=', but not the module or the hash.
+    auto separator = fields[i].find('=');
+    auto path_separator = separator == std::string::npos
+                              ? std::string::npos
+                              : fields[i].find('=', separator + 1);
+    ImportRecord import;
+    if (path_separator == std::string::npos ||
+        !parse_number(
+            fields[i].substr(separator + 1, path_separator - separator - 1),
+            16, &import.hash))
+      return false;
+    import.module = fields[i].substr(0, separator);
+    import.path = fields[i].substr(path_separator + 1);
+    record->imports.push_back(std::move(import));
+  }
+  return true;
+}
+
+}  // namespace
+
+BuildDatabase BuildDatabase::load(const std::string& path,
+                                  const std::string& configuration) {
+  BuildDatabase database(configuration);
+  std::ifstream in(path);
+  std::string line;
+  if (!std::getline(in, line) || line != k_header ||
+      !std::getline(in, line) || line != configuration)
+    return database;
+  while (std::getline(in, line)) {
+    auto fields = split_fields(line);
+    FileRecord record;
+    if (!parse_record(fields, &record)) return BuildDatabase(configuration);
+    database.records_[fields[0]] = std::move(record);
+  }
+  return database;
+}
+
+const FileRecord* BuildDatabase::find(const std::string& source) const {
+  auto record = records_.find(source);
+  return record == std::end(records_) ? nullptr : &record->second;
+}
+
+void BuildDatabase::set(const std::string& source, FileRecord record) {
+  records_[source] = std::move(record);
+}
+
+MaybeError<> BuildDatabase::save(const std::string& path) const {
+  std::ostringstream out;
+  out << k_header << '\n' << configuration_ << '\n';
+  for (const auto& entry : records_) {
+    const auto& record = entry.second;
+    out << entry.first << '\t' << std::dec << record.stamp.mtime_ns << '\t'
+        << record.stamp.size << '\t' << std::hex << record.source_hash << '\t'
+        << record.interface_hash;
+    for (const auto& import : record.imports)
+      out << '\t' << import.module << '=' << import.hash << '=' << import.path;
+    out << std::dec << '\n';
+  }
+  return util::replace_file(path, out.str());
+}
+
+}  // namespace build
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "build/files.h"
+#include "error/error.h"
+
+namespace build {
+
+/// An interface that a source file imported when it was compiled.
+struct ImportRecord {
+  std::string module;
+  /// The file found by the interface loader, in the build or not.
+  std::string path;
+  std::uint64_t hash = 0;
+};
+
+/// What the build knew of a source file when it last compiled it.
+struct FileRecord {
+  FileStamp stamp;
+  std::uint64_t source_hash = 0;
+  /// The hash of the interface that the file compiled to.
+  std::uint64_t interface_hash = 0;
+  /// The imported interfaces that the file was compiled with.
+  std::vector<ImportRecord> imports;
+};
+
+/// The records of the files compiled by the previous builds, kept in a text
+/// file between the builds, one line per file.
+class BuildDatabase {
+ public:
+  explicit BuildDatabase(std::string configuration)
+      : configuration_(std::move(configuration)) {}
+
+  /// Read the database. It is empty if the file doesn't exist, if it is
+  /// invalid, or if it was written with another configuration (e.g. other
+  /// compilation flags): all the files are compiled again.
+  static BuildDatabase load(const std::string& path,
+                            const std::string& configuration);
+
+  /// The record of the source file, or null if it has none.
+  const FileRecord* find(const std::string& source) const;
+  void set(const std::string& source, FileRecord record);
+  void erase(const std::string& source) { records_.erase(source); }
+
+  /// Write the database: a temporary file replaces the previous one, so that
+  /// an interrupted build doesn't leave a truncated database.
+  MaybeError<> save(const std::string& path) const;
+
+ private:
+  std::string configuration_;
+  std::unordered_map<std::string, FileRecord> records_;
+};
+
+}  // namespace build
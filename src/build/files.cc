@@ -0,0 +1,29 @@
+#include "build/files.h"
+
+#include <sys/stat.h>
+
+#include "util/mapped_file.h"
+
+namespace build {
+
+Option<FileStamp> file_stamp(const std::string& path) {
+  struct stat file_stat;
+  if (::stat(path.c_str(), &file_stat) != 0) return none;
+  FileStamp stamp;
+  stamp.mtime_ns = std::int64_t{file_stat.st_mtim.tv_sec} * 1000000000 +
+                   file_stat.st_mtim.tv_nsec;
+  stamp.size = static_cast<std::uint64_t>(file_stat.st_size);
+  return stamp;
+}
+
+ErrorOr<std::uint64_t> hash_file(const std::string& path) {
+  RETURN_OR_MOVE(auto file, util::MappedFile::open(path));
+  std::uint64_t hash = 14695981039346656037ull;
+  for (std::size_t i = 0; i < file->size(); ++i) {
+    hash ^= static_cast<unsigned char>(file->data()[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace build
@@ -0,0 +1,35 @@
+#pragma once
+
+/// This file contains what the build knows of the files: whether they may
+/// have changed, and the hash of their contents.
+
+#include <cstdint>
+#include <string>
+
+#include "error/error.h"
+#include "util/option.h"
+
+namespace build {
+
+/// The modification time and size of a file: if they didn't change, the
+/// contents are assumed to be the same, without reading them.
+struct FileStamp {
+  std::int64_t mtime_ns = 0;
+  std::uint64_t size = 0;
+};
+
+inline bool operator==(const FileStamp& left, const FileStamp& right) {
+  return left.mtime_ns == right.mtime_ns && left.size == right.size;
+}
+
+inline bool operator!=(const FileStamp& left, const FileStamp& right) {
+  return !(left == right);
+}
+
+/// The stamp of the file, or none if it doesn't exist.
+Option<FileStamp> file_stamp(const std::string& path);
+
+/// The 64-bit FNV-1a hash of the contents of the file.
+ErrorOr<std::uint64_t> hash_file(const std::string& path);
+
+}  // namespace build
@@ -0,0 +1,89 @@
+#include "build/graph.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "build/imports.h"
+
+namespace build {
+
+BuildGraph::BuildGraph(std::vector<Source> sources)
+    : sources_(std::move(sources)),
+      dependencies_(sources_.size()),
+      dependents_(sources_.size()),
+      priorities_(sources_.size()) {}
+
+ErrorOr<BuildGraph> BuildGraph::create(std::vector<Source> sources) {
+  BuildGraph graph(std::move(sources));
+  std::unordered_map<std::string, Node> modules;
+  for (Node node = 0; node < graph.size(); ++node) {
+    const auto& path = graph.source(node).path;
+    auto inserted = modules.emplace(module_name(path), node);
+    if (!inserted.second)
+      return GenericError("The module `" + module_name(path) +
+                          "' is defined in " +
+                          graph.source(inserted.first->second).path +
+                          " and in " + path);
+  }
+  for (Node node = 0; node < graph.size(); ++node) {
+    auto& dependencies = graph.dependencies_[node];
+    for (const auto& module : graph.source(node).imports) {
+      auto dependency = modules.find(module);
+      if (dependency == std::end(modules) ||
+          std::find(std::begin(dependencies), std::end(dependencies),
+                    dependency->second) != std::end(dependencies))
+        continue;
+      dependencies.push_back(dependency->second);
+      graph.dependents_[dependency->second].push_back(node);
+    }
+  }
+
+  RETURN_OR_MOVE(auto order, graph.topological_order());
+  // From the last nodes of the chains to the first ones.
+  for (auto node = order.rbegin(); node != order.rend(); ++node) {
+    std::uint64_t longest_chain = 0;
+    for (auto dependent : graph.dependents(*node))
+      longest_chain = std::max(longest_chain, graph.priority(dependent));
+    graph.priorities_[*node] = graph.source(*node).cost + longest_chain;
+  }
+  return std::move(graph);
+}
+
+ErrorOr<std::vector<BuildGraph::Node>> BuildGraph::topological_order() const {
+  std::vector<Node> order;
+  std::vector<std::size_t> remaining(size());
+  for (Node node = 0; node < size(); ++node) {
+    remaining[node] = dependencies(node).size();
+    if (remaining[node] == 0) order.push_back(node);
+  }
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    for (auto dependent : dependents(order[i])) {
+      if (--remaining[dependent] == 0) order.push_back(dependent);
+    }
+  }
+  if (order.size() == size()) return std::move(order);
+
+  // The nodes left are in a cycle, or depend on one: follow the remaining
+  // dependencies until a node comes back.
+  Node node = 0;
+  while (remaining[node] == 0) ++node;
+  std::vector<std::size_t> position(size(), size());
+  std::vector<Node> path;
+  while (position[node] == size()) {
+    position[node] = path.size();
+    path.push_back(node);
+    for (auto dependency : dependencies(node)) {
+      if (remaining[dependency] != 0) {
+        node = dependency;
+        break;
+      }
+    }
+  }
+  std::string cycle;
+  for (auto itr = path.begin() + position[node]; itr != path.end(); ++itr)
+    cycle += source(*itr).path + " -> ";
+  return GenericError("The imports have a cycle: " + cycle +
+                      source(node).path);
+}
+
+}  // namespace build
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "error/error.h"
+
+namespace build {
+
+/// A source file of the build.
+struct Source {
+  std::string path;
+  /// The modules that it imports, in the build or not.
+  std::vector<std::string> imports;
+  /// The estimated cost of its compilation, e.g. its size.
+  std::uint64_t cost = 1;
+};
+
+/// The dependencies between the source files of a build: a file depends on
+/// the files of the modules that it imports, named after them (see
+/// module_name). The modules that are not in the build are not part of the
+/// graph: their interfaces are already compiled.
+class BuildGraph {
+ public:
+  using Node = std::size_t;
+
+  /// An error if two files are the same module, or if the imports have a
+  /// cycle.
+  static ErrorOr<BuildGraph> create(std::vector<Source> sources);
+
+  std::size_t size() const { return sources_.size(); }
+  const Source& source(Node node) const { return sources_[node]; }
+  const std::vector<Node>& dependencies(Node node) const {
+    return dependencies_[node];
+  }
+  const std::vector<Node>& dependents(Node node) const {
+    return dependents_[node];
+  }
+  /// The cost of the longest chain of compilations that starts with the node:
+  /// the critical path of the build goes through the nodes with the highest
+  /// priority, they are compiled first.
+  std::uint64_t priority(Node node) const { return priorities_[node]; }
+
+ private:
+  explicit BuildGraph(std::vector<Source> sources);
+
+  /// The nodes, each after its dependencies, or an error if there is a cycle.
+  ErrorOr<std::vector<Node>> topological_order() const;
+
+  std::vector<Source> sources_;
+  std::vector<std::vector<Node>> dependencies_;
+  std::vector<std::vector<Node>> dependents_;
+  std::vector<std::uint64_t> priorities_;
+};
+
+}  // namespace build
@@ -0,0 +1,47 @@
+#include "build/imports.h"
+
+#include "lexer/lexer.h"
+
+namespace build {
+
+namespace {
+
+using lexer::TokenType;
+
+// The type of the next token that is not a comment, and its text.
+TokenType next_token(lexer::Lexer* lexer, std::string* text) {
+  while (true) {
+    auto token = lexer->get_next_token();
+    if (!token.is_ok()) return TokenType::END_OF_FILE;
+    auto type = token.value_or_die().type();
+    if (type == TokenType::COMMENT) continue;
+    if (type == TokenType::LOWER_CASE_IDENT)
+      *text = token.value_or_die().text();
+    return type;
+  }
+}
+
+}  // namespace
+
+std::vector<std::string> scan_imports(const std::string& path) {
+  auto lexer = lexer::from_file(path);
+  std::vector<std::string> imports;
+  std::string module;
+  // import <module>;
+  while (next_token(&lexer, &module) == TokenType::IMPORT &&
+         next_token(&lexer, &module) == TokenType::LOWER_CASE_IDENT) {
+    imports.push_back(module);
+    if (next_token(&lexer, &module) != TokenType::SEMICOLON) break;
+  }
+  return imports;
+}
+
+std::string module_name(const std::string& path) {
+  auto begin = path.find_last_of('/');
+  begin = begin == std::string::npos ? 0 : begin + 1;
+  auto end = path.find_last_of('.');
+  if (end == std::string::npos || end < begin) end = path.size();
+  return path.substr(begin, end - begin);
+}
+
+}  // namespace build
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace build {
+
+/// The modules imported by the source file, in order. Only the head of the
+/// file is lexed: the imports are before the declarations. The scan stops at
+/// the first error, which the compilation of the file reports.
+std::vector<std::string> scan_imports(const std::string& path);
+
+/// The name of the module of a source file: `src/math.gh` is `math`.
+std::string module_name(const std::string& path);
+
+}  // namespace build
@@ -33,15 +33,9 @@ std::unique_ptr<raw_fd_ostream> get_ostream_for_file(
                                           llvm::sys::fs::F_None);
 }
 
-CodeGenerator::CodeGenerator(const std::string& name)
-    : module_(std::make_unique<Module>(name, context_)),
-      ir_builder_(context_, ConstantFolder()),
-      gen_value_(none),
-      current_function_(none) {
-  auto target_triple = sys::getDefaultTargetTriple();
-  module_->setTargetTriple(target_triple);
+std::unique_ptr<TargetMachine> create_target_machine(
+    const std::string& target_triple) {
   std::string error;
-
   auto target = TargetRegistry::lookupTarget(target_triple, error);
 
   // Print an error and exit if we couldn't find the requested target.
@@ -60,17 +54,38 @@ CodeGenerator::CodeGenerator(const std::string& name)
 #else
   auto rm = Reloc::Model();
 #endif
-  std::unique_ptr<TargetMachine> target_machine(
+  return std::unique_ptr<TargetMachine>(
       target->createTargetMachine(target_triple, cpu, features, opt, rm));
-  module_->setDataLayout(target_machine->createDataLayout());
 }
 
-Module& CodeGenerator::get_module() {
-  llvm::verifyModule(*module_);
-  return *module_;
+CodeGenerator::CodeGenerator(const std::string& name)
+    : CodeGenerator(name, nullptr) {}
+
+CodeGenerator::CodeGenerator(const std::string& name, LLVMContext* context)
+    : owned_context_(context == nullptr ? std::make_unique<LLVMContext>()
+                                        : nullptr),
+      context_(context == nullptr ? *owned_context_ : *context),
+      module_(std::make_unique<Module>(name, context_)),
+      ir_builder_(context_, ConstantFolder()),
+      gen_value_(none),
+      current_function_(none) {
+  init_builtin_types();
+  auto target_triple = sys::getDefaultTargetTriple();
+  module_->setTargetTriple(target_triple);
+  module_->setDataLayout(
+      create_target_machine(target_triple)->createDataLayout());
 }
-void CodeGenerator::print(raw_ostream& out) const {
-  llvm::verifyModule(*module_);
-  out << *module_;
+
+Module& CodeGenerator::get_module() { return *module_; }
+
+std::unique_ptr<Module> CodeGenerator::release_module() {
+  return std::move(module_);
+}
+
+bool CodeGenerator::verify(raw_ostream* errors) const {
+  // verifyModule returns true if the module is broken.
+  return !llvm::verifyModule(*module_, errors);
 }
+
+void CodeGenerator::print(raw_ostream& out) const { out << *module_; }
 }  // namespace codegen
@@ -1,16 +1,24 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
 
+#include "ast/declaration.h"
 #include "ast/module.h"
+#include "ast/variable_declaration.h"
+#include "codegen/memory_effects.h"
 #include "error/error.h"
+#include "util/trace.h"
 #include "visitor/error_visitor.h"
 #include "visitor/visitor.h"
 
@@ -24,26 +32,48 @@ struct LLVMInitializer {
 std::unique_ptr<llvm::raw_fd_ostream> get_ostream_for_file(
     const std::string& filename);
 
+/// The target machine for the triple, with a generic CPU.
+std::unique_ptr<llvm::TargetMachine> create_target_machine(
+    const std::string& target_triple);
+
 class CodeGenerator : public ast::VisitorWithErrors<> {
-  using Variables = std::unordered_map<ast::Declaration*, llvm::AllocaInst*>;
+  using Variables = std::unordered_map<ast::Declaration*, llvm::Value*>;
+  using Slots = std::unordered_map<ast::Declaration*, llvm::AllocaInst*>;
   using Functions = std::unordered_map<ast::Declaration*, llvm::Function*>;
   using FunctionsArgs = std::unordered_map<ast::Declaration*, llvm::Value*>;
+  using Types = std::unordered_map<const ast::TypeDeclaration*, llvm::Type*>;
 
  public:
   explicit CodeGenerator(const std::string& name);
-  // void visit(ast::Assignment* node) override;
-  // void visit(ast::BinaryOp* node) override;
+  /// Generate the module in an existing context, to link it with the modules
+  /// of the other files.
+  CodeGenerator(const std::string& name, llvm::LLVMContext* context);
+  void visit(ast::ArrayIndex* node) override;
+  void visit(ast::ArrayLength* node) override;
+  void visit(ast::ArrayLiteral* node) override;
+  void visit(ast::ArraySlice* node) override;
+  void visit(ast::Assignment* node) override;
+  void visit(ast::BinaryOp* node) override;
+  void visit(ast::BooleanConstant* node) override;
+  void visit(ast::BreakStatement* node) override;
+  void visit(ast::ContinueStatement* node) override;
+  void visit(ast::ForBlock* node) override;
   // void visit(ast::FunctionArgumentDeclaration* node) override;
-  // void visit(ast::FunctionCall* node) override;
+  void visit(ast::FunctionCall* node) override;
   void visit(ast::FunctionDeclaration* node) override;
   void visit(ast::IntConstant* node) override;
   void visit(ast::BlockStatement* node) override;
   void visit(ast::ReturnStatement* node) override;
   void visit(ast::ValueStatement* node) override;
   void visit(ast::IfStatement* node) override;
+  void visit(ast::WhileBlock* node) override;
 
   void visit(ast::Module* node) override {
+    memory_effects_ = std::make_unique<MemoryEffects>(node);
+    find_assigned_variables(node);
     for (auto const& declaration : node->top_level_declarations()) {
+      util::TraceScope trace("declaration",
+                             ast::declaration_name(*declaration));
       declaration->accept(*this);
       current_function_ = none;
       gen_value_ = none;
@@ -54,26 +84,126 @@ class CodeGenerator : public ast::VisitorWithErrors<> {
   void visit(ast::VariableReference* node) override;
 
   llvm::Module& get_module();
+  /// Take the generated module, e.g. to link it. The generator can't be used
+  /// anymore.
+  std::unique_ptr<llvm::Module> release_module();
+
+  /// Check that the generated module is valid. Returns false and prints the
+  /// problems to the stream, if given, otherwise.
+  bool verify(llvm::raw_ostream* errors = nullptr) const;
 
   void print(llvm::raw_ostream& out) const;
 
  private:
-  llvm::LLVMContext context_;
+  /// Fill types_ with the builtin types.
+  void init_builtin_types();
+  /// The LLVM type of a resolved type.
+  llvm::Type* get_llvm_type(const ast::Type& type);
+  /// The declared type of the variable, or the type of its value.
+  llvm::Type* get_variable_type(ast::VariableDeclaration* node);
+  /// Convert the integer value to the integer type, if needed.
+  llvm::Value* cast_to(llvm::Value* value, llvm::Type* type);
+
+  /// Fill assigned_variables_.
+  void find_assigned_variables(ast::Module* node);
+  /// Whether the variable lives on the stack: the assigned variables, and
+  /// the arrays, whose elements are accessed in memory.
+  bool needs_stack_slot(const ast::Declaration* node, llvm::Type* type) const;
+  /// Allocate a variable on the stack of the current function.
+  llvm::AllocaInst* create_stack_slot(llvm::Type* type,
+                                      const std::string& name);
+  /// Turn the stack slots of the generated function back into SSA values,
+  /// with PHIs at the joins, and forget them. The arrays stay in memory.
+  void promote_stack_slots(llvm::Function* function);
+
+  /// An array or a slice in memory.
+  struct ArrayPointer {
+    /// The array, or the first element of the slice.
+    llvm::Value* pointer;
+    /// The number of elements, as an Int64.
+    llvm::Value* length;
+    bool is_slice;
+  };
+  /// The array or slice value in memory: the arrays that are not variables
+  /// are copied.
+  ArrayPointer generate_array_pointer(ast::Value* node);
+  /// The address of the element `index' (an Int64).
+  llvm::Value* get_element_pointer(const ArrayPointer& array,
+                                   llvm::Value* index);
+  /// The address of the element, checked against the bounds.
+  llvm::Value* generate_element_address(ast::Value* array, ast::Value* index);
+  /// Whether the index is known to be in the bounds of the array: it is the
+  /// variable of a range loop which stays in them.
+  bool is_in_bounds(ast::Value* array, ast::Value* index);
+  /// Trap if the condition is false.
+  void generate_bounds_check(llvm::Value* in_bounds);
+
+  /// Generate the value of an operand, converted to the type.
+  llvm::Value* generate_operand(ast::Value* node, llvm::Type* type);
+  /// Reduce the shift amount modulo the width of its type.
+  llvm::Value* mask_shift_amount(llvm::Value* amount);
+  /// Generate `&&` and `||`, that don't evaluate their right side if the
+  /// left one decides the result.
+  llvm::Value* generate_logical_operation(ast::BinaryOp* node);
+
+  /// Generate the condition of an `if` or a loop, as a boolean.
+  llvm::Value* generate_condition(ast::Value* node);
+
+  /// The blocks targeted by `continue' and `break'.
+  struct Loop {
+    llvm::BasicBlock* latch;
+    llvm::BasicBlock* exit;
+  };
+  /// Generate the body of the loop at the insertion point, and branch to its
+  /// latch at the end.
+  void generate_loop_body(ast::BlockStatement* body, Loop loop);
+  /// Branch from the latch to the header, with the loop metadata.
+  void generate_back_edge(llvm::BasicBlock* header);
+
+  /// The LLVM function of the declaration, declared with its attributes if
+  /// it doesn't exist yet.
+  llvm::Function* get_or_declare_function(ast::FunctionDeclaration* node);
+  /// Mark the call in return position as a tail call, unless it may read the
+  /// arrays of the frame of the caller.
+  void mark_tail_call(llvm::CallInst* call);
+
+  // Null if the context is not owned.
+  std::unique_ptr<llvm::LLVMContext> owned_context_;
+  llvm::LLVMContext& context_;
   std::unique_ptr<llvm::Module> module_;
   llvm::IRBuilder<> ir_builder_;
   // Return value of visitation of a value node.
   Option<llvm::Value*> gen_value_;
 
-  /// Keeps the associations of ast::LocalVariableDeclaration to
-  /// llvm::AllocaInst
+  /// Keeps the associations of ast::LocalVariableDeclaration to their SSA
+  /// llvm::Value
   Variables variables_;
 
+  /// The variables that are assigned somewhere.
+  std::unordered_set<const ast::Declaration*> assigned_variables_;
+
+  /// Keeps the associations of the assigned local variables and arguments to
+  /// their stack slot, until the end of their function.
+  Slots slots_;
+
+  /// The loops around the current statement, the innermost last.
+  std::vector<Loop> loops_;
+
+  /// The range loops around the current statement, by loop variable.
+  std::unordered_map<const ast::Declaration*, ast::ForBlock*> range_loops_;
+
   /// Keeps the associations of ast::FunctionDeclaration to llvm::Function
   Functions functions_;
 
   /// Keeps the associations of ast::FunctionArgumentDeclaration to llvm::Value
   FunctionsArgs functions_args_;
 
+  /// Keeps the associations of ast::TypeDeclaration to llvm::Type
+  Types types_;
+
+  /// Which functions read the memory, to set their attributes.
+  std::unique_ptr<MemoryEffects> memory_effects_;
+
   // Current function holding the blocks.
   Option<llvm::Function*> current_function_;
 
@@ -0,0 +1,233 @@
+#include "codegen/codegen.h"
+
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/array_type.h"
+#include "ast/for_block.h"
+#include "ast/int_constant.h"
+#include "ast/variable_reference.h"
+#include "util/logging.h"
+#include "util/option.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+
+// The arrays are LLVM arrays, in memory: the variables are on the stack (or
+// global), and the elements are accessed with GEPs. The slices are a pointer
+// to their first element and a length, passed by value.
+//
+// Each access to an element checks its index against the length, and traps
+// if it is out of the bounds. The check is left out when the index is the
+// variable of a range loop that stays in the bounds, e.g.
+// `for (i in 0..xs.length) { xs[i] }`: LLVM can then vectorize the loop.
+
+namespace {
+
+// The variable referenced by the value, if it is a reference.
+ast::Declaration* referenced_variable(ast::Value* value) {
+  if (value->node_type() != ast::NodeType::VARIABLE_REFERENCE) return nullptr;
+  auto& resolution = static_cast<ast::VariableReference*>(value)->resolution();
+  return resolution.is_ok() ? resolution.value_or_die() : nullptr;
+}
+
+// The length of the value, if it is known at compile time: an integer
+// constant, or the length of an array.
+Option<std::int64_t> constant_length(ast::Value* value) {
+  if (value->node_type() == ast::NodeType::INT_CONSTANT)
+    return static_cast<ast::IntConstant*>(value)->value();
+  if (value->node_type() != ast::NodeType::ARRAY_LENGTH) return none;
+  auto& base = static_cast<ast::ArrayLength*>(value)->base();
+  auto array = ast::types::as_array(
+      base->type().value_or_die().get_declaration());
+  if (array == nullptr) return none;
+  return static_cast<std::int64_t>(array->size());
+}
+
+}  // namespace
+
+CodeGenerator::ArrayPointer CodeGenerator::generate_array_pointer(
+    ast::Value* node) {
+  auto declaration = node->type().value_or_die().get_declaration();
+  auto int64 = Type::getInt64Ty(context_);
+  if (auto array = ast::types::as_array(declaration)) {
+    auto length = ConstantInt::get(int64, array->size());
+    auto variable = referenced_variable(node);
+    if (variable != nullptr) {
+      auto slot = slots_.find(variable);
+      if (slot != std::end(slots_)) return {slot->second, length, false};
+      auto global_var = module_->getNamedGlobal(
+          static_cast<ast::VariableReference*>(node)->id().to_string());
+      if (global_var != nullptr) return {global_var, length, false};
+    }
+    node->accept(*this);
+    auto value = gen_value_.value_or_die();
+    if (current_function_.is_ok()) {
+      auto copy = create_stack_slot(value->getType(), "array");
+      ir_builder_.CreateStore(value, copy);
+      return {copy, length, false};
+    }
+    // Outside of a function, the array has to be a constant.
+    if (!isa<Constant>(value)) {
+      add_error(node->location(),
+                "The array can't be computed at compile time");
+      value = Constant::getNullValue(value->getType());
+    }
+    auto copy = new GlobalVariable(*module_, value->getType(),
+                                   /*isConstant=*/true,
+                                   GlobalValue::PrivateLinkage,
+                                   cast<Constant>(value), "array");
+    return {copy, length, false};
+  }
+
+  node->accept(*this);
+  auto slice = gen_value_.value_or_die();
+  return {ir_builder_.CreateExtractValue(slice, 0),
+          ir_builder_.CreateExtractValue(slice, 1), true};
+}
+
+Value* CodeGenerator::get_element_pointer(const ArrayPointer& array,
+                                          Value* index) {
+  auto type = array.pointer->getType()->getPointerElementType();
+  if (array.is_slice)
+    return ir_builder_.CreateInBoundsGEP(type, array.pointer, index);
+  Value* indices[] = {ConstantInt::get(index->getType(), 0), index};
+  return ir_builder_.CreateInBoundsGEP(type, array.pointer, indices);
+}
+
+Value* CodeGenerator::generate_element_address(ast::Value* array,
+                                               ast::Value* index) {
+  auto pointer = generate_array_pointer(array);
+  auto index_value = generate_operand(index, Type::getInt64Ty(context_));
+  if (!is_in_bounds(array, index)) {
+    // Unsigned, the negative indices are above the length.
+    generate_bounds_check(
+        ir_builder_.CreateICmpULT(index_value, pointer.length));
+  }
+  return get_element_pointer(pointer, index_value);
+}
+
+bool CodeGenerator::is_in_bounds(ast::Value* array, ast::Value* index) {
+  auto variable = referenced_variable(index);
+  auto loop_itr = range_loops_.find(variable);
+  if (loop_itr == std::end(range_loops_)) return false;
+  auto loop = loop_itr->second;
+
+  // The index starts in the array...
+  auto begin = loop->begin().get();
+  if (begin->node_type() != ast::NodeType::INT_CONSTANT) return false;
+  auto first = static_cast<ast::IntConstant*>(begin)->value();
+  auto index_type = get_variable_type(loop->variable());
+  if (first < 0 || !ConstantInt::isValueValidForType(index_type, first))
+    return false;
+
+  // ...and stops before its end. The end is converted to the type of the
+  // index: a positive end can only get smaller.
+  auto end = loop->end().get();
+  auto array_type = ast::types::as_array(
+      array->type().value_or_die().get_declaration());
+  if (array_type != nullptr) {
+    auto last = constant_length(end);
+    return last.is_ok() && last.value_or_die() <=
+                               static_cast<std::int64_t>(array_type->size());
+  }
+  // `for (i in 0..xs.length) { xs[i] }`, with the same slice during the whole
+  // loop.
+  if (end->node_type() != ast::NodeType::ARRAY_LENGTH) return false;
+  auto slice = referenced_variable(array);
+  return slice != nullptr && assigned_variables_.count(slice) == 0 &&
+         referenced_variable(
+             static_cast<ast::ArrayLength*>(end)->base().get()) == slice;
+}
+
+void CodeGenerator::generate_bounds_check(Value* in_bounds) {
+  // Known at compile time, e.g. for a constant index in an array.
+  auto constant = dyn_cast<ConstantInt>(in_bounds);
+  if (constant != nullptr && constant->isOne()) return;
+  // Outside of a function, the value is only used if it is a constant.
+  if (!current_function_.is_ok()) return;
+
+  auto function = current_function_.value_or_die();
+  auto out_of_bounds = BasicBlock::Create(context_, "bounds.fail", function);
+  auto next = BasicBlock::Create(context_, "bounds.ok", function);
+  MDBuilder metadata(context_);
+  ir_builder_.CreateCondBr(in_bounds, next, out_of_bounds,
+                           metadata.createBranchWeights(1 << 20, 1));
+
+  ir_builder_.SetInsertPoint(out_of_bounds);
+  ir_builder_.CreateCall(
+      Intrinsic::getDeclaration(module_.get(), Intrinsic::trap), {});
+  ir_builder_.CreateUnreachable();
+
+  ir_builder_.SetInsertPoint(next);
+}
+
+void CodeGenerator::visit(ast::ArrayLiteral* node) {
+  CHECK(node->type().is_ok()) << "Array literal should be typed";
+  auto type = get_llvm_type(node->type().value_or_die());
+  auto element_type = type->getArrayElementType();
+  // Built with the constant folder: the constant elements make a constant.
+  Value* array = UndefValue::get(type);
+  unsigned position = 0;
+  for (const auto& element : node->elements()) {
+    array = ir_builder_.CreateInsertValue(
+        array, generate_operand(element.get(), element_type), position++);
+  }
+  gen_value_ = array;
+}
+
+void CodeGenerator::visit(ast::ArrayIndex* node) {
+  auto address =
+      generate_element_address(node->base().get(), node->index().get());
+  gen_value_ = ir_builder_.CreateLoad(address);
+}
+
+void CodeGenerator::visit(ast::ArraySlice* node) {
+  auto array = generate_array_pointer(node->base().get());
+  auto int64 = Type::getInt64Ty(context_);
+  auto& begin_node = node->begin();
+  auto& end_node = node->end();
+  Value* begin = begin_node.is_ok()
+                     ? generate_operand(begin_node.value_or_die().get(), int64)
+                     : ConstantInt::get(int64, 0);
+  Value* end = end_node.is_ok()
+                   ? generate_operand(end_node.value_or_die().get(), int64)
+                   : array.length;
+  // The missing bounds are in the array.
+  if (begin_node.is_ok() && end_node.is_ok()) {
+    generate_bounds_check(
+        ir_builder_.CreateAnd(ir_builder_.CreateICmpULE(begin, end),
+                              ir_builder_.CreateICmpULE(end, array.length)));
+  } else if (begin_node.is_ok() || end_node.is_ok()) {
+    generate_bounds_check(ir_builder_.CreateICmpULE(
+        begin_node.is_ok() ? begin : end, array.length));
+  }
+
+  auto type = get_llvm_type(node->type().value_or_die());
+  Value* slice = UndefValue::get(type);
+  slice = ir_builder_.CreateInsertValue(
+      slice, get_element_pointer(array, begin), 0);
+  gen_value_ =
+      ir_builder_.CreateInsertValue(slice, ir_builder_.CreateNUWSub(end, begin),
+                                    1);
+}
+
+void CodeGenerator::visit(ast::ArrayLength* node) {
+  auto& base = node->base();
+  auto array = ast::types::as_array(
+      base->type().value_or_die().get_declaration());
+  if (array == nullptr) {
+    base->accept(*this);
+    gen_value_ = ir_builder_.CreateExtractValue(gen_value_.value_or_die(), 1);
+    return;
+  }
+  // The array is only evaluated for the side effects.
+  if (referenced_variable(base.get()) == nullptr) base->accept(*this);
+  gen_value_ = ConstantInt::get(Type::getInt64Ty(context_), array->size());
+}
+
+}  // namespace codegen
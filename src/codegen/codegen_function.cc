@@ -23,23 +23,63 @@ void CodeGenerator::visit(ast::ValueStatement* node) {
   CHECK(gen_value_.is_ok()) << "No value generated by the visitor";
 }
 
-void CodeGenerator::visit(ast::FunctionDeclaration* node) {
-  std::vector<Type*> param_types;  // fill by visiting.
-  for (std::size_t i = 0; i < node->arguments().size(); ++i) {
-    // TODO: put real type here.
-    param_types.push_back(IntegerType::get(context_, 32));
+Function* CodeGenerator::get_or_declare_function(
+    ast::FunctionDeclaration* node) {
+  auto function_itr = functions_.find(node);
+  if (function_itr != std::end(functions_)) return function_itr->second;
+
+  std::vector<Type*> param_types;
+  for (const auto& argument : node->arguments()) {
+    param_types.push_back(get_variable_type(argument.get()));
   }
 
   ArrayRef<Type*> param_types_array(param_types);
-  // TODO: put real return type here.
-  FunctionType* t = FunctionType::get(IntegerType::get(context_, 32),
-                                      param_types_array, /*isVarArg=*/false);
-  Constant* c = module_->getOrInsertFunction(node->id().short_name(), t);
+  CHECK(node->type().is_ok()) << "Function return type not deduced: "
+                              << node->id().to_string();
+  FunctionType* t =
+      FunctionType::get(get_llvm_type(node->type().value_or_die()),
+                        param_types_array, /*isVarArg=*/false);
+
+  // Only the public functions (and main) can be called from outside of the
+  // module. The others can use the fast calling convention, and be removed
+  // once inlined. The extern functions are the public functions of another
+  // module.
+  bool is_exported = node->is_public() || node->is_extern() ||
+                     node->id().short_name() == "main";
+  Function* llvm_function = Function::Create(
+      t, is_exported ? GlobalValue::ExternalLinkage
+                     : GlobalValue::InternalLinkage,
+      node->id().short_name(), module_.get());
+  llvm_function->setCallingConv(is_exported ? CallingConv::C
+                                            : CallingConv::Fast);
+
+  // There are no exceptions.
+  llvm_function->addFnAttr(Attribute::NoUnwind);
+  CHECK(memory_effects_ != nullptr) << "Function declared outside of a module";
+  auto effects = memory_effects_->effects(node);
+  // The slices are like the arguments: a pure function can read them.
+  if (effects.globals != MemoryEffects::Effect::NONE && node->is_pure()) {
+    const char* access =
+        effects.globals == MemoryEffects::Effect::WRITE ? "writes" : "reads";
+    add_error(node->id().location(), "The pure function `" +
+                                         node->id().to_string() + "' " +
+                                         access + " mutable global variables");
+  }
+  auto effect = effects.memory();
+  if (effect == MemoryEffects::Effect::NONE)
+    llvm_function->addFnAttr(Attribute::ReadNone);
+  else if (effect == MemoryEffects::Effect::READ)
+    llvm_function->addFnAttr(Attribute::ReadOnly);
 
-  Function* llvm_function = cast<Function>(c);
-  current_function_ = llvm_function;
-  llvm_function->setCallingConv(CallingConv::C);
   functions_[node] = llvm_function;
+  return llvm_function;
+}
+
+void CodeGenerator::visit(ast::FunctionDeclaration* node) {
+  Function* llvm_function = get_or_declare_function(node);
+  // Linked with its definition.
+  if (node->is_extern()) return;
+  current_function_ = llvm_function;
 
   // Name the parameters.
   CHECK(llvm_function->arg_size() == node->arguments().size())
@@ -58,9 +98,34 @@ void CodeGenerator::visit(ast::FunctionDeclaration* node) {
   BasicBlock* body_block = BasicBlock::Create(context_, node->id().to_string(),
                                               current_function_.value_or_die());
   ir_builder_.SetInsertPoint(body_block);
+  // The assigned arguments are copied on the stack, like the variables.
+  for (const auto& argument : node->arguments()) {
+    auto llvm_argument = functions_args_[argument.get()];
+    if (!needs_stack_slot(argument.get(), llvm_argument->getType())) continue;
+    auto slot = create_stack_slot(llvm_argument->getType(),
+                                  argument->id().to_string() + ".slot");
+    ir_builder_.CreateStore(llvm_argument, slot);
+    slots_[argument.get()] = slot;
+  }
   node->accept_body(*this);
+  promote_stack_slots(llvm_function);
 
   consume_return_value();
 }
 
+void CodeGenerator::visit(ast::FunctionCall* node) {
+  CHECK(node->function().is_ok()) << "Only functions can be called";
+  Function* callee = get_or_declare_function(node->function().value_or_die());
+
+  std::vector<Value*> arguments;
+  auto parameter = callee->arg_begin();
+  for (const auto& argument : node->arguments()) {
+    arguments.push_back(
+        generate_operand(argument.get(), (parameter++)->getType()));
+  }
+  auto call = ir_builder_.CreateCall(callee, arguments);
+  call->setCallingConv(callee->getCallingConv());
+  gen_value_ = call;
+}
+
 }  // namespace codegen
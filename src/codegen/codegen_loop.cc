@@ -0,0 +1,127 @@
+#include "codegen/codegen.h"
+
+#include "llvm/IR/Metadata.h"
+
+#include "ast/block_statement.h"
+#include "ast/for_block.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
+#include "ast/while_block.h"
+#include "util/logging.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+
+// The loops are generated in the canonical form that the LLVM loop passes
+// (vectorizer, unroller, ...) expect:
+//
+//   preheader: (the current block) br header
+//   header:    br condition, body, exit
+//   body:      ...; br latch (`continue': br latch, `break': br exit)
+//   latch:     br header, !llvm.loop
+//   exit:
+//
+// The latch is the only block going back to the header, and the only one
+// holding the loop metadata.
+
+void CodeGenerator::generate_loop_body(ast::BlockStatement* body, Loop loop) {
+  loops_.push_back(loop);
+  body->accept(*this);
+  loops_.pop_back();
+  // Unless the iteration always ends with a return, break or continue.
+  if (!consume_return_value()) ir_builder_.CreateBr(loop.latch);
+}
+
+void CodeGenerator::generate_back_edge(BasicBlock* header) {
+  // The loop id is distinct: its first operand is itself. The loop passes
+  // attach their hints and results (e.g. "already vectorized") to it.
+  auto placeholder = MDNode::getTemporary(context_, None);
+  auto loop_id = MDNode::get(context_, {placeholder.get()});
+  loop_id->replaceOperandWith(0, loop_id);
+  auto branch = ir_builder_.CreateBr(header);
+  branch->setMetadata(LLVMContext::MD_loop, loop_id);
+}
+
+void CodeGenerator::visit(ast::WhileBlock* node) {
+  CHECK(current_function_.is_ok())
+      << "WhileBlock can't live outside of function";
+  auto function = current_function_.value_or_die();
+
+  auto header = BasicBlock::Create(context_, "while.cond", function);
+  ir_builder_.CreateBr(header);
+  ir_builder_.SetInsertPoint(header);
+  auto condition = generate_condition(node->condition().get());
+  auto body = BasicBlock::Create(context_, "while.body", function);
+  // Needed by the body, but inserted after it.
+  auto latch = BasicBlock::Create(context_, "while.latch");
+  auto exit = BasicBlock::Create(context_, "while.end");
+  ir_builder_.CreateCondBr(condition, body, exit);
+
+  ir_builder_.SetInsertPoint(body);
+  generate_loop_body(node->body().get(), {latch, exit});
+
+  latch->insertInto(function);
+  ir_builder_.SetInsertPoint(latch);
+  generate_back_edge(header);
+
+  exit->insertInto(function);
+  ir_builder_.SetInsertPoint(exit);
+}
+
+void CodeGenerator::visit(ast::ForBlock* node) {
+  CHECK(current_function_.is_ok()) << "ForBlock can't live outside of function";
+  auto function = current_function_.value_or_die();
+  auto variable = node->variable();
+  auto name = variable->id().to_string();
+  auto type = get_variable_type(variable);
+
+  // The bounds are evaluated once, before the loop: with the index going up
+  // by 1 in the latch only, LLVM knows the trip count (end - begin).
+  auto begin = generate_operand(node->begin().get(), type);
+  auto end = generate_operand(node->end().get(), type);
+  auto preheader = ir_builder_.GetInsertBlock();
+  auto header = BasicBlock::Create(context_, "for.cond", function);
+  ir_builder_.CreateBr(header);
+
+  ir_builder_.SetInsertPoint(header);
+  auto index = ir_builder_.CreatePHI(type, 2, name);
+  index->addIncoming(begin, preheader);
+  variables_[variable] = index;
+  auto body = BasicBlock::Create(context_, "for.body", function);
+  auto latch = BasicBlock::Create(context_, "for.latch");
+  auto exit = BasicBlock::Create(context_, "for.end");
+  ir_builder_.CreateCondBr(ir_builder_.CreateICmpSLT(index, end), body, exit);
+
+  ir_builder_.SetInsertPoint(body);
+  // The bounds checks of the arrays indexed by the variable can use its range.
+  range_loops_[variable] = node;
+  generate_loop_body(node->body().get(), {latch, exit});
+  range_loops_.erase(variable);
+
+  latch->insertInto(function);
+  ir_builder_.SetInsertPoint(latch);
+  // The index is below `end`: adding 1 can't overflow.
+  auto next =
+      ir_builder_.CreateNSWAdd(index, ConstantInt::get(type, 1), name + ".next");
+  index->addIncoming(next, latch);
+  generate_back_edge(header);
+
+  exit->insertInto(function);
+  ir_builder_.SetInsertPoint(exit);
+}
+
+void CodeGenerator::visit(ast::BreakStatement* /*unused*/) {
+  CHECK(!loops_.empty()) << "`break' outside of a loop";
+  ir_builder_.CreateBr(loops_.back().exit);
+  // Like after a return, the rest of the block is unreachable.
+  has_returned_ = true;
+}
+
+void CodeGenerator::visit(ast::ContinueStatement* /*unused*/) {
+  CHECK(!loops_.empty()) << "`continue' outside of a loop";
+  ir_builder_.CreateBr(loops_.back().latch);
+  has_returned_ = true;
+}
+
+}  // namespace codegen
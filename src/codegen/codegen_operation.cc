@@ -0,0 +1,169 @@
+#include "codegen/codegen.h"
+
+#include "ast/binary_operation.h"
+#include "ast/boolean_constant.h"
+#include "util/logging.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+using ast::BinaryOperator;
+
+namespace {
+
+// Operands that can be evaluated even if the operator would have
+// short-circuited them: no side effect, and (almost) no cost.
+bool is_trivial_operand(ast::Value* value) {
+  return value->node_type() == ast::NodeType::BOOLEAN_CONSTANT ||
+         value->node_type() == ast::NodeType::INT_CONSTANT ||
+         value->node_type() == ast::NodeType::VARIABLE_REFERENCE;
+}
+
+}  // namespace
+
+void CodeGenerator::visit(ast::BooleanConstant* node) {
+  gen_value_ = ir_builder_.getInt1(node->value());
+}
+
+Value* CodeGenerator::generate_operand(ast::Value* node, Type* type) {
+  node->accept(*this);
+  CHECK(gen_value_.is_ok()) << "Operand with no value";
+  return cast_to(gen_value_.value_or_die(), type);
+}
+
+void CodeGenerator::visit(ast::BinaryOp* node) {
+  auto op = node->operation();
+  if (op == BinaryOperator::AND || op == BinaryOperator::OR) {
+    gen_value_ = generate_logical_operation(node);
+    return;
+  }
+
+  // The operands are extended to the type of the result, or to the widest
+  // one for the comparisons.
+  CHECK(node->left_value().type().is_ok() &&
+        node->right_value().type().is_ok())
+      << "Binary operation should be typed";
+  auto left_type = get_llvm_type(node->left_value().type().value_or_die());
+  auto right_type = get_llvm_type(node->right_value().type().value_or_die());
+  auto type =
+      left_type->getIntegerBitWidth() >= right_type->getIntegerBitWidth()
+          ? left_type
+          : right_type;
+  auto left = generate_operand(&node->left_value(), type);
+  auto right = generate_operand(&node->right_value(), type);
+
+  // The integers are signed, and overflowing them is undefined behavior
+  // (like in C): the arithmetic is emitted with the nsw flag, which lets LLVM
+  // reassociate and widen it.
+  switch (op) {
+    case BinaryOperator::PLUS:
+      gen_value_ = ir_builder_.CreateNSWAdd(left, right);
+      break;
+    case BinaryOperator::MINUS:
+      gen_value_ = ir_builder_.CreateNSWSub(left, right);
+      break;
+    case BinaryOperator::TIMES:
+      gen_value_ = ir_builder_.CreateNSWMul(left, right);
+      break;
+    case BinaryOperator::DIVIDE:
+    case BinaryOperator::INT_DIVIDE:
+      // LLVM turns the divisions by a constant into shifts and
+      // multiplications.
+      gen_value_ = ir_builder_.CreateSDiv(left, right);
+      break;
+    case BinaryOperator::MODULO:
+      gen_value_ = ir_builder_.CreateSRem(left, right);
+      break;
+    case BinaryOperator::BITAND:
+      gen_value_ = ir_builder_.CreateAnd(left, right);
+      break;
+    case BinaryOperator::BITOR:
+      gen_value_ = ir_builder_.CreateOr(left, right);
+      break;
+    case BinaryOperator::BITXOR:
+      gen_value_ = ir_builder_.CreateXor(left, right);
+      break;
+    case BinaryOperator::BITSHIFT_LEFT:
+      gen_value_ = ir_builder_.CreateShl(left, mask_shift_amount(right));
+      break;
+    case BinaryOperator::BITSHIFT_RIGHT:
+      gen_value_ = ir_builder_.CreateAShr(left, mask_shift_amount(right));
+      break;
+    case BinaryOperator::EQUAL:
+      gen_value_ = ir_builder_.CreateICmpEQ(left, right);
+      break;
+    case BinaryOperator::DIFFERENT:
+      gen_value_ = ir_builder_.CreateICmpNE(left, right);
+      break;
+    case BinaryOperator::GREATER:
+      gen_value_ = ir_builder_.CreateICmpSGT(left, right);
+      break;
+    case BinaryOperator::GREATER_OR_EQUAL:
+      gen_value_ = ir_builder_.CreateICmpSGE(left, right);
+      break;
+    case BinaryOperator::LESS:
+      gen_value_ = ir_builder_.CreateICmpSLT(left, right);
+      break;
+    case BinaryOperator::LESS_OR_EQUAL:
+      gen_value_ = ir_builder_.CreateICmpSLE(left, right);
+      break;
+    default:
+      CHECK(false) << "Binary operation not supported: " << op;
+  }
+}
+
+Value* CodeGenerator::mask_shift_amount(Value* amount) {
+  // Shifting by the width of the type or more is poison in LLVM: the amount
+  // is taken modulo the width, like the x86 shifts do. The mask is folded
+  // for constants, and removed by the backend otherwise.
+  auto width = amount->getType()->getIntegerBitWidth();
+  return ir_builder_.CreateAnd(
+      amount, ConstantInt::get(amount->getType(), width - 1));
+}
+
+Value* CodeGenerator::generate_logical_operation(ast::BinaryOp* node) {
+  bool is_and = node->operation() == BinaryOperator::AND;
+  auto left = generate_operand(&node->left_value(), ir_builder_.getInt1Ty());
+
+  // Without side effects, evaluating both sides is cheaper than a branch.
+  // Outside of a function, there is no block to branch to.
+  if (is_trivial_operand(&node->right_value()) ||
+      !current_function_.is_ok()) {
+    auto right =
+        generate_operand(&node->right_value(), ir_builder_.getInt1Ty());
+    return is_and ? ir_builder_.CreateAnd(left, right)
+                  : ir_builder_.CreateOr(left, right);
+  }
+
+  // A constant left side decides the result, or is the identity.
+  if (auto constant = dyn_cast<ConstantInt>(left)) {
+    if (constant->isOne() != is_and) return constant;
+    return generate_operand(&node->right_value(), ir_builder_.getInt1Ty());
+  }
+
+  auto function = current_function_.value_or_die();
+  auto left_block = ir_builder_.GetInsertBlock();
+  auto right_block = BasicBlock::Create(
+      context_, is_and ? "and.rhs" : "or.rhs", function);
+  auto end_block = BasicBlock::Create(
+      context_, is_and ? "and.end" : "or.end", function);
+  if (is_and)
+    ir_builder_.CreateCondBr(left, right_block, end_block);
+  else
+    ir_builder_.CreateCondBr(left, end_block, right_block);
+
+  ir_builder_.SetInsertPoint(right_block);
+  auto right = generate_operand(&node->right_value(), ir_builder_.getInt1Ty());
+  // The right side may have created blocks.
+  right_block = ir_builder_.GetInsertBlock();
+  ir_builder_.CreateBr(end_block);
+
+  ir_builder_.SetInsertPoint(end_block);
+  auto result = ir_builder_.CreatePHI(ir_builder_.getInt1Ty(), 2);
+  // When the right side is not evaluated, the result is the left side.
+  result->addIncoming(ir_builder_.getInt1(!is_and), left_block);
+  result->addIncoming(right, right_block);
+  return result;
+}
+
+}  // namespace codegen
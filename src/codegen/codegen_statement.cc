@@ -23,15 +23,73 @@ void CodeGenerator::visit(ast::BlockStatement* node) {
     // Restore state of node.
     current_function_ = current_function;
     gen_value_ = none;
-    // TODO: plug the SSA code here for PHI nodes.
   }
 }
 
+namespace {
+
+// Whether the values of the type hold a pointer, like the slices.
+bool holds_pointer(Type* type) {
+  if (type->isPointerTy()) return true;
+  if (type->isArrayTy()) return holds_pointer(type->getArrayElementType());
+  if (auto structure = dyn_cast<StructType>(type)) {
+    for (auto element : structure->elements()) {
+      if (holds_pointer(element)) return true;
+    }
+  }
+  return false;
+}
+
+// Whether the function has arrays in its frame, which slices may point to.
+bool has_stack_arrays(Function* function) {
+  for (auto& instruction : function->getEntryBlock()) {
+    auto slot = dyn_cast<AllocaInst>(&instruction);
+    if (slot != nullptr && slot->getAllocatedType()->isArrayTy()) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+void CodeGenerator::mark_tail_call(CallInst* call) {
+  auto function = current_function_.value_or_die();
+  // A tail call promises that the callee doesn't read the frame of the
+  // caller, and a `musttail' one reuses it: not with a slice of its arrays.
+  if (has_stack_arrays(function)) {
+    for (unsigned i = 0; i < call->getNumArgOperands(); ++i) {
+      if (holds_pointer(call->getArgOperand(i)->getType())) return;
+    }
+  }
+  auto callee = call->getCalledFunction();
+  // With the same signature, the caller's frame can always be reused: the
+  // tail call is guaranteed, even without optimizations.
+  bool same_signature =
+      callee != nullptr &&
+      callee->getFunctionType() == function->getFunctionType() &&
+      callee->getCallingConv() == function->getCallingConv();
+  call->setTailCallKind(same_signature ? CallInst::TCK_MustTail
+                                       : CallInst::TCK_Tail);
+}
+
 void CodeGenerator::visit(ast::ReturnStatement* node) {
   if (node->value().is_ok()) {
     node->value().value_or_die()->accept(*this);
     assert(gen_value_.is_ok() && "No value generated by the visitor");
-    ir_builder_.CreateRet(gen_value_.value_or_die());
+    auto function = current_function_.value_or_die();
+    auto value = gen_value_.value_or_die();
+    // Only `return f(...);': a call whose value was bound to a variable is
+    // not in tail position, and must be right before the `ret'.
+    auto call = dyn_cast<CallInst>(value);
+    if (call != nullptr &&
+        node->value().value_or_die()->node_type() ==
+            ast::NodeType::FUNCTION_CALL &&
+        &ir_builder_.GetInsertBlock()->back() == call)
+      mark_tail_call(call);
+    if (function->getReturnType()->isVoidTy())
+      // return f(); where f returns nothing.
+      ir_builder_.CreateRetVoid();
+    else
+      ir_builder_.CreateRet(cast_to(value, function->getReturnType()));
   } else {
     ir_builder_.CreateRetVoid();
   }
@@ -39,20 +97,25 @@ void CodeGenerator::visit(ast::ReturnStatement* node) {
   has_returned_ = true;
 }
 
+Value* CodeGenerator::generate_condition(ast::Value* node) {
+  node->accept(*this);
+  CHECK(gen_value_.is_ok()) << "Condition with no value";
+  Value* value = gen_value_.value_or_die();
+  // Compare the integers with 0, unless it is already a boolean.
+  if (value->getType()->isIntegerTy(1)) return value;
+  return ir_builder_.CreateICmpNE(value,
+                                  Constant::getNullValue(value->getType()));
+}
+
 void CodeGenerator::visit(ast::IfStatement* node) {
   CHECK(current_function_.is_ok())
       << "IfStatement can't live outside of function";
   auto current_function = current_function_.value_or_die();
 
+  auto equality = generate_condition(node->condition().get());
+  // The condition may have created blocks: branch from the last one.
   auto if_start_block = ir_builder_.GetInsertBlock();
 
-  node->condition()->accept(*this);
-  CHECK(gen_value_.is_ok()) << "If condition with no value";
-  Value* condition_value = gen_value_.value_or_die();
-  // Create the initial comparison.
-  auto equality =
-      ir_builder_.CreateICmpNE(condition_value, ir_builder_.getInt32(0));
-
   // We generate the if block.
   BasicBlock* if_block =
       BasicBlock::Create(context_, "if.true", current_function);
@@ -0,0 +1,62 @@
+#include "codegen/codegen.h"
+
+#include "ast/array_type.h"
+#include "ast/builtin_type.h"
+#include "ast/variable_declaration.h"
+#include "util/logging.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+
+void CodeGenerator::init_builtin_types() {
+  types_[&ast::types::void_type] = Type::getVoidTy(context_);
+  types_[&ast::types::boolean] = Type::getInt1Ty(context_);
+  types_[&ast::types::int8] = Type::getInt8Ty(context_);
+  types_[&ast::types::int16] = Type::getInt16Ty(context_);
+  types_[&ast::types::int32] = Type::getInt32Ty(context_);
+  types_[&ast::types::int64] = Type::getInt64Ty(context_);
+}
+
+Type* CodeGenerator::get_llvm_type(const ast::Type& type) {
+  CHECK(type.is_resolved()) << "Type " << type.to_string()
+                            << " should be resolved";
+  auto declaration = type.get_declaration();
+  auto type_itr = types_.find(declaration);
+  if (type_itr != std::end(types_)) return type_itr->second;
+
+  // The array and slice types are created when they are first used.
+  auto element = ast::types::element_type(declaration);
+  CHECK(element != nullptr) << "No LLVM type for " << type.to_string();
+  auto element_type = get_llvm_type(ast::Type(element));
+  Type* llvm_type = nullptr;
+  if (auto array = ast::types::as_array(declaration)) {
+    llvm_type = llvm::ArrayType::get(element_type, array->size());
+  } else {
+    // A pointer to the first element, and the length.
+    llvm_type = StructType::get(
+        context_, {element_type->getPointerTo(), Type::getInt64Ty(context_)});
+  }
+  types_[declaration] = llvm_type;
+  return llvm_type;
+}
+
+Type* CodeGenerator::get_variable_type(ast::VariableDeclaration* node) {
+  if (node->type().is_ok()) return get_llvm_type(node->type().value_or_die());
+  // Without a type, the variable has the type of its value.
+  CHECK(node->value().is_ok()) << "Variable without type nor value";
+  auto& value_type = node->value().value_or_die()->type();
+  CHECK(value_type.is_ok()) << "The value of " << node->id().to_string()
+                            << " should be typed";
+  return get_llvm_type(value_type.value_or_die());
+}
+
+Value* CodeGenerator::cast_to(Value* value, Type* type) {
+  if (value->getType() == type) return value;
+  CHECK(value->getType()->isIntegerTy() && type->isIntegerTy())
+      << "Only integers can be converted";
+  // All the integers are signed.
+  return ir_builder_.CreateSExtOrTrunc(value, type);
+}
+
+}  // namespace codegen
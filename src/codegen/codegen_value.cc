@@ -1,15 +1,16 @@
 #include "codegen/codegen.h"
 #include "ast/int_constant.h"
 #include "ast/return_statement.h"
+#include "util/logging.h"
 
 namespace codegen {
 
 using namespace llvm;  // NOLINT
 
 void CodeGenerator::visit(ast::IntConstant* node) {
-  gen_value_ =
-      llvm::Constant::getIntegerValue(llvm::IntegerType::get(context_, 32),
-                                      llvm::APInt(32, node->value(), true));
+  CHECK(node->type().is_ok()) << "Integer constant should be typed";
+  auto type = get_llvm_type(node->type().value_or_die());
+  gen_value_ = llvm::ConstantInt::get(type, node->value(), /*isSigned=*/true);
 }
 
 }  // namespace codegen
@@ -1,5 +1,11 @@
 #include "codegen/codegen.h"
 
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/Transforms/Utils/PromoteMemToReg.h"
+
+#include "ast/array_type.h"
+#include "ast/assignment.h"
 #include "ast/local_variable_declaration.h"
 #include "ast/value.h"
 #include "ast/variable_reference.h"
@@ -8,26 +14,139 @@
 namespace codegen {
 using namespace llvm;  // NOLINT
 
+namespace {
+
+// Collects the variables that are assigned.
+class AssignmentFinder : public ast::ASTVisitor {
+ public:
+  explicit AssignmentFinder(
+      std::unordered_set<const ast::Declaration*>* assigned_variables)
+      : assigned_variables_(assigned_variables) {}
+
+  void visit(ast::Assignment* node) override {
+    auto& target = node->target();
+    if (target.is_resolved())
+      assigned_variables_->insert(target.resolution().value_or_die());
+    ASTVisitor::visit(node);
+  }
+
+ private:
+  std::unordered_set<const ast::Declaration*>* assigned_variables_;
+};
+
+}  // namespace
+
+void CodeGenerator::find_assigned_variables(ast::Module* node) {
+  assigned_variables_.clear();
+  AssignmentFinder finder(&assigned_variables_);
+  node->accept(finder);
+}
+
+bool CodeGenerator::needs_stack_slot(const ast::Declaration* node,
+                                     Type* type) const {
+  return assigned_variables_.count(node) != 0 || type->isArrayTy();
+}
+
+AllocaInst* CodeGenerator::create_stack_slot(Type* type,
+                                             const std::string& name) {
+  // In the entry block, where they can be promoted.
+  auto& entry = current_function_.value_or_die()->getEntryBlock();
+  IRBuilder<> builder(&entry, entry.begin());
+  return builder.CreateAlloca(type, nullptr, name);
+}
+
+void CodeGenerator::promote_stack_slots(Function* function) {
+  // Like mem2reg, which doesn't run without optimizations: all the slots are
+  // in the entry block, in a deterministic order.
+  slots_.clear();
+  std::vector<AllocaInst*> promoted;
+  for (auto& instruction : function->getEntryBlock()) {
+    auto slot = dyn_cast<AllocaInst>(&instruction);
+    if (slot != nullptr && isAllocaPromotable(slot)) promoted.push_back(slot);
+  }
+  if (promoted.empty()) return;
+  DominatorTree dominators(*function);
+  PromoteMemToReg(promoted, dominators);
+}
+
+void CodeGenerator::visit(ast::Assignment* node) {
+  auto& target = node->target();
+  CHECK(target.resolution().is_ok()) << "Resolution should be done";
+  auto declaration = target.resolution().value_or_die();
+  if (node->index().is_ok()) {
+    auto address = generate_element_address(
+        &target, node->index().value_or_die().get());
+    auto element = ast::types::element_type(
+        target.type().value_or_die().get_declaration());
+    ir_builder_.CreateStore(
+        generate_operand(node->value().get(), get_llvm_type(ast::Type(element))),
+        address);
+    return;
+  }
+  auto type =
+      get_variable_type(static_cast<ast::VariableDeclaration*>(declaration));
+  auto value = generate_operand(node->value().get(), type);
+
+  auto slot = slots_.find(declaration);
+  if (slot != std::end(slots_)) {
+    ir_builder_.CreateStore(value, slot->second);
+    return;
+  }
+  auto global_var = module_->getNamedGlobal(target.id().to_string());
+  CHECK(global_var != nullptr) << "Assigned variable should be in scopes";
+  ir_builder_.CreateStore(value, global_var);
+}
+
 void CodeGenerator::visit(ast::LocalVariableDeclaration* node) {
   auto var_name = node->id().to_string();
 
-  if (current_function_.is_ok()) {
-    // Scoped variable to put on the stack.
-    auto alloca = ir_builder_.CreateAlloca(IntegerType::get(context_, 32),
-                                           nullptr, var_name);
-    variables_[node] = alloca;
+  auto type = get_variable_type(node);
 
+  if (current_function_.is_ok()) {
+    // Scoped variable: there is no way to take the address of a variable, so
+    // if it is never assigned, it is its value, in SSA form. The assigned
+    // ones are on the stack until the end of the function, which builds
+    // their PHIs at the joins. So are the arrays, for their elements.
+    Value* value = UndefValue::get(type);
     if (node->value().is_ok()) {
       node->value().value_or_die()->accept(*this);
       CHECK(gen_value_.is_ok())
           << "The variable assignment should have generate a value";
-      ir_builder_.CreateStore(gen_value_.value_or_die(), alloca);
+      value = cast_to(gen_value_.value_or_die(), type);
+    }
+    if (needs_stack_slot(node, type)) {
+      auto slot = create_stack_slot(type, var_name);
+      if (node->value().is_ok()) ir_builder_.CreateStore(value, slot);
+      slots_[node] = slot;
+      return;
     }
+    // Name the instruction after the variable, unless it is another one.
+    if (isa<Instruction>(value) && !value->hasName()) value->setName(var_name);
+    variables_[node] = value;
   } else {
-    // We have to declare a global variable.
-    module_->getOrInsertGlobal(var_name, IntegerType::get(context_, 32));
-    auto global_var = module_->getNamedGlobal(var_name);
-    global_var->setLinkage(GlobalValue::CommonLinkage);
+    // We have to declare a global variable. Its value has to be a constant:
+    // the instructions generated for it (e.g. calls) go to a block outside
+    // of any function, that is thrown away. Otherwise, it is an error.
+    Constant* initializer = Constant::getNullValue(type);
+    if (node->value().is_ok()) {
+      std::unique_ptr<BasicBlock> initializer_block(
+          BasicBlock::Create(context_));
+      ir_builder_.SetInsertPoint(initializer_block.get());
+      node->value().value_or_die()->accept(*this);
+      CHECK(gen_value_.is_ok())
+          << "The variable assignment should have generate a value";
+      auto value = cast_to(gen_value_.value_or_die(), type);
+      // The constant folder computed the scalars: this is an array.
+      if (isa<Constant>(value))
+        initializer = cast<Constant>(value);
+      else
+        add_error(node->location(), "The value of the global variable `" +
+                                        var_name +
+                                        "' can't be computed at compile time");
+      ir_builder_.ClearInsertionPoint();
+    }
+    new GlobalVariable(*module_, type, /*isConstant=*/!node->is_mutable(),
+                       GlobalValue::ExternalLinkage, initializer, var_name);
   }
 }
 
@@ -38,6 +157,12 @@ void CodeGenerator::visit(ast::VariableReference* node) {
 
   auto declaration = node->resolution().value_or_die();
 
+  auto slot_itr = slots_.find(declaration);
+  if (slot_itr != std::end(slots_)) {
+    gen_value_ = ir_builder_.CreateLoad(slot_itr->second, var_name);
+    return;
+  }
+
   auto var_itr = variables_.find(declaration);
   auto arg_itr = functions_args_.find(declaration);
   auto global_var = module_->getNamedGlobal(var_name);
@@ -47,9 +172,9 @@ void CodeGenerator::visit(ast::VariableReference* node) {
       << "Variable reference should be in scopes";
 
   if (var_itr != std::end(variables_)) {
-    gen_value_ = ir_builder_.CreateLoad(var_itr->second);
+    gen_value_ = var_itr->second;
   } else if (global_var != nullptr) {
-    gen_value_ = global_var;
+    gen_value_ = ir_builder_.CreateLoad(global_var);
   } else {
     gen_value_ = arg_itr->second;
   }
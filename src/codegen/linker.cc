@@ -0,0 +1,70 @@
+#include "codegen/linker.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/Linker/Linker.h"
+
+#include "util/logging.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+
+namespace {
+
+// The files can't refer to the global variables of the other files: they
+// don't clash when linked.
+void make_globals_private(Module* module) {
+  for (auto& variable : module->globals()) {
+    if (!variable.isDeclaration())
+      variable.setLinkage(GlobalValue::InternalLinkage);
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<Module> link_program(
+    std::vector<std::unique_ptr<Module>> modules,
+    const std::vector<std::string>& exports, raw_ostream* errors) {
+  CHECK(!modules.empty()) << "No module to link";
+  // The module defining each public function, to report the duplicates
+  // before the linker does.
+  std::unordered_map<std::string, std::string> definitions;
+  bool duplicates = false;
+  for (const auto& module : modules) {
+    make_globals_private(module.get());
+    for (const auto& function : *module) {
+      if (function.isDeclaration() || function.hasLocalLinkage()) continue;
+      auto inserted = definitions.emplace(function.getName().str(),
+                                          module->getModuleIdentifier());
+      if (inserted.second) continue;
+      *errors << "The function `" << function.getName() << "' is defined in "
+              << inserted.first->second << " and in "
+              << module->getModuleIdentifier() << '\n';
+      duplicates = true;
+    }
+  }
+  if (duplicates) return nullptr;
+
+  auto program = std::move(modules.front());
+  Linker linker(*program);
+  for (auto module = std::next(std::begin(modules));
+       module != std::end(modules); ++module) {
+    auto name = (*module)->getModuleIdentifier();
+    // The linker renames the clashing internal functions.
+    CHECK(!linker.linkInModule(std::move(*module))) << "Could not link "
+                                                     << name;
+  }
+
+  for (auto& function : *program) {
+    if (function.isDeclaration() || function.hasLocalLinkage()) continue;
+    if (std::find(std::begin(exports), std::end(exports),
+                  function.getName().str()) == std::end(exports))
+      function.setLinkage(GlobalValue::InternalLinkage);
+  }
+  return program;
+}
+
+}  // namespace codegen
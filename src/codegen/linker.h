@@ -0,0 +1,27 @@
+#pragma once
+
+/// This file contains the whole-program mode: the modules of all the files
+/// are linked into one, so that the optimizer sees across the files.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace codegen {
+
+/// Link the modules, generated in the same context, into one program.
+///
+/// The global variables are private to their file. Once linked, the functions
+/// that are not in `exports` are internalized, so that the optimizer can
+/// inline them in the other files and remove the unused ones.
+///
+/// Returns null and prints the problems to `errors` if a public function is
+/// defined in several modules.
+std::unique_ptr<llvm::Module> link_program(
+    std::vector<std::unique_ptr<llvm::Module>> modules,
+    const std::vector<std::string>& exports, llvm::raw_ostream* errors);
+
+}  // namespace codegen
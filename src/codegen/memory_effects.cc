@@ -0,0 +1,149 @@
+#include "codegen/memory_effects.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ast/array_access.h"
+#include "ast/array_type.h"
+#include "ast/assignment.h"
+#include "ast/function_call.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/variable_reference.h"
+#include "visitor/visitor.h"
+
+namespace codegen {
+
+using Effect = MemoryEffects::Effect;
+using Effects = MemoryEffects::Effects;
+
+namespace {
+
+// Looks for the accesses to the mutable globals, and the calls, in the body
+// of a function.
+class MemoryAccessFinder : public ast::ASTVisitor {
+ public:
+  MemoryAccessFinder(
+      const std::unordered_set<const ast::Declaration*>& mutable_globals,
+      ast::FunctionDeclaration* function)
+      : mutable_globals_(mutable_globals), function_(function) {}
+
+  void visit(ast::Assignment* node) override {
+    if (is_mutable_global(&node->target())) effects_.globals = Effect::WRITE;
+    ASTVisitor::visit(node);
+  }
+
+  void visit(ast::VariableReference* node) override {
+    if (is_mutable_global(node))
+      effects_.globals = std::max(effects_.globals, Effect::READ);
+  }
+
+  void visit(ast::ArrayIndex* node) override {
+    const auto& type = node->base()->type();
+    if (type.is_ok() &&
+        ast::types::as_slice(type.value_or_die().get_declaration()) != nullptr)
+      effects_.reads_slices = true;
+    ASTVisitor::visit(node);
+  }
+
+  void visit(ast::FunctionCall* node) override {
+    // The recursive calls don't add any effect.
+    if (node->function().is_ok() &&
+        node->function().value_or_die() != function_)
+      callees_.push_back(node->function().value_or_die());
+    ASTVisitor::visit(node);
+  }
+
+  void visit(ast::FunctionDeclaration* node) override {
+    // A nested function only has effects when it is called.
+    if (node == function_) ASTVisitor::visit(node);
+  }
+
+  const Effects& effects() const { return effects_; }
+  const std::vector<ast::FunctionDeclaration*>& callees() const {
+    return callees_;
+  }
+
+ private:
+  bool is_mutable_global(ast::VariableReference* node) const {
+    return node->is_resolved() &&
+           mutable_globals_.count(node->resolution().value_or_die()) != 0;
+  }
+
+  const std::unordered_set<const ast::Declaration*>& mutable_globals_;
+  ast::FunctionDeclaration* function_;
+  Effects effects_;
+  std::vector<ast::FunctionDeclaration*> callees_;
+};
+
+// Looks for an assignment to a mutable global anywhere in the module.
+class GlobalWriteFinder : public ast::ASTVisitor {
+ public:
+  explicit GlobalWriteFinder(
+      const std::unordered_set<const ast::Declaration*>& mutable_globals)
+      : mutable_globals_(mutable_globals) {}
+
+  void visit(ast::Assignment* node) override {
+    auto& target = node->target();
+    if (target.is_resolved() &&
+        mutable_globals_.count(target.resolution().value_or_die()) != 0)
+      found_ = true;
+  }
+
+  bool found() const { return found_; }
+
+ private:
+  const std::unordered_set<const ast::Declaration*>& mutable_globals_;
+  bool found_ = false;
+};
+
+}  // namespace
+
+MemoryEffects::MemoryEffects(ast::Module* module) {
+  for (const auto& declaration : module->top_level_declarations()) {
+    if (declaration->node_type() != ast::NodeType::LOCAL_VARIABLE_DECLARATION)
+      continue;
+    auto variable =
+        static_cast<ast::LocalVariableDeclaration*>(declaration.get());
+    if (variable->is_mutable()) mutable_globals_.insert(variable);
+  }
+  if (mutable_globals_.empty()) return;
+  GlobalWriteFinder finder(mutable_globals_);
+  module->accept(finder);
+  globals_written_ = finder.found();
+}
+
+Effects MemoryEffects::effects(ast::FunctionDeclaration* function) {
+  auto known = effects_.find(function);
+  if (known != std::end(effects_)) {
+    if (known->second.first == State::DONE) return known->second.second;
+    // Mutual recursion: assume the worst.
+    Effects worst;
+    worst.globals = globals_written_ ? Effect::WRITE : Effect::READ;
+    worst.reads_slices = true;
+    return worst;
+  }
+  if (function->is_extern()) {
+    // Defined elsewhere: it can call back the public functions. A pure
+    // function can still read the slices.
+    Effects external;
+    external.globals = function->is_pure() ? Effect::NONE : Effect::WRITE;
+    external.reads_slices = true;
+    effects_[function] = {State::DONE, external};
+    return external;
+  }
+  effects_[function] = {State::IN_PROGRESS, Effects()};
+
+  MemoryAccessFinder finder(mutable_globals_, function);
+  function->accept(finder);
+  Effects effects = finder.effects();
+  for (auto callee : finder.callees()) {
+    if (effects.globals == Effect::WRITE && effects.reads_slices) break;
+    auto callee_effects = this->effects(callee);
+    effects.globals = std::max(effects.globals, callee_effects.globals);
+    effects.reads_slices |= callee_effects.reads_slices;
+  }
+  effects_[function] = {State::DONE, effects};
+  return effects;
+}
+
+}  // namespace codegen
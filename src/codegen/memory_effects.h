@@ -0,0 +1,54 @@
+#pragma once
+
+/// This file contains the analysis of the memory accessed by the functions,
+/// used to give them the readnone/readonly attributes.
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ast/function_declaration.h"
+#include "ast/module.h"
+
+namespace codegen {
+
+/// Finds the functions that access the memory. The local variables are not
+/// memory, only the mutable global variables and the elements of the slices
+/// are: a function is readnone if it doesn't access them (directly or through
+/// its callees), readonly if it only reads them. Constant globals don't count,
+/// LLVM knows they can't change.
+class MemoryEffects {
+ public:
+  /// Ordered from the weakest to the strongest.
+  enum class Effect { NONE, READ, WRITE };
+
+  struct Effects {
+    /// The strongest access to the mutable global variables.
+    Effect globals = Effect::NONE;
+    /// Whether the function reads elements of slices, which point to the
+    /// memory of its callers. They can't be written.
+    bool reads_slices = false;
+
+    /// The strongest access to any memory.
+    Effect memory() const {
+      return reads_slices ? std::max(globals, Effect::READ) : globals;
+    }
+  };
+
+  explicit MemoryEffects(ast::Module* module);
+
+  Effects effects(ast::FunctionDeclaration* function);
+
+ private:
+  enum class State { IN_PROGRESS, DONE };
+
+  std::unordered_set<const ast::Declaration*> mutable_globals_;
+  // Whether any function assigns a mutable global variable.
+  bool globals_written_ = false;
+  std::unordered_map<const ast::FunctionDeclaration*,
+                     std::pair<State, Effects>>
+      effects_;
+};
+
+}  // namespace codegen
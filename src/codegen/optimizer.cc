@@ -0,0 +1,209 @@
+#include "codegen/optimizer.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "llvm/Analysis/CallGraphSCCPass.h"
+#include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/PassInfo.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Instrumentation.h"
+
+#include "codegen/codegen.h"
+#include "util/time_report.h"
+
+namespace codegen {
+
+using namespace llvm;  // NOLINT
+
+namespace {
+
+/// A run of a pass, from its begin marker to its end marker.
+struct PassRun {
+  explicit PassRun(std::string name) : name(std::move(name)) {}
+
+  void begin() {
+    // Ends the previous run first, if its end marker didn't run.
+    phase.reset();
+    phase = std::make_unique<util::ScopedPhase>(name.c_str());
+  }
+  void end() { phase.reset(); }
+
+  std::string name;
+  std::unique_ptr<util::ScopedPhase> phase;
+};
+
+/// A pass of the same kind as the measured one, run right before it (to
+/// begin its phase) or right after it (to end it), in the same nested pass
+/// manager. It changes nothing.
+template <typename Base>
+class Marker : public Base {
+ public:
+  static char ID;
+
+  /// `measured` is the pass after a begin marker, null for an end marker.
+  Marker(std::shared_ptr<PassRun> run, const Pass* measured)
+      : Base(ID), run_(std::move(run)), measured_(measured) {}
+
+  void getAnalysisUsage(AnalysisUsage& usage) const override {
+    // The analyses of the measured pass run before its phase.
+    if (measured_ != nullptr)
+      measured_->getAnalysisUsage(usage);
+    else
+      Base::getAnalysisUsage(usage);
+    usage.setPreservesAll();
+  }
+
+ protected:
+  bool mark() {
+    if (measured_ != nullptr)
+      run_->begin();
+    else
+      run_->end();
+    return false;
+  }
+
+ private:
+  std::shared_ptr<PassRun> run_;
+  const Pass* measured_;
+};
+
+template <typename Base>
+char Marker<Base>::ID = 0;
+
+class ModuleMarker : public Marker<ModulePass> {
+ public:
+  using Marker::Marker;
+  bool runOnModule(Module& /*module*/) override { return mark(); }
+};
+
+class FunctionMarker : public Marker<FunctionPass> {
+ public:
+  using Marker::Marker;
+  bool runOnFunction(Function& /*function*/) override { return mark(); }
+};
+
+class LoopMarker : public Marker<LoopPass> {
+ public:
+  using Marker::Marker;
+  bool runOnLoop(Loop* /*loop*/, LPPassManager& /*manager*/) override {
+    return mark();
+  }
+};
+
+class SCCMarker : public Marker<CallGraphSCCPass> {
+ public:
+  using Marker::Marker;
+  bool runOnSCC(CallGraphSCC& /*scc*/) override { return mark(); }
+};
+
+/// A marker of the kind of the pass, or null if there is none.
+Pass* create_marker(PassKind kind, std::shared_ptr<PassRun> run,
+                    const Pass* measured) {
+  switch (kind) {
+    case PT_Module:
+      return new ModuleMarker(std::move(run), measured);
+    case PT_Function:
+      return new FunctionMarker(std::move(run), measured);
+    case PT_Loop:
+      return new LoopMarker(std::move(run), measured);
+    case PT_CallGraphSCC:
+      return new SCCMarker(std::move(run), measured);
+    default:
+      return nullptr;
+  }
+}
+
+/// Records each pass, when it runs, as a phase of the active TimeReport and
+/// as a trace event (see util::ScopedPhase). The legacy pass managers have
+/// no instrumentation: the passes are surrounded by markers.
+template <typename Manager>
+class InstrumentedPassManager : public Manager {
+ public:
+  using Manager::Manager;
+
+  void add(Pass* pass) override {
+    // The immutable passes don't run, and an analysis that is already
+    // available is dropped: they are counted in the enclosing phase.
+    auto info = Pass::lookupPassInfo(pass->getPassID());
+    if ((util::TimeReport::active() == nullptr &&
+         util::Tracer::active() == nullptr) ||
+        pass->getAsImmutablePass() != nullptr ||
+        (info != nullptr && info->isAnalysis())) {
+      Manager::add(pass);
+      return;
+    }
+    auto kind = pass->getPassKind();
+    auto run = std::make_shared<PassRun>(std::string(pass->getPassName()));
+    auto begin = create_marker(kind, run, pass);
+    if (begin == nullptr) {
+      Manager::add(pass);
+      return;
+    }
+    Manager::add(begin);
+    Manager::add(pass);
+    Manager::add(create_marker(kind, std::move(run), nullptr));
+  }
+};
+
+}  // namespace
+
+void optimize(Module* module, unsigned level) {
+  if (level == 0) return;
+  // Without the target, the vectorizers see no vector registers.
+  auto target_machine = create_target_machine(module->getTargetTriple());
+  auto target_analysis = createTargetTransformInfoWrapperPass(
+      target_machine->getTargetIRAnalysis());
+
+  PassManagerBuilder builder;
+  builder.OptLevel = level;
+  builder.Inliner = createFunctionInliningPass(level, 0);
+  builder.LoopVectorize = level >= 2;
+  builder.SLPVectorize = level >= 2;
+
+  InstrumentedPassManager<legacy::FunctionPassManager> function_passes(
+      module);
+  function_passes.add(createTargetTransformInfoWrapperPass(
+      target_machine->getTargetIRAnalysis()));
+  builder.populateFunctionPassManager(function_passes);
+  function_passes.doInitialization();
+  for (auto& function : *module) function_passes.run(function);
+  function_passes.doFinalization();
+
+  InstrumentedPassManager<legacy::PassManager> module_passes;
+  module_passes.add(target_analysis);
+  builder.populateModulePassManager(module_passes);
+  module_passes.run(*module);
+}
+
+bool apply_profile(Module* module, const ProfileOptions& options,
+                   raw_ostream* errors) {
+  legacy::PassManager passes;
+  if (options.generate) {
+    // The counters are memory written by all the functions.
+    for (auto& function : *module) {
+      function.removeFnAttr(Attribute::ReadNone);
+      function.removeFnAttr(Attribute::ReadOnly);
+    }
+    passes.add(createPGOInstrumentationGenPass());
+    // Turn the counters into globals, written by the profile runtime.
+    passes.add(createInstrProfilingPass());
+  }
+  if (!options.use.empty()) {
+    // LLVM reports a missing profile by exiting.
+    if (!std::ifstream(options.use)) {
+      *errors << "Could not read the profile " << options.use << '\n';
+      return false;
+    }
+    passes.add(createPGOInstrumentationUsePass(options.use));
+  }
+  passes.run(*module);
+  return true;
+}
+
+}  // namespace codegen
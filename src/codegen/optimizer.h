@@ -0,0 +1,38 @@
+#pragma once
+
+/// This file contains the optimization of the generated IR, with the
+/// standard LLVM pipeline, optionally guided by a profile.
+
+#include <string>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace codegen {
+
+/// Run the LLVM pipeline of the optimization level (like `opt -O<level>`) on
+/// the module, with the inliner and the loop and SLP vectorizers from -O2.
+/// The costs are the ones of the target of the module. Each pass is a phase
+/// of the active util::TimeReport, and a trace event.
+void optimize(llvm::Module* module, unsigned level);
+
+/// The profile-guided optimization, like clang's -fprofile-generate and
+/// -fprofile-use, at the IR level.
+struct ProfileOptions {
+  /// Count the executions of the edges of the functions. The instrumented
+  /// program writes them to `default.profraw' (or $LLVM_PROFILE_FILE) when
+  /// linked with the profile runtime, e.g. by `clang -fprofile-generate'.
+  bool generate = false;
+  /// The profile merged by `llvm-profdata merge', if not empty: it gives the
+  /// branch weights and the function entry counts.
+  std::string use;
+};
+
+/// Instrument the module, or annotate it with the profile. It runs before
+/// the optimization, so that the functions have the same shape when the
+/// profile is generated and when it is used. Returns false and prints the
+/// problems to `errors' if the profile can't be read.
+bool apply_profile(llvm::Module* module, const ProfileOptions& options,
+                   llvm::raw_ostream* errors);
+
+}  // namespace codegen
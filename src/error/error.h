@@ -1,15 +1,22 @@
 #pragma once
 
+#include <cassert>
 #include <memory>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "util/option.h"
 #include "util/variant.h"
 
 // Error utilities.
 
+namespace lexer {
+struct Range;
+}  // namespace lexer
+
 /// Base error interface.
 /// All error classes must derive from this one.
 class Error {
@@ -31,13 +38,16 @@ class GenericError : public Error {
   /// Return the error message it was constructed with.
   std::string to_string() const override { return message(); }
 
-  ~GenericError() override = default;
-
- protected:
-  /// Access to the field containing the error message passed to the
-  /// constructor.
+  /// The message passed to the constructor, without the location that
+  /// to_string may add.
   std::string message() const { return message_; }
 
+  /// The range of the source that the error is about, or null: the language
+  /// server reports the errors there.
+  virtual const lexer::Range* range() const { return nullptr; }
+
+  ~GenericError() override = default;
+
  private:
   const std::string message_;
 };
@@ -60,8 +70,26 @@ using enable_if_base_of = typename std::enable_if<
     std::is_base_of<Base, typename std::decay<Derived>::type>::value>;
 }  // namespace internals
 
+/// Mark a function whose ErrorOr/MaybeError result must be checked.
+#if defined(__GNUC__) || defined(__clang__)
+#define MUST_USE_RESULT __attribute__((warn_unused_result))
+#else
+#define MUST_USE_RESULT
+#endif
+
+/// Error taken out of an ErrorOr or a MaybeError, to be propagated to the
+/// caller without copying it (and without slicing it to the caller's error
+/// type). Only produced by release_error(), see RETURN_IF_ERROR.
+template <typename Err>
+struct PropagatedError {
+  std::unique_ptr<Err> error;
+};
+
 /// Represents either an error or a Value.
 /// This class is immutable (but the Value can be mutable).
+///
+/// The value is stored inline: the success path never allocates, and errors
+/// (the rare case) are only built when they happen.
 template <typename Value, typename Err = GenericError>
 class ErrorOr {
   static_assert(std::is_base_of<Error, Err>::value,
@@ -84,21 +112,39 @@ class ErrorOr {
   template <typename E>
   ErrorOr(E error,  // NOLINT: explicit
           typename enable_if_error<E>::type* /*unused*/ = nullptr)
-      : variant_(std::make_unique<Err>(std::move(error))) {}
+      : error_(std::make_unique<E>(std::move(error))), has_value_(false) {}
+
+  /// Take over an error propagated from another ErrorOr or MaybeError.
+  template <typename E>
+  ErrorOr(PropagatedError<E> error,  // NOLINT: explicit
+          typename enable_if_error<E>::type* /*unused*/ = nullptr)
+      : error_(std::move(error.error)), has_value_(false) {
+    assert(error_ && "Propagating an empty error");
+  }
 
   /// Construct a value directly.
   template <typename T, typename = typename std::enable_if<
                             std::is_constructible<Value, T&&>::value>::type>
   ErrorOr(T value)  // NOLINT: explicit
-      : variant_(Value(std::move(value))) {}
+      : has_value_(true) {
+    new (&value_) Value(std::move(value));
+  }
 
   // Move constructor.
+  ErrorOr(ErrorOr&& other) noexcept(
+      std::is_nothrow_move_constructible<Value>::value)
+      : error_(std::move(other.error_)), has_value_(other.has_value_) {
+    if (has_value_) new (&value_) Value(std::move(other.value_));
+  }
+
   template <typename T, typename E,
             typename = typename std::enable_if<
                 std::is_constructible<Value, T&&>::value>::type,
             typename = typename enable_if_error<E>::type>
   ErrorOr(ErrorOr<T, E>&& other)  // NOLINT: explicit
-      : variant_(std::move(other.variant_)) {}
+      : error_(std::move(other.error_)), has_value_(other.has_value_) {
+    if (has_value_) new (&value_) Value(std::move(other.value_));
+  }
 
   // Move assignment.
   template <typename T, typename E,
@@ -107,29 +153,57 @@ class ErrorOr {
             typename = typename std::enable_if<
                 std::is_constructible<Err, E&&>::value>::type>
   ErrorOr& operator=(ErrorOr<T, E>&& other) {
-    variant_ = std::move(other.variant_);
+    if (static_cast<void*>(this) == static_cast<void*>(&other)) return *this;
+    destroy_value();
+    error_ = std::move(other.error_);
+    has_value_ = other.has_value_;
+    if (has_value_) new (&value_) Value(std::move(other.value_));
     return *this;
   }
 
+  ErrorOr& operator=(ErrorOr&& other) {
+    return operator=<Value, Err>(std::move(other));
+  }
+
   // Copy constructor.
   ErrorOr(const ErrorOr& other) = delete;
   // Copy assignment.
   ErrorOr& operator=(const ErrorOr& other) = delete;
 
+  ~ErrorOr() { destroy_value(); }
+
   /// Check whether it is an error or a value.
-  bool is_ok() const { return variant_.template is<Value>(); }
+  bool is_ok() const { return has_value_; }
 
   /// Return the value if it is one, fail otherwise.
-  Value& value_or_die() { return variant_.template get<Value>(); }
+  Value& value_or_die() {
+    if (ERROR_UNLIKELY(!is_ok())) throw_bad_access("value_or_die");
+    return value_;
+  }
 
   /// Return the value if it is one, fail otherwise.
-  const Value& value_or_die() const { return variant_.template get<Value>(); }
+  const Value& value_or_die() const {
+    if (ERROR_UNLIKELY(!is_ok())) throw_bad_access("value_or_die");
+    return value_;
+  }
 
   /// Gives ownership of the value if it is one, fail otherwise.
-  Value consume_value_or_die() { return variant_.template consume<Value>(); }
+  Value consume_value_or_die() {
+    if (ERROR_UNLIKELY(!is_ok())) throw_bad_access("consume_value_or_die");
+    return std::move(value_);
+  }
 
   /// Return the error if it is one, fail otherwise.
-  const Err& error_or_die() const { return *variant_.template get<ErrPtr>(); }
+  const Err& error_or_die() const {
+    if (ERROR_UNLIKELY(!error_)) throw_bad_access("error_or_die");
+    return *error_;
+  }
+
+  /// Give up ownership of the error, to propagate it. Must be an error.
+  PropagatedError<Err> release_error() {
+    assert(!is_ok() && "release_error() called on a value");
+    return {std::move(error_)};
+  }
 
   /// Return the error if it is one, otherwise return "Ok".
   std::string to_string() const {
@@ -138,7 +212,20 @@ class ErrorOr {
   }
 
  private:
-  Variant<Value, ErrPtr> variant_;
+  void destroy_value() {
+    if (is_ok()) value_.~Value();
+  }
+
+  static void throw_bad_access(const char* method) {
+    throw BadVariantAccess(std::string("in ErrorOr::") + method + "()");
+  }
+
+  // Null when holding a value, or once the error was released.
+  ErrPtr error_;
+  bool has_value_;
+  union {
+    Value value_;
+  };
 
   // Friend other implementations of that class, for the move
   // constructor/assignment.
@@ -160,36 +247,56 @@ class MaybeError {
   using enable_if_error = internals::enable_if_base_of<Err, E>;
 
   // Constructor for no error.
-  MaybeError() : error_or_() {}
+  MaybeError() = default;
 
-  // Inherit the constructors.
+  // Construct an error from a subtype of Err.
   template <typename E>
   MaybeError(  // NOLINT: explicit
       E&& value,
-      typename std::enable_if<
-          std::is_constructible<Err, E&&>::value>::type* /*unused*/ = nullptr)
-      : error_or_(std::make_unique<Err>(std::forward<E>(value))) {}
+      typename enable_if_error<E>::type* /*unused*/ = nullptr)
+      : error_(std::make_unique<typename std::decay<E>::type>(
+            std::forward<E>(value))) {}
+
+  /// Take over an error propagated from another ErrorOr or MaybeError.
+  template <typename E>
+  MaybeError(  // NOLINT: explicit
+      PropagatedError<E> error,
+      typename enable_if_error<E>::type* /*unused*/ = nullptr)
+      : error_(std::move(error.error)) {
+    assert(error_ && "Propagating an empty error");
+  }
+
+  MaybeError(MaybeError&& other) noexcept = default;
 
   template <typename E>
   MaybeError(  // NOLINT: explicit
       MaybeError<E>&& other,
-      typename std::enable_if<
-          std::is_constructible<Err, E&&>::value>::type* /*unused*/ = nullptr)
-      : error_or_(std::move(other.error_or_)) {}
+      typename enable_if_error<E>::type* /*unused*/ = nullptr)
+      : error_(std::move(other.error_)) {}
 
-  template <typename E, typename = typename std::enable_if<
-                            std::is_constructible<Err, E&&>::value>::type>
+  MaybeError& operator=(MaybeError&& other) noexcept = default;
+
+  template <typename E, typename = typename enable_if_error<E>::type>
   MaybeError& operator=(MaybeError<E>&& other) {
-    error_or_ = std::move(other.error_or_);
+    error_ = std::move(other.error_);
     return *this;
   }
 
   MaybeError(const MaybeError&) = delete;
   MaybeError& operator=(const MaybeError&) = delete;
 
-  // Inherit methods.
-  const Err& error_or_die() const { return *error_or_.value_or_die(); }
-  bool is_ok() const { return !error_or_.is_ok(); }
+  const Err& error_or_die() const {
+    if (ERROR_UNLIKELY(is_ok()))
+      throw BadVariantAccess("in MaybeError::error_or_die()");
+    return *error_;
+  }
+  bool is_ok() const { return !error_; }
+
+  /// Give up ownership of the error, to propagate it. Must be an error.
+  PropagatedError<Err> release_error() {
+    assert(!is_ok() && "release_error() called without an error");
+    return {std::move(error_)};
+  }
 
   std::string to_string() const {
     if (is_ok()) return "Ok";
@@ -197,17 +304,19 @@ class MaybeError {
   }
 
  private:
-  Option<std::unique_ptr<Err>> error_or_;
+  // Null when there is no error.
+  std::unique_ptr<Err> error_;
 
   template <typename E>
   friend class MaybeError;
 };
 
 // Macro to propagate the error from the method called, if it failed.
-#define RETURN_IF_ERROR(CALL)                      \
-  do {                                             \
-    const auto& res = (CALL);                      \
-    if (!res.is_ok()) return {res.error_or_die()}; \
+// The error is moved to the caller, never copied.
+#define RETURN_IF_ERROR(CALL)                                       \
+  do {                                                              \
+    auto&& res = (CALL);                                            \
+    if (ERROR_UNLIKELY(!res.is_ok())) return {res.release_error()}; \
   } while (0)
 
 // These macros are needed because we can't just use res##__LINE__, because
@@ -217,16 +326,16 @@ class MaybeError {
 
 // Macro to either propagate the error from the method called, or assign it to
 // a local variable if it succeeded.
-#define RETURN_OR_ASSIGN(DECL, CALL)                     \
-  const auto& __ERROR_MACRO_VAR(__LINE__) = CALL;        \
-  if (!__ERROR_MACRO_VAR(__LINE__).is_ok())              \
-    return {__ERROR_MACRO_VAR(__LINE__).error_or_die()}; \
+#define RETURN_OR_ASSIGN(DECL, CALL)                        \
+  auto&& __ERROR_MACRO_VAR(__LINE__) = CALL;                \
+  if (ERROR_UNLIKELY(!__ERROR_MACRO_VAR(__LINE__).is_ok())) \
+    return {__ERROR_MACRO_VAR(__LINE__).release_error()};   \
   DECL = __ERROR_MACRO_VAR(__LINE__).value_or_die();  // NOLINT (parenthesis)
 
 // Macro to either propagate the error from the method called, or move it to
 // a local variable if it succeeded.
-#define RETURN_OR_MOVE(DECL, CALL)                       \
-  auto __ERROR_MACRO_VAR(__LINE__) = CALL;               \
-  if (!__ERROR_MACRO_VAR(__LINE__).is_ok())              \
-    return {__ERROR_MACRO_VAR(__LINE__).error_or_die()}; \
+#define RETURN_OR_MOVE(DECL, CALL)                          \
+  auto __ERROR_MACRO_VAR(__LINE__) = CALL;                  \
+  if (ERROR_UNLIKELY(!__ERROR_MACRO_VAR(__LINE__).is_ok())) \
+    return {__ERROR_MACRO_VAR(__LINE__).release_error()};   \
   DECL = __ERROR_MACRO_VAR(__LINE__).consume_value_or_die();  // NOLINT
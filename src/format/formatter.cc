@@ -0,0 +1,71 @@
+#include "format/formatter.h"
+
+#include <ostream>
+#include <streambuf>
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "pretty_printer/pretty_printer.h"
+
+namespace format {
+
+namespace {
+
+/// Appends what is written to a string: the printer writes in the memory
+/// reserved beforehand, and nothing is copied afterwards, unlike with a
+/// std::ostringstream.
+class StringBuffer : public std::streambuf {
+ public:
+  explicit StringBuffer(std::string* out) : out_(out) {}
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+      out_->push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* data, std::streamsize size) override {
+    out_->append(data, static_cast<std::size_t>(size));
+    return size;
+  }
+
+ private:
+  std::string* out_;
+};
+
+MaybeError<> print(const std::string& source, const std::string& filename,
+                   std::string* formatted) {
+  lexer::Lexer lexer(source, lexer::Lexer::SourceTag::STRING, filename);
+  parser::Parser parser(&lexer);
+  RETURN_OR_MOVE(auto module, parser.parse());
+  formatted->clear();
+  // The formatted source is about as long as the source.
+  formatted->reserve(source.size() + source.size() / 8);
+  StringBuffer buffer(formatted);
+  std::ostream out(&buffer);
+  ast::PrettyPrinterVisitor printer(out);
+  printer.set_comments(&parser.comments());
+  printer.set_keep_blank_lines(true);
+  module->accept(printer);
+  return {};
+}
+
+}  // namespace
+
+MaybeError<> format_source(const std::string& source,
+                           const std::string& filename, const Options& options,
+                           std::string* formatted) {
+  RETURN_IF_ERROR(print(source, filename, formatted));
+  if (!options.check_idempotence) return {};
+  std::string again;
+  auto result = print(*formatted, filename + " (formatted)", &again);
+  if (!result.is_ok())
+    return GenericError("The formatted " + filename + " doesn't parse: " +
+                        result.error_or_die().to_string());
+  if (again != *formatted)
+    return GenericError("Formatting " + filename + " is not idempotent");
+  return {};
+}
+
+}  // namespace format
@@ -0,0 +1,30 @@
+#pragma once
+
+/// This file contains the formatter of gHopper sources: the gh-format tool
+/// parses a file and prints it back with the AST pretty printer, comments,
+/// blank lines, compound assignments and grouping parentheses included.
+///
+/// Example:
+/// std::string formatted;
+/// auto result = format::format_source(source, "main.gh", {}, &formatted);
+
+#include <string>
+
+#include "error/error.h"
+
+namespace format {
+
+struct Options {
+  /// Format the output again and check that it didn't change, so that a
+  /// formatted tree stays formatted. It doubles the work.
+  bool check_idempotence = true;
+};
+
+/// Format the source, named filename in the errors, into the string, which is
+/// replaced. An error if the source doesn't parse, or if the formatting is
+/// not idempotent.
+MaybeError<> format_source(const std::string& source,
+                           const std::string& filename, const Options& options,
+                           std::string* formatted);
+
+}  // namespace format
@@ -0,0 +1,115 @@
+#include <libgen.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "format/formatter.h"
+#include "util/gflags_utils.h"
+#include "util/logging.h"
+#include "util/mapped_file.h"
+
+// LCOV_EXCL_START: main is not tested
+
+DEFINE_bool(in_place, false,
+            "Rewrite the FILES that are not formatted, instead of printing "
+            "them to the standard output");
+DEFINE_bool(check, false,
+            "Only print the names of the FILES that are not formatted, and "
+            "fail if there are some (e.g. in a pre-commit hook)");
+DEFINE_bool(check_idempotence, true,
+            "Format the output again, and fail if it changes");
+DEFINE_int32(jobs, 0,
+             "Number of files formatted at once (0 for the number of "
+             "processors)");
+
+namespace {
+
+/// What became of a file, reported once all the files are formatted, in the
+/// order of the command line.
+struct Result {
+  std::string formatted;
+  bool changed = false;
+  std::string error;
+};
+
+Result format_file(const std::string& path, const format::Options& options) {
+  Result result;
+  auto file = util::MappedFile::open(path);
+  if (!file.is_ok()) {
+    result.error = file.error_or_die().to_string();
+    return result;
+  }
+  const auto& mapped = *file.value_or_die();
+  std::string source(mapped.data() == nullptr ? "" : mapped.data(),
+                     mapped.size());
+  auto formatted =
+      format::format_source(source, path, options, &result.formatted);
+  if (!formatted.is_ok()) {
+    result.error = formatted.error_or_die().to_string();
+    return result;
+  }
+  result.changed = result.formatted != source;
+  if (result.changed && FLAGS_in_place) {
+    auto replaced = util::replace_file(path, result.formatted);
+    if (!replaced.is_ok()) result.error = replaced.error_or_die().to_string();
+  }
+  // Only the standard output needs the formatted file afterwards.
+  if (FLAGS_in_place || FLAGS_check) std::string().swap(result.formatted);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      std::string("Format gHopper sources.\n\nUsage: ") + basename(argv[0]) +
+      " [FLAGS] FILES");  // NOLINT
+  gflags::GFlagsWrapper w(&argc, &argv, true);
+
+  if (FLAGS_in_place && FLAGS_check) {
+    LOG(ERROR) << "--in_place and --check can't be combined";
+    return 1;
+  }
+  std::vector<std::string> files(argv + 1, argv + argc);  // NOLINT
+  format::Options options;
+  options.check_idempotence = FLAGS_check_idempotence;
+
+  // The files are independent: each thread takes the next one.
+  std::vector<Result> results(files.size());
+  std::atomic<std::size_t> next{0};
+  auto work = [&]() {
+    for (auto i = next++; i < files.size(); i = next++)
+      results[i] = format_file(files[i], options);
+  };
+  unsigned int jobs =
+      FLAGS_jobs > 0 ? static_cast<unsigned int>(FLAGS_jobs)
+                     : std::max(1u, std::thread::hardware_concurrency());
+  jobs = std::min<unsigned int>(
+      jobs, std::max<std::size_t>(1, files.size()));
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < jobs; ++i) threads.emplace_back(work);
+  work();
+  for (auto& thread : threads) thread.join();
+
+  int exit_code = 0;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    const auto& result = results[i];
+    if (!result.error.empty()) {
+      std::cerr << result.error << '\n';
+      exit_code = 1;
+    } else if (FLAGS_check) {
+      if (result.changed) {
+        std::cout << files[i] << '\n';
+        exit_code = 1;
+      }
+    } else if (!FLAGS_in_place) {
+      std::cout << result.formatted;
+    }
+  }
+  return exit_code;
+}
+
+// LCOV_EXCL_STOP
@@ -0,0 +1,208 @@
+#include "generator/generator.h"
+
+#include <sstream>
+
+namespace generator {
+
+namespace {
+
+const char* const k_operators[] = {"+", "-", "*", "&", "|", "^"};
+constexpr int k_num_operators = sizeof(k_operators) / sizeof(k_operators[0]);
+
+// Probabilities, in percents, of the choices made by the generator.
+constexpr int k_declaration_chance = 40;
+constexpr int k_if_chance = 25;
+constexpr int k_else_if_chance = 25;
+constexpr int k_else_chance = 50;
+constexpr int k_early_return_chance = 30;
+constexpr int k_binary_operation_chance = 60;
+constexpr int k_function_call_chance = 20;
+constexpr int k_variable_chance = 70;
+constexpr int k_hex_chance = 20;
+
+}  // namespace
+
+Generator::Generator(const Options& options)
+    : options_(options), random_(options.seed) {}
+
+void Generator::generate(std::ostream* out) {
+  std::size_t written = 0;
+  for (int index = 0; options_.size != 0 ? written < options_.size
+                                         : index < options_.functions;
+       ++index) {
+    // Generate each declaration in a buffer, to know the size of the output.
+    std::ostringstream buffer;
+    if (index % options_.functions_per_global == 0) generate_global(&buffer);
+    generate_function(&buffer);
+    const std::string declarations = buffer.str();
+    *out << declarations;
+    written += declarations.size();
+  }
+}
+
+void Generator::generate_global(std::ostream* out) {
+  std::string name = identifier();
+  *out << "val " << name << ": Int64 = ";
+  generate_constant(out);
+  *out << ";\n\n";
+  variables_.push_back(std::move(name));
+}
+
+void Generator::generate_function(std::ostream* out) {
+  Function function{identifier(), uniform(0, options_.max_arguments)};
+  const auto globals = variables_.size();
+  *out << "// Function number " << functions_.size() << ".\n";
+  *out << "fun " << function.name << '(';
+  for (int i = 0; i < function.arguments; ++i) {
+    if (i != 0) *out << ", ";
+    std::string name = identifier();
+    *out << (chance(50) ? "val " : "mut ") << name << ": Int64";
+    variables_.push_back(std::move(name));
+  }
+  *out << "): Int64 {\n";
+  generate_block(out, 1, /*must_return=*/true);
+  *out << "}\n\n";
+  variables_.resize(globals);
+  // Only add it now: functions are never recursive.
+  functions_.push_back(std::move(function));
+}
+
+bool Generator::generate_block(std::ostream* out, int depth,
+                               bool must_return) {
+  const auto outer_variables = variables_.size();
+  const int statements = uniform(0, options_.max_statements);
+  bool returned = false;
+  for (int i = 0; i < statements && !returned; ++i) {
+    const int choice = uniform(0, 99);
+    if (choice < k_declaration_chance) {
+      std::string name = identifier();
+      indent(out, depth);
+      *out << (chance(50) ? "val " : "mut ") << name << ": Int64 = ";
+      generate_expression(out, options_.max_expression_depth, false);
+      *out << ";\n";
+      // Only visible after its declaration.
+      variables_.push_back(std::move(name));
+    } else if (choice < k_declaration_chance + k_if_chance &&
+               depth <= options_.max_nesting_depth) {
+      returned = generate_if(out, depth);
+    } else {
+      indent(out, depth);
+      generate_expression(out, options_.max_expression_depth, false);
+      *out << ";\n";
+    }
+  }
+  if (!returned && (must_return || chance(k_early_return_chance))) {
+    indent(out, depth);
+    *out << "return ";
+    generate_expression(out, options_.max_expression_depth, false);
+    *out << ";\n";
+    returned = true;
+  }
+  variables_.resize(outer_variables);
+  return returned;
+}
+
+bool Generator::generate_if(std::ostream* out, int depth) {
+  indent(out, depth);
+  *out << "if (";
+  generate_expression(out, options_.max_expression_depth, false);
+  *out << ") {\n";
+  bool all_returned = generate_block(out, depth + 1, false);
+  indent(out, depth);
+  *out << '}';
+  while (chance(k_else_if_chance)) {
+    *out << " else if (";
+    generate_expression(out, options_.max_expression_depth, false);
+    *out << ") {\n";
+    all_returned &= generate_block(out, depth + 1, false);
+    indent(out, depth);
+    *out << '}';
+  }
+  if (chance(k_else_chance)) {
+    *out << " else {\n";
+    all_returned &= generate_block(out, depth + 1, false);
+    indent(out, depth);
+    *out << '}';
+  } else {
+    all_returned = false;
+  }
+  *out << '\n';
+  return all_returned;
+}
+
+void Generator::generate_expression(std::ostream* out, int depth,
+                                    bool parenthesize) {
+  if (depth > 0 && options_.binary_operations &&
+      chance(k_binary_operation_chance)) {
+    if (parenthesize) *out << '(';
+    generate_expression(out, depth - 1, true);
+    *out << ' ' << k_operators[uniform(0, k_num_operators - 1)] << ' ';
+    generate_expression(out, depth - 1, true);
+    if (parenthesize) *out << ')';
+  } else if (depth > 0 && options_.function_calls && !functions_.empty() &&
+             chance(k_function_call_chance)) {
+    const auto& function =
+        functions_[uniform(0, static_cast<int>(functions_.size()) - 1)];
+    *out << function.name << '(';
+    for (int i = 0; i < function.arguments; ++i) {
+      if (i != 0) *out << ", ";
+      generate_expression(out, depth - 1, false);
+    }
+    *out << ')';
+  } else if (!variables_.empty() && chance(k_variable_chance)) {
+    *out << variables_[uniform(0, static_cast<int>(variables_.size()) - 1)];
+  } else {
+    generate_constant(out);
+  }
+}
+
+void Generator::generate_constant(std::ostream* out) {
+  if (chance(k_hex_chance))
+    *out << "0x" << std::hex << uniform(0, 0xffff) << std::dec;
+  else
+    *out << uniform(0, 1000);
+}
+
+void Generator::indent(std::ostream* out, int depth) {
+  for (int i = 0; i < depth; ++i) *out << "  ";
+}
+
+std::string Generator::identifier() {
+  // A geometric distribution, with the right mean.
+  const int mean_extra =
+      options_.mean_identifier_length - options_.min_identifier_length;
+  const int continue_permille =
+      mean_extra <= 0 ? 0 : 1000 - 1000 / (mean_extra + 1);
+  int length = options_.min_identifier_length;
+  while (length < options_.max_identifier_length &&
+         uniform(0, 999) < continue_permille)
+    ++length;
+
+  // The suffix makes the identifier unique, and different from the keywords.
+  const std::string suffix = std::to_string(next_identifier_++);
+  std::string name(1, static_cast<char>('a' + uniform(0, 25)));
+  for (int i = static_cast<int>(name.size() + suffix.size()); i < length;
+       ++i) {
+    const int c = uniform(0, 36);
+    name += c < 26 ? static_cast<char>('a' + c)
+                   : c < 36 ? static_cast<char>('A' + c - 26) : '_';
+  }
+  return name + suffix;
+}
+
+int Generator::uniform(int min, int max) {
+  // Not std::uniform_int_distribution: its results depend on the standard
+  // library.
+  return min + static_cast<int>(random_() %
+                                static_cast<std::uint32_t>(max - min + 1));
+}
+
+bool Generator::chance(int percent) { return uniform(0, 99) < percent; }
+
+std::string generate(const Options& options) {
+  std::ostringstream out;
+  Generator(options).generate(&out);
+  return out.str();
+}
+
+}  // namespace generator
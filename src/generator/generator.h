@@ -0,0 +1,100 @@
+#pragma once
+
+/// This file contains the generator of random gHopper programs, used to
+/// benchmark the compiler on inputs of any size.
+///
+/// Example:
+/// generator::Options options;
+/// options.seed = 42;
+/// options.size = 1 << 20;
+/// std::string program = generator::generate(options);
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace generator {
+
+/// The knobs of the generated program. The same options (seed included)
+/// always give the same program, on every platform.
+struct Options {
+  std::uint32_t seed = 0;
+  /// Number of functions to generate. Ignored if size is not 0.
+  int functions = 100;
+  /// If not 0, generate functions until the program is at least this long,
+  /// in bytes.
+  std::size_t size = 0;
+  /// One global variable is declared every `functions_per_global` functions.
+  int functions_per_global = 8;
+  int max_arguments = 4;
+  /// Maximum number of statements in a block, not counting the return.
+  int max_statements = 6;
+  /// Maximum number of nested if statements.
+  int max_nesting_depth = 3;
+  /// Maximum depth of the tree of an expression: 0 means only variables and
+  /// constants.
+  int max_expression_depth = 3;
+  /// The length of the identifiers follows a geometric distribution, cut to
+  /// [min, max]. They always have a unique numeric suffix, so they may be
+  /// slightly longer.
+  int min_identifier_length = 1;
+  int mean_identifier_length = 8;
+  int max_identifier_length = 32;
+  /// Use binary operations in the expressions.
+  bool binary_operations = true;
+  /// Call the previously declared functions in the expressions. There is no
+  /// recursion.
+  bool function_calls = true;
+};
+
+/// Writes a valid gHopper program: it has no errors at any stage of the
+/// compilation. All the values are Int64.
+class Generator {
+ public:
+  explicit Generator(const Options& options);
+
+  /// Write the whole program to the stream.
+  void generate(std::ostream* out);
+
+ private:
+  struct Function {
+    std::string name;
+    int arguments;
+  };
+
+  void generate_global(std::ostream* out);
+  void generate_function(std::ostream* out);
+  // Generate the statements of a block, without the braces. Returns true if
+  // all the paths of the block return: nothing can follow it.
+  bool generate_block(std::ostream* out, int depth, bool must_return);
+  // Returns true if all the branches return.
+  bool generate_if(std::ostream* out, int depth);
+  // Generate an expression with at most `depth` levels of operations or
+  // calls. Binary operations are parenthesized if `parenthesize` is set.
+  void generate_expression(std::ostream* out, int depth, bool parenthesize);
+  void generate_constant(std::ostream* out);
+  void indent(std::ostream* out, int depth);
+
+  // A new identifier, different from all the others.
+  std::string identifier();
+  // Random integer in [min, max].
+  int uniform(int min, int max);
+  // True with the given probability, in percents.
+  bool chance(int percent);
+
+  const Options options_;
+  std::mt19937 random_;
+  int next_identifier_ = 0;
+  // The functions declared so far, that can be called.
+  std::vector<Function> functions_;
+  // The variables that can be referenced at this point.
+  std::vector<std::string> variables_;
+};
+
+/// Return the program generated with these options.
+std::string generate(const Options& options);
+
+}  // namespace generator
@@ -0,0 +1,94 @@
+#include <libgen.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "generator/generator.h"
+#include "util/gflags_utils.h"
+#include "util/logging.h"
+
+// LCOV_EXCL_START: main is not tested
+
+DEFINE_uint64(seed, 0, "Seed of the random generator");
+DEFINE_int32(functions, 100,
+             "Number of functions to generate, if --size is not given");
+DEFINE_string(size, "",
+              "Generate functions until the program has at least this size, "
+              "in bytes; accepts the K, M and G suffixes (e.g. 100M)");
+DEFINE_int32(functions_per_global, 8,
+             "Declare a global variable every N functions");
+DEFINE_int32(max_arguments, 4, "Maximum number of arguments of a function");
+DEFINE_int32(max_statements, 6, "Maximum number of statements in a block");
+DEFINE_int32(max_nesting_depth, 3, "Maximum number of nested if statements");
+DEFINE_int32(max_expression_depth, 3,
+             "Maximum depth of the operations and calls in an expression");
+DEFINE_int32(min_identifier_length, 1, "Minimum length of the identifiers");
+DEFINE_int32(mean_identifier_length, 8, "Mean length of the identifiers");
+DEFINE_int32(max_identifier_length, 32, "Maximum length of the identifiers");
+DEFINE_bool(binary_operations, true, "Generate binary operations");
+DEFINE_bool(function_calls, true, "Generate function calls");
+DEFINE_string(out, "", "Output file; the standard output by default");
+
+namespace {
+
+// Parse a size like "100M". Returns false if it's not valid.
+bool parse_size(const std::string& text, std::size_t* size) {
+  char* end;
+  const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+  if (end == text.c_str()) return false;
+  const std::string unit = end;
+  if (unit.empty())
+    *size = value;
+  else if (unit == "K")
+    *size = value << 10;
+  else if (unit == "M")
+    *size = value << 20;
+  else if (unit == "G")
+    *size = value << 30;
+  else
+    return false;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      std::string("Generate a random gHopper program.\n\nUsage: ") +
+      basename(argv[0]) + " [FLAGS]");  // NOLINT
+  gflags::GFlagsWrapper w(&argc, &argv, true);
+
+  generator::Options options;
+  options.seed = FLAGS_seed;
+  options.functions = FLAGS_functions;
+  if (!FLAGS_size.empty() && !parse_size(FLAGS_size, &options.size)) {
+    LOG(ERROR) << "Invalid --size: " << FLAGS_size;
+    return 1;
+  }
+  options.functions_per_global = FLAGS_functions_per_global;
+  options.max_arguments = FLAGS_max_arguments;
+  options.max_statements = FLAGS_max_statements;
+  options.max_nesting_depth = FLAGS_max_nesting_depth;
+  options.max_expression_depth = FLAGS_max_expression_depth;
+  options.min_identifier_length = FLAGS_min_identifier_length;
+  options.mean_identifier_length = FLAGS_mean_identifier_length;
+  options.max_identifier_length = FLAGS_max_identifier_length;
+  options.binary_operations = FLAGS_binary_operations;
+  options.function_calls = FLAGS_function_calls;
+
+  generator::Generator generator(options);
+  if (FLAGS_out.empty()) {
+    generator.generate(&std::cout);
+    return std::cout ? 0 : 1;
+  }
+  std::ofstream out(FLAGS_out);
+  generator.generate(&out);
+  if (!out) {
+    LOG(ERROR) << "Could not write to " << FLAGS_out;
+    return 1;
+  }
+  return 0;
+}
+
+// LCOV_EXCL_STOP
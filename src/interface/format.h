@@ -0,0 +1,44 @@
+#pragma once
+
+/// This file describes the binary format of the module interfaces (.ghi): the
+/// declarations that a module exports, with their resolved types, so that
+/// the modules importing it don't have to parse its source.
+///
+/// All the integers are little-endian. The file is:
+///  - the header: the magic "GHI\0", the u32 version, the u32 number of
+///    functions, and the u32 offset of the string table;
+///  - the index: for each function, sorted by name, the u32 offset and u32
+///    length of its name in the string table, and the u32 offset of its
+///    record in the file;
+///  - the records: the u8 flags of the function, its return type, the u32
+///    number of arguments, and for each argument its u8 flags, the u32
+///    offset and u32 length of its name, and its type;
+///  - the string table, until the end of the file.
+///
+/// A type is its u8 kind, the u8 index of its builtin type (of the element
+/// for an array or a slice) in ast::types::builtin_types, and the u64 size of
+/// an array.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace interface {
+namespace format {
+
+constexpr char k_magic[4] = {'G', 'H', 'I', '\0'};
+/// Changed with the format, or with the list of builtin types.
+constexpr std::uint32_t k_version = 1;
+
+constexpr std::size_t k_header_size = 16;
+constexpr std::size_t k_index_entry_size = 12;
+
+/// Flags of a function.
+constexpr std::uint8_t k_pure = 1;
+/// Flags of an argument.
+constexpr std::uint8_t k_mutable = 1;
+
+/// Kinds of types.
+enum class TypeKind : std::uint8_t { BUILTIN = 0, ARRAY = 1, SLICE = 2 };
+
+}  // namespace format
+}  // namespace interface
@@ -0,0 +1,206 @@
+#include "interface/module_interface.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+
+#include "ast/array_type.h"
+#include "ast/builtin_type.h"
+#include "interface/format.h"
+
+namespace interface {
+
+namespace {
+
+/// Reads the little-endian integers of the file, before `end`. A read past
+/// the end fails, and so do all the following ones.
+class Reader {
+ public:
+  Reader(const util::MappedFile& file, std::size_t position, std::size_t end)
+      : data_(file.data()),
+        end_(std::min(end, file.size())),
+        position_(position),
+        ok_(position <= end_) {}
+
+  bool ok() const { return ok_; }
+  std::uint8_t u8() { return static_cast<std::uint8_t>(read(1)); }
+  std::uint32_t u32() { return static_cast<std::uint32_t>(read(4)); }
+  std::uint64_t u64() { return read(8); }
+
+ private:
+  std::uint64_t read(std::size_t size) {
+    if (!ok_ || end_ - position_ < size) {
+      ok_ = false;
+      return 0;
+    }
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      auto byte = static_cast<unsigned char>(data_[position_ + i]);
+      value |= std::uint64_t{byte} << (8 * i);
+    }
+    position_ += size;
+    return value;
+  }
+
+  const char* data_;
+  std::size_t end_;
+  std::size_t position_;
+  bool ok_;
+};
+
+/// The type at the position of the reader, or null if it is invalid.
+const ast::TypeDeclaration* read_type(Reader* reader) {
+  auto kind = reader->u8();
+  auto index = reader->u8();
+  const auto& builtins = ast::types::builtin_types;
+  if (!reader->ok() || index >= builtins.size()) return nullptr;
+  const ast::TypeDeclaration* builtin = builtins[index];
+  switch (static_cast<format::TypeKind>(kind)) {
+    case format::TypeKind::BUILTIN:
+      return builtin;
+    case format::TypeKind::ARRAY: {
+      auto size = reader->u64();
+      if (!reader->ok()) return nullptr;
+      return ast::types::array_of(builtin, size);
+    }
+    case format::TypeKind::SLICE:
+      return ast::types::slice_of(builtin);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+ErrorOr<std::unique_ptr<ModuleInterface>> ModuleInterface::open(
+    const std::string& path) {
+  RETURN_OR_MOVE(auto file, util::MappedFile::open(path));
+  if (file->size() < format::k_header_size ||
+      !std::equal(std::begin(format::k_magic), std::end(format::k_magic),
+                  file->data()))
+    return GenericError("The file " + path + " is not a module interface");
+  Reader header(*file, sizeof(format::k_magic), format::k_header_size);
+  auto version = header.u32();
+  auto function_count = header.u32();
+  auto strings_offset = header.u32();
+  if (version != format::k_version)
+    return GenericError("The interface " + path + " has the version " +
+                        std::to_string(version) + ", expected " +
+                        std::to_string(format::k_version) +
+                        ": its module must be compiled again");
+  // The index and the records are before the string table.
+  if (format::k_header_size +
+              format::k_index_entry_size * std::uint64_t{function_count} >
+          strings_offset ||
+      strings_offset > file->size())
+    return GenericError("The interface " + path + " is corrupted");
+  return std::unique_ptr<ModuleInterface>(
+      new ModuleInterface(std::move(file), function_count, strings_offset));
+}
+
+GenericError ModuleInterface::corrupted() const {
+  return GenericError("The interface " + path() + " is corrupted");
+}
+
+bool ModuleInterface::get_string(std::uint32_t offset, std::uint32_t length,
+                                 const char** string) const {
+  std::uint64_t table_size = file_->size() - strings_offset_;
+  if (std::uint64_t{offset} + length > table_size) return false;
+  *string = file_->data() + strings_offset_ + offset;
+  return true;
+}
+
+ErrorOr<ast::FunctionDeclaration*> ModuleInterface::lookup(
+    const std::string& name) {
+  auto known = functions_.find(name);
+  if (known != std::end(functions_)) return known->second.get();
+
+  // Binary search of the index, without copying the names.
+  std::uint32_t low = 0;
+  std::uint32_t high = function_count_;
+  while (low < high) {
+    auto middle = low + (high - low) / 2;
+    Reader entry(*file_,
+                 format::k_header_size +
+                     format::k_index_entry_size * std::size_t{middle},
+                 strings_offset_);
+    auto name_offset = entry.u32();
+    auto name_length = entry.u32();
+    auto record_offset = entry.u32();
+    const char* entry_name = nullptr;
+    if (!entry.ok() || !get_string(name_offset, name_length, &entry_name))
+      return corrupted();
+    int comparison =
+        name.compare(0, std::string::npos, entry_name, name_length);
+    if (comparison < 0) {
+      high = middle;
+    } else if (comparison > 0) {
+      low = middle + 1;
+    } else {
+      RETURN_OR_MOVE(auto function, decode_function(name, record_offset));
+      auto result = function.get();
+      functions_[name] = std::move(function);
+      return result;
+    }
+  }
+  return nullptr;
+}
+
+ErrorOr<std::unique_ptr<ast::FunctionDeclaration>>
+ModuleInterface::decode_function(const std::string& name,
+                                 std::uint32_t offset) const {
+  // The records are between the index and the string table.
+  Reader record(*file_, offset, strings_offset_);
+  lexer::Range location(path(), 0, 0, 0, 0);
+  ast::FunctionQualifiers qualifiers;
+  qualifiers.is_extern = true;
+  qualifiers.is_pure = (record.u8() & format::k_pure) != 0;
+  auto return_type = read_type(&record);
+  auto argument_count = record.u32();
+  if (return_type == nullptr || !record.ok()) return corrupted();
+
+  ast::FunctionDeclaration::ArgumentList arguments;
+  for (std::uint32_t i = 0; i < argument_count; ++i) {
+    bool is_mutable = (record.u8() & format::k_mutable) != 0;
+    auto name_offset = record.u32();
+    auto name_length = record.u32();
+    auto type = read_type(&record);
+    const char* argument_name = nullptr;
+    if (type == nullptr ||
+        !get_string(name_offset, name_length, &argument_name))
+      return corrupted();
+    arguments.push_back(std::make_unique<ast::FunctionArgumentDeclaration>(
+        location,
+        ast::Identifier(std::string(argument_name, name_length), location,
+                        false),
+        ast::Type(type), none, is_mutable));
+  }
+  return std::make_unique<ast::FunctionDeclaration>(
+      location, ast::Identifier(name, location, false), std::move(arguments),
+      ast::Type(return_type), ast::FunctionDeclaration::StatementsBody(),
+      qualifiers);
+}
+
+ErrorOr<ModuleInterface*> InterfaceLoader::load(const std::string& module) {
+  auto known = interfaces_.find(module);
+  if (known != std::end(interfaces_)) return known->second.get();
+  for (const auto& directory : search_path_) {
+    auto path = (directory.empty() ? "" : directory + "/") + module + ".ghi";
+    if (::access(path.c_str(), F_OK) != 0) continue;
+    RETURN_OR_MOVE(auto interface, ModuleInterface::open(path));
+    auto result = interface.get();
+    interfaces_[module] = std::move(interface);
+    return result;
+  }
+  return GenericError("Could not find the interface of the module `" +
+                      module + "'");
+}
+
+std::vector<std::pair<std::string, std::string>> InterfaceLoader::loaded()
+    const {
+  std::vector<std::pair<std::string, std::string>> result;
+  for (const auto& interface : interfaces_)
+    result.emplace_back(interface.first, interface.second->path());
+  return result;
+}
+
+}  // namespace interface
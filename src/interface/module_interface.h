@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast/function_declaration.h"
+#include "error/error.h"
+#include "util/mapped_file.h"
+
+namespace interface {
+
+/// The interface of an imported module, written by write_interface and mapped
+/// in memory. Only the header is read when it is opened: the declarations are
+/// found by a binary search of the index, and decoded when they are looked
+/// up.
+///
+/// The declarations are extern functions with resolved types. They belong to
+/// the interface, which must outlive the ASTs that reference them.
+class ModuleInterface {
+ public:
+  /// Map the interface file, and check its header.
+  static ErrorOr<std::unique_ptr<ModuleInterface>> open(
+      const std::string& path);
+
+  /// The exported function with this name, or null if there is none. An
+  /// error if the interface is corrupted.
+  ErrorOr<ast::FunctionDeclaration*> lookup(const std::string& name);
+
+  std::uint32_t function_count() const { return function_count_; }
+  const std::string& path() const { return file_->path(); }
+
+ private:
+  ModuleInterface(std::unique_ptr<util::MappedFile> file,
+                  std::uint32_t function_count, std::uint32_t strings_offset)
+      : file_(std::move(file)),
+        function_count_(function_count),
+        strings_offset_(strings_offset) {}
+
+  /// Decode the record of a function, at this offset.
+  ErrorOr<std::unique_ptr<ast::FunctionDeclaration>> decode_function(
+      const std::string& name, std::uint32_t offset) const;
+  /// The string of the string table at this offset. False if it is out of the
+  /// table.
+  bool get_string(std::uint32_t offset, std::uint32_t length,
+                  const char** string) const;
+  GenericError corrupted() const;
+
+  std::unique_ptr<util::MappedFile> file_;
+  std::uint32_t function_count_;
+  std::uint32_t strings_offset_;
+  // The functions decoded so far, by name.
+  std::unordered_map<std::string, std::unique_ptr<ast::FunctionDeclaration>>
+      functions_;
+};
+
+/// Opens the interfaces of the imported modules: `import math;` uses the
+/// first `math.ghi` found in the directories of the search path. Each
+/// interface is opened once.
+class InterfaceLoader {
+ public:
+  explicit InterfaceLoader(std::vector<std::string> search_path)
+      : search_path_(std::move(search_path)) {}
+
+  /// The interface of the module. An error if it is not found, or if it
+  /// can't be read.
+  ErrorOr<ModuleInterface*> load(const std::string& module);
+
+  /// The modules loaded so far, with the paths of their interfaces.
+  std::vector<std::pair<std::string, std::string>> loaded() const;
+
+ private:
+  std::vector<std::string> search_path_;
+  std::unordered_map<std::string, std::unique_ptr<ModuleInterface>>
+      interfaces_;
+};
+
+}  // namespace interface
@@ -0,0 +1,120 @@
+#include "interface/writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ast/array_type.h"
+#include "ast/builtin_type.h"
+#include "ast/function_declaration.h"
+#include "interface/format.h"
+#include "util/logging.h"
+
+namespace interface {
+
+namespace {
+
+/// Bytes of the file, with the integers in little-endian.
+class Buffer {
+ public:
+  void put_u8(std::uint8_t value) {
+    bytes_.push_back(static_cast<char>(value));
+  }
+  void put_u32(std::uint32_t value) { put(value, 4); }
+  void put_u64(std::uint64_t value) { put(value, 8); }
+  void put_bytes(const std::string& bytes) { bytes_ += bytes; }
+
+  std::uint32_t size() const {
+    return static_cast<std::uint32_t>(bytes_.size());
+  }
+  const std::string& bytes() const { return bytes_; }
+
+ private:
+  void put(std::uint64_t value, int size) {
+    for (int i = 0; i < size; ++i) put_u8((value >> (8 * i)) & 0xff);
+  }
+
+  std::string bytes_;
+};
+
+std::uint8_t builtin_index(const ast::TypeDeclaration* type) {
+  const auto& builtins = ast::types::builtin_types;
+  auto itr = std::find(std::begin(builtins), std::end(builtins), type);
+  CHECK(itr != std::end(builtins))
+      << "Not a builtin type: " << type->id().to_string();
+  return static_cast<std::uint8_t>(itr - std::begin(builtins));
+}
+
+void write_type(const ast::Type& type, Buffer* out) {
+  auto declaration = type.get_declaration();
+  if (auto array = ast::types::as_array(declaration)) {
+    out->put_u8(static_cast<std::uint8_t>(format::TypeKind::ARRAY));
+    out->put_u8(builtin_index(array->element()));
+    out->put_u64(array->size());
+  } else if (auto slice = ast::types::as_slice(declaration)) {
+    out->put_u8(static_cast<std::uint8_t>(format::TypeKind::SLICE));
+    out->put_u8(builtin_index(slice->element()));
+  } else {
+    out->put_u8(static_cast<std::uint8_t>(format::TypeKind::BUILTIN));
+    out->put_u8(builtin_index(declaration));
+  }
+}
+
+// Add the string to the table, and write its offset and length.
+void write_string(const std::string& value, Buffer* strings, Buffer* out) {
+  out->put_u32(strings->size());
+  out->put_u32(static_cast<std::uint32_t>(value.size()));
+  strings->put_bytes(value);
+}
+
+}  // namespace
+
+void write_interface(const ast::Module& module, std::ostream* out) {
+  std::vector<ast::FunctionDeclaration*> functions;
+  for (const auto& declaration : module.top_level_declarations()) {
+    if (declaration->node_type() != ast::NodeType::FUNCTION_DECLARATION)
+      continue;
+    auto function = static_cast<ast::FunctionDeclaration*>(declaration.get());
+    if (function->is_public()) functions.push_back(function);
+  }
+  // Sorted for the binary search of the names.
+  std::sort(
+      std::begin(functions), std::end(functions),
+      [](ast::FunctionDeclaration* left, ast::FunctionDeclaration* right) {
+        return left->name() < right->name();
+      });
+
+  Buffer index;
+  Buffer records;
+  Buffer strings;
+  auto records_offset = static_cast<std::uint32_t>(
+      format::k_header_size + format::k_index_entry_size * functions.size());
+  for (auto function : functions) {
+    write_string(function->name(), &strings, &index);
+    index.put_u32(records_offset + records.size());
+
+    CHECK(function->type().is_ok()) << "Function return type not deduced: "
+                                    << function->name();
+    records.put_u8(function->is_pure() ? format::k_pure : 0);
+    write_type(function->type().value_or_die(), &records);
+    records.put_u32(static_cast<std::uint32_t>(function->arguments().size()));
+    for (const auto& argument : function->arguments()) {
+      records.put_u8(argument->is_mutable() ? format::k_mutable : 0);
+      write_string(argument->id().to_string(), &strings, &records);
+      CHECK(argument->type().is_ok()) << "Argument type not deduced: "
+                                      << argument->id().to_string();
+      write_type(argument->type().value_or_die(), &records);
+    }
+  }
+
+  Buffer header;
+  header.put_bytes(std::string(format::k_magic, sizeof(format::k_magic)));
+  header.put_u32(format::k_version);
+  header.put_u32(static_cast<std::uint32_t>(functions.size()));
+  header.put_u32(records_offset + records.size());
+  *out << header.bytes() << index.bytes() << records.bytes()
+       << strings.bytes();
+}
+
+}  // namespace interface
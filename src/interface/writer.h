@@ -0,0 +1,15 @@
+#pragma once
+
+#include <ostream>
+
+#include "ast/module.h"
+
+namespace interface {
+
+/// Write the interface of the module, in the format of interface/format.h:
+/// the declarations of its public functions, with their types.
+///
+/// Assumes that the types are checked.
+void write_interface(const ast::Module& module, std::ostream* out);
+
+}  // namespace interface
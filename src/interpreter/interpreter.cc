@@ -0,0 +1,371 @@
+#include "interpreter/interpreter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "ast/assignment.h"
+#include "ast/block_statement.h"
+#include "ast/boolean_constant.h"
+#include "ast/builtin_type.h"
+#include "ast/for_block.h"
+#include "ast/function_argument_declaration.h"
+#include "ast/function_call.h"
+#include "ast/if_statement.h"
+#include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/return_statement.h"
+#include "ast/value_statement.h"
+#include "ast/variable_reference.h"
+#include "ast/while_block.h"
+#include "util/logging.h"
+
+namespace interpreter {
+
+using ast::BinaryOperator;
+
+namespace {
+
+// Truncate the value to its lowest bits, and sign-extend it back.
+std::int64_t wrap(std::uint64_t value, int bits) {
+  if (bits == 1) return value & 1;
+  int shift = 64 - bits;
+  return static_cast<std::int64_t>(value << shift) >> shift;
+}
+
+}  // namespace
+
+int bit_width(const ast::Type& type) {
+  auto width = ast::types::int_type_to_width(type.get_declaration());
+  if (!width.is_ok()) return 1;
+  switch (width.value_or_die()) {
+    case ast::types::IntWidth::W_8:
+      return 8;
+    case ast::types::IntWidth::W_16:
+      return 16;
+    case ast::types::IntWidth::W_32:
+      return 32;
+    case ast::types::IntWidth::W_64:
+      return 64;
+  }
+  CHECK(false) << "Unknown integer width";
+  return 64;
+}
+
+std::int64_t convert(std::int64_t value, const ast::Type& type) {
+  if (type.get_declaration() == &ast::types::void_type) return 0;
+  return wrap(static_cast<std::uint64_t>(value), bit_width(type));
+}
+
+Option<std::int64_t> evaluate_operation(BinaryOperator op, std::int64_t left,
+                                        std::int64_t right, int bits) {
+  // The wrapping arithmetic is done on unsigned integers.
+  auto unsigned_left = static_cast<std::uint64_t>(left);
+  auto unsigned_right = static_cast<std::uint64_t>(right);
+  auto shift = unsigned_right & static_cast<std::uint64_t>(bits - 1);
+  auto min_value = std::numeric_limits<std::int64_t>::min() >> (64 - bits);
+  switch (op) {
+    case BinaryOperator::PLUS:
+      return wrap(unsigned_left + unsigned_right, bits);
+    case BinaryOperator::MINUS:
+      return wrap(unsigned_left - unsigned_right, bits);
+    case BinaryOperator::TIMES:
+      return wrap(unsigned_left * unsigned_right, bits);
+    case BinaryOperator::DIVIDE:
+    case BinaryOperator::INT_DIVIDE:
+    case BinaryOperator::MODULO:
+      // Undefined at runtime, the error (if any) is not ours to report.
+      if (right == 0 || (left == min_value && right == -1)) return none;
+      return op == BinaryOperator::MODULO ? left % right : left / right;
+    case BinaryOperator::BITAND:
+      return left & right;
+    case BinaryOperator::BITOR:
+      return left | right;
+    case BinaryOperator::BITXOR:
+      return left ^ right;
+    case BinaryOperator::BITSHIFT_LEFT:
+      return wrap(unsigned_left << shift, bits);
+    case BinaryOperator::BITSHIFT_RIGHT:
+      return left >> shift;
+    case BinaryOperator::EQUAL:
+      return std::int64_t{left == right};
+    case BinaryOperator::DIFFERENT:
+      return std::int64_t{left != right};
+    case BinaryOperator::GREATER:
+      return std::int64_t{left > right};
+    case BinaryOperator::GREATER_OR_EQUAL:
+      return std::int64_t{left >= right};
+    case BinaryOperator::LESS:
+      return std::int64_t{left < right};
+    case BinaryOperator::LESS_OR_EQUAL:
+      return std::int64_t{left <= right};
+    case BinaryOperator::AND:
+      return std::int64_t{left != 0 && right != 0};
+    case BinaryOperator::OR:
+      return std::int64_t{left != 0 || right != 0};
+    default:
+      return none;
+  }
+}
+
+Interpreter::Interpreter(ast::Module* module, int fuel, int max_depth)
+    : fuel_(fuel), max_depth_(max_depth) {
+  for (const auto& declaration : module->top_level_declarations()) {
+    if (declaration->node_type() != ast::NodeType::LOCAL_VARIABLE_DECLARATION)
+      continue;
+    auto variable =
+        static_cast<ast::LocalVariableDeclaration*>(declaration.get());
+    if (!variable->is_mutable() && variable->value().is_ok())
+      globals_[variable] = variable;
+  }
+}
+
+Option<std::int64_t> Interpreter::call(ast::FunctionDeclaration* function,
+                                       std::vector<std::int64_t> arguments) {
+  remaining_fuel_ = fuel_;
+  Call call{function, arguments};
+  auto result = invoke(function, std::move(arguments));
+  if (!result.is_ok()) results_.emplace(std::move(call), none);
+  return result;
+}
+
+Option<std::int64_t> Interpreter::evaluate(ast::Value* value) {
+  remaining_fuel_ = fuel_;
+  return evaluate(value, Frame());
+}
+
+bool Interpreter::consume_fuel() {
+  if (remaining_fuel_ == 0) return false;
+  --remaining_fuel_;
+  return true;
+}
+
+Option<std::int64_t> Interpreter::evaluate_global(
+    const ast::Declaration* declaration) {
+  auto known = global_values_.find(declaration);
+  if (known != std::end(global_values_)) return known->second;
+  auto global = globals_.find(declaration);
+  // A mutable variable, or a local variable of another function.
+  if (global == std::end(globals_)) return none;
+  // The value of the variable depends on itself.
+  if (!globals_in_progress_.insert(declaration).second) return none;
+  auto variable = global->second;
+  auto& value = variable->value().value_or_die();
+  auto result = evaluate(value.get(), Frame());
+  globals_in_progress_.erase(declaration);
+  if (!result.is_ok()) return none;
+  auto converted = convert(result.value_or_die(),
+                           variable->type().is_ok()
+                               ? variable->type().value_or_die()
+                               : value->type().value_or_die());
+  global_values_[declaration] = converted;
+  return converted;
+}
+
+Option<std::int64_t> Interpreter::evaluate(ast::Value* value,
+                                           const Frame& frame) {
+  if (!consume_fuel()) return none;
+  switch (value->node_type()) {
+    case ast::NodeType::INT_CONSTANT:
+      return static_cast<ast::IntConstant*>(value)->value();
+    case ast::NodeType::BOOLEAN_CONSTANT:
+      return std::int64_t{static_cast<ast::BooleanConstant*>(value)->value()};
+    case ast::NodeType::VARIABLE_REFERENCE: {
+      auto reference = static_cast<ast::VariableReference*>(value);
+      CHECK(reference->is_resolved()) << "Variable was not resolved";
+      auto declaration = reference->resolution().value_or_die();
+      auto local = frame.find(declaration);
+      if (local != std::end(frame)) return local->second;
+      return evaluate_global(declaration);
+    }
+    case ast::NodeType::BINARY_OP: {
+      auto operation = static_cast<ast::BinaryOp*>(value);
+      auto op = operation->operation();
+      auto left = evaluate(&operation->left_value(), frame);
+      if (!left.is_ok()) return none;
+      // Only evaluate the right side if the left one doesn't decide.
+      if (op == BinaryOperator::AND || op == BinaryOperator::OR) {
+        if ((left.value_or_die() != 0) == (op == BinaryOperator::OR))
+          return left;
+        return evaluate(&operation->right_value(), frame);
+      }
+      auto right = evaluate(&operation->right_value(), frame);
+      if (!right.is_ok()) return none;
+      int bits = std::max(
+          bit_width(operation->left_value().type().value_or_die()),
+          bit_width(operation->right_value().type().value_or_die()));
+      return evaluate_operation(op, left.value_or_die(), right.value_or_die(),
+                                bits);
+    }
+    case ast::NodeType::FUNCTION_CALL: {
+      auto call = static_cast<ast::FunctionCall*>(value);
+      if (!call->function().is_ok()) return none;
+      std::vector<std::int64_t> arguments;
+      for (const auto& argument : call->arguments()) {
+        auto argument_value = evaluate(argument.get(), frame);
+        if (!argument_value.is_ok()) return none;
+        arguments.push_back(argument_value.value_or_die());
+      }
+      return invoke(call->function().value_or_die(), std::move(arguments));
+    }
+    default:
+      return none;
+  }
+}
+
+Option<std::int64_t> Interpreter::invoke(ast::FunctionDeclaration* function,
+                                         std::vector<std::int64_t> arguments) {
+  const auto& parameters = function->arguments();
+  CHECK(parameters.size() == arguments.size()) << "Wrong number of arguments";
+  for (std::size_t i = 0; i < parameters.size(); ++i) {
+    if (parameters[i]->type().is_ok())
+      arguments[i] =
+          convert(arguments[i], parameters[i]->type().value_or_die());
+  }
+
+  Call call{function, std::move(arguments)};
+  auto memoized = results_.find(call);
+  if (memoized != std::end(results_)) return memoized->second;
+  if (depth_ == max_depth_ || function->is_extern()) return none;
+
+  using StatementsBody = ast::FunctionDeclaration::StatementsBody;
+  CHECK(function->body().is<StatementsBody>())
+      << "Function should have a statements body: " << function->name();
+  Frame frame;
+  for (std::size_t i = 0; i < parameters.size(); ++i)
+    frame[parameters[i].get()] = call.arguments[i];
+
+  ++depth_;
+  std::int64_t result = 0;
+  auto status =
+      execute(function->body().get_unchecked<StatementsBody>().get(), &frame,
+              &result);
+  --depth_;
+  if (status != Status::RETURNED) return none;
+
+  CHECK(function->type().is_ok()) << "Function return type not deduced: "
+                                  << function->name();
+  result = convert(result, function->type().value_or_die());
+  results_.emplace(std::move(call), result);
+  return result;
+}
+
+bool Interpreter::execute_iteration(ast::BlockStatement* body, Frame* frame,
+                                    std::int64_t* result, Status* status) {
+  *status = execute(body, frame, result);
+  switch (*status) {
+    case Status::NEXT:
+    case Status::CONTINUED:
+      return true;
+    case Status::BROKE:
+      *status = Status::NEXT;
+      return false;
+    default:
+      return false;
+  }
+}
+
+Interpreter::Status Interpreter::execute(ast::Statement* statement,
+                                         Frame* frame, std::int64_t* result) {
+  if (!consume_fuel()) return Status::FAILED;
+  switch (statement->node_type()) {
+    case ast::NodeType::BLOCK_STATEMENT:
+      for (const auto& child :
+           static_cast<ast::BlockStatement*>(statement)->statements()) {
+        auto status = execute(child.get(), frame, result);
+        if (status != Status::NEXT) return status;
+      }
+      return Status::NEXT;
+    case ast::NodeType::IF_STATEMENT: {
+      auto if_statement = static_cast<ast::IfStatement*>(statement);
+      auto condition = evaluate(if_statement->condition().get(), *frame);
+      if (!condition.is_ok()) return Status::FAILED;
+      if (condition.value_or_die() != 0)
+        return execute(if_statement->body().get(), frame, result);
+      if (if_statement->else_statement().is_ok())
+        return execute(if_statement->else_statement().value_or_die().get(),
+                       frame, result);
+      return Status::NEXT;
+    }
+    case ast::NodeType::RETURN_STATEMENT: {
+      auto& value = static_cast<ast::ReturnStatement*>(statement)->value();
+      if (value.is_ok()) {
+        auto returned = evaluate(value.value_or_die().get(), *frame);
+        if (!returned.is_ok()) return Status::FAILED;
+        *result = returned.value_or_die();
+      }
+      return Status::RETURNED;
+    }
+    case ast::NodeType::VALUE_STATEMENT: {
+      auto& value = static_cast<ast::ValueStatement*>(statement)->value();
+      return evaluate(value.get(), *frame).is_ok() ? Status::NEXT
+                                                   : Status::FAILED;
+    }
+    case ast::NodeType::LOCAL_VARIABLE_DECLARATION: {
+      auto variable = static_cast<ast::LocalVariableDeclaration*>(statement);
+      // An uninitialized variable has no defined value.
+      if (!variable->value().is_ok()) return Status::FAILED;
+      auto& value = variable->value().value_or_die();
+      auto variable_value = evaluate(value.get(), *frame);
+      if (!variable_value.is_ok()) return Status::FAILED;
+      (*frame)[variable] = convert(variable_value.value_or_die(),
+                                   variable->type().is_ok()
+                                       ? variable->type().value_or_die()
+                                       : value->type().value_or_die());
+      return Status::NEXT;
+    }
+    case ast::NodeType::ASSIGNMENT: {
+      auto assignment = static_cast<ast::Assignment*>(statement);
+      // The arrays are not evaluated.
+      if (assignment->index().is_ok()) return Status::FAILED;
+      auto& target = assignment->target();
+      auto variable = frame->find(target.resolution().value_or_die());
+      // The global variables can't change at compile time.
+      if (variable == std::end(*frame)) return Status::FAILED;
+      auto value = evaluate(assignment->value().get(), *frame);
+      if (!value.is_ok()) return Status::FAILED;
+      variable->second =
+          convert(value.value_or_die(), target.type().value_or_die());
+      return Status::NEXT;
+    }
+    case ast::NodeType::WHILE_BLOCK: {
+      auto loop = static_cast<ast::WhileBlock*>(statement);
+      auto status = Status::NEXT;
+      while (true) {
+        auto condition = evaluate(loop->condition().get(), *frame);
+        if (!condition.is_ok()) return Status::FAILED;
+        if (condition.value_or_die() == 0) return Status::NEXT;
+        if (!execute_iteration(loop->body().get(), frame, result, &status))
+          return status;
+      }
+    }
+    case ast::NodeType::FOR_BLOCK: {
+      auto loop = static_cast<ast::ForBlock*>(statement);
+      auto begin = evaluate(loop->begin().get(), *frame);
+      auto end = evaluate(loop->end().get(), *frame);
+      if (!begin.is_ok() || !end.is_ok()) return Status::FAILED;
+      const auto& type = loop->variable()->type().value_or_die();
+      auto last = convert(end.value_or_die(), type);
+      auto status = Status::NEXT;
+      for (auto index = convert(begin.value_or_die(), type); index < last;
+           ++index) {
+        // An empty body would not consume any fuel.
+        if (!consume_fuel()) return Status::FAILED;
+        (*frame)[loop->variable()] = index;
+        if (!execute_iteration(loop->body().get(), frame, result, &status))
+          return status;
+      }
+      return Status::NEXT;
+    }
+    case ast::NodeType::BREAK_STATEMENT:
+      return Status::BROKE;
+    case ast::NodeType::CONTINUE_STATEMENT:
+      return Status::CONTINUED;
+    case ast::NodeType::FUNCTION_DECLARATION:
+      // Nothing to execute until it is called.
+      return Status::NEXT;
+    default:
+      return Status::FAILED;
+  }
+}
+
+}  // namespace interpreter
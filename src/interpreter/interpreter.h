@@ -0,0 +1,112 @@
+#pragma once
+
+/// This file contains the evaluation of the code at compile time, for the
+/// constants and the calls to pure functions.
+
+#include <cstdint>
+#include <functional>  // hash
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast/binary_operation.h"
+#include "ast/function_declaration.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/module.h"
+#include "util/option.h"
+
+namespace interpreter {
+
+/// The number of bits of an integer type, or 1 for a boolean.
+int bit_width(const ast::Type& type);
+
+/// Convert the value to the type, like the generated code does: the integers
+/// are truncated and sign-extended.
+std::int64_t convert(std::int64_t value, const ast::Type& type);
+
+/// Evaluate the operation on operands extended to `bits` bits, with the
+/// semantics of the generated code: the result wraps around, and the shift
+/// amounts are masked. None if it is undefined (division by zero).
+Option<std::int64_t> evaluate_operation(ast::BinaryOperator op,
+                                        std::int64_t left, std::int64_t right,
+                                        int bits);
+
+/// Evaluates a typed AST at compile time. The values are the integers and the
+/// booleans (0 or 1): a value can be evaluated if it only depends on
+/// constants and on the immutable global variables.
+///
+/// Each evaluation runs with a limited fuel (number of nodes evaluated) and a
+/// limited depth of calls, so that the compilation always ends. The results
+/// of the calls are memoized by function and arguments.
+class Interpreter {
+ public:
+  static constexpr int k_default_fuel = 100000;
+  static constexpr int k_default_max_depth = 128;
+
+  explicit Interpreter(ast::Module* module, int fuel = k_default_fuel,
+                       int max_depth = k_default_max_depth);
+
+  /// The result of the call, if it can be evaluated. The arguments are
+  /// converted to the types of the parameters.
+  Option<std::int64_t> call(ast::FunctionDeclaration* function,
+                            std::vector<std::int64_t> arguments);
+
+  /// The value, if it can be evaluated outside of any function.
+  Option<std::int64_t> evaluate(ast::Value* value);
+
+ private:
+  using Frame = std::unordered_map<const ast::Declaration*, std::int64_t>;
+
+  struct Call {
+    ast::FunctionDeclaration* function;
+    std::vector<std::int64_t> arguments;
+
+    bool operator==(const Call& other) const {
+      return function == other.function && arguments == other.arguments;
+    }
+  };
+
+  struct CallHash {
+    std::size_t operator()(const Call& call) const {
+      std::size_t hash = std::hash<ast::FunctionDeclaration*>{}(call.function);
+      for (auto argument : call.arguments)
+        hash = hash * 31 + std::hash<std::int64_t>{}(argument);
+      return hash;
+    }
+  };
+
+  // How the execution of a statement ended: NEXT goes on with the following
+  // statement, BROKE and CONTINUED go up to the innermost loop.
+  enum class Status { NEXT, RETURNED, BROKE, CONTINUED, FAILED };
+
+  Option<std::int64_t> evaluate(ast::Value* value, const Frame& frame);
+  Option<std::int64_t> evaluate_global(const ast::Declaration* declaration);
+  Option<std::int64_t> invoke(ast::FunctionDeclaration* function,
+                              std::vector<std::int64_t> arguments);
+  /// Execute the statement, and put the returned value in `result`.
+  Status execute(ast::Statement* statement, Frame* frame,
+                 std::int64_t* result);
+  /// Execute one iteration of a loop. False if the loop ends there, with its
+  /// status in `status`.
+  bool execute_iteration(ast::BlockStatement* body, Frame* frame,
+                         std::int64_t* result, Status* status);
+  /// Account for the evaluation of one node. False if there is no fuel left.
+  bool consume_fuel();
+
+  int fuel_;
+  int max_depth_;
+  int remaining_fuel_ = 0;
+  int depth_ = 0;
+
+  // The immutable global variables, and the values computed for them.
+  std::unordered_map<const ast::Declaration*, ast::LocalVariableDeclaration*>
+      globals_;
+  std::unordered_map<const ast::Declaration*, std::int64_t> global_values_;
+  std::unordered_set<const ast::Declaration*> globals_in_progress_;
+
+  // The results of the calls. A call that failed with all the fuel and all
+  // the depth available fails everywhere: it is memoized as none.
+  std::unordered_map<Call, Option<std::int64_t>, CallHash> results_;
+};
+
+}  // namespace interpreter
@@ -17,7 +17,7 @@ class FileReader {
   FileReader(std::unique_ptr<std::istream> stream, const std::string& filename)
       : stream_{std::move(stream)}, read_loc_{filename, 1, 0} {}
 
-  ErrorOr<State, LexError> read_one_char();
+  MUST_USE_RESULT ErrorOr<State, LexError> read_one_char();
 
  private:
   std::unique_ptr<std::istream> stream_;
@@ -7,8 +7,19 @@ namespace lexer {
 class LexError : public GenericError {
  public:
   explicit LexError(const std::string& message, const Range& r)
-      : GenericError(message + " in " + r.to_string()) {}
+      : GenericError(message), range_(r) {}
+
+  /// The location is only formatted when the error is displayed.
+  std::string to_string() const override {
+    return message() + " in " + range_.to_string();
+  }
+
+  const Range* range() const override { return &range_; }
+
   ~LexError() override = default;
+
+ private:
+  const Range range_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const LexError& error) {
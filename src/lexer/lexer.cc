@@ -147,7 +147,7 @@ ErrorOr<Token, LexError> Lexer::get_next_token() {
       if (!is_alpha_num(current_char())) {
         unget_char();
         // Found single '0'.
-        return helper.make_single_token(TokenType::INT);
+        return Token{TokenType::INT, int64_t{0}, {beginning, beginning}};
       }
       do {
         RETURN_IF_ERROR(get_next_char());
@@ -29,7 +29,7 @@ class Lexer {
 
   // Consume characters from the stream until a full token is seen, and return
   // that token, or a lexing error if a malformed token was seen.
-  ErrorOr<Token, LexError> get_next_token();
+  MUST_USE_RESULT ErrorOr<Token, LexError> get_next_token();
 
   // Get the current location, in the source, of the lexer.
   const Location& location() const;
@@ -52,7 +52,7 @@ class Lexer {
   ErrorOr<Token, LexError> read_lowercase_identifier();
   // Reads the next char from the stream, updating the location. May return an
   // error if read operation fails.
-  MaybeError<LexError> get_next_char();
+  MUST_USE_RESULT MaybeError<LexError> get_next_char();
   // Push the current character and location on a stack, and restore the
   // previous one.
   void unget_char();
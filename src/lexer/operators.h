@@ -48,6 +48,29 @@ inline Option<BinaryOperator> token_to_binary_operator(TokenType tt) {
   }
 }
 
+/// The operator of a compound assignment: `+=` is PLUS. None for the other
+/// tokens, including `=`.
+inline Option<BinaryOperator> compound_assignment_operator(TokenType tt) {
+  switch (tt) {
+    case TokenType::PLUS_ASSIGN:
+      return BinaryOperator::PLUS;
+    case TokenType::MINUS_ASSIGN:
+      return BinaryOperator::MINUS;
+    case TokenType::TIMES_ASSIGN:
+      return BinaryOperator::TIMES;
+    case TokenType::DIVIDE_ASSIGN:
+      return BinaryOperator::DIVIDE;
+    case TokenType::OR_ASSIGN:
+      return BinaryOperator::BITOR;
+    case TokenType::XOR_ASSIGN:
+      return BinaryOperator::BITXOR;
+    case TokenType::AND_ASSIGN:
+      return BinaryOperator::BITAND;
+    default:
+      return none;
+  }
+}
+
 namespace internals {
 const int binary_operator_precedence[] = {
 #define MAKE_PRECEDENCE(NAME, VALUE, TOKEN) VALUE,
@@ -0,0 +1,318 @@
+#include "lsp/document.h"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/binary_operation.h"
+#include "ast/boolean_constant.h"
+#include "ast/function_argument_declaration.h"
+#include "ast/function_call.h"
+#include "ast/function_declaration.h"
+#include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/module.h"
+#include "ast/variable_reference.h"
+#include "lexer/lexer.h"
+#include "name_resolution/visitor.h"
+#include "parser/parser.h"
+#include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
+#include "visitor/visitor.h"
+
+namespace lsp {
+
+namespace {
+
+/// Collects the declarations without a type, before the type checker infers
+/// them.
+class InferredTypeCollector : public ast::ASTVisitor {
+ public:
+  explicit InferredTypeCollector(std::vector<Option<ast::Type>*>* types)
+      : types_(types) {}
+
+  void visit(ast::FunctionArgumentDeclaration* node) override {
+    collect(node);
+    ASTVisitor::visit(node);
+  }
+  void visit(ast::FunctionDeclaration* node) override {
+    collect(node);
+    ASTVisitor::visit(node);
+  }
+  void visit(ast::LocalVariableDeclaration* node) override {
+    collect(node);
+    ASTVisitor::visit(node);
+  }
+
+ private:
+  void collect(ast::Declaration* node) {
+    if (!node->type().is_ok()) types_->push_back(&node->type());
+  }
+
+  std::vector<Option<ast::Type>*>* types_;
+};
+
+/// Forgets the types of the values and the resolved names: the declarations
+/// that they point to may be gone.
+class AnalysisReset : public ast::ASTVisitor {
+ public:
+  void visit(ast::ArrayIndex* node) override { reset(node); }
+  void visit(ast::ArrayLength* node) override { reset(node); }
+  void visit(ast::ArrayLiteral* node) override { reset(node); }
+  void visit(ast::ArraySlice* node) override { reset(node); }
+  void visit(ast::BinaryOp* node) override { reset(node); }
+  void visit(ast::BooleanConstant* node) override { reset(node); }
+  void visit(ast::FunctionCall* node) override { reset(node); }
+  void visit(ast::IntConstant* node) override { reset(node); }
+  void visit(ast::VariableReference* node) override {
+    node->resolution() = none;
+    reset(node);
+  }
+  // The default values of the arguments are not visited by default.
+  void visit(ast::FunctionArgumentDeclaration* node) override {
+    if (node->value().is_ok()) node->value().value_or_die()->accept(*this);
+  }
+
+ private:
+  template <typename Node>
+  void reset(Node* node) {
+    node->type() = none;
+    ASTVisitor::visit(node);
+  }
+};
+
+Diagnostic make_diagnostic(int base_line, const lexer::Range* range,
+                           const std::string& message, bool is_error) {
+  Diagnostic diagnostic;
+  diagnostic.message = message;
+  diagnostic.is_error = is_error;
+  diagnostic.begin.line = base_line;
+  diagnostic.end.line = base_line;
+  if (range == nullptr) return diagnostic;
+  // The columns of the ranges start at 1, and include their end.
+  diagnostic.begin = {base_line + range->begin.line - 1,
+                      std::max(range->begin.column - 1, 0)};
+  diagnostic.end = {base_line + range->end.line - 1,
+                    std::max(range->end.column, 0)};
+  return diagnostic;
+}
+
+}  // namespace
+
+Document::Document(std::string text, std::vector<std::string> import_path)
+    : import_path_(std::move(import_path)) {
+  replace(std::move(text));
+}
+
+void Document::index_lines() {
+  line_offsets_.assign(1, 0);
+  for (auto newline = text_.find('\n'); newline != std::string::npos;
+       newline = text_.find('\n', newline + 1))
+    line_offsets_.push_back(newline + 1);
+}
+
+void Document::replace(std::string text) {
+  text_ = std::move(text);
+  index_lines();
+  parse_lines(0, line_count(), 0, chunks_.size());
+}
+
+void Document::edit(Position begin, Position end, const std::string& text) {
+  // Clamp the positions to the text.
+  auto clamp = [this](Position* position) {
+    position->line = std::min(std::max(position->line, 0), line_count() - 1);
+    auto line_begin = line_offsets_[static_cast<std::size_t>(position->line)];
+    auto line_end = position->line + 1 < line_count()
+                        ? line_offsets_[position->line + 1] - 1
+                        : text_.size();
+    position->character = static_cast<int>(
+        std::min(static_cast<std::size_t>(std::max(position->character, 0)),
+                 line_end - line_begin));
+    return line_begin + static_cast<std::size_t>(position->character);
+  };
+  auto begin_offset = clamp(&begin);
+  auto end_offset = clamp(&end);
+  if (end_offset < begin_offset) {
+    std::swap(begin, end);
+    std::swap(begin_offset, end_offset);
+  }
+  text_.replace(begin_offset, end_offset - begin_offset, text);
+  index_lines();
+  const int added_lines =
+      static_cast<int>(std::count(std::begin(text), std::end(text), '\n'));
+  const int line_shift = added_lines - (end.line - begin.line);
+
+  // The chunks that have the lines of the edit, before it.
+  std::size_t first = 0;
+  while (first + 1 < chunks_.size() &&
+         chunks_[first].first_line + chunks_[first].line_count <= begin.line)
+    ++first;
+  // The edit may complete the declaration of a chunk that didn't parse.
+  while (first > 0 && chunks_[first - 1].error.is_ok()) --first;
+  std::size_t last = first + 1;
+  while (last < chunks_.size() && chunks_[last].first_line <= end.line)
+    ++last;
+  for (auto i = last; i < chunks_.size(); ++i) {
+    chunks_[i].first_line += line_shift;
+    chunks_[i].base_line += line_shift;
+  }
+  const auto& last_chunk = chunks_[last - 1];
+  parse_lines(chunks_[first].first_line,
+              last_chunk.first_line + last_chunk.line_count + line_shift,
+              first, last);
+}
+
+void Document::parse_lines(int begin_line, int end_line,
+                           std::size_t first_chunk, std::size_t last_chunk) {
+  std::vector<Chunk> chunks;
+  parsed_lines_ = end_line - begin_line;
+  if (!parse_chunks(begin_line, end_line, &chunks) &&
+      end_line < line_count()) {
+    // The error may be further, e.g. if the declaration lost its closing
+    // brace: report it where the parse of the whole text stops. The parser
+    // stops at the first error, so it is usually close.
+    std::vector<Chunk> until_end;
+    parsed_lines_ = line_count() - begin_line;
+    if (parse_chunks(begin_line, line_count(), &until_end)) {
+      // The next chunks had an error that the edit fixed.
+      chunks = std::move(until_end);
+      last_chunk = chunks_.size();
+    } else {
+      chunks.back().error = std::move(until_end.back().error);
+    }
+  }
+  auto position = chunks_.erase(
+      std::begin(chunks_) + static_cast<std::ptrdiff_t>(first_chunk),
+      std::begin(chunks_) + static_cast<std::ptrdiff_t>(last_chunk));
+  chunks_.insert(position, std::make_move_iterator(std::begin(chunks)),
+                 std::make_move_iterator(std::end(chunks)));
+}
+
+bool Document::parse_chunks(int begin_line, int end_line,
+                            std::vector<Chunk>* chunks) {
+  auto tag = "#" + std::to_string(++parse_count_);
+  auto begin_offset = line_offsets_[static_cast<std::size_t>(begin_line)];
+  auto end_offset = end_line < line_count()
+                        ? line_offsets_[static_cast<std::size_t>(end_line)]
+                        : text_.size();
+  lexer::Lexer lexer(text_.substr(begin_offset, end_offset - begin_offset),
+                     lexer::Lexer::SourceTag::STRING, tag);
+  parser::Parser parser(&lexer);
+  auto module = parser.parse();
+
+  auto add_chunk = [&](int first_line) {
+    chunks->emplace_back();
+    auto& chunk = chunks->back();
+    chunk.first_line = first_line;
+    chunk.line_count = end_line - first_line;
+    chunk.base_line = begin_line;
+    chunk.tag = tag;
+    return &chunk;
+  };
+  if (!module.is_ok()) {
+    const auto& error = module.error_or_die();
+    // Like the ranges, relative to the first line.
+    add_chunk(begin_line)->error =
+        make_diagnostic(0, error.range(), error.message(), true);
+    return false;
+  }
+
+  transform::FunctionValueBodyTransformer value_body;
+  Chunk* chunk = add_chunk(begin_line);
+  for (auto& declaration : module.value_or_die()->release_declarations()) {
+    const auto& range = declaration->location();
+    // A declaration that starts where the previous one ends goes with it.
+    if (!chunk->declarations.empty() &&
+        begin_line + range.begin.line - 1 >=
+            chunk->first_line + chunk->line_count) {
+      chunk = add_chunk(chunk->first_line + chunk->line_count);
+    }
+    chunk->line_count = begin_line + range.end.line - chunk->first_line;
+    declaration->accept(value_body);
+    InferredTypeCollector collector(&chunk->inferred_types);
+    declaration->accept(collector);
+    chunk->declarations.push_back(std::move(declaration));
+  }
+  // The last chunk has the lines after the last declaration.
+  chunk->line_count = end_line - chunk->first_line;
+  return true;
+}
+
+Diagnostic Document::to_diagnostic(const lexer::Range& range,
+                                   const std::string& message,
+                                   bool is_error) const {
+  // The chunk with the tag that has the line.
+  for (const auto& chunk : chunks_) {
+    if (chunk.tag != range.file) continue;
+    int line = chunk.base_line + range.begin.line - 1;
+    if (line >= chunk.first_line &&
+        line < chunk.first_line + chunk.line_count)
+      return make_diagnostic(chunk.base_line, &range, message, is_error);
+  }
+  // LCOV_EXCL_START: the ranges of the passes are in the chunks.
+  return make_diagnostic(0, nullptr, message, is_error);
+  // LCOV_EXCL_STOP
+}
+
+bool Document::analyze(const std::function<bool()>& cancelled) {
+  AnalysisReset reset;
+  for (auto& chunk : chunks_) {
+    for (auto type : chunk.inferred_types) *type = none;
+    for (const auto& declaration : chunk.declarations)
+      declaration->accept(reset);
+  }
+
+  // Like the compiler, only report the first parsing error if there is one.
+  std::vector<Diagnostic> diagnostics;
+  for (const auto& chunk : chunks_) {
+    if (!chunk.error.is_ok()) continue;
+    auto error = chunk.error.value_or_die();
+    error.begin.line += chunk.base_line;
+    error.end.line += chunk.base_line;
+    diagnostics_.assign(1, std::move(error));
+    return true;
+  }
+
+  bool declared = false;
+  for (const auto& chunk : chunks_) {
+    // Each parse checks it for its own declarations.
+    for (const auto& declaration : chunk.declarations) {
+      bool is_import =
+          declaration->node_type() == ast::NodeType::IMPORT_STATEMENT;
+      if (is_import && declared)
+        diagnostics.push_back(to_diagnostic(
+            declaration->location(),
+            "The imports must be before the declarations", true));
+      declared = declared || !is_import;
+    }
+  }
+
+  // Each pass needs the previous one to succeed, like in the compiler.
+  loader_ = std::make_unique<interface::InterfaceLoader>(import_path_);
+  name_resolution::NameResolver resolver;
+  resolver.set_interface_loader(loader_.get());
+  typechecker::TypeChecker type_checker;
+  for (ast::VisitorWithErrors<>* pass :
+       {static_cast<ast::VisitorWithErrors<>*>(&resolver),
+        static_cast<ast::VisitorWithErrors<>*>(&type_checker)}) {
+    for (const auto& chunk : chunks_) {
+      for (const auto& declaration : chunk.declarations) {
+        if (cancelled()) return false;
+        declaration->accept(*pass);
+      }
+    }
+    for (auto error : pass->error_list().errors())
+      diagnostics.push_back(
+          to_diagnostic(error.location(), error.message(), true));
+    for (auto warning : pass->error_list().warnings())
+      diagnostics.push_back(
+          to_diagnostic(warning.location(), warning.message(), false));
+    if (!pass->error_list().errors().empty()) break;
+  }
+  diagnostics_ = std::move(diagnostics);
+  return true;
+}
+
+}  // namespace lsp
@@ -0,0 +1,125 @@
+#pragma once
+
+/// This file contains the documents of the language server: the sources
+/// opened in the editor, with their AST and their diagnostics.
+///
+/// The AST is kept between the edits, split in chunks of whole lines with
+/// one or a few top-level declarations. An edit only lexes and parses the
+/// chunks whose lines it touches again: the chunks after it keep their AST,
+/// and are only moved by the number of lines that the edit added. For that,
+/// each parse gives its own name to its ranges (their file), and the ranges
+/// are relative to the first line of the parse: a chunk knows where its
+/// ranges start in the document.
+///
+/// The analysis (the name resolution and the type checking) is done on the
+/// whole document, from a clean AST: what the previous analysis added to the
+/// nodes (their types, the resolved names) is reset first.
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast/ast.h"
+#include "ast/base_types.h"
+#include "error/error.h"
+#include "interface/module_interface.h"
+#include "util/option.h"
+
+namespace lsp {
+
+/// A position in the text, like in the protocol: the line and the column
+/// start at 0. The columns are in bytes.
+struct Position {
+  int line = 0;
+  int character = 0;
+};
+
+inline bool operator==(const Position& left, const Position& right) {
+  return left.line == right.line && left.character == right.character;
+}
+
+struct Diagnostic {
+  Position begin;
+  /// Excluded.
+  Position end;
+  std::string message;
+  /// A warning otherwise.
+  bool is_error = true;
+};
+
+class Document {
+ public:
+  /// The imports are looked up in these directories.
+  Document(std::string text, std::vector<std::string> import_path);
+
+  const std::string& text() const { return text_; }
+  int line_count() const { return static_cast<int>(line_offsets_.size()); }
+
+  /// Replace the text between the positions (clamped to the text) with this
+  /// one, and parse the chunks that changed.
+  void edit(Position begin, Position end, const std::string& text);
+  /// Replace the whole text, and parse it again.
+  void replace(std::string text);
+
+  /// The number of lines parsed by the last edit, to check that it was
+  /// incremental.
+  int parsed_lines() const { return parsed_lines_; }
+  std::size_t chunk_count() const { return chunks_.size(); }
+
+  /// Resolve the names and check the types of the whole document, or only
+  /// report the first parsing error if there is one, like the compiler.
+  /// Stops, and returns false, if `cancelled' returns true: it is called
+  /// between the declarations.
+  bool analyze(const std::function<bool()>& cancelled);
+
+  /// The diagnostics of the last analysis.
+  const std::vector<Diagnostic>& diagnostics() const { return diagnostics_; }
+
+ private:
+  /// Lines of the text, with the top-level declarations that start in them.
+  struct Chunk {
+    /// From 0, in the document.
+    int first_line = 0;
+    int line_count = 0;
+    /// The line of the document where the line 1 of the ranges of the AST
+    /// is.
+    int base_line = 0;
+    /// The name of the parse, in the ranges.
+    std::string tag;
+    std::vector<std::unique_ptr<ast::ASTNode>> declarations;
+    /// The types of the declarations that have none in the source: the type
+    /// checker infers them.
+    std::vector<Option<ast::Type>*> inferred_types;
+    /// The lexing or parsing error, which stops the parse of the chunk, in
+    /// lines relative to the base line. It may be after the chunk.
+    Option<Diagnostic> error = none;
+  };
+
+  void index_lines();
+  /// Parse the lines, and replace the chunks from first to last (excluded)
+  /// with the result. If they don't parse, they make one chunk with the
+  /// error, and the next chunks are kept.
+  void parse_lines(int begin_line, int end_line, std::size_t first_chunk,
+                   std::size_t last_chunk);
+  /// Parse the lines as a new series of chunks. False if they don't parse.
+  bool parse_chunks(int begin_line, int end_line, std::vector<Chunk>* chunks);
+  /// The diagnostic of an error of a pass, in the chunks that have its tag.
+  Diagnostic to_diagnostic(const lexer::Range& range,
+                           const std::string& message, bool is_error) const;
+
+  std::string text_;
+  /// The offset of the first character of each line.
+  std::vector<std::size_t> line_offsets_;
+  std::vector<Chunk> chunks_;
+  std::vector<std::string> import_path_;
+  // The imported declarations belong to the loader, until the next analysis.
+  std::unique_ptr<interface::InterfaceLoader> loader_;
+  std::vector<Diagnostic> diagnostics_;
+  int parsed_lines_ = 0;
+  // The parses are numbered, to tag their ranges.
+  int parse_count_ = 0;
+};
+
+}  // namespace lsp
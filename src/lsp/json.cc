@@ -0,0 +1,311 @@
+#include "lsp/json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace lsp {
+
+namespace {
+
+// Deeper values are errors, rather than overflowing the stack.
+constexpr int k_max_depth = 256;
+
+class Parser {
+ public:
+  explicit Parser(const std::string& text) : text_(text) {}
+
+  ErrorOr<Json> parse_text() {
+    RETURN_OR_MOVE(Json value, parse_value(0));
+    skip_spaces();
+    if (position_ != text_.size()) return error("Unexpected data");
+    return std::move(value);
+  }
+
+ private:
+  GenericError error(const std::string& message) const {
+    return GenericError(message + " at offset " + std::to_string(position_) +
+                        " of the JSON text");
+  }
+
+  void skip_spaces() {
+    while (position_ < text_.size() &&
+           (text_[position_] == ' ' || text_[position_] == '\t' ||
+            text_[position_] == '\n' || text_[position_] == '\r'))
+      ++position_;
+  }
+
+  bool consume(const char* word) {
+    std::size_t size = std::char_traits<char>::length(word);
+    if (text_.compare(position_, size, word) != 0) return false;
+    position_ += size;
+    return true;
+  }
+
+  ErrorOr<Json> parse_value(int depth) {
+    if (depth > k_max_depth) return error("Too deep");
+    skip_spaces();
+    if (position_ == text_.size()) return error("Expected a value");
+    switch (text_[position_]) {
+      case '{':
+        return parse_object(depth);
+      case '[':
+        return parse_array(depth);
+      case '"': {
+        RETURN_OR_MOVE(std::string value, parse_string());
+        return Json(std::move(value));
+      }
+      default:
+        break;
+    }
+    if (consume("null")) return Json();
+    if (consume("true")) return Json(true);
+    if (consume("false")) return Json(false);
+    return parse_number();
+  }
+
+  ErrorOr<Json> parse_object(int depth) {
+    ++position_;
+    Json::Object members;
+    skip_spaces();
+    if (consume("}")) return Json(std::move(members));
+    while (true) {
+      skip_spaces();
+      if (position_ == text_.size() || text_[position_] != '"')
+        return error("Expected a member name");
+      RETURN_OR_MOVE(std::string key, parse_string());
+      skip_spaces();
+      if (!consume(":")) return error("Expected `:'");
+      RETURN_OR_MOVE(Json value, parse_value(depth + 1));
+      members.emplace_back(std::move(key), std::move(value));
+      skip_spaces();
+      if (consume("}")) return Json(std::move(members));
+      if (!consume(",")) return error("Expected `,' or `}'");
+    }
+  }
+
+  ErrorOr<Json> parse_array(int depth) {
+    ++position_;
+    Json::Array elements;
+    skip_spaces();
+    if (consume("]")) return Json(std::move(elements));
+    while (true) {
+      RETURN_OR_MOVE(Json value, parse_value(depth + 1));
+      elements.push_back(std::move(value));
+      skip_spaces();
+      if (consume("]")) return Json(std::move(elements));
+      if (!consume(",")) return error("Expected `,' or `]'");
+    }
+  }
+
+  ErrorOr<Json> parse_number() {
+    const char* begin = text_.c_str() + position_;
+    // strtod accepts more than JSON (hexadecimal, inf...): check the first
+    // character.
+    if (*begin != '-' && (*begin < '0' || *begin > '9'))
+      return error("Expected a value");
+    char* end;
+    double value = std::strtod(begin, &end);
+    position_ += static_cast<std::size_t>(end - begin);
+    return Json(value);
+  }
+
+  /// Read the 4 hexadecimal digits of a \u escape.
+  bool parse_hex(unsigned int* code) {
+    if (position_ + 4 > text_.size()) return false;
+    *code = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = text_[position_++];
+      *code <<= 4;
+      if (c >= '0' && c <= '9')
+        *code |= static_cast<unsigned int>(c - '0');
+      else if (c >= 'a' && c <= 'f')
+        *code |= static_cast<unsigned int>(c - 'a' + 10);
+      else if (c >= 'A' && c <= 'F')
+        *code |= static_cast<unsigned int>(c - 'A' + 10);
+      else
+        return false;
+    }
+    return true;
+  }
+
+  static void append_utf8(unsigned int code, std::string* out) {
+    if (code < 0x80) {
+      out->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      out->push_back(static_cast<char>(0xc0 | (code >> 6)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+      out->push_back(static_cast<char>(0xe0 | (code >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+      out->push_back(static_cast<char>(0xf0 | (code >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+  }
+
+  ErrorOr<std::string> parse_string() {
+    ++position_;
+    std::string value;
+    while (position_ < text_.size()) {
+      char c = text_[position_++];
+      if (c == '"') return std::move(value);
+      if (c != '\\') {
+        value.push_back(c);
+        continue;
+      }
+      if (position_ == text_.size()) break;
+      c = text_[position_++];
+      switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+          value.push_back(c);
+          break;
+        case 'b':
+          value.push_back('\b');
+          break;
+        case 'f':
+          value.push_back('\f');
+          break;
+        case 'n':
+          value.push_back('\n');
+          break;
+        case 'r':
+          value.push_back('\r');
+          break;
+        case 't':
+          value.push_back('\t');
+          break;
+        case 'u': {
+          unsigned int code;
+          if (!parse_hex(&code)) return error("Invalid \\u escape");
+          // A surrogate pair is one character.
+          unsigned int low;
+          if (code >= 0xd800 && code < 0xdc00 && consume("\\u") &&
+              parse_hex(&low) && low >= 0xdc00 && low < 0xe000)
+            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          append_utf8(code, &value);
+          break;
+        }
+        default:
+          return error("Invalid escape");
+      }
+    }
+    return error("Unterminated string");
+  }
+
+  const std::string& text_;
+  std::size_t position_ = 0;
+};
+
+void write_string(const std::string& value, std::string* out) {
+  out->push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        *out += "\\\"";
+        break;
+      case '\\':
+        *out += "\\\\";
+        break;
+      case '\n':
+        *out += "\\n";
+        break;
+      case '\r':
+        *out += "\\r";
+        break;
+      case '\t':
+        *out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          *out += escaped;
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+ErrorOr<Json> Json::parse(const std::string& text) {
+  return Parser(text).parse_text();
+}
+
+const Json& Json::operator[](const std::string& key) const {
+  static const Json null_value;
+  for (const auto& member : object_)
+    if (member.first == key) return member.second;
+  return null_value;
+}
+
+bool Json::has(const std::string& key) const {
+  for (const auto& member : object_)
+    if (member.first == key) return true;
+  return false;
+}
+
+std::string Json::to_string() const {
+  std::string out;
+  write(&out);
+  return out;
+}
+
+void Json::write(std::string* out) const {
+  switch (type_) {
+    case Type::NULL_VALUE:
+      *out += "null";
+      return;
+    case Type::BOOLEAN:
+      *out += boolean_ ? "true" : "false";
+      return;
+    case Type::NUMBER: {
+      char number[32];
+      // The integers, like the ids and the positions, are written as such.
+      if (std::floor(number_) == number_ && std::fabs(number_) < 1e15)
+        std::snprintf(number, sizeof(number), "%lld",
+                      static_cast<long long>(number_));  // NOLINT
+      else
+        std::snprintf(number, sizeof(number), "%.17g", number_);
+      *out += number;
+      return;
+    }
+    case Type::STRING:
+      write_string(string_, out);
+      return;
+    case Type::ARRAY: {
+      out->push_back('[');
+      const char* separator = "";
+      for (const auto& element : array_) {
+        *out += separator;
+        element.write(out);
+        separator = ",";
+      }
+      out->push_back(']');
+      return;
+    }
+    case Type::OBJECT: {
+      out->push_back('{');
+      const char* separator = "";
+      for (const auto& member : object_) {
+        *out += separator;
+        write_string(member.first, out);
+        out->push_back(':');
+        member.second.write(out);
+        separator = ",";
+      }
+      out->push_back('}');
+      return;
+    }
+  }
+}
+
+}  // namespace lsp
@@ -0,0 +1,84 @@
+#pragma once
+
+/// This file contains the JSON values of the language server protocol: what
+/// the messages are made of.
+///
+/// Example:
+/// auto message = lsp::Json::parse(R"({"id": 1, "method": "shutdown"})");
+/// auto id = message.value_or_die()["id"].number();
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "error/error.h"
+
+namespace lsp {
+
+class Json {
+ public:
+  enum class Type { NULL_VALUE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+  using Array = std::vector<Json>;
+  /// The members are kept in their order.
+  using Object = std::vector<std::pair<std::string, Json>>;
+
+  Json() = default;
+  Json(std::nullptr_t) {}  // NOLINT: implicit
+  Json(bool value) : type_(Type::BOOLEAN), boolean_(value) {}  // NOLINT
+  Json(int value) : Json(static_cast<double>(value)) {}        // NOLINT
+  Json(std::int64_t value)                                      // NOLINT
+      : Json(static_cast<double>(value)) {}
+  Json(double value) : type_(Type::NUMBER), number_(value) {}  // NOLINT
+  Json(std::string value)                                      // NOLINT
+      : type_(Type::STRING),
+        string_(std::move(value)) {}
+  Json(const char* value) : Json(std::string(value)) {}  // NOLINT
+  Json(Array value)                                      // NOLINT
+      : type_(Type::ARRAY),
+        array_(std::move(value)) {}
+  Json(Object value)  // NOLINT
+      : type_(Type::OBJECT),
+        object_(std::move(value)) {}
+
+  /// Parse a whole JSON text.
+  static ErrorOr<Json> parse(const std::string& text);
+
+  Type type() const { return type_; }
+  bool is_null() const { return type_ == Type::NULL_VALUE; }
+  bool is_number() const { return type_ == Type::NUMBER; }
+  bool is_string() const { return type_ == Type::STRING; }
+  bool is_array() const { return type_ == Type::ARRAY; }
+  bool is_object() const { return type_ == Type::OBJECT; }
+
+  /// The values, or false, 0, or empty for the other types.
+  bool boolean() const { return boolean_; }
+  double number() const { return number_; }
+  const std::string& string() const { return string_; }
+  const Array& array() const { return array_; }
+  const Object& object() const { return object_; }
+
+  /// The member of an object, or null if there is no such member (or if it
+  /// is not an object): the optional fields can be read without checks.
+  const Json& operator[](const std::string& key) const;
+  bool has(const std::string& key) const;
+
+  /// The compact JSON text.
+  std::string to_string() const;
+
+ private:
+  void write(std::string* out) const;
+
+  Type type_ = Type::NULL_VALUE;
+  bool boolean_ = false;
+  double number_ = 0;
+  std::string string_;
+  Array array_;
+  Object object_;
+};
+
+inline bool operator==(const Json& left, const Json& right) {
+  return left.to_string() == right.to_string();
+}
+
+}  // namespace lsp
@@ -0,0 +1,41 @@
+#include <libgen.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lsp/server.h"
+#include "util/gflags_utils.h"
+#include "util/logging.h"
+
+DECLARE_bool(logtostderr);
+
+// LCOV_EXCL_START: main is not tested
+
+DEFINE_string(import_path, "",
+              "Colon-separated directories in which the interfaces (.ghi) of "
+              "the imported modules are searched, after the directory of the "
+              "document, like in gracc");
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage(
+      std::string("Language server for gHopper: speaks the Language Server "
+                  "Protocol on the standard input and output, and publishes "
+                  "the diagnostics of the open documents.\n\nUsage: ") +
+      basename(argv[0]) + " [FLAGS]");  // NOLINT
+  gflags::GFlagsWrapper w(&argc, &argv, true);
+
+  std::vector<std::string> import_path;
+  std::istringstream directories(FLAGS_import_path);
+  std::string directory;
+  while (std::getline(directories, directory, ':'))
+    if (!directory.empty()) import_path.push_back(directory);
+
+  // The standard output only has the messages: the logs go to stderr.
+  FLAGS_logtostderr = true;
+  std::ios::sync_with_stdio(false);
+  lsp::Server server(&std::cin, &std::cout, std::move(import_path));
+  return server.run();
+}
+
+// LCOV_EXCL_STOP
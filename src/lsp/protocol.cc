@@ -0,0 +1,44 @@
+#include "lsp/protocol.h"
+
+#include <cstdlib>
+
+namespace lsp {
+
+namespace {
+
+constexpr char k_content_length[] = "Content-Length:";
+
+}  // namespace
+
+ErrorOr<std::string> read_content(std::istream* in) {
+  std::size_t length = 0;
+  bool has_length = false;
+  std::string line;
+  while (true) {
+    if (!std::getline(*in, line)) return GenericError("End of the input");
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    // The headers end with an empty line.
+    if (line.empty()) break;
+    if (line.compare(0, sizeof(k_content_length) - 1, k_content_length) ==
+        0) {
+      char* end;
+      const char* value = line.c_str() + sizeof(k_content_length) - 1;
+      length = std::strtoull(value, &end, 10);
+      has_length = end != value;
+    }
+    // The other headers (Content-Type) are ignored.
+  }
+  if (!has_length) return GenericError("Missing Content-Length header");
+  std::string content(length, '\0');
+  if (!in->read(&content[0], static_cast<std::streamsize>(length)))
+    return GenericError("End of the input in a message");
+  return std::move(content);
+}
+
+void write_message(const Json& message, std::ostream* out) {
+  auto content = message.to_string();
+  *out << k_content_length << ' ' << content.size() << "\r\n\r\n" << content;
+  out->flush();
+}
+
+}  // namespace lsp
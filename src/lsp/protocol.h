@@ -0,0 +1,26 @@
+#pragma once
+
+/// This file contains the framing of the language server protocol: each
+/// message is a JSON text preceded by headers, like in HTTP:
+///
+///   Content-Length: 52\r\n
+///   \r\n
+///   {"jsonrpc":"2.0","id":1,"method":"shutdown"}
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "error/error.h"
+#include "lsp/json.h"
+
+namespace lsp {
+
+/// Read the headers and the content of the next message. An error at the end
+/// of the input, or if the headers are malformed.
+ErrorOr<std::string> read_content(std::istream* in);
+
+/// Write the message with its headers, and flush it.
+void write_message(const Json& message, std::ostream* out);
+
+}  // namespace lsp
@@ -0,0 +1,297 @@
+#include "lsp/server.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include "HopperConfig.h"
+
+#include "lsp/protocol.h"
+#include "util/logging.h"
+
+namespace lsp {
+
+namespace {
+
+// The error codes of the protocol.
+constexpr int k_parse_error = -32700;
+constexpr int k_method_not_found = -32601;
+constexpr int k_server_not_initialized = -32002;
+
+// The kinds of text synchronization.
+constexpr int k_incremental_sync = 2;
+
+// The severities of the diagnostics.
+constexpr int k_error = 1;
+constexpr int k_warning = 2;
+
+/// The path of a file URI, or empty for the other URIs.
+std::string uri_path(const std::string& uri) {
+  const std::string scheme = "file://";
+  if (uri.compare(0, scheme.size(), scheme) != 0) return "";
+  std::string path;
+  for (std::size_t i = scheme.size(); i < uri.size(); ++i) {
+    if (uri[i] == '%' && i + 2 < uri.size()) {
+      path.push_back(static_cast<char>(
+          std::strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16)));
+      i += 2;
+    } else {
+      path.push_back(uri[i]);
+    }
+  }
+  return path;
+}
+
+Position to_position(const Json& position) {
+  Position result;
+  result.line = static_cast<int>(position["line"].number());
+  result.character = static_cast<int>(position["character"].number());
+  return result;
+}
+
+Json to_json(const Position& position) {
+  return Json::Object{{"line", position.line},
+                      {"character", position.character}};
+}
+
+}  // namespace
+
+Server::Server(std::istream* in, std::ostream* out,
+               std::vector<std::string> import_path)
+    : in_(in), out_(out), import_path_(std::move(import_path)) {
+  // Like std::cin, the input may flush the output when it is read: that
+  // would race with the worker, which writes the diagnostics.
+  in_->tie(nullptr);
+}
+
+int Server::run() {
+  std::thread worker(&Server::work, this);
+  int exit_code = 1;
+  while (true) {
+    auto content = read_content(in_);
+    if (!content.is_ok()) {
+      LOG(INFO) << content.error_or_die().to_string();
+      break;
+    }
+    auto message = Json::parse(content.value_or_die());
+    if (!message.is_ok()) {
+      reply_error(Json(), k_parse_error, message.error_or_die().to_string());
+      continue;
+    }
+    if (!handle(message.value_or_die())) {
+      exit_code = shutdown_ ? 0 : 1;
+      break;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    has_changes_ = true;
+  }
+  changed_.notify_all();
+  worker.join();
+  return exit_code;
+}
+
+bool Server::handle(const Json& message) {
+  const auto& method = message["method"].string();
+  const auto& id = message["id"];
+  const auto& params = message["params"];
+  // The responses to the requests of the server have no method.
+  const bool is_request = message.has("id") && message.has("method");
+  if (method == "exit") return false;
+  if (method == "initialize") {
+    initialized_ = true;
+    Json::Object capabilities = {
+        {"textDocumentSync", Json::Object{{"openClose", true},
+                                          {"change", k_incremental_sync}}}};
+    // The columns are in bytes: that's UTF-8, if the editor knows it.
+    for (const auto& encoding :
+         params["capabilities"]["general"]["positionEncodings"].array()) {
+      if (encoding.string() == "utf-8")
+        capabilities.emplace_back("positionEncoding", "utf-8");
+    }
+    reply(id, Json::Object{
+                  {"capabilities", std::move(capabilities)},
+                  {"serverInfo", Json::Object{{"name", "gracc-lsp"},
+                                              {"version",
+                                               ghopper_version_string}}}});
+    return true;
+  }
+  if (!initialized_) {
+    if (is_request)
+      reply_error(id, k_server_not_initialized, "Not initialized");
+    return true;
+  }
+
+  const auto& document = params["textDocument"];
+  Change change;
+  change.uri = document["uri"].string();
+  change.version = static_cast<std::int64_t>(document["version"].number());
+  if (method == "shutdown") {
+    // The diagnostics of the last changes are published first.
+    wait_until_idle();
+    shutdown_ = true;
+    reply(id, Json());
+  } else if (method == "textDocument/didOpen") {
+    change.kind = Change::Kind::OPEN;
+    change.content = document["text"];
+    queue(std::move(change));
+  } else if (method == "textDocument/didChange") {
+    change.kind = Change::Kind::EDIT;
+    change.content = params["contentChanges"];
+    queue(std::move(change));
+  } else if (method == "textDocument/didClose") {
+    change.kind = Change::Kind::CLOSE;
+    queue(std::move(change));
+  } else if (is_request) {
+    reply_error(id, k_method_not_found, "Unknown method " + method);
+  }
+  // The other notifications are ignored.
+  return true;
+}
+
+void Server::queue(Change change) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_.push_back(std::move(change));
+    has_changes_ = true;
+  }
+  changed_.notify_all();
+}
+
+void Server::wait_until_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return changes_.empty() && !busy_; });
+}
+
+void Server::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this]() { return stopping_ || !changes_.empty(); });
+    if (stopping_) return;
+    busy_ = true;
+    // Until the analysis isn't cancelled by new changes.
+    while (!changes_.empty() && !stopping_) {
+      std::deque<Change> changes;
+      changes.swap(changes_);
+      has_changes_ = false;
+      lock.unlock();
+      for (const auto& change : changes) apply(change);
+      analyze();
+      lock.lock();
+    }
+    busy_ = false;
+    idle_.notify_all();
+  }
+}
+
+void Server::apply(const Change& change) {
+  if (change.kind == Change::Kind::OPEN) {
+    // The imports are searched next to the file first, like in gracc.
+    auto import_path = import_path_;
+    auto path = uri_path(change.uri);
+    if (!path.empty()) {
+      auto last = path.find_last_of('/');
+      import_path.insert(std::begin(import_path),
+                         last == std::string::npos ? ""
+                                                   : path.substr(0, last));
+    }
+    auto& open = documents_[change.uri];
+    open.document = std::make_unique<Document>(change.content.string(),
+                                               std::move(import_path));
+    open.version = change.version;
+    changed_documents_.insert(change.uri);
+    return;
+  }
+  auto found = documents_.find(change.uri);
+  if (found == std::end(documents_)) return;
+  auto& open = found->second;
+  if (change.kind == Change::Kind::CLOSE) {
+    documents_.erase(found);
+    changed_documents_.erase(change.uri);
+    // The editor forgets the diagnostics of the closed documents.
+    send(Json::Object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/publishDiagnostics"},
+        {"params", Json::Object{{"uri", change.uri},
+                                {"diagnostics", Json::Array()}}}});
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (const auto& edit : change.content.array()) {
+    if (edit.has("range")) {
+      open.document->edit(to_position(edit["range"]["start"]),
+                          to_position(edit["range"]["end"]),
+                          edit["text"].string());
+    } else {
+      open.document->replace(edit["text"].string());
+    }
+  }
+  LOG(DEBUG) << "Parsed " << open.document->parsed_lines() << " lines of "
+             << change.uri << " in "
+             << std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count()
+             << "us";
+  open.version = change.version;
+  changed_documents_.insert(change.uri);
+}
+
+bool Server::analyze() {
+  for (auto uri = std::begin(changed_documents_);
+       uri != std::end(changed_documents_);) {
+    auto start = std::chrono::steady_clock::now();
+    auto& document = *documents_[*uri].document;
+    if (!document.analyze([this]() { return has_changes_.load(); })) {
+      LOG(DEBUG) << "Cancelled the analysis of " << *uri;
+      return false;
+    }
+    LOG(DEBUG) << "Analyzed " << *uri << " in "
+               << std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count()
+               << "us";
+    publish_diagnostics(*uri);
+    uri = changed_documents_.erase(uri);
+  }
+  return true;
+}
+
+void Server::publish_diagnostics(const std::string& uri) {
+  const auto& open = documents_[uri];
+  Json::Array diagnostics;
+  for (const auto& diagnostic : open.document->diagnostics()) {
+    diagnostics.push_back(Json::Object{
+        {"range", Json::Object{{"start", to_json(diagnostic.begin)},
+                               {"end", to_json(diagnostic.end)}}},
+        {"severity", diagnostic.is_error ? k_error : k_warning},
+        {"source", "gracc"},
+        {"message", diagnostic.message}});
+  }
+  send(Json::Object{
+      {"jsonrpc", "2.0"},
+      {"method", "textDocument/publishDiagnostics"},
+      {"params", Json::Object{{"uri", uri},
+                              {"version", open.version},
+                              {"diagnostics", std::move(diagnostics)}}}});
+}
+
+void Server::send(const Json& message) {
+  std::lock_guard<std::mutex> lock(out_mutex_);
+  write_message(message, out_);
+}
+
+void Server::reply(const Json& id, Json result) {
+  send(Json::Object{
+      {"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void Server::reply_error(const Json& id, int code, const std::string& message) {
+  send(Json::Object{
+      {"jsonrpc", "2.0"},
+      {"id", id},
+      {"error", Json::Object{{"code", code}, {"message", message}}}});
+}
+
+}  // namespace lsp
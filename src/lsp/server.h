@@ -0,0 +1,96 @@
+#pragma once
+
+/// This file contains the language server: it reads the messages of the
+/// editor (see protocol.h), keeps the open documents (see document.h), and
+/// publishes their diagnostics.
+///
+/// The messages are read on the calling thread, which only queues the
+/// changes of the documents. A worker thread applies them, in order, and
+/// analyzes the documents that changed. A new change cancels the analysis in
+/// progress: the worker applies it first, and starts the analysis again, so
+/// that the diagnostics of a version that is already stale are not computed
+/// to the end.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lsp/document.h"
+#include "lsp/json.h"
+
+namespace lsp {
+
+class Server {
+ public:
+  /// The imports are searched in the directory of the document, then in the
+  /// import path.
+  Server(std::istream* in, std::ostream* out,
+         std::vector<std::string> import_path);
+
+  /// Serve until the exit notification, or the end of the input. Returns the
+  /// exit code: 0 if the shutdown was requested before.
+  int run();
+
+ private:
+  /// A change of a document, applied by the worker.
+  struct Change {
+    enum class Kind { OPEN, EDIT, CLOSE };
+    Kind kind = Kind::OPEN;
+    std::string uri;
+    std::int64_t version = 0;
+    /// The new text for OPEN, and the contentChanges for EDIT.
+    Json content;
+  };
+
+  /// Handle a request or a notification. False on the exit notification.
+  bool handle(const Json& message);
+  void queue(Change change);
+  /// Wait until the worker applied the changes and published the
+  /// diagnostics.
+  void wait_until_idle();
+
+  void work();
+  void apply(const Change& change);
+  /// Analyze the documents that changed. False if a new change cancelled it.
+  bool analyze();
+  void publish_diagnostics(const std::string& uri);
+
+  void send(const Json& message);
+  void reply(const Json& id, Json result);
+  void reply_error(const Json& id, int code, const std::string& message);
+
+  std::istream* in_;
+  std::ostream* out_;
+  std::mutex out_mutex_;
+  std::vector<std::string> import_path_;
+  bool initialized_ = false;
+  bool shutdown_ = false;
+
+  // Shared with the worker.
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::condition_variable idle_;
+  std::deque<Change> changes_;
+  std::atomic<bool> has_changes_{false};
+  bool busy_ = false;
+  bool stopping_ = false;
+
+  // Only used by the worker.
+  struct OpenDocument {
+    std::unique_ptr<Document> document;
+    std::int64_t version = 0;
+  };
+  std::unordered_map<std::string, OpenDocument> documents_;
+  /// The documents to analyze.
+  std::set<std::string> changed_documents_;
+};
+
+}  // namespace lsp
@@ -1,25 +1,112 @@
 #include <libgen.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "HopperConfig.h"
 
 #include "ast/module.h"
+#include "build/builder.h"
+#include "build/files.h"
 #include "codegen/codegen.h"
+#include "codegen/linker.h"
+#include "codegen/optimizer.h"
+#include "interface/module_interface.h"
+#include "interface/writer.h"
+#include "name_resolution/visitor.h"
 #include "parser/parser.h"
 #include "pretty_printer/pretty_printer.h"
+#include "serialization/reader.h"
+#include "serialization/writer.h"
+#include "transform/add_return.h"
+#include "transform/constant_folder.h"
 #include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
 #include "util/gflags_utils.h"
 #include "util/logging.h"
+#include "util/mapped_file.h"
+#include "util/time_report.h"
+#include "util/trace.h"
 
 // LCOV_EXCL_START: main is not tested
 
-std::string ir_filename(const std::string& filename) {
+DEFINE_bool(print_ast, false,
+            "Pretty-print the AST of each file to the standard output, before "
+            "its IR (see gh-format to format the files themselves)");
+DEFINE_bool(time_report, false,
+            "Print the time and memory used by each compilation phase, for "
+            "each file and in total, to stderr");
+DEFINE_string(trace_out, "",
+              "Write a trace of the compilation phases and of each top-level "
+              "declaration to this file, in the Chrome trace event format "
+              "(for chrome://tracing or Perfetto)");
+DEFINE_int32(optimize, 0,
+             "Optimization level of the generated IR, like the -O levels of "
+             "LLVM's opt (0 for none)");
+DEFINE_bool(profile_generate, false,
+            "Instrument the generated code to count the executions of its "
+            "branches. Link it with the profile runtime (e.g. with clang "
+            "-fprofile-generate), run it, and merge the profiles with "
+            "llvm-profdata for --profile_use");
+DEFINE_string(profile_use, "",
+              "Optimize with the branch weights and the function entry counts "
+              "of this profile (.profdata), generated with --profile_generate "
+              "and the same --lto setting");
+DEFINE_string(lto, "",
+              "Whole-program mode: link the IR of all the SOURCES into this "
+              "file, and optimize it as a whole, so that the functions can be "
+              "inlined across the files and the unused ones removed");
+DEFINE_string(lto_exports, "main",
+              "Comma-separated functions that stay visible outside of the "
+              "program linked with --lto, the others are internalized");
+DEFINE_bool(build, false,
+            "Build mode: compile the SOURCES in the order of their imports, "
+            "only if they or the interfaces that they import changed since "
+            "the previous build, several at once (see --jobs)");
+DEFINE_int32(jobs, 0,
+             "Number of files compiled at once by --build (0 for the number "
+             "of processors)");
+DEFINE_string(build_db, ".gracc_build",
+              "File in which --build records what it compiled, to find what "
+              "changed on the next build");
+DEFINE_string(ast_cache, "",
+              "Directory in which the parsed ASTs are cached, by the hash of "
+              "their source: the files that didn't change are not parsed "
+              "again");
+DEFINE_bool(write_interfaces, true,
+            "Write the interface (.ghi) of each of the SOURCES next to it, "
+            "for the modules that import it, even with --lto. --build always "
+            "writes them");
+DEFINE_string(import_path, "",
+              "Colon-separated directories in which the interfaces (.ghi) of "
+              "the imported modules are searched, after the directories of "
+              "the SOURCES. The interface of each file is written next to "
+              "it (see --write_interfaces), e.g. `import math;' uses the "
+              "math.ghi of math.gh");
+
+/// The file with the same name as the source, and the extension.
+std::string replace_extension(const std::string& filename,
+                              const std::string& extension) {
   auto last = filename.find_last_of(".");
   if (last == std::string::npos)
     throw std::invalid_argument("Filename " + filename +
                                 " does not end in '.gh'");
-  return filename.substr(0, last + 1) + "ll";
+  return filename.substr(0, last + 1) + extension;
+}
+
+std::string ir_filename(const std::string& filename) {
+  return replace_extension(filename, "ll");
+}
+
+std::string interface_filename(const std::string& filename) {
+  return replace_extension(filename, "ghi");
 }
 
 std::string get_usage_string(const std::string& program_name) {
@@ -31,44 +118,411 @@ Usage: )" +
          program_name + R"( [FLAGS] SOURCES)";
 }
 
+/// The items of a list separated by `separator`.
+std::vector<std::string> split_list(const std::string& list,
+                                    char separator = ',') {
+  std::vector<std::string> items;
+  std::istringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, separator)) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+/// The directory of the file, empty for the current one.
+std::string directory_of(const std::string& filename) {
+  auto last = filename.find_last_of('/');
+  return last == std::string::npos ? "" : filename.substr(0, last);
+}
+
+/// The directories in which the imports are searched: the directories of the
+/// sources, the one of the importing file first, then the --import_path.
+std::vector<std::string> import_search_path(
+    const std::string& input, const std::vector<std::string>& sources) {
+  std::vector<std::string> search_path = {directory_of(input)};
+  auto add = [&search_path](std::string directory) {
+    if (std::find(std::begin(search_path), std::end(search_path),
+                  directory) == std::end(search_path))
+      search_path.push_back(std::move(directory));
+  };
+  for (const auto& source : sources) add(directory_of(source));
+  for (auto& directory : split_list(FLAGS_import_path, ':'))
+    add(std::move(directory));
+  return search_path;
+}
+
+/// Instrument or annotate the module with the profile, then optimize it.
+/// Returns false if there was an error.
+bool optimize_module(llvm::Module* module) {
+  codegen::ProfileOptions profile;
+  profile.generate = FLAGS_profile_generate;
+  profile.use = FLAGS_profile_use;
+  if (profile.generate || !profile.use.empty()) {
+    util::ScopedPhase phase("Profile instrumentation");
+    if (!codegen::apply_profile(module, profile, &llvm::errs())) return false;
+  }
+  if (FLAGS_optimize > 0) {
+    util::ScopedPhase phase("Optimization");
+    codegen::optimize(module, FLAGS_optimize);
+  }
+  return true;
+}
+
+/// Run the visitor on the module as a timed phase, and print its errors.
+/// Returns false if there were errors.
+template <typename Visitor>
+bool run_pass(ast::Module* module, Visitor* visitor, const char* phase_name) {
+  {
+    util::ScopedPhase phase(phase_name);
+    module->accept(*visitor);
+  }
+  for (auto const& error : visitor->error_list().errors()) {
+    std::cerr << error.to_string() << '\n';
+  }
+  return visitor->error_list().errors().empty();
+}
+
+template <typename Visitor>
+bool run_pass(ast::Module* module, const char* phase_name) {
+  Visitor visitor;
+  return run_pass(module, &visitor, phase_name);
+}
+
+/// The file of the --ast_cache for the source with this hash.
+std::string ast_cache_filename(std::uint64_t source_hash) {
+  std::ostringstream filename;
+  filename << FLAGS_ast_cache << '/' << std::hex << std::setw(16)
+           << std::setfill('0') << source_hash << ".gha";
+  return filename.str();
+}
+
+/// Write the AST in the --ast_cache. The files compiled at the same time may
+/// have the same source.
+void write_ast_cache(ast::Module* module, std::uint64_t source_hash) {
+  util::ScopedPhase phase("AST cache writing");
+  auto filename = ast_cache_filename(source_hash);
+  std::ostringstream bytes;
+  serialization::write_ast(module, source_hash, &bytes);
+  auto replaced = util::replace_file(filename, bytes.str());
+  if (!replaced.is_ok())
+    LOG(WARNING) << "Could not write the AST: "
+                 << replaced.error_or_die().to_string();
+}
+
+/// Parse the file, and transform value functions (fun a() = 3;) into
+/// statement functions (fun a() { return 3; }). With --ast_cache, the AST is
+/// read from the cache if the source didn't change. Returns null if there
+/// was an error.
+std::unique_ptr<ast::Module> parse_file(const std::string& input) {
+  // The source is hashed if there is a cache.
+  bool use_cache = false;
+  std::uint64_t source_hash = 0;
+  if (!FLAGS_ast_cache.empty()) {
+    util::ScopedPhase phase("AST cache reading");
+    auto hash = build::hash_file(input);
+    if (hash.is_ok()) {
+      use_cache = true;
+      source_hash = hash.value_or_die();
+      auto cached = serialization::SerializedAST::open(
+          ast_cache_filename(source_hash));
+      if (cached.is_ok() &&
+          cached.value_or_die()->source_hash() == source_hash) {
+        auto module = cached.value_or_die()->to_module(input);
+        if (module.is_ok()) return module.consume_value_or_die();
+      }
+    }
+  }
+
+  auto lexer = lexer::from_file(input);
+  parser::Parser parser(&lexer);
+  auto result = [&parser]() {
+    util::ScopedPhase phase("Parsing");
+    return parser.parse();
+  }();
+  if (!result.is_ok()) {
+    std::cerr << result.to_string() << '\n';
+    return nullptr;
+  }
+  auto module = result.consume_value_or_die();
+
+  {
+    util::ScopedPhase phase("Function value body transform");
+    transform::FunctionValueBodyTransformer transformer;
+    module->accept(transformer);
+  }
+  if (use_cache) write_ast_cache(module.get(), source_hash);
+  return module;
+}
+
+/// Compile one file to its IR, in the context, and add the interfaces that
+/// it imported to `imports' if it is not null. Returns null if there was an
+/// error.
+std::unique_ptr<llvm::Module> compile_file(
+    const std::string& input, llvm::LLVMContext* context,
+    const std::vector<std::string>& sources,
+    std::vector<build::ImportRecord>* imports) {
+  LOG(DEBUG) << "Processing file " << input;
+  util::TraceScope trace("file", input);
+  auto parsed = parse_file(input);
+  if (parsed == nullptr) return nullptr;
+  ast::Module* module = parsed.get();
+  // The imported declarations belong to the loader, until the end of the
+  // code generation.
+  interface::InterfaceLoader loader(import_search_path(input, sources));
+  name_resolution::NameResolver resolver;
+  resolver.set_interface_loader(&loader);
+  bool resolved = run_pass(module, &resolver, "Name resolution");
+  if (imports != nullptr) {
+    for (auto& interface : loader.loaded()) {
+      build::ImportRecord import;
+      import.module = std::move(interface.first);
+      import.path = std::move(interface.second);
+      imports->push_back(std::move(import));
+    }
+  }
+  if (!resolved ||
+      !run_pass<typechecker::TypeChecker>(module, "Type checking") ||
+      !run_pass<transform::VoidFunctionReturnAdder>(module,
+                                                    "Return insertion"))
+    return nullptr;
+
+  if (FLAGS_write_interfaces || FLAGS_build) {
+    // Write the interface for the modules that import this one. It is
+    // replaced, not truncated: they may have mapped it.
+    util::ScopedPhase phase("Interface writing");
+    std::ostringstream interface;
+    interface::write_interface(*module, &interface);
+    auto replaced =
+        util::replace_file(interface_filename(input), interface.str());
+    if (!replaced.is_ok()) {
+      std::cerr << replaced.error_or_die().to_string() << '\n';
+      return nullptr;
+    }
+  }
+
+  if (FLAGS_print_ast) {
+    // Pretty-print the AST to standard output.
+    util::ScopedPhase phase("AST printing");
+    ast::PrettyPrinterVisitor printer(std::cout);
+    module->accept(printer);
+  }
+
+  // Evaluate the constant expressions and branches, to generate less IR.
+  if (!run_pass<transform::ConstantFolder>(module, "Constant folding"))
+    return nullptr;
+
+  // Generate the LLVM IR representation.
+  codegen::CodeGenerator generator(input, context);
+  {
+    util::ScopedPhase phase("Code generation");
+    module->accept(generator);
+  }
+  for (auto const& warning : generator.error_list().warnings()) {
+    std::cerr << warning.to_string() << std::endl;
+  }
+  for (auto const& error : generator.error_list().errors()) {
+    std::cerr << error.to_string() << '\n';
+  }
+  if (!generator.error_list().errors().empty()) return nullptr;
+
+  {
+    util::ScopedPhase phase("Verification");
+    std::string errors;
+    llvm::raw_string_ostream errors_stream(errors);
+    if (!generator.verify(&errors_stream)) {
+      // A bug of the compiler: don't write or optimize the invalid IR.
+      std::cerr << "Invalid IR generated for " << input << ":\n"
+                << errors_stream.str() << '\n';
+      return nullptr;
+    }
+  }
+
+  // The linked program is optimized as a whole.
+  if (FLAGS_lto.empty() && !optimize_module(&generator.get_module()))
+    return nullptr;
+  return generator.release_module();
+}
+
+/// Print the IR of the module to the file.
+void print_module(const llvm::Module& module, const std::string& filename) {
+  util::ScopedPhase phase("IR printing");
+  auto out = codegen::get_ostream_for_file(filename);
+  *out << module;
+}
+
+/// Link the modules and optimize them as a whole, into the --lto file.
+/// Returns false if there was an error.
+bool link_program(std::vector<std::unique_ptr<llvm::Module>> modules) {
+  util::TraceScope trace("file", FLAGS_lto);
+  std::unique_ptr<llvm::Module> program;
+  {
+    util::ScopedPhase phase("Linking");
+    program = codegen::link_program(
+        std::move(modules), split_list(FLAGS_lto_exports), &llvm::errs());
+  }
+  if (program == nullptr) return false;
+  program->setModuleIdentifier(FLAGS_lto);
+  if (!optimize_module(program.get())) return false;
+  print_module(*program, FLAGS_lto);
+  return true;
+}
+
+/// Compile the file and print its IR, unless it is linked. With
+/// --time_report, it is timed in its own report, merged in the total: the
+/// reports of the files compiled in parallel by --build are printed one at a
+/// time.
+std::unique_ptr<llvm::Module> compile_and_report(
+    const std::string& input, llvm::LLVMContext* context,
+    const std::vector<std::string>& sources, util::TimeReport* total_report,
+    std::vector<build::ImportRecord>* imports) {
+  util::TimeReport file_report(input);
+  util::TimeReport::set_active(FLAGS_time_report ? &file_report : nullptr);
+  auto module = compile_file(input, context, sources, imports);
+  if (module != nullptr && FLAGS_lto.empty())
+    print_module(*module, ir_filename(input));
+  util::TimeReport::set_active(nullptr);
+  if (FLAGS_time_report) {
+    static std::mutex report_mutex;
+    std::lock_guard<std::mutex> lock(report_mutex);
+    file_report.print(std::cerr);
+    total_report->merge(file_report);
+  }
+  return module;
+}
+
+/// Compiles the files of --build, each in its own LLVM context.
+class BuildCompiler : public build::Compiler {
+ public:
+  BuildCompiler(const std::vector<std::string>* sources,
+                util::TimeReport* total_report)
+      : sources_(sources), total_report_(total_report) {}
+
+  bool compile(const std::string& source,
+               std::vector<build::ImportRecord>* imports) override {
+    llvm::LLVMContext context;
+    return compile_and_report(source, &context, *sources_, total_report_,
+                              imports) != nullptr;
+  }
+
+  std::string interface_path(const std::string& source) const override {
+    return interface_filename(source);
+  }
+
+  std::vector<std::string> outputs(const std::string& source) const override {
+    return {ir_filename(source), interface_filename(source)};
+  }
+
+ private:
+  const std::vector<std::string>* sources_;
+  util::TimeReport* total_report_;
+};
+
+/// The flags that change the outputs of the compilation: the files are
+/// compiled again by --build when they change.
+std::string build_configuration() {
+  std::ostringstream configuration;
+  configuration << ghopper_version_string << " --optimize=" << FLAGS_optimize
+                << " --profile_generate=" << FLAGS_profile_generate
+                << " --profile_use=" << FLAGS_profile_use
+                << " --import_path=" << FLAGS_import_path;
+  if (!FLAGS_profile_use.empty()) {
+    // A new profile is usually merged into the same path.
+    auto hash = build::hash_file(FLAGS_profile_use);
+    if (hash.is_ok())
+      configuration << " profile=" << std::hex << hash.value_or_die();
+  }
+  return configuration.str();
+}
+
+/// Build the sources with --build. Returns false if there was an error.
+bool build_sources(const std::vector<std::string>& sources,
+                   util::TimeReport* total_report) {
+  build::BuildOptions options;
+  options.database = FLAGS_build_db;
+  options.configuration = build_configuration();
+  options.jobs = FLAGS_jobs > 0
+                     ? static_cast<unsigned int>(FLAGS_jobs)
+                     : std::max(1u, std::thread::hardware_concurrency());
+  BuildCompiler compiler(&sources, total_report);
+  auto summary = build::run_build(sources, options, &compiler);
+  if (!summary.is_ok()) {
+    std::cerr << summary.error_or_die().to_string() << '\n';
+    return false;
+  }
+  const auto& result = summary.value_or_die();
+  std::cout << result.compiled << " compiled, " << result.up_to_date
+            << " up to date";
+  if (result.failed > 0) std::cout << ", " << result.failed << " failed";
+  std::cout << '\n';
+  return result.failed == 0;
+}
+
 int main(int argc, char* argv[]) {
   gflags::SetUsageMessage(get_usage_string(basename(argv[0])));  // NOLINT
   gflags::SetVersionString(ghopper_version_string);
   gflags::GFlagsWrapper w(&argc, &argv, true);
 
+  if (FLAGS_profile_generate && !FLAGS_profile_use.empty()) {
+    std::cerr << "--profile_generate and --profile_use can't be combined\n";
+    return 1;
+  }
+  if (FLAGS_build && !FLAGS_lto.empty()) {
+    std::cerr << "--build and --lto can't be combined\n";
+    return 1;
+  }
+  // The files of --build are compiled in parallel, their ASTs would be
+  // interleaved.
+  if (FLAGS_build && FLAGS_print_ast) {
+    std::cerr << "--build and --print_ast can't be combined\n";
+    return 1;
+  }
+  std::vector<std::string> sources(argv + 1, argv + argc);  // NOLINT
+
   codegen::LLVMInitializer llvm_initializer;
 
+  util::Tracer tracer;
+  if (!FLAGS_trace_out.empty()) {
+    util::Tracer::set_active(&tracer);
+    tracer.set_thread_name("main");
+  }
+
+  // The modules are linked in the same context.
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules;
+  util::TimeReport total_report("all files");
   int exit_code = 0;
-  for (int i = 1; i < argc; ++i) {
-    std::string input = argv[i];  // NOLINT: "pointer arithmetics"
-    log(DEBUG) << "Processing file " << input;
-    auto lexer = lexer::from_file(input);
-    auto parser = parser::Parser(&lexer);
-    auto result = parser.parse();
-    if (!result.is_ok()) {
-      std::cerr << result.to_string() << '\n';
+  if (FLAGS_build && !build_sources(sources, &total_report)) exit_code = 1;
+  for (const auto& input : sources) {
+    if (FLAGS_build) break;  // Already compiled.
+    auto module = compile_and_report(input, &context, sources, &total_report,
+                                     nullptr);
+    if (module == nullptr) {
       exit_code = 1;
       break;
-    } else {
-      // Transform value functions (fun a() = 3;) into statement functions
-      // (fun a() { return 3; }).
-      transform::FunctionValueBodyTransformer transformer;
-      result.value_or_die()->accept(transformer);
-
-      // Pretty-print the AST to standard output.
-      ast::PrettyPrinterVisitor printer(std::cout);
-      result.value_or_die()->accept(printer);
-
-      // Generate the LLVM IR representation.
-      codegen::CodeGenerator generator(input);
-      result.value_or_die()->accept(generator);
-      auto out = codegen::get_ostream_for_file(ir_filename(input));
-      // Print the IR to a file.
-      generator.print(*out);
-
-      for (auto const& warning : generator.error_list().warnings()) {
-        std::cerr << warning.to_string() << std::endl;
-      }
+    }
+    if (!FLAGS_lto.empty()) modules.push_back(std::move(module));
+  }
+  if (exit_code == 0 && !modules.empty()) {
+    util::TimeReport link_report(FLAGS_lto);
+    util::TimeReport::set_active(FLAGS_time_report ? &link_report : nullptr);
+    if (!link_program(std::move(modules))) exit_code = 1;
+    util::TimeReport::set_active(nullptr);
+    if (FLAGS_time_report) {
+      link_report.print(std::cerr);
+      total_report.merge(link_report);
+    }
+  }
+  if (FLAGS_time_report && sources.size() > 1)
+    total_report.print(std::cerr);
+
+  if (!FLAGS_trace_out.empty()) {
+    util::Tracer::set_active(nullptr);
+    std::ofstream trace_file(FLAGS_trace_out);
+    tracer.write(trace_file);
+    if (!trace_file) {
+      LOG(ERROR) << "Could not write the trace to " << FLAGS_trace_out;
+      exit_code = 1;
     }
   }
 
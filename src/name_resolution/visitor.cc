@@ -1,24 +1,46 @@
 #include "name_resolution/visitor.h"
 
+#include <algorithm>
+
+#include "ast/array_type.h"
 #include "ast/function_call.h"
 #include "ast/function_declaration.h"
+#include "ast/import_statement.h"
 #include "ast/local_variable_declaration.h"
 #include "ast/variable_reference.h"
 
 namespace name_resolution {
 void NameResolver::resolve_option_type(Option<ast::Type>* maybe_type) {
-  if (maybe_type->is_ok()) {
-    auto& type = maybe_type->value_or_die();
-    if (!type.is_resolved()) {
-      auto it = type_map_.find(type.id());
-      if (it == type_map_.end()) {
-        add_error(type.location(),
-                  "Could not resolve type: " + type.to_string());
-        return;
-      }
-      type.set_resolution(it->second);
+  if (maybe_type->is_ok()) resolve_type(&maybe_type->value_or_die());
+}
+
+bool NameResolver::resolve_type(ast::Type* type) {
+  if (type->is_resolved()) return true;
+  if (type->element() != nullptr) {
+    ast::Type element = *type->element();
+    if (!resolve_type(&element)) return false;
+    auto element_declaration = element.get_declaration();
+    if (!ast::types::int_type_to_width(element_declaration).is_ok() &&
+        element_declaration != &ast::types::boolean) {
+      add_error(element.location(),
+                "The elements of an array must be integers or booleans, got `" +
+                    element.to_string() + "'");
+      return false;
     }
+    if (type->size().is_ok())
+      type->set_resolution(ast::types::array_of(
+          element_declaration, type->size().value_or_die()));
+    else
+      type->set_resolution(ast::types::slice_of(element_declaration));
+    return true;
   }
+  auto it = type_map_.find(type->id());
+  if (it == type_map_.end()) {
+    add_error(type->location(), "Could not resolve type: " + type->to_string());
+    return false;
+  }
+  type->set_resolution(it->second);
+  return true;
 }
 
 void NameResolver::visit(ast::LocalVariableDeclaration* node) {
@@ -41,17 +63,66 @@ void NameResolver::visit_variable_declaration(ast::VariableDeclaration* node) {
   name_map_[node->id()] = node;
 }
 
+void NameResolver::visit(ast::ImportStatement* node) {
+  const auto& module = node->module();
+  if (loader_ == nullptr) {
+    add_error(module.location(),
+              "Could not find the interface of the module `" +
+                  module.to_string() + "'");
+    return;
+  }
+  auto interface = loader_->load(module.to_string());
+  if (!interface.is_ok()) {
+    add_error(module.location(), interface.error_or_die().to_string());
+    return;
+  }
+  if (std::find(std::begin(imports_), std::end(imports_),
+                interface.value_or_die()) == std::end(imports_))
+    imports_.push_back(interface.value_or_die());
+}
+
+bool NameResolver::find_imported(const ast::Identifier& id,
+                                 ast::Declaration** found) {
+  for (auto interface : imports_) {
+    auto function = interface->lookup(id.to_string());
+    if (!function.is_ok()) {
+      add_error(id.location(), function.error_or_die().to_string());
+      return false;
+    }
+    if (function.value_or_die() != nullptr) {
+      *found = function.value_or_die();
+      return true;
+    }
+  }
+  *found = nullptr;
+  return true;
+}
+
 void NameResolver::visit(ast::VariableReference* node) {
   auto it = name_map_.find(node->id());
-  if (it == name_map_.end())
+  if (it != name_map_.end()) {
+    node->resolution() = it->second;
+    return;
+  }
+  // The declarations of the module hide the imported ones.
+  ast::Declaration* imported = nullptr;
+  if (!find_imported(node->id(), &imported)) return;
+  if (imported == nullptr)
     add_error(node->id().location(),
               "No variable named `" + node->id().to_string() + "'");
   else
-    node->resolution() = it->second;
+    node->resolution() = imported;
 }
 
 void NameResolver::visit(ast::FunctionDeclaration* node) {
   resolve_option_type(&node->type());
+  auto it = name_map_.find(node->id());
+  if (it != name_map_.end())
+    add_warning(node->id().location(),
+                "Shadowing of a previously declared name: " +
+                    node->id().to_string());
+  // Declared before the body, for the recursive calls.
+  name_map_[node->id()] = node;
   ASTVisitor::visit(node);
 }
 }  // namespace name_resolution
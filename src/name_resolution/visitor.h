@@ -1,10 +1,12 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include "ast/ast.h"
 #include "ast/base_types.h"
 #include "ast/builtin_type.h"
+#include "interface/module_interface.h"
 #include "util/option.h"
 #include "visitor/error_visitor.h"
 
@@ -19,6 +21,13 @@ class NameResolver : public ast::VisitorWithErrors<> {
     }
   }
 
+  /// The interfaces of the imported modules are opened by the loader.
+  /// Without one, the imports are errors.
+  void set_interface_loader(interface::InterfaceLoader* loader) {
+    loader_ = loader;
+  }
+
+  void visit(ast::ImportStatement* node) override;
   void visit(ast::LocalVariableDeclaration* node) override;
   void visit(ast::FunctionDeclaration* node) override;
   void visit(ast::FunctionArgumentDeclaration* node) override;
@@ -27,8 +36,17 @@ class NameResolver : public ast::VisitorWithErrors<> {
  private:
   void visit_variable_declaration(ast::VariableDeclaration* node);
   void resolve_option_type(Option<ast::Type>* maybe_type);
+  /// Resolve the type, and the element of an array or slice type. False if
+  /// there was an error.
+  bool resolve_type(ast::Type* type);
+  /// Look up the name in the imported modules, in the order of the imports.
+  /// Returns null if there is no such declaration, and false if there was an
+  /// error.
+  bool find_imported(const ast::Identifier& id, ast::Declaration** found);
   std::unordered_map<ast::Identifier, ast::TypeDeclaration*> type_map_;
   std::unordered_map<ast::Identifier, ast::Declaration*> name_map_;
   Option<NameResolver*> parent_;
+  interface::InterfaceLoader* loader_ = nullptr;
+  std::vector<interface::ModuleInterface*> imports_;
 };
 }  // namespace name_resolution
@@ -1,19 +1,28 @@
 #include "parser/parser.h"
 
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/assignment.h"
 #include "ast/binary_operation.h"
 #include "ast/block_statement.h"
 #include "ast/boolean_constant.h"
+#include "ast/for_block.h"
 #include "ast/function_call.h"
 #include "ast/function_declaration.h"
 #include "ast/if_statement.h"
+#include "ast/import_statement.h"
 #include "ast/int_constant.h"
 #include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
 #include "ast/module.h"
 #include "ast/return_statement.h"
 #include "ast/value_statement.h"
 #include "ast/variable_declaration.h"
 #include "ast/variable_reference.h"
+#include "ast/while_block.h"
 #include "lexer/operators.h"
+#include "util/time_report.h"
+#include "util/trace.h"
 
 #define ASSERT_TOKEN(TYPE)                    \
   assert(current_token().type() == (TYPE) &&  \
@@ -31,6 +40,32 @@ using lexer::TokenType;
 using ast::Identifier;
 using ast::Type;
 
+namespace {
+
+bool is_int_token(TokenType type) {
+  return type == TokenType::INT || type == TokenType::HEX ||
+         type == TokenType::OCT || type == TokenType::BINARY_NUMBER;
+}
+
+// Whether the value can be evaluated twice: a variable or a constant.
+bool is_simple_value(const ast::Value& value) {
+  return value.node_type() == ast::NodeType::VARIABLE_REFERENCE ||
+         value.node_type() == ast::NodeType::INT_CONSTANT;
+}
+
+std::unique_ptr<ast::Value> copy_simple_value(const ast::Value& value) {
+  if (value.node_type() == ast::NodeType::INT_CONSTANT) {
+    const auto& constant = static_cast<const ast::IntConstant&>(value);
+    return std::make_unique<ast::IntConstant>(constant.location(),
+                                              constant.value());
+  }
+  const auto& variable = static_cast<const ast::VariableReference&>(value);
+  return std::make_unique<ast::VariableReference>(variable.location(),
+                                                  variable.id());
+}
+
+}  // namespace
+
 Parser::Parser(Lexer* lexer) : lexer_(lexer) {}
 
 ScopedLocation Parser::scoped_location() const { return ScopedLocation(this); }
@@ -63,14 +98,19 @@ ErrorOr<Option<ast::Identifier>> Parser::parse_identifier(IdentifierType type) {
   auto location = scoped_location();
   bool absolute = false;
   std::stringstream text;
-  text << current_token().text();
+  // The integer tokens have a value, not a text.
+  auto add_text = [this, &text]() {
+    if (current_token().value().is<std::string>())
+      text << current_token().text();
+  };
+  add_text();
   if (current_token().type() == TokenType::COLON_COLON) {
     if (type == IdentifierType::SIMPLE)
       return ParseError("Unexpected '::', expected unqualified id",
                         location.error_range());
     absolute = true;
     RETURN_IF_ERROR(get_token());
-    text << current_token().text();
+    add_text();
   }
   while (current_token().type() == TokenType::UPPER_CASE_IDENT) {
     RETURN_IF_ERROR(get_token());
@@ -96,8 +136,29 @@ ErrorOr<Option<ast::Identifier>> Parser::parse_identifier(IdentifierType type) {
 }
 
 ErrorOr<ast::Type> Parser::parse_type() {
-  RETURN_OR_MOVE(Identifier id, parse_type_identifier());
-  return Type(id);
+  auto location = scoped_location();
+  if (current_token().type() != TokenType::OPEN_BRACKET) {
+    RETURN_OR_MOVE(Identifier id, parse_type_identifier());
+    return Type(id);
+  }
+
+  RETURN_IF_ERROR(get_token());
+  RETURN_OR_MOVE(Type element, parse_type());
+  std::string name = "[" + element.to_string();
+  Option<std::uint64_t> size;
+  if (current_token().type() == TokenType::SEMICOLON) {
+    RETURN_IF_ERROR(get_token());
+    if (!is_int_token(current_token().type()))
+      return ParseError("Expected the size of the array",
+                        location.error_range());
+    size = static_cast<std::uint64_t>(current_token().int_value());
+    name += "; " + std::to_string(size.value_or_die());
+    RETURN_IF_ERROR(get_token());
+  }
+  EXPECT_TOKEN(TokenType::CLOSE_BRACKET,
+               "Expected `]' at the end of the array type");
+  return Type(Identifier(name + "]", location.range(), true),
+              std::move(element), std::move(size));
 }
 
 Parser::ErrorOrPtr<ast::IntConstant> Parser::parse_int_constant() {
@@ -115,6 +176,8 @@ Parser::ErrorOrPtr<ast::Value> Parser::parse_value_no_operator() {
     RETURN_OR_MOVE(auto value, parse_value());
     EXPECT_TOKEN(TokenType::CLOSE_PAREN,
                  "Expected a ')' to match the opening one");
+    if (value->node_type() == ast::NodeType::BINARY_OP)
+      static_cast<ast::BinaryOp*>(value.get())->set_parenthesized(true);
     return std::move(value);
   }
 
@@ -125,13 +188,24 @@ Parser::ErrorOrPtr<ast::Value> Parser::parse_value_no_operator() {
     return std::make_unique<ast::BooleanConstant>(location.range(), bool_value);
   }
 
-  if (current_token().type() == TokenType::INT ||
-      current_token().type() == TokenType::HEX ||
-      current_token().type() == TokenType::OCT ||
-      current_token().type() == TokenType::BINARY_NUMBER) {
+  if (is_int_token(current_token().type())) {
     return parse_int_constant();
   }
 
+  if (current_token().type() == TokenType::OPEN_BRACKET) {
+    RETURN_IF_ERROR(get_token());
+    ast::ArrayLiteral::ElementList elements;
+    do {
+      if (!elements.empty()) RETURN_IF_ERROR(get_token());
+      RETURN_OR_MOVE(auto element, parse_value());
+      elements.push_back(std::move(element));
+    } while (current_token().type() == TokenType::COMMA);
+    EXPECT_TOKEN(TokenType::CLOSE_BRACKET,
+                 "Expected `]' at the end of the array");
+    return std::make_unique<ast::ArrayLiteral>(location.range(),
+                                               std::move(elements));
+  }
+
   if (current_token().type() == TokenType::LOWER_CASE_IDENT ||
       current_token().type() == TokenType::UPPER_CASE_IDENT ||
       current_token().type() == TokenType::COLON_COLON) {
@@ -142,12 +216,53 @@ Parser::ErrorOrPtr<ast::Value> Parser::parse_value_no_operator() {
   return ParseError("Expected value", location.error_range());
 }
 
+Parser::ErrorOrPtr<ast::Value> Parser::parse_array_access(
+    std::unique_ptr<ast::Value> array, const ScopedLocation& location) {
+  if (current_token().type() == TokenType::DOT) {
+    RETURN_IF_ERROR(get_token());
+    if (current_token().type() != TokenType::LOWER_CASE_IDENT ||
+        current_token().text() != "length")
+      return ParseError("Expected `length' after `.'", location.error_range());
+    RETURN_IF_ERROR(get_token());
+    return std::make_unique<ast::ArrayLength>(location.range(),
+                                              std::move(array));
+  }
+
+  ASSERT_TOKEN(TokenType::OPEN_BRACKET);
+  Option<std::unique_ptr<ast::Value>> begin;
+  if (current_token().type() != TokenType::DOTDOT) {
+    RETURN_OR_MOVE(begin, parse_value());
+    if (current_token().type() != TokenType::DOTDOT) {
+      EXPECT_TOKEN(TokenType::CLOSE_BRACKET,
+                   "Expected `]' at the end of the index");
+      return std::make_unique<ast::ArrayIndex>(
+          location.range(), std::move(array),
+          std::move(begin.value_or_die()));
+    }
+  }
+  ASSERT_TOKEN(TokenType::DOTDOT);
+  Option<std::unique_ptr<ast::Value>> end;
+  if (current_token().type() != TokenType::CLOSE_BRACKET) {
+    RETURN_OR_MOVE(end, parse_value());
+  }
+  EXPECT_TOKEN(TokenType::CLOSE_BRACKET,
+               "Expected `]' at the end of the range");
+  return std::make_unique<ast::ArraySlice>(location.range(), std::move(array),
+                                           std::move(begin), std::move(end));
+}
+
 Parser::ErrorOrPtr<ast::Value> Parser::parse_value(int parent_precedence) {
   auto location = scoped_location();
   RETURN_OR_MOVE(auto value, parse_value_no_operator());
 
-  // Parse function calls.
-  while (current_token().type() == TokenType::OPEN_PAREN) {
+  // Parse the function calls and the accesses to the arrays.
+  while (current_token().type() == TokenType::OPEN_PAREN ||
+         current_token().type() == TokenType::OPEN_BRACKET ||
+         current_token().type() == TokenType::DOT) {
+    if (current_token().type() != TokenType::OPEN_PAREN) {
+      RETURN_OR_MOVE(value, parse_array_access(std::move(value), location));
+      continue;
+    }
     RETURN_IF_ERROR(get_token());
     std::vector<std::unique_ptr<ast::Value>> arguments;
     while (current_token().type() != TokenType::CLOSE_PAREN) {
@@ -207,10 +322,12 @@ Parser::ErrorOrPtr<Declaration> Parser::parse_variable_declaration() {
                 "VariableDeclaration classes");
 
   auto location = scoped_location();
-  // Starts with VAL or MUT.
+  // Starts with VAL, MUT or CONSTANT.
   assert(current_token().type() == TokenType::VAL ||
-         current_token().type() == TokenType::MUT);
+         current_token().type() == TokenType::MUT ||
+         current_token().type() == TokenType::CONSTANT);
   bool mut = current_token().type() == TokenType::MUT;
+  bool constant = current_token().type() == TokenType::CONSTANT;
   RETURN_IF_ERROR(get_token());
   // Then a simple name, lowercase.
   RETURN_OR_MOVE(Identifier variable_name,
@@ -234,8 +351,14 @@ Parser::ErrorOrPtr<Declaration> Parser::parse_variable_declaration() {
                       location.error_range());
   }
 
+  if (constant && !value.is_ok()) {
+    return ParseError("Expected the value of the constant",
+                      location.error_range());
+  }
+
   return std::make_unique<Declaration>(location.range(), variable_name,
-                                       std::move(type), std::move(value), mut);
+                                       std::move(type), std::move(value), mut,
+                                       constant);
 }
 
 Parser::ErrorOrPtr<ast::BlockStatement> Parser::parse_statement_or_list() {
@@ -278,6 +401,55 @@ Parser::ErrorOrPtr<ast::IfStatement> Parser::parse_if_statement() {
       location.range(), std::move(condition), std::move(if_body), none);
 }
 
+Parser::ErrorOrPtr<ast::BlockStatement> Parser::parse_loop_body() {
+  ++loop_depth_;
+  auto body = parse_statement_or_list();
+  --loop_depth_;
+  return body;
+}
+
+Parser::ErrorOrPtr<ast::WhileBlock> Parser::parse_while_block() {
+  auto location = scoped_location();
+  ASSERT_TOKEN(TokenType::WHILE);
+
+  EXPECT_TOKEN(TokenType::OPEN_PAREN, "Expected '(' after 'while' keyword");
+  RETURN_OR_MOVE(auto condition, parse_value());
+  EXPECT_TOKEN(TokenType::CLOSE_PAREN, "Expected ')' before 'while' body");
+  RETURN_OR_MOVE(auto body, parse_loop_body());
+
+  return std::make_unique<ast::WhileBlock>(
+      location.range(), std::move(condition), std::move(body));
+}
+
+Parser::ErrorOrPtr<ast::ForBlock> Parser::parse_for_block() {
+  auto location = scoped_location();
+  ASSERT_TOKEN(TokenType::FOR);
+
+  EXPECT_TOKEN(TokenType::OPEN_PAREN, "Expected '(' after 'for' keyword");
+  auto variable_location = scoped_location();
+  RETURN_OR_MOVE(Identifier variable_name,
+                 parse_value_identifier(IdentifierType::SIMPLE));
+  // Without a type, the variable has the type of the bounds.
+  Option<Type> type;
+  if (current_token().type() == TokenType::COLON) {
+    RETURN_IF_ERROR(get_token());
+    RETURN_OR_MOVE(type, parse_type());
+  }
+  auto variable = std::make_unique<ast::LocalVariableDeclaration>(
+      variable_location.range(), variable_name, std::move(type), none,
+      /*mut=*/false);
+  EXPECT_TOKEN(TokenType::IN, "Expected `in' after the loop variable");
+  RETURN_OR_MOVE(auto begin, parse_value());
+  EXPECT_TOKEN(TokenType::DOTDOT, "Expected `..' between the bounds");
+  RETURN_OR_MOVE(auto end, parse_value());
+  EXPECT_TOKEN(TokenType::CLOSE_PAREN, "Expected ')' before 'for' body");
+  RETURN_OR_MOVE(auto body, parse_loop_body());
+
+  return std::make_unique<ast::ForBlock>(location.range(), std::move(variable),
+                                         std::move(begin), std::move(end),
+                                         std::move(body));
+}
+
 Parser::ErrorOrPtr<ast::Statement> Parser::parse_statement() {
   auto location = scoped_location();
 
@@ -310,8 +482,33 @@ Parser::ErrorOrPtr<ast::Statement> Parser::parse_statement() {
                       location.error_range());
   }
 
+  if (current_token().type() == TokenType::WHILE) {
+    return parse_while_block();
+  }
+
+  if (current_token().type() == TokenType::FOR) {
+    return parse_for_block();
+  }
+
+  if (current_token().type() == TokenType::BREAK ||
+      current_token().type() == TokenType::CONTINUE) {
+    bool is_break = current_token().type() == TokenType::BREAK;
+    RETURN_IF_ERROR(get_token());
+    if (loop_depth_ == 0) {
+      return ParseError(is_break ? "`break' outside of a loop"
+                                 : "`continue' outside of a loop",
+                        location.range());
+    }
+    EXPECT_TOKEN(TokenType::SEMICOLON,
+                 "Expected `;' at the end of the statement");
+    if (is_break)
+      return std::make_unique<ast::BreakStatement>(location.range());
+    return std::make_unique<ast::ContinueStatement>(location.range());
+  }
+
   if (current_token().type() == TokenType::VAL ||
-      current_token().type() == TokenType::MUT) {
+      current_token().type() == TokenType::MUT ||
+      current_token().type() == TokenType::CONSTANT) {
     RETURN_OR_MOVE(auto var_decl,
                    parse_variable_declaration<ast::LocalVariableDeclaration>());
     EXPECT_TOKEN(TokenType::SEMICOLON,
@@ -319,14 +516,66 @@ Parser::ErrorOrPtr<ast::Statement> Parser::parse_statement() {
     return std::move(var_decl);
   }
 
-  if (current_token().type() == TokenType::FUN) {
-    return parse_function_declaration();
+  if (current_token().type() == TokenType::FUN ||
+      current_token().type() == TokenType::PURE) {
+    // The loops around the function don't go through its body.
+    int loop_depth = loop_depth_;
+    loop_depth_ = 0;
+    auto function = parse_function_declaration();
+    loop_depth_ = loop_depth;
+    return std::move(function);
   }
 
   auto value = parse_value();
   if (!value.is_ok()) {
     return ParseError("Could not parse as a statement", location.error_range());
   }
+
+  auto compound_operator =
+      lexer::compound_assignment_operator(current_token().type());
+  if (current_token().type() == TokenType::ASSIGN ||
+      compound_operator.is_ok()) {
+    auto target = std::move(value.value_or_die());
+    // `a[i] = v;' assigns the element `i' of the variable `a'.
+    Option<std::unique_ptr<ast::Value>> index;
+    if (target->node_type() == ast::NodeType::ARRAY_INDEX) {
+      auto element = static_cast<ast::ArrayIndex*>(target.get());
+      index = std::move(element->index());
+      target = std::move(element->base());
+    }
+    if (target->node_type() != ast::NodeType::VARIABLE_REFERENCE)
+      return ParseError("Only variables can be assigned", location.range());
+    std::unique_ptr<ast::VariableReference> variable(
+        static_cast<ast::VariableReference*>(target.release()));
+    if (compound_operator.is_ok() && index.is_ok() &&
+        !is_simple_value(*index.value_or_die()))
+      return ParseError(
+          "The index of a compound assignment must be a variable or a "
+          "constant",
+          index.value_or_die()->location());
+    RETURN_IF_ERROR(get_token());
+    RETURN_OR_MOVE(std::unique_ptr<ast::Value> assigned, parse_value());
+    EXPECT_TOKEN(TokenType::SEMICOLON,
+                 "Expected `;' at the end of the assignment");
+    if (compound_operator.is_ok()) {
+      // `x += 1;' is `x = x + 1;', and `a[i] += 1;' is `a[i] = a[i] + 1;'.
+      std::unique_ptr<ast::Value> current =
+          std::make_unique<ast::VariableReference>(variable->location(),
+                                                   variable->id());
+      if (index.is_ok()) {
+        current = std::make_unique<ast::ArrayIndex>(
+            location.range(), std::move(current),
+            copy_simple_value(*index.value_or_die()));
+      }
+      assigned = std::make_unique<ast::BinaryOp>(
+          location.range(), std::move(current),
+          compound_operator.value_or_die(), std::move(assigned));
+    }
+    return std::make_unique<ast::Assignment>(
+        location.range(), std::move(variable), std::move(assigned),
+        std::move(index), compound_operator);
+  }
+
   EXPECT_TOKEN(TokenType::SEMICOLON,
                "Expected `;' at the end of the statement");
   return std::make_unique<ast::ValueStatement>(location.range(),
@@ -386,6 +635,18 @@ Parser::parse_function_arguments_declaration() {
 Parser::ErrorOrPtr<ast::FunctionDeclaration>
 Parser::parse_function_declaration() {
   auto location = scoped_location();
+  ast::FunctionQualifiers qualifiers;
+  if (current_token().type() == TokenType::EXTERN) {
+    qualifiers.is_extern = true;
+    RETURN_IF_ERROR(get_token());
+  } else if (current_token().type() == TokenType::PUBLIC) {
+    qualifiers.is_public = true;
+    RETURN_IF_ERROR(get_token());
+  }
+  if (current_token().type() == TokenType::PURE) {
+    qualifiers.is_pure = true;
+    RETURN_IF_ERROR(get_token());
+  }
   EXPECT_TOKEN(TokenType::FUN, "Function declarations must start with `fun'");
   RETURN_OR_MOVE(Identifier fun_name,
                  parse_value_identifier(IdentifierType::SIMPLE));
@@ -400,11 +661,24 @@ Parser::parse_function_declaration() {
   }
 
   auto body_location = scoped_location();
+  if (qualifiers.is_extern) {
+    // extern fun my_fun(val a : Int32) : Int32;
+    if (!type.is_ok())
+      return ParseError("Expected the return type of the extern function",
+                        body_location.error_range());
+    EXPECT_TOKEN(TokenType::SEMICOLON,
+                 "Expected `;' after the declaration of an extern function");
+    return std::make_unique<ast::FunctionDeclaration>(
+        location.range(), std::move(fun_name), std::move(arguments),
+        std::move(type), ast::FunctionDeclaration::StatementsBody(),
+        qualifiers);
+  }
+
   if (current_token().type() == TokenType::OPEN_BRACE) {
     RETURN_OR_MOVE(auto body, parse_statement_list());
     return std::make_unique<ast::FunctionDeclaration>(
         location.range(), std::move(fun_name), std::move(arguments),
-        std::move(type), std::move(body));
+        std::move(type), std::move(body), qualifiers);
   }
 
   if (current_token().type() == TokenType::ASSIGN) {
@@ -416,16 +690,30 @@ Parser::parse_function_declaration() {
 
     return std::make_unique<ast::FunctionDeclaration>(
         location.range(), std::move(fun_name), std::move(arguments),
-        std::move(type), std::move(value));
+        std::move(type), std::move(value), qualifiers);
   }
 
   return ParseError("Expected function body", body_location.error_range());
 }
 
+Parser::ErrorOrPtr<ast::ImportStatement> Parser::parse_import_statement() {
+  auto location = scoped_location();
+  EXPECT_TOKEN(TokenType::IMPORT, "Expected `import'");
+  RETURN_OR_MOVE(Identifier module,
+                 parse_value_identifier(IdentifierType::SIMPLE));
+  EXPECT_TOKEN(TokenType::SEMICOLON, "Expected `;' after the imported module");
+  return std::make_unique<ast::ImportStatement>(location.range(),
+                                                std::move(module));
+}
+
 Parser::ErrorOrPtr<ast::ASTNode> Parser::parse_toplevel_declaration() {
   auto location = scoped_location();
+  if (current_token().type() == TokenType::IMPORT) {
+    return parse_import_statement();
+  }
   if (current_token().type() == TokenType::VAL ||
-      current_token().type() == TokenType::MUT) {
+      current_token().type() == TokenType::MUT ||
+      current_token().type() == TokenType::CONSTANT) {
     RETURN_OR_MOVE(auto val_decl,
                    parse_variable_declaration<ast::LocalVariableDeclaration>());
 
@@ -435,12 +723,52 @@ Parser::ErrorOrPtr<ast::ASTNode> Parser::parse_toplevel_declaration() {
 
     return std::move(val_decl);
   }
-  if (current_token().type() == TokenType::FUN) {
+  if (current_token().type() == TokenType::FUN ||
+      current_token().type() == TokenType::PUBLIC ||
+      current_token().type() == TokenType::PURE ||
+      current_token().type() == TokenType::EXTERN) {
     return parse_function_declaration();
   }
   return ParseError("Expected top-level declaration", location.error_range());
 }
 
+namespace {
+// Number of tokens lexed at once when timing the lexing.
+constexpr int k_lexing_batch_size = 256;
+}  // namespace
+
+Parser::TokenSource::LexResult Parser::TokenSource::operator()() {
+  LexResult result = [this]() -> LexResult {
+    if (lexed_->empty()) {
+      if (util::TimeReport::active() == nullptr &&
+          util::Tracer::active() == nullptr)
+        return lexer_->get_next_token();
+      lex_batch();
+    }
+    LexResult front = std::move(lexed_->front());
+    lexed_->pop_front();
+    return front;
+  }();
+  if (result.is_ok() && result.value_or_die().type() == TokenType::COMMENT) {
+    const auto& comment = result.value_or_die();
+    comments_->emplace_back(TokenType::COMMENT, comment.text(),
+                            comment.location());
+  }
+  return result;
+}
+
+void Parser::TokenSource::lex_batch() {
+  util::ScopedPhase phase("Lexing");
+  for (int i = 0; i < k_lexing_batch_size; ++i) {
+    lexed_->emplace_back(lexer_->get_next_token());
+    const auto& result = lexed_->back();
+    // Stop at the end of the file or at the first error, like the parser.
+    if (!result.is_ok() ||
+        result.value_or_die().type() == TokenType::END_OF_FILE)
+      break;
+  }
+}
+
 MaybeError<> Parser::get_token() {
   if (!token_stack_.empty()) {
     last_end_ = current_token().location().end;
@@ -460,7 +788,14 @@ Parser::ErrorOrPtr<ast::Module> Parser::parse() {
   auto location = scoped_location();
   std::vector<std::unique_ptr<ast::ASTNode>> declarations;
   while (current_token().type() != TokenType::END_OF_FILE) {
+    util::TraceScope trace("declaration", "");
+    // The build only reads the head of the files to find their imports.
+    if (current_token().type() == TokenType::IMPORT && !declarations.empty() &&
+        declarations.back()->node_type() != ast::NodeType::IMPORT_STATEMENT)
+      return ParseError("The imports must be before the declarations",
+                        scoped_location().error_range());
     RETURN_OR_MOVE(auto decl, parse_toplevel_declaration());
+    trace.set_name(ast::declaration_name(*decl));
     declarations.emplace_back(std::move(decl));
   }
   return std::make_unique<ast::Module>(location.range(),
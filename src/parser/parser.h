@@ -19,7 +19,14 @@ namespace parser {
 class ParseError : public GenericError {
  public:
   explicit ParseError(const std::string& message, const lexer::Range& location)
-      : GenericError(location_line(message, location)) {}
+      : GenericError(message), location_(location) {}
+
+  /// The location is only formatted when the error is displayed.
+  std::string to_string() const override {
+    return location_line(message(), location_);
+  }
+
+  const lexer::Range* range() const override { return &location_; }
 
   static std::string location_line(const std::string& message,
                                    const lexer::Range& location) {
@@ -28,6 +35,9 @@ class ParseError : public GenericError {
     return ss.str();
   }
   ~ParseError() override = default;
+
+ private:
+  const lexer::Range location_;
 };
 
 // Parser class allows to parse any input.
@@ -45,13 +55,21 @@ class Parser {
   // Parse the input from the stream.
   ErrorOrPtr<ast::Module> parse();
 
+  /// The comments read so far, in the order of the file. They are not in the
+  /// AST: the formatter puts them back between the statements.
+  const std::vector<lexer::Token>& comments() const { return *comments_; }
+
  private:
   static constexpr unsigned int k_lookahead = 0;
 
   /// TopLevel:
-  /// <VariableDeclaration>|<FunctionDeclaration>
+  /// <ImportStatement>|<VariableDeclaration>|<FunctionDeclaration>
   ErrorOrPtr<ast::ASTNode> parse_toplevel_declaration();
 
+  /// ImportStatement:
+  /// import <ValueId>;
+  ErrorOrPtr<ast::ImportStatement> parse_import_statement();
+
   /// IntConstant:
   /// <intValue>|<hexValue>|<octValue>|<binValue>
   ErrorOrPtr<ast::IntConstant> parse_int_constant();
@@ -63,6 +81,7 @@ class Parser {
 
   /// FunctionDeclaration:
   /// fun <ValueId> (<FuncArgsDecl>) [: <Type>] (= <Value>;|<BlockStatement>)
+  /// |extern [pure] fun <ValueId> (<FuncArgsDecl>) : <Type>;
   ErrorOrPtr<ast::FunctionDeclaration> parse_function_declaration();
 
   /// FuncArgsDecl:
@@ -71,11 +90,17 @@ class Parser {
   parse_function_arguments_declaration();
 
   /// Value:
-  /// <ValueNoOp> [([<Value>[COMMA <Value>]...])]... [<Operator> <Value> ]...
+  /// <ValueNoOp> [([<Value>[COMMA <Value>]...])|<ArrayAccess>]...
+  ///     [<Operator> <Value> ]...
   ErrorOrPtr<ast::Value> parse_value(int parent_precedence = 0);
 
+  /// ArrayAccess, after the array:
+  /// [<Value>]|[[<Value>]..[<Value>]]|.length
+  ErrorOrPtr<ast::Value> parse_array_access(std::unique_ptr<ast::Value> array,
+                                            const ScopedLocation& location);
+
   /// ValueNoOp:
-  /// [(<Value>)|true|false|<IntConstant>|<ValueId>]
+  /// [(<Value>)|true|false|<IntConstant>|<ValueId>|[<Value>[, <Value>]...]]
   ErrorOrPtr<ast::Value> parse_value_no_operator();
 
   /// Statement list:
@@ -86,13 +111,28 @@ class Parser {
   /// if ( <Value> ) [else (<Statement|IfStmt)]
   ErrorOrPtr<ast::IfStatement> parse_if_statement();
 
+  /// WhileBlock:
+  /// while ( <Value> ) (<Statement>|<BlockStatement>)
+  ErrorOrPtr<ast::WhileBlock> parse_while_block();
+
+  /// ForBlock:
+  /// for ( <variable_name> [: <Type>] in <Value> .. <Value> )
+  ///     (<Statement>|<BlockStatement>)
+  ErrorOrPtr<ast::ForBlock> parse_for_block();
+
+  /// Parse the body of a loop, in which `break' and `continue' are allowed.
+  ErrorOrPtr<ast::BlockStatement> parse_loop_body();
+
   /// Statement:
   /// value;
+  /// <variable_name>[[<Value>]] <AssignmentOperator> value;
   /// return [value];
+  /// break;
+  /// continue;
   ErrorOrPtr<ast::Statement> parse_statement();
 
   /// Type:
-  /// <TypeIdentifier>
+  /// <TypeIdentifier>|[<Type>; <IntConstant>]|[<Type>]
   ErrorOr<ast::Type> parse_type();
 
   enum class IdentifierType {
@@ -126,17 +166,47 @@ class Parser {
   ErrorOrPtr<ast::BlockStatement> parse_statement_or_list();
 
   const lexer::Token& current_token() const;
-  MaybeError<> get_token();
+  MUST_USE_RESULT MaybeError<> get_token();
   void unget_token();
 
   ScopedLocation scoped_location() const;
 
+  /// Callback of the token stack. When the compilation is timed or traced (see
+  /// util::TimeReport and util::Tracer), the tokens are lexed ahead in
+  /// batches, so that the lexing can be reported as a separate phase: timing
+  /// each token would cost more than lexing it.
+  class TokenSource {
+   public:
+    using LexResult = ErrorOr<lexer::Token, lexer::LexError>;
+
+    TokenSource(Lexer* lexer,
+                std::shared_ptr<std::vector<lexer::Token>> comments)
+        : lexer_(lexer),
+          lexed_(std::make_shared<std::deque<LexResult>>()),
+          comments_(std::move(comments)) {}
+
+    LexResult operator()();
+
+   private:
+    void lex_batch();
+
+    Lexer* lexer_;
+    // Shared because std::function copies its callable.
+    std::shared_ptr<std::deque<LexResult>> lexed_;
+    std::shared_ptr<std::vector<lexer::Token>> comments_;
+  };
+
   Range::Position last_end_{0, 0};
+  // Number of loops around the current statement, in the current function.
+  int loop_depth_ = 0;
   Lexer* lexer_;
+  // Each token is lexed once, whatever the ungets: the token source records
+  // the comments.
+  std::shared_ptr<std::vector<lexer::Token>> comments_ =
+      std::make_shared<std::vector<lexer::Token>>();
   using TokenStack =
       util::LookaheadStack<k_lookahead, lexer::Token, lexer::LexError>;
-  TokenStack token_stack_ =
-      TokenStack{std::bind(&Lexer::get_next_token, lexer_)};
+  TokenStack token_stack_ = TokenStack{TokenSource(lexer_, comments_)};
   friend class ScopedLocation;
 };
 
@@ -2,12 +2,43 @@
 namespace ast {
 
 void PrettyPrinterVisitor::visit(BinaryOp* node) {
-  out_ << '(';
-  node->left_value().accept(*this);
+  // The parentheses that the precedence and the left associativity need,
+  // `(a + b) * c' and `a - (b - c)', and the ones of the source around an
+  // operand, like in `(a * b) + c'. Not the ones around a whole value.
+  int precedence = lexer::operator_precedence(node->operation());
+  bool parenthesized =
+      precedence < min_precedence_ ||
+      (node->is_parenthesized() && min_precedence_ > 0);
+  if (parenthesized) out_ << '(';
+  print_value(&node->left_value(), precedence);
   out_ << ' ';
   out_ << node->operation();
   out_ << ' ';
-  node->right_value().accept(*this);
-  out_ << ')';
+  print_value(&node->right_value(), precedence + 1);
+  if (parenthesized) out_ << ')';
+}
+
+void PrettyPrinterVisitor::visit(Assignment* node) {
+  out_ << node->target().id().to_string();
+  if (node->index().is_ok()) {
+    out_ << '[';
+    print_value(node->index().value_or_die().get());
+    out_ << ']';
+  }
+  // `x += v;' is `x = x + v;': only `v' is printed, unless a transformation
+  // changed the operation.
+  auto value = node->value().get();
+  const auto& compound_operator = node->compound_operator();
+  if (compound_operator.is_ok() &&
+      value->node_type() == NodeType::BINARY_OP &&
+      static_cast<BinaryOp*>(value)->operation() ==
+          compound_operator.value_or_die()) {
+    out_ << ' ' << compound_operator.value_or_die() << "= ";
+    print_value(&static_cast<BinaryOp*>(value)->right_value());
+  } else {
+    out_ << " = ";
+    print_value(value);
+  }
+  out_ << ";";
 }
 }  // namespace ast
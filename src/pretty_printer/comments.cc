@@ -0,0 +1,66 @@
+#include "pretty_printer/pretty_printer.h"
+
+#include <limits>
+
+namespace ast {
+
+void PrettyPrinterVisitor::visit(Module* node) {
+  last_line_ = -1;
+  for (auto const& decl : node->top_level_declarations()) {
+    print_commented(decl.get());
+    out_ << "\n";
+  }
+  // The comments at the end of the file.
+  print_comments_before(std::numeric_limits<int>::max());
+}
+
+void PrettyPrinterVisitor::print_block(
+    const BlockStatement::StatementList& statements,
+    const lexer::Range& location) {
+  out_ << "{\n";
+  ++indent_;
+  // No blank line after the opening brace.
+  last_line_ = -1;
+  for (auto const& statement : statements) {
+    print_commented(statement.get());
+    out_ << '\n';
+  }
+  // The comments before the closing brace.
+  print_comments_before(location.end.line);
+  --indent_;
+  print_indent() << "}";
+}
+
+void PrettyPrinterVisitor::print_commented(ASTNode* node) {
+  print_comments_before(node->location().begin.line);
+  print_blank_line_before(node->location().begin.line);
+  print_indent();
+  node->accept(*this);
+  // The comments inside the node come after it.
+  const int line = node->location().end.line;
+  last_line_ = line;
+  if (comments_ == nullptr || next_comment_ == comments_->size() ||
+      (*comments_)[next_comment_].location().begin.line != line)
+    return;
+  out_ << "  " << (*comments_)[next_comment_].text();
+  ++next_comment_;
+}
+
+void PrettyPrinterVisitor::print_comments_before(int line) {
+  if (comments_ == nullptr) return;
+  for (; next_comment_ < comments_->size() &&
+         (*comments_)[next_comment_].location().begin.line < line;
+       ++next_comment_) {
+    const auto& comment = (*comments_)[next_comment_];
+    print_blank_line_before(comment.location().begin.line);
+    print_indent() << comment.text() << '\n';
+    last_line_ = comment.location().end.line;
+  }
+}
+
+void PrettyPrinterVisitor::print_blank_line_before(int line) {
+  if (keep_blank_lines_ && last_line_ >= 0 && line > last_line_ + 1)
+    out_ << '\n';
+}
+
+}  // namespace ast
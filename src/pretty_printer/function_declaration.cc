@@ -15,6 +15,9 @@ void PrettyPrinterVisitor::visit(FunctionArgumentDeclaration* node) {
 }
 
 void PrettyPrinterVisitor::visit(FunctionDeclaration* node) {
+  if (node->is_extern()) out_ << "extern ";
+  if (node->is_public()) out_ << "public ";
+  if (node->is_pure()) out_ << "pure ";
   out_ << "fun " << node->id().to_string() << '(';
   bool print_comma = false;
   for (const auto& arg : node->arguments()) {
@@ -25,24 +28,20 @@ void PrettyPrinterVisitor::visit(FunctionDeclaration* node) {
   out_ << ')';
   if (node->type().is_ok())
     out_ << " : " << node->type().value_or_die().to_string();
+  if (node->is_extern()) {
+    out_ << ';';
+    return;
+  }
   out_ << ' ';
 
   if (node->body().is<FunctionDeclaration::StatementsBody>()) {
-    out_ << "{\n";
-    ++indent_;
-    for (auto const& statement :
-         node->body()
-             .get_unchecked<FunctionDeclaration::StatementsBody>()
-             ->statements()) {
-      print_indent();
-      statement->accept(*this);
-      out_ << '\n';
-    }
-    --indent_;
-    print_indent() << "}";
+    const auto& block =
+        node->body().get_unchecked<FunctionDeclaration::StatementsBody>();
+    print_block(block->statements(), block->location());
   } else {
     out_ << "= ";
-    node->body().get_unchecked<FunctionDeclaration::ValueBody>()->accept(*this);
+    print_value(
+        node->body().get_unchecked<FunctionDeclaration::ValueBody>().get());
     out_ << ';';
   }
 }
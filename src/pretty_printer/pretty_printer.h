@@ -1,41 +1,60 @@
 #pragma once
 
 #include <iostream>
+#include <limits>
+#include <vector>
 
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/assignment.h"
 #include "ast/ast.h"
 #include "ast/binary_operation.h"
 #include "ast/block_statement.h"
 #include "ast/boolean_constant.h"
+#include "ast/for_block.h"
 #include "ast/function_call.h"
 #include "ast/function_declaration.h"
 #include "ast/if_statement.h"
+#include "ast/import_statement.h"
 #include "ast/int_constant.h"
 #include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
 #include "ast/module.h"
 #include "ast/return_statement.h"
 #include "ast/value_statement.h"
 #include "ast/variable_reference.h"
+#include "ast/while_block.h"
+#include "lexer/token.h"
 
 namespace ast {
 class PrettyPrinterVisitor : public ASTVisitor {
  public:
   explicit PrettyPrinterVisitor(std::ostream& out) : out_(out) {}
 
-  void visit(Module* node) override {
-    for (auto const& decl : node->top_level_declarations()) {
-      decl->accept(*this);
-      out_ << "\n";
-    }
+  /// Print these comments (see parser::Parser::comments) too, each before the
+  /// declaration or the statement that follows it, or after the one that ends
+  /// on its line. They must outlive the visitor.
+  void set_comments(const std::vector<lexer::Token>* comments) {
+    comments_ = comments;
   }
 
+  /// Keep one blank line where the source has some between the declarations,
+  /// the statements and the comments of a block.
+  void set_keep_blank_lines(bool keep) { keep_blank_lines_ = keep; }
+
+  void visit(Module* node) override;
+
   void visit(LocalVariableDeclaration* node) override {
-    out_ << (node->is_mutable() ? "mut" : "val") << ' ';
+    if (node->is_constant())
+      out_ << "constant ";
+    else
+      out_ << (node->is_mutable() ? "mut" : "val") << ' ';
     out_ << node->id().to_string();
     if (node->type().is_ok())
       out_ << " : " << node->type().value_or_die().to_string();
     if (node->value().is_ok()) {
       out_ << " = ";
-      node->value().value_or_die()->accept(*this);
+      print_value(node->value().value_or_die().get());
     }
     out_ << ";";
   }
@@ -45,12 +64,12 @@ class PrettyPrinterVisitor : public ASTVisitor {
   void visit(FunctionArgumentDeclaration* node) override;
 
   void visit(FunctionCall* node) override {
-    node->base().accept(*this);
+    print_value(&node->base(), k_postfix_precedence);
     out_ << '(';
     auto delimiter = "";
     for (auto& arg : node->arguments()) {
       out_ << delimiter;
-      arg->accept(*this);
+      print_value(arg.get());
       delimiter = ", ";
     }
     out_ << ')';
@@ -62,6 +81,38 @@ class PrettyPrinterVisitor : public ASTVisitor {
     out_ << node->id().to_string();
   }
 
+  void visit(ArrayLiteral* node) override {
+    out_ << '[';
+    auto delimiter = "";
+    for (auto& element : node->elements()) {
+      out_ << delimiter;
+      print_value(element.get());
+      delimiter = ", ";
+    }
+    out_ << ']';
+  }
+
+  void visit(ArrayIndex* node) override {
+    print_value(node->base().get(), k_postfix_precedence);
+    out_ << '[';
+    print_value(node->index().get());
+    out_ << ']';
+  }
+
+  void visit(ArraySlice* node) override {
+    print_value(node->base().get(), k_postfix_precedence);
+    out_ << '[';
+    if (node->begin().is_ok()) print_value(node->begin().value_or_die().get());
+    out_ << "..";
+    if (node->end().is_ok()) print_value(node->end().value_or_die().get());
+    out_ << ']';
+  }
+
+  void visit(ArrayLength* node) override {
+    print_value(node->base().get(), k_postfix_precedence);
+    out_ << ".length";
+  }
+
   void visit(IntConstant* node) override { out_ << node->value(); }
   void visit(BooleanConstant* node) override {
     if (node->value())
@@ -74,19 +125,19 @@ class PrettyPrinterVisitor : public ASTVisitor {
     out_ << "return";
     if (node->value().is_ok()) {
       out_ << ' ';
-      node->value().value_or_die()->accept(*this);
+      print_value(node->value().value_or_die().get());
     }
     out_ << ";";
   }
 
   void visit(ValueStatement* node) override {
-    node->value()->accept(*this);
+    print_value(node->value().get());
     out_ << ";";
   }
 
   void visit(IfStatement* node) override {
     out_ << "if (";
-    node->condition()->accept(*this);
+    print_value(node->condition().get());
     out_ << ") ";
 
     node->body()->accept(*this);
@@ -97,19 +148,64 @@ class PrettyPrinterVisitor : public ASTVisitor {
     }
   }
 
+  void visit(ImportStatement* node) override {
+    out_ << "import " << node->module().to_string() << ';';
+  }
+
+  void visit(WhileBlock* node) override {
+    out_ << "while (";
+    print_value(node->condition().get());
+    out_ << ") ";
+    node->body()->accept(*this);
+  }
+
+  void visit(ForBlock* node) override {
+    auto variable = node->variable();
+    out_ << "for (" << variable->id().to_string();
+    if (variable->type().is_ok())
+      out_ << " : " << variable->type().value_or_die().to_string();
+    out_ << " in ";
+    print_value(node->begin().get());
+    out_ << "..";
+    print_value(node->end().get());
+    out_ << ") ";
+    node->body()->accept(*this);
+  }
+
+  void visit(BreakStatement* /*unused*/) override { out_ << "break;"; }
+  void visit(ContinueStatement* /*unused*/) override { out_ << "continue;"; }
+
+  void visit(Assignment* node) override;
+
   void visit(BlockStatement* node) override {
-    out_ << "{\n";
-    ++indent_;
-    for (auto const& statement : node->statements()) {
-      print_indent();
-      statement->accept(*this);
-      out_ << '\n';
-    }
-    --indent_;
-    print_indent() << "}";
+    print_block(node->statements(), node->location());
   }
 
  private:
+  /// The precedence of the calls and of the accesses to the arrays: a binary
+  /// operation is parenthesized to be their base.
+  static constexpr int k_postfix_precedence = std::numeric_limits<int>::max();
+
+  /// Print the value, parenthesized if it is a binary operation of a lower
+  /// precedence than `min_precedence'.
+  void print_value(Value* value, int min_precedence = 0) {
+    auto enclosing = min_precedence_;
+    min_precedence_ = min_precedence;
+    value->accept(*this);
+    min_precedence_ = enclosing;
+  }
+
+  /// Print the braces and the statements, with the comments of the block.
+  void print_block(const BlockStatement::StatementList& statements,
+                   const lexer::Range& location);
+  /// Print the node, with the comments before it and on its last line.
+  void print_commented(ASTNode* node);
+  /// Print the comments before this line, each on its own line.
+  void print_comments_before(int line);
+  /// Print a blank line if there are some in the source between the last
+  /// line printed and this one.
+  void print_blank_line_before(int line);
+
   std::ostream& print_indent() {
     for (int i = 0; i < indent_; ++i) {
       out_ << "  ";
@@ -118,6 +214,15 @@ class PrettyPrinterVisitor : public ASTVisitor {
   }
   std::ostream& out_;
   int indent_ = 0;
+  const std::vector<lexer::Token>* comments_ = nullptr;
+  // The first comment that is not printed yet.
+  std::size_t next_comment_ = 0;
+  bool keep_blank_lines_ = false;
+  // The last line of the source printed in the current block, or -1 at the
+  // start of the block.
+  int last_line_ = -1;
+  // The lowest precedence of a binary operation printed without parentheses.
+  int min_precedence_ = 0;
 };
 
 }  // namespace ast
@@ -0,0 +1,120 @@
+#pragma once
+
+/// This file describes the binary format of the serialized ASTs (.gha): the
+/// syntax tree of a module, as written by the parser and the syntactic
+/// transformations, so that the tools can skip the lexing and the parsing of
+/// the files that didn't change.
+///
+/// The format only has indices and offsets, no pointers: the file is read
+/// where it is mapped. All the integers are little-endian. The file is:
+///  - the header: the magic "GHA\0", the u32 version, the u64 hash of the
+///    source, the u32 number of nodes, the u32 number of children, the u32
+///    number of strings, and four unused bytes;
+///  - the nodes: a record of k_node_size bytes per node, the root first (see
+///    below);
+///  - the children: for each node, its u32 child indices in a row, k_none for
+///    the missing optional children;
+///  - the strings: for each string, its u32 offset and u32 length in the
+///    bytes, then the bytes until the end of the file. Each string is there
+///    once.
+///
+/// A node record is its u8 Kind, its u8 flags, its u16 first column and u16
+/// last column (clamped to 65535), two unused bytes, its u32 first line and
+/// u32 last line, the u32 index of its first child and the u32 number of its
+/// children, and a u64 value. The children of a node come after it.
+///
+/// The ranges don't have the name of the file: it is the one the AST is read
+/// for, wherever the file moved.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace serialization {
+namespace format {
+
+constexpr char k_magic[4] = {'G', 'H', 'A', '\0'};
+/// Changed with the format, or with the list of the binary operators.
+constexpr std::uint32_t k_version = 2;
+
+constexpr std::size_t k_header_size = 32;
+constexpr std::size_t k_node_size = 32;
+constexpr std::size_t k_child_size = 4;
+constexpr std::size_t k_string_entry_size = 8;
+
+/// A missing optional child.
+constexpr std::uint32_t k_none = 0xffffffff;
+
+/// The kinds of the nodes, with their children and their value. They don't
+/// follow ast::NodeType, so that the format only changes on purpose.
+enum class Kind : std::uint8_t {
+  /// The top-level declarations.
+  MODULE = 0,
+  /// The identifier of the module.
+  IMPORT_STATEMENT = 1,
+  /// The identifier, the return type or none, the body (a block, a value, or
+  /// none if it is extern), then the arguments.
+  FUNCTION_DECLARATION = 2,
+  /// The identifier, the type or none, and the value or none.
+  FUNCTION_ARGUMENT_DECLARATION = 3,
+  LOCAL_VARIABLE_DECLARATION = 4,
+  /// The statements.
+  BLOCK_STATEMENT = 5,
+  /// The condition, the body, and the else block or none.
+  IF_STATEMENT = 6,
+  /// The condition and the body.
+  WHILE_BLOCK = 7,
+  /// The variable, the first and the last values, and the body.
+  FOR_BLOCK = 8,
+  /// The value or none.
+  RETURN_STATEMENT = 9,
+  /// The value.
+  VALUE_STATEMENT = 10,
+  /// The target, the value, and the index or none. The value is 0, or 1 plus
+  /// the ast::BinaryOperator of a compound assignment.
+  ASSIGNMENT = 11,
+  BREAK_STATEMENT = 12,
+  CONTINUE_STATEMENT = 13,
+  /// The value is the integer.
+  INT_CONSTANT = 14,
+  /// The value is 0 or 1.
+  BOOLEAN_CONSTANT = 15,
+  /// The identifier.
+  VARIABLE_REFERENCE = 16,
+  /// The left and right values. The value is the ast::BinaryOperator.
+  BINARY_OP = 17,
+  /// The function, then the arguments.
+  FUNCTION_CALL = 18,
+  /// The elements.
+  ARRAY_LITERAL = 19,
+  /// The array and the index.
+  ARRAY_INDEX = 20,
+  /// The array, and the first and the last indices or none.
+  ARRAY_SLICE = 21,
+  /// The array.
+  ARRAY_LENGTH = 22,
+  /// The value is the index of the name in the strings.
+  IDENTIFIER = 23,
+  /// A type by its name, like an identifier.
+  NAMED_TYPE = 24,
+  /// The element type. The value is the size of the array.
+  ARRAY_TYPE = 25,
+  /// The element type.
+  SLICE_TYPE = 26,
+};
+constexpr std::uint8_t k_kind_count = 27;
+
+/// Flags of a function.
+constexpr std::uint8_t k_public = 1;
+constexpr std::uint8_t k_pure = 2;
+constexpr std::uint8_t k_extern = 4;
+/// Flags of a variable.
+constexpr std::uint8_t k_mutable = 1;
+constexpr std::uint8_t k_constant = 2;
+/// Flags of an identifier or of a named type.
+constexpr std::uint8_t k_uppercase = 1;
+constexpr std::uint8_t k_absolute = 2;
+/// Flags of a binary operation.
+constexpr std::uint8_t k_parenthesized = 1;
+
+}  // namespace format
+}  // namespace serialization
@@ -0,0 +1,481 @@
+#include "serialization/reader.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/assignment.h"
+#include "ast/binary_operation.h"
+#include "ast/block_statement.h"
+#include "ast/boolean_constant.h"
+#include "ast/for_block.h"
+#include "ast/function_call.h"
+#include "ast/function_declaration.h"
+#include "ast/if_statement.h"
+#include "ast/import_statement.h"
+#include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
+#include "ast/return_statement.h"
+#include "ast/value_statement.h"
+#include "ast/variable_reference.h"
+#include "ast/while_block.h"
+
+namespace serialization {
+
+using format::Kind;
+
+lexer::Range NodeView::range(const std::string& file) const {
+  return lexer::Range(file, static_cast<int>(read(8, 4)),
+                      static_cast<int>(read(2, 2)),
+                      static_cast<int>(read(12, 4)),
+                      static_cast<int>(read(4, 2)));
+}
+
+NodeView NodeView::child(std::uint32_t position) const {
+  return NodeView(ast_, child_index(position));
+}
+
+std::uint32_t NodeView::child_index(std::uint32_t position) const {
+  auto first_child = read(16, 4);
+  return static_cast<std::uint32_t>(ast_->read(
+      ast_->children_offset() + (first_child + position) * format::k_child_size,
+      4));
+}
+
+const char* NodeView::name_data() const {
+  auto entry = ast_->strings_offset() + value() * format::k_string_entry_size;
+  auto bytes = ast_->strings_offset() +
+               ast_->string_count_ * std::size_t{format::k_string_entry_size};
+  return ast_->file_->data() + bytes + ast_->read(entry, 4);
+}
+
+std::uint32_t NodeView::name_size() const {
+  auto entry = ast_->strings_offset() + value() * format::k_string_entry_size;
+  return static_cast<std::uint32_t>(ast_->read(entry + 4, 4));
+}
+
+std::uint64_t NodeView::read(std::size_t offset, std::size_t size) const {
+  return ast_->read(format::k_header_size + index_ * format::k_node_size +
+                        offset,
+                    size);
+}
+
+std::uint64_t SerializedAST::read(std::size_t offset, std::size_t size) const {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    auto byte = static_cast<unsigned char>(file_->data()[offset + i]);
+    value |= std::uint64_t{byte} << (8 * i);
+  }
+  return value;
+}
+
+std::size_t SerializedAST::children_offset() const {
+  return format::k_header_size + node_count_ * format::k_node_size;
+}
+
+std::size_t SerializedAST::strings_offset() const {
+  return children_offset() + child_count_ * format::k_child_size;
+}
+
+ErrorOr<std::unique_ptr<SerializedAST>> SerializedAST::open(
+    const std::string& path) {
+  RETURN_OR_MOVE(auto file, util::MappedFile::open(path));
+  if (file->size() < format::k_header_size ||
+      !std::equal(std::begin(format::k_magic), std::end(format::k_magic),
+                  file->data()))
+    return GenericError("The file " + path + " is not a serialized AST");
+  std::unique_ptr<SerializedAST> result(new SerializedAST(std::move(file)));
+  auto version = result->read(sizeof(format::k_magic), 4);
+  if (version != format::k_version)
+    return GenericError("The AST " + path + " has the version " +
+                        std::to_string(version) + ", expected " +
+                        std::to_string(format::k_version));
+  if (!result->check())
+    return GenericError("The AST " + path + " is corrupted");
+  return std::move(result);
+}
+
+bool SerializedAST::check() {
+  source_hash_ = read(8, 8);
+  node_count_ = static_cast<std::uint32_t>(read(16, 4));
+  child_count_ = static_cast<std::uint32_t>(read(20, 4));
+  string_count_ = static_cast<std::uint32_t>(read(24, 4));
+  // The tables are in the file. The counts are 32 bits, the sizes can't
+  // overflow.
+  std::uint64_t strings_end =
+      strings_offset() +
+      string_count_ * std::uint64_t{format::k_string_entry_size};
+  if (node_count_ == 0 || strings_end > file_->size()) return false;
+
+  std::uint64_t bytes_size = file_->size() - strings_end;
+  for (std::uint32_t i = 0; i < string_count_; ++i) {
+    auto entry = strings_offset() + i * format::k_string_entry_size;
+    if (read(entry, 4) + read(entry + 4, 4) > bytes_size) return false;
+  }
+
+  // Each node but the root is the child of one node, after it: they make a
+  // tree.
+  std::vector<bool> has_parent(node_count_, false);
+  for (std::uint32_t i = 0; i < node_count_; ++i) {
+    NodeView node(this, i);
+    if (node.u8(0) >= format::k_kind_count) return false;
+    if ((node.kind() == Kind::IDENTIFIER || node.kind() == Kind::NAMED_TYPE) &&
+        node.value() >= string_count_)
+      return false;
+    if (node.read(16, 4) + node.child_count() > child_count_) return false;
+    for (std::uint32_t position = 0; position < node.child_count();
+         ++position) {
+      auto child = node.child_index(position);
+      if (child == format::k_none) continue;
+      if (child <= i || child >= node_count_ || has_parent[child])
+        return false;
+      has_parent[child] = true;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/// Builds the AST nodes from their views.
+class Decoder {
+ public:
+  Decoder(const SerializedAST& ast, const std::string& file)
+      : ast_(ast), file_(file) {}
+
+  ErrorOr<std::unique_ptr<ast::Module>> module(NodeView node) const;
+
+ private:
+  ErrorOr<std::unique_ptr<ast::Statement>> statement(NodeView node) const;
+  ErrorOr<std::unique_ptr<ast::Value>> value(NodeView node) const;
+  ErrorOr<Option<std::unique_ptr<ast::Value>>> optional_value(
+      NodeView node, std::uint32_t position) const;
+  ErrorOr<std::unique_ptr<ast::BlockStatement>> block(NodeView node) const;
+  ErrorOr<std::unique_ptr<ast::FunctionDeclaration>> function(
+      NodeView node) const;
+  template <typename Variable>
+  ErrorOr<std::unique_ptr<Variable>> variable(NodeView node) const;
+  ErrorOr<std::unique_ptr<ast::VariableReference>> variable_reference(
+      NodeView node) const;
+  ErrorOr<ast::Identifier> identifier(NodeView node) const;
+  ErrorOr<ast::Type> type(NodeView node) const;
+
+  /// Whether the node is a missing optional child, where one is expected.
+  static bool is_missing(NodeView node) {
+    return node.index() == format::k_none;
+  }
+  /// An error unless the node has this kind and this number of children.
+  MaybeError<> expect(NodeView node, Kind kind, std::uint32_t children) const;
+  GenericError corrupted() const {
+    return GenericError("The AST " + ast_.path() + " is corrupted");
+  }
+
+  const SerializedAST& ast_;
+  const std::string& file_;
+};
+
+MaybeError<> Decoder::expect(NodeView node, Kind kind,
+                             std::uint32_t children) const {
+  if (node.kind() != kind || node.child_count() != children)
+    return corrupted();
+  return {};
+}
+
+ErrorOr<std::unique_ptr<ast::Module>> Decoder::module(NodeView node) const {
+  if (node.kind() != Kind::MODULE) return corrupted();
+  ast::Module::Declarations declarations;
+  for (std::uint32_t i = 0; i < node.child_count(); ++i) {
+    RETURN_OR_MOVE(auto declaration, statement(node.child(i)));
+    declarations.push_back(std::move(declaration));
+  }
+  return std::make_unique<ast::Module>(node.range(file_),
+                                       std::move(declarations));
+}
+
+ErrorOr<std::unique_ptr<ast::Statement>> Decoder::statement(
+    NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  switch (node.kind()) {
+    case Kind::IMPORT_STATEMENT: {
+      RETURN_IF_ERROR(expect(node, Kind::IMPORT_STATEMENT, 1));
+      RETURN_OR_MOVE(auto module, identifier(node.child(0)));
+      return std::make_unique<ast::ImportStatement>(node.range(file_),
+                                                    std::move(module));
+    }
+    case Kind::FUNCTION_DECLARATION:
+      return function(node);
+    case Kind::LOCAL_VARIABLE_DECLARATION:
+      return variable<ast::LocalVariableDeclaration>(node);
+    case Kind::BLOCK_STATEMENT:
+      return block(node);
+    case Kind::IF_STATEMENT: {
+      RETURN_IF_ERROR(expect(node, Kind::IF_STATEMENT, 3));
+      RETURN_OR_MOVE(auto condition, value(node.child(0)));
+      RETURN_OR_MOVE(auto body, block(node.child(1)));
+      Option<std::unique_ptr<ast::BlockStatement>> else_statement;
+      if (node.has_child(2)) {
+        RETURN_OR_MOVE(else_statement, block(node.child(2)));
+      }
+      return std::make_unique<ast::IfStatement>(
+          node.range(file_), std::move(condition), std::move(body),
+          std::move(else_statement));
+    }
+    case Kind::WHILE_BLOCK: {
+      RETURN_IF_ERROR(expect(node, Kind::WHILE_BLOCK, 2));
+      RETURN_OR_MOVE(auto condition, value(node.child(0)));
+      RETURN_OR_MOVE(auto body, block(node.child(1)));
+      return std::make_unique<ast::WhileBlock>(
+          node.range(file_), std::move(condition), std::move(body));
+    }
+    case Kind::FOR_BLOCK: {
+      RETURN_IF_ERROR(expect(node, Kind::FOR_BLOCK, 4));
+      RETURN_OR_MOVE(auto variable,
+                     variable<ast::LocalVariableDeclaration>(node.child(0)));
+      RETURN_OR_MOVE(auto begin, value(node.child(1)));
+      RETURN_OR_MOVE(auto end, value(node.child(2)));
+      RETURN_OR_MOVE(auto body, block(node.child(3)));
+      return std::make_unique<ast::ForBlock>(
+          node.range(file_), std::move(variable), std::move(begin),
+          std::move(end), std::move(body));
+    }
+    case Kind::RETURN_STATEMENT: {
+      RETURN_IF_ERROR(expect(node, Kind::RETURN_STATEMENT, 1));
+      RETURN_OR_MOVE(auto result, optional_value(node, 0));
+      return std::make_unique<ast::ReturnStatement>(node.range(file_),
+                                                    std::move(result));
+    }
+    case Kind::VALUE_STATEMENT: {
+      RETURN_IF_ERROR(expect(node, Kind::VALUE_STATEMENT, 1));
+      RETURN_OR_MOVE(auto result, value(node.child(0)));
+      return std::make_unique<ast::ValueStatement>(node.range(file_),
+                                                   std::move(result));
+    }
+    case Kind::ASSIGNMENT: {
+      RETURN_IF_ERROR(expect(node, Kind::ASSIGNMENT, 3));
+      if (node.value() >
+          static_cast<std::uint64_t>(ast::BinaryOperator::__NUMBER_OPERATORS__))
+        return corrupted();
+      RETURN_OR_MOVE(auto target, variable_reference(node.child(0)));
+      RETURN_OR_MOVE(auto result, value(node.child(1)));
+      RETURN_OR_MOVE(auto index, optional_value(node, 2));
+      Option<ast::BinaryOperator> compound_operator;
+      if (node.value() != 0)
+        compound_operator = static_cast<ast::BinaryOperator>(node.value() - 1);
+      return std::make_unique<ast::Assignment>(
+          node.range(file_), std::move(target), std::move(result),
+          std::move(index), compound_operator);
+    }
+    case Kind::BREAK_STATEMENT:
+      RETURN_IF_ERROR(expect(node, Kind::BREAK_STATEMENT, 0));
+      return std::make_unique<ast::BreakStatement>(node.range(file_));
+    case Kind::CONTINUE_STATEMENT:
+      RETURN_IF_ERROR(expect(node, Kind::CONTINUE_STATEMENT, 0));
+      return std::make_unique<ast::ContinueStatement>(node.range(file_));
+    default:
+      return corrupted();
+  }
+}
+
+ErrorOr<std::unique_ptr<ast::Value>> Decoder::value(NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  switch (node.kind()) {
+    case Kind::INT_CONSTANT:
+      RETURN_IF_ERROR(expect(node, Kind::INT_CONSTANT, 0));
+      return std::make_unique<ast::IntConstant>(
+          node.range(file_), static_cast<std::int64_t>(node.value()));
+    case Kind::BOOLEAN_CONSTANT:
+      RETURN_IF_ERROR(expect(node, Kind::BOOLEAN_CONSTANT, 0));
+      return std::make_unique<ast::BooleanConstant>(node.range(file_),
+                                                    node.value() != 0);
+    case Kind::VARIABLE_REFERENCE:
+      return variable_reference(node);
+    case Kind::BINARY_OP: {
+      RETURN_IF_ERROR(expect(node, Kind::BINARY_OP, 2));
+      if (node.value() >=
+          static_cast<std::uint64_t>(ast::BinaryOperator::__NUMBER_OPERATORS__))
+        return corrupted();
+      RETURN_OR_MOVE(auto left, value(node.child(0)));
+      RETURN_OR_MOVE(auto right, value(node.child(1)));
+      auto operation = std::make_unique<ast::BinaryOp>(
+          node.range(file_), std::move(left),
+          static_cast<ast::BinaryOperator>(node.value()), std::move(right));
+      operation->set_parenthesized((node.flags() & format::k_parenthesized) !=
+                                   0);
+      return std::move(operation);
+    }
+    case Kind::FUNCTION_CALL: {
+      if (node.child_count() == 0) return corrupted();
+      RETURN_OR_MOVE(auto base, value(node.child(0)));
+      ast::FunctionCall::ArgumentList arguments;
+      for (std::uint32_t i = 1; i < node.child_count(); ++i) {
+        RETURN_OR_MOVE(auto argument, value(node.child(i)));
+        arguments.push_back(std::move(argument));
+      }
+      return std::make_unique<ast::FunctionCall>(
+          node.range(file_), std::move(base), std::move(arguments));
+    }
+    case Kind::ARRAY_LITERAL: {
+      ast::ArrayLiteral::ElementList elements;
+      for (std::uint32_t i = 0; i < node.child_count(); ++i) {
+        RETURN_OR_MOVE(auto element, value(node.child(i)));
+        elements.push_back(std::move(element));
+      }
+      return std::make_unique<ast::ArrayLiteral>(node.range(file_),
+                                                 std::move(elements));
+    }
+    case Kind::ARRAY_INDEX: {
+      RETURN_IF_ERROR(expect(node, Kind::ARRAY_INDEX, 2));
+      RETURN_OR_MOVE(auto base, value(node.child(0)));
+      RETURN_OR_MOVE(auto index, value(node.child(1)));
+      return std::make_unique<ast::ArrayIndex>(
+          node.range(file_), std::move(base), std::move(index));
+    }
+    case Kind::ARRAY_SLICE: {
+      RETURN_IF_ERROR(expect(node, Kind::ARRAY_SLICE, 3));
+      RETURN_OR_MOVE(auto base, value(node.child(0)));
+      RETURN_OR_MOVE(auto begin, optional_value(node, 1));
+      RETURN_OR_MOVE(auto end, optional_value(node, 2));
+      return std::make_unique<ast::ArraySlice>(
+          node.range(file_), std::move(base), std::move(begin),
+          std::move(end));
+    }
+    case Kind::ARRAY_LENGTH: {
+      RETURN_IF_ERROR(expect(node, Kind::ARRAY_LENGTH, 1));
+      RETURN_OR_MOVE(auto base, value(node.child(0)));
+      return std::make_unique<ast::ArrayLength>(node.range(file_),
+                                                std::move(base));
+    }
+    default:
+      return corrupted();
+  }
+}
+
+ErrorOr<Option<std::unique_ptr<ast::Value>>> Decoder::optional_value(
+    NodeView node, std::uint32_t position) const {
+  Option<std::unique_ptr<ast::Value>> result;
+  if (node.has_child(position)) {
+    RETURN_OR_MOVE(result, value(node.child(position)));
+  }
+  return std::move(result);
+}
+
+ErrorOr<std::unique_ptr<ast::BlockStatement>> Decoder::block(
+    NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  if (node.kind() != Kind::BLOCK_STATEMENT) return corrupted();
+  ast::BlockStatement::StatementList statements;
+  for (std::uint32_t i = 0; i < node.child_count(); ++i) {
+    RETURN_OR_MOVE(auto child, statement(node.child(i)));
+    statements.push_back(std::move(child));
+  }
+  return std::make_unique<ast::BlockStatement>(node.range(file_),
+                                               std::move(statements));
+}
+
+ErrorOr<std::unique_ptr<ast::FunctionDeclaration>> Decoder::function(
+    NodeView node) const {
+  if (node.child_count() < 3) return corrupted();
+  RETURN_OR_MOVE(auto id, identifier(node.child(0)));
+  Option<ast::Type> return_type;
+  if (node.has_child(1)) {
+    RETURN_OR_MOVE(return_type, type(node.child(1)));
+  }
+  ast::FunctionDeclaration::ArgumentList arguments;
+  for (std::uint32_t i = 3; i < node.child_count(); ++i) {
+    RETURN_OR_MOVE(auto argument,
+                   variable<ast::FunctionArgumentDeclaration>(node.child(i)));
+    arguments.push_back(std::move(argument));
+  }
+  ast::FunctionQualifiers qualifiers;
+  qualifiers.is_public = (node.flags() & format::k_public) != 0;
+  qualifiers.is_pure = (node.flags() & format::k_pure) != 0;
+  qualifiers.is_extern = (node.flags() & format::k_extern) != 0;
+
+  // The body is a block, a value, or nothing for an extern function.
+  ast::FunctionDeclaration::StatementsBody statements;
+  if (node.has_child(2) && node.child(2).kind() != Kind::BLOCK_STATEMENT) {
+    RETURN_OR_MOVE(auto body, value(node.child(2)));
+    return std::make_unique<ast::FunctionDeclaration>(
+        node.range(file_), std::move(id), std::move(arguments),
+        std::move(return_type), std::move(body), qualifiers);
+  }
+  if (node.has_child(2)) {
+    RETURN_OR_MOVE(statements, block(node.child(2)));
+  }
+  return std::make_unique<ast::FunctionDeclaration>(
+      node.range(file_), std::move(id), std::move(arguments),
+      std::move(return_type), std::move(statements), qualifiers);
+}
+
+template <typename Variable>
+ErrorOr<std::unique_ptr<Variable>> Decoder::variable(NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  if (node.child_count() != 3 ||
+      (node.kind() != Kind::LOCAL_VARIABLE_DECLARATION &&
+       node.kind() != Kind::FUNCTION_ARGUMENT_DECLARATION) ||
+      (node.kind() == Kind::LOCAL_VARIABLE_DECLARATION) !=
+          std::is_same<Variable, ast::LocalVariableDeclaration>::value)
+    return corrupted();
+  RETURN_OR_MOVE(auto id, identifier(node.child(0)));
+  Option<ast::Type> variable_type;
+  if (node.has_child(1)) {
+    RETURN_OR_MOVE(variable_type, type(node.child(1)));
+  }
+  RETURN_OR_MOVE(auto initial_value, optional_value(node, 2));
+  return std::make_unique<Variable>(
+      node.range(file_), std::move(id), std::move(variable_type),
+      std::move(initial_value), (node.flags() & format::k_mutable) != 0,
+      (node.flags() & format::k_constant) != 0);
+}
+
+ErrorOr<std::unique_ptr<ast::VariableReference>> Decoder::variable_reference(
+    NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  RETURN_IF_ERROR(expect(node, Kind::VARIABLE_REFERENCE, 1));
+  RETURN_OR_MOVE(auto id, identifier(node.child(0)));
+  return std::make_unique<ast::VariableReference>(node.range(file_),
+                                                  std::move(id));
+}
+
+ErrorOr<ast::Identifier> Decoder::identifier(NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  RETURN_IF_ERROR(expect(node, Kind::IDENTIFIER, 0));
+  return ast::Identifier(node.name(), node.range(file_),
+                         (node.flags() & format::k_uppercase) != 0,
+                         (node.flags() & format::k_absolute) != 0);
+}
+
+ErrorOr<ast::Type> Decoder::type(NodeView node) const {
+  if (is_missing(node)) return corrupted();
+  if (node.kind() == Kind::NAMED_TYPE) {
+    RETURN_IF_ERROR(expect(node, Kind::NAMED_TYPE, 0));
+    return ast::Type(ast::Identifier(node.name(), node.range(file_),
+                                     (node.flags() & format::k_uppercase) != 0,
+                                     (node.flags() & format::k_absolute) != 0));
+  }
+  if ((node.kind() != Kind::ARRAY_TYPE && node.kind() != Kind::SLICE_TYPE) ||
+      node.child_count() != 1)
+    return corrupted();
+  RETURN_OR_MOVE(auto element, type(node.child(0)));
+  // Named like the parser does.
+  std::string name = "[" + element.to_string();
+  Option<std::uint64_t> size;
+  if (node.kind() == Kind::ARRAY_TYPE) {
+    size = node.value();
+    name += "; " + std::to_string(node.value());
+  }
+  return ast::Type(ast::Identifier(name + "]", node.range(file_), true),
+                   std::move(element), std::move(size));
+}
+
+}  // namespace
+
+ErrorOr<std::unique_ptr<ast::Module>> SerializedAST::to_module(
+    const std::string& file) const {
+  return Decoder(*this, file).module(root());
+}
+
+}  // namespace serialization
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ast/module.h"
+#include "error/error.h"
+#include "lexer/token.h"
+#include "serialization/format.h"
+#include "util/mapped_file.h"
+
+namespace serialization {
+
+class SerializedAST;
+
+/// A node of a serialized AST, read in the mapped file when it is accessed:
+/// walking the tree doesn't allocate anything.
+class NodeView {
+ public:
+  format::Kind kind() const { return static_cast<format::Kind>(u8(0)); }
+  std::uint8_t flags() const { return u8(1); }
+  /// The integer of the node, see format::Kind.
+  std::uint64_t value() const { return read(24, 8); }
+  /// The range of the node in the file.
+  lexer::Range range(const std::string& file) const;
+
+  std::uint32_t child_count() const {
+    return static_cast<std::uint32_t>(read(20, 4));
+  }
+  /// False for a missing optional child.
+  bool has_child(std::uint32_t position) const {
+    return child_index(position) != format::k_none;
+  }
+  /// The child at this position, which must be there.
+  NodeView child(std::uint32_t position) const;
+
+  /// The name of an identifier or of a named type, in the mapped file: it is
+  /// not null-terminated.
+  const char* name_data() const;
+  std::uint32_t name_size() const;
+  std::string name() const { return std::string(name_data(), name_size()); }
+
+  std::uint32_t index() const { return index_; }
+
+ private:
+  friend class SerializedAST;
+
+  NodeView(const SerializedAST* ast, std::uint32_t index)
+      : ast_(ast), index_(index) {}
+
+  std::uint8_t u8(std::size_t offset) const {
+    return static_cast<std::uint8_t>(read(offset, 1));
+  }
+  /// The little-endian integer at this offset of the record.
+  std::uint64_t read(std::size_t offset, std::size_t size) const;
+  std::uint32_t child_index(std::uint32_t position) const;
+
+  const SerializedAST* ast_;
+  std::uint32_t index_;
+};
+
+/// An AST written by write_ast, mapped in memory. The whole file is checked
+/// when it is opened: its nodes can then be read without any check, and they
+/// make a tree.
+class SerializedAST {
+ public:
+  /// Map the file, and check it.
+  static ErrorOr<std::unique_ptr<SerializedAST>> open(const std::string& path);
+
+  /// The hash of the source that the AST was parsed from.
+  std::uint64_t source_hash() const { return source_hash_; }
+  std::uint32_t node_count() const { return node_count_; }
+  NodeView root() const { return NodeView(this, 0); }
+  const std::string& path() const { return file_->path(); }
+
+  /// Build the AST, with the ranges in this file. An error if the nodes
+  /// don't make a module, e.g. if a value is where a statement is expected.
+  ErrorOr<std::unique_ptr<ast::Module>> to_module(
+      const std::string& file) const;
+
+ private:
+  friend class NodeView;
+
+  explicit SerializedAST(std::unique_ptr<util::MappedFile> file)
+      : file_(std::move(file)) {}
+
+  /// Read the header and check the tables. False if the file is corrupted.
+  bool check();
+  /// The little-endian integer at this offset of the file.
+  std::uint64_t read(std::size_t offset, std::size_t size) const;
+  std::size_t children_offset() const;
+  std::size_t strings_offset() const;
+
+  std::unique_ptr<util::MappedFile> file_;
+  std::uint64_t source_hash_ = 0;
+  std::uint32_t node_count_ = 0;
+  std::uint32_t child_count_ = 0;
+  std::uint32_t string_count_ = 0;
+};
+
+}  // namespace serialization
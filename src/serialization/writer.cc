@@ -0,0 +1,325 @@
+#include "serialization/writer.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/assignment.h"
+#include "ast/binary_operation.h"
+#include "ast/block_statement.h"
+#include "ast/boolean_constant.h"
+#include "ast/for_block.h"
+#include "ast/function_call.h"
+#include "ast/function_declaration.h"
+#include "ast/if_statement.h"
+#include "ast/import_statement.h"
+#include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
+#include "ast/return_statement.h"
+#include "ast/value_statement.h"
+#include "ast/variable_reference.h"
+#include "ast/while_block.h"
+#include "serialization/format.h"
+#include "util/logging.h"
+#include "visitor/visitor.h"
+
+namespace serialization {
+
+namespace {
+
+using format::Kind;
+
+void put(std::uint64_t value, int size, std::string* out) {
+  for (int i = 0; i < size; ++i)
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+std::uint16_t clamp_column(int column) {
+  return static_cast<std::uint16_t>(std::min(std::max(column, 0), 0xffff));
+}
+
+/// The record of a node, until it is written.
+struct Node {
+  Kind kind = Kind::MODULE;
+  std::uint8_t flags = 0;
+  const lexer::Range* range = nullptr;
+  std::uint32_t first_child = 0;
+  std::uint32_t child_count = 0;
+  std::uint64_t value = 0;
+};
+
+/// Adds the records of the nodes that it visits, each before its children.
+class Serializer : public ast::ASTVisitor {
+ public:
+  /// Add the node and its children. Returns its index.
+  std::uint32_t add(ast::ASTNode* node) {
+    auto parent = current_;
+    current_ = reserve();
+    node->accept(*this);
+    std::swap(parent, current_);
+    return parent;
+  }
+
+  void write(std::uint64_t source_hash, std::ostream* out) const;
+
+  void visit(ast::ArrayIndex* node) override {
+    set(node, Kind::ARRAY_INDEX, {add(node->base().get()),
+                                  add(node->index().get())});
+  }
+  void visit(ast::ArrayLength* node) override {
+    set(node, Kind::ARRAY_LENGTH, {add(node->base().get())});
+  }
+  void visit(ast::ArrayLiteral* node) override {
+    std::vector<std::uint32_t> elements;
+    for (const auto& element : node->elements())
+      elements.push_back(add(element.get()));
+    set(node, Kind::ARRAY_LITERAL, std::move(elements));
+  }
+  void visit(ast::ArraySlice* node) override {
+    set(node, Kind::ARRAY_SLICE, {add(node->base().get()),
+                                  add_optional(node->begin()),
+                                  add_optional(node->end())});
+  }
+  void visit(ast::Assignment* node) override {
+    const auto& compound_operator = node->compound_operator();
+    set(node, Kind::ASSIGNMENT,
+        {add(&node->target()), add(node->value().get()),
+         add_optional(node->index())},
+        compound_operator.is_ok()
+            ? 1 + static_cast<std::uint64_t>(compound_operator.value_or_die())
+            : 0);
+  }
+  void visit(ast::BinaryOp* node) override {
+    set(node, Kind::BINARY_OP, {add(&node->left_value()),
+                                add(&node->right_value())},
+        static_cast<std::uint64_t>(node->operation()),
+        node->is_parenthesized() ? format::k_parenthesized : 0);
+  }
+  void visit(ast::BlockStatement* node) override {
+    std::vector<std::uint32_t> statements;
+    for (const auto& statement : node->statements())
+      statements.push_back(add(statement.get()));
+    set(node, Kind::BLOCK_STATEMENT, std::move(statements));
+  }
+  void visit(ast::BooleanConstant* node) override {
+    set(node, Kind::BOOLEAN_CONSTANT, {}, node->value() ? 1 : 0);
+  }
+  void visit(ast::BreakStatement* node) override {
+    set(node, Kind::BREAK_STATEMENT, {});
+  }
+  void visit(ast::ContinueStatement* node) override {
+    set(node, Kind::CONTINUE_STATEMENT, {});
+  }
+  void visit(ast::ForBlock* node) override {
+    set(node, Kind::FOR_BLOCK, {add(node->variable()),
+                                add(node->begin().get()),
+                                add(node->end().get()),
+                                add(node->body().get())});
+  }
+  void visit(ast::FunctionArgumentDeclaration* node) override {
+    set_variable(node, Kind::FUNCTION_ARGUMENT_DECLARATION);
+  }
+  void visit(ast::FunctionCall* node) override {
+    std::vector<std::uint32_t> children = {add(&node->base())};
+    for (const auto& argument : node->arguments())
+      children.push_back(add(argument.get()));
+    set(node, Kind::FUNCTION_CALL, std::move(children));
+  }
+  void visit(ast::FunctionDeclaration* node) override;
+  void visit(ast::IfStatement* node) override {
+    set(node, Kind::IF_STATEMENT, {add(node->condition().get()),
+                                   add(node->body().get()),
+                                   add_optional(node->else_statement())});
+  }
+  void visit(ast::ImportStatement* node) override {
+    set(node, Kind::IMPORT_STATEMENT, {add_identifier(node->module())});
+  }
+  void visit(ast::IntConstant* node) override {
+    set(node, Kind::INT_CONSTANT, {},
+        static_cast<std::uint64_t>(node->value()));
+  }
+  void visit(ast::LocalVariableDeclaration* node) override {
+    set_variable(node, Kind::LOCAL_VARIABLE_DECLARATION);
+  }
+  void visit(ast::Module* node) override {
+    std::vector<std::uint32_t> declarations;
+    for (const auto& declaration : node->top_level_declarations())
+      declarations.push_back(add(declaration.get()));
+    set(node, Kind::MODULE, std::move(declarations));
+  }
+  void visit(ast::ReturnStatement* node) override {
+    set(node, Kind::RETURN_STATEMENT, {add_optional(node->value())});
+  }
+  void visit(ast::ValueStatement* node) override {
+    set(node, Kind::VALUE_STATEMENT, {add(node->value().get())});
+  }
+  void visit(ast::VariableReference* node) override {
+    set(node, Kind::VARIABLE_REFERENCE, {add_identifier(node->id())});
+  }
+  void visit(ast::WhileBlock* node) override {
+    set(node, Kind::WHILE_BLOCK, {add(node->condition().get()),
+                                  add(node->body().get())});
+  }
+
+ private:
+  std::uint32_t reserve() {
+    nodes_.emplace_back();
+    return static_cast<std::uint32_t>(nodes_.size() - 1);
+  }
+
+  /// Fill the record of the node being added, once its children are added.
+  void set(ast::ASTNode* node, Kind kind, std::vector<std::uint32_t> children,
+           std::uint64_t value = 0, std::uint8_t flags = 0) {
+    set(node->location(), kind, std::move(children), value, flags);
+  }
+  void set(const lexer::Range& range, Kind kind,
+           std::vector<std::uint32_t> children, std::uint64_t value,
+           std::uint8_t flags);
+
+  void set_variable(ast::VariableDeclaration* node, Kind kind) {
+    std::uint8_t flags = (node->is_mutable() ? format::k_mutable : 0) |
+                         (node->is_constant() ? format::k_constant : 0);
+    auto identifier = add_identifier(node->id());
+    auto type = node->type().is_ok() ? add_type(node->type().value_or_die())
+                                     : format::k_none;
+    set(node, kind, {identifier, type, add_optional(node->value())}, 0,
+        flags);
+  }
+
+  template <typename T>
+  std::uint32_t add_optional(const Option<std::unique_ptr<T>>& node) {
+    return node.is_ok() ? add(node.value_or_die().get()) : format::k_none;
+  }
+
+  std::uint32_t add_identifier(const ast::Identifier& id,
+                               Kind kind = Kind::IDENTIFIER);
+  std::uint32_t add_type(const ast::Type& type);
+  std::uint32_t intern(const std::string& string);
+
+  std::vector<Node> nodes_;
+  std::vector<std::uint32_t> children_;
+  std::vector<const std::string*> strings_;
+  std::unordered_map<std::string, std::uint32_t> string_indices_;
+  // The node whose record is filled by the visit.
+  std::uint32_t current_ = 0;
+};
+
+void Serializer::visit(ast::FunctionDeclaration* node) {
+  std::uint8_t flags = (node->is_public() ? format::k_public : 0) |
+                       (node->is_pure() ? format::k_pure : 0) |
+                       (node->is_extern() ? format::k_extern : 0);
+  std::vector<std::uint32_t> children = {add_identifier(node->id())};
+  children.push_back(node->type().is_ok()
+                         ? add_type(node->type().value_or_die())
+                         : format::k_none);
+  auto& body = node->body();
+  if (body.is<ast::FunctionDeclaration::ValueBody>()) {
+    children.push_back(
+        add(body.get_unchecked<ast::FunctionDeclaration::ValueBody>().get()));
+  } else {
+    auto& block =
+        body.get_unchecked<ast::FunctionDeclaration::StatementsBody>();
+    // Extern functions have no body.
+    children.push_back(block == nullptr ? format::k_none : add(block.get()));
+  }
+  for (const auto& argument : node->arguments())
+    children.push_back(add(argument.get()));
+  set(node, Kind::FUNCTION_DECLARATION, std::move(children), 0, flags);
+}
+
+void Serializer::set(const lexer::Range& range, Kind kind,
+                     std::vector<std::uint32_t> children, std::uint64_t value,
+                     std::uint8_t flags) {
+  // The children were added meanwhile.
+  auto& node = nodes_[current_];
+  node.kind = kind;
+  node.flags = flags;
+  node.range = &range;
+  node.first_child = static_cast<std::uint32_t>(children_.size());
+  node.child_count = static_cast<std::uint32_t>(children.size());
+  node.value = value;
+  children_.insert(std::end(children_), std::begin(children),
+                   std::end(children));
+}
+
+std::uint32_t Serializer::add_identifier(const ast::Identifier& id,
+                                         Kind kind) {
+  auto parent = current_;
+  current_ = reserve();
+  std::uint8_t flags = (id.is_uppercase() ? format::k_uppercase : 0) |
+                       (id.is_absolute() ? format::k_absolute : 0);
+  set(id.location(), kind, {}, intern(id.to_string()), flags);
+  std::swap(parent, current_);
+  return parent;
+}
+
+std::uint32_t Serializer::add_type(const ast::Type& type) {
+  // The name of an array type is made from its element.
+  if (type.element() == nullptr)
+    return add_identifier(type.id(), Kind::NAMED_TYPE);
+  auto parent = current_;
+  current_ = reserve();
+  auto element = add_type(*type.element());
+  if (type.size().is_ok())
+    set(type.location(), Kind::ARRAY_TYPE, {element},
+        type.size().value_or_die(), 0);
+  else
+    set(type.location(), Kind::SLICE_TYPE, {element}, 0, 0);
+  std::swap(parent, current_);
+  return parent;
+}
+
+std::uint32_t Serializer::intern(const std::string& string) {
+  auto inserted = string_indices_.emplace(
+      string, static_cast<std::uint32_t>(strings_.size()));
+  if (inserted.second) strings_.push_back(&inserted.first->first);
+  return inserted.first->second;
+}
+
+void Serializer::write(std::uint64_t source_hash, std::ostream* out) const {
+  std::string bytes(format::k_magic, sizeof(format::k_magic));
+  put(format::k_version, 4, &bytes);
+  put(source_hash, 8, &bytes);
+  put(nodes_.size(), 4, &bytes);
+  put(children_.size(), 4, &bytes);
+  put(strings_.size(), 4, &bytes);
+  put(0, 4, &bytes);
+  CHECK(bytes.size() == format::k_header_size) << "Wrong header size";
+
+  for (const auto& node : nodes_) {
+    bytes.push_back(static_cast<char>(node.kind));
+    bytes.push_back(static_cast<char>(node.flags));
+    put(clamp_column(node.range->begin.column), 2, &bytes);
+    put(clamp_column(node.range->end.column), 2, &bytes);
+    put(0, 2, &bytes);
+    put(static_cast<std::uint32_t>(node.range->begin.line), 4, &bytes);
+    put(static_cast<std::uint32_t>(node.range->end.line), 4, &bytes);
+    put(node.first_child, 4, &bytes);
+    put(node.child_count, 4, &bytes);
+    put(node.value, 8, &bytes);
+  }
+  for (auto child : children_) put(child, 4, &bytes);
+  std::uint32_t offset = 0;
+  for (auto string : strings_) {
+    put(offset, 4, &bytes);
+    put(string->size(), 4, &bytes);
+    offset += static_cast<std::uint32_t>(string->size());
+  }
+  for (auto string : strings_) bytes += *string;
+  out->write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+}  // namespace
+
+void write_ast(ast::Module* module, std::uint64_t source_hash,
+               std::ostream* out) {
+  Serializer serializer;
+  serializer.add(module);
+  serializer.write(source_hash, out);
+}
+
+}  // namespace serialization
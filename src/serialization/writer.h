@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include "ast/module.h"
+
+namespace serialization {
+
+/// Write the AST of the module, in the format of serialization/format.h. The
+/// hash of the source that it was parsed from is kept in the file, to check
+/// that it is still the right one.
+///
+/// Only the syntax is written: the AST is expected before the name
+/// resolution, the resolutions and the deduced types are not kept.
+void write_ast(ast::Module* module, std::uint64_t source_hash,
+               std::ostream* out);
+
+}  // namespace serialization
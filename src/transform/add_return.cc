@@ -2,10 +2,13 @@
 
 #include "ast/block_statement.h"
 #include "ast/builtin_type.h"
+#include "ast/for_block.h"
 #include "ast/function_declaration.h"
 #include "ast/if_statement.h"
+#include "ast/loop_control_statement.h"
 #include "ast/return_statement.h"
 #include "ast/variable_declaration.h"
+#include "ast/while_block.h"
 #include "util/logging.h"
 
 namespace transform {
@@ -23,6 +26,25 @@ void VoidFunctionReturnAdder::visit(ast::ReturnStatement* /*unused*/) {
   has_returned_ = true;
 }
 
+void VoidFunctionReturnAdder::visit(ast::BreakStatement* /*unused*/) {
+  has_returned_ = true;
+}
+
+void VoidFunctionReturnAdder::visit(ast::ContinueStatement* /*unused*/) {
+  has_returned_ = true;
+}
+
+void VoidFunctionReturnAdder::visit(ast::ForBlock* node) {
+  // The body may not run at all: the code after the loop is reachable.
+  visit(node->body().get());
+  has_returned_ = false;
+}
+
+void VoidFunctionReturnAdder::visit(ast::WhileBlock* node) {
+  visit(node->body().get());
+  has_returned_ = false;
+}
+
 void VoidFunctionReturnAdder::visit(ast::BlockStatement* node) {
   CHECK(!has_returned_);
   auto& statements = node->statements();
@@ -39,6 +61,7 @@ void VoidFunctionReturnAdder::visit(ast::BlockStatement* node) {
 }
 
 void VoidFunctionReturnAdder::visit(ast::FunctionDeclaration* node) {
+  if (node->is_extern()) return;
   has_returned_ = false;
   CHECK(node->type().is_ok()) << "Function return type not deduced: "
                               << node->name();
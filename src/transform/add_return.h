@@ -5,15 +5,21 @@
 
 namespace transform {
 
-/// Add a return statement at the end of functions returning `Void`.
+/// Add a return statement at the end of functions returning `Void`, and
+/// report the unreachable code after a return, a break or a continue.
 class VoidFunctionReturnAdder : public ast::VisitorWithErrors<> {
  public:
+  void visit(ast::BreakStatement* node) override;
+  void visit(ast::ContinueStatement* node) override;
+  void visit(ast::ForBlock* node) override;
   void visit(ast::FunctionDeclaration* node) override;
   void visit(ast::IfStatement* node) override;
   void visit(ast::ReturnStatement* node) override;
   void visit(ast::BlockStatement* node) override;
+  void visit(ast::WhileBlock* node) override;
 
  private:
+  // True if the rest of the current block is unreachable.
   bool has_returned_ = false;
 };
 }  // namespace transform
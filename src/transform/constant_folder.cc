@@ -0,0 +1,338 @@
+#include "transform/constant_folder.h"
+
+#include <algorithm>
+#include <string>
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/array_type.h"
+#include "ast/assignment.h"
+#include "ast/binary_operation.h"
+#include "ast/block_statement.h"
+#include "ast/boolean_constant.h"
+#include "ast/builtin_type.h"
+#include "ast/for_block.h"
+#include "ast/function_call.h"
+#include "ast/function_declaration.h"
+#include "ast/if_statement.h"
+#include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
+#include "ast/return_statement.h"
+#include "ast/value_statement.h"
+#include "ast/variable_reference.h"
+#include "ast/while_block.h"
+#include "util/logging.h"
+
+namespace transform {
+
+using ast::BinaryOperator;
+
+namespace {
+
+// The value of a constant (0 or 1 for a boolean).
+Option<std::int64_t> constant_value(ast::Value* value) {
+  if (value->node_type() == ast::NodeType::INT_CONSTANT)
+    return static_cast<ast::IntConstant*>(value)->value();
+  if (value->node_type() == ast::NodeType::BOOLEAN_CONSTANT)
+    return std::int64_t{static_cast<ast::BooleanConstant*>(value)->value()};
+  return none;
+}
+
+std::unique_ptr<ast::Value> make_constant(const lexer::Range& location,
+                                          const ast::Type& type,
+                                          std::int64_t value) {
+  std::unique_ptr<ast::Value> result;
+  if (type.get_declaration() == &ast::types::boolean)
+    result = std::make_unique<ast::BooleanConstant>(location, value != 0);
+  else
+    result = std::make_unique<ast::IntConstant>(
+        location, interpreter::convert(value, type));
+  result->type() = ast::Type(type.get_declaration());
+  return result;
+}
+
+// The taken branch of an `if` with a constant condition, or nullptr if there
+// is none.
+ast::BlockStatement* taken_branch(ast::IfStatement* if_statement,
+                                  std::int64_t condition) {
+  if (condition != 0) return if_statement->body().get();
+  if (if_statement->else_statement().is_ok())
+    return if_statement->else_statement().value_or_die().get();
+  return nullptr;
+}
+
+// Whether the code after the statement is unreachable, as seen by the code
+// generation.
+bool always_returns(ast::Statement* statement) {
+  switch (statement->node_type()) {
+    case ast::NodeType::RETURN_STATEMENT:
+    case ast::NodeType::BREAK_STATEMENT:
+    case ast::NodeType::CONTINUE_STATEMENT:
+      return true;
+    case ast::NodeType::BLOCK_STATEMENT: {
+      const auto& statements =
+          static_cast<ast::BlockStatement*>(statement)->statements();
+      return std::any_of(std::begin(statements), std::end(statements),
+                         [](const std::unique_ptr<ast::Statement>& s) {
+                           return always_returns(s.get());
+                         });
+    }
+    case ast::NodeType::IF_STATEMENT: {
+      auto if_statement = static_cast<ast::IfStatement*>(statement);
+      const auto& else_statement = if_statement->else_statement();
+      return else_statement.is_ok() &&
+             always_returns(if_statement->body().get()) &&
+             always_returns(else_statement.value_or_die().get());
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void ConstantFolder::fold(std::unique_ptr<ast::Value>* value) {
+  (*value)->accept(*this);
+  // Consuming the replacement leaves it empty for the next value.
+  if (replacement_.is_ok()) *value = replacement_.consume_value_or_die();
+}
+
+void ConstantFolder::visit(ast::BinaryOp* node) {
+  auto op = node->operation();
+  fold(&node->left_value_ptr());
+  auto left = constant_value(&node->left_value());
+
+  if ((op == BinaryOperator::AND || op == BinaryOperator::OR) &&
+      left.is_ok()) {
+    // The left side decides the result, or the right side is the result.
+    if ((left.value_or_die() != 0) == (op == BinaryOperator::OR)) {
+      replacement_ = std::move(node->left_value_ptr());
+    } else {
+      fold(&node->right_value_ptr());
+      replacement_ = std::move(node->right_value_ptr());
+    }
+    return;
+  }
+
+  fold(&node->right_value_ptr());
+  auto right = constant_value(&node->right_value());
+  if (!left.is_ok() || !right.is_ok()) return;
+
+  CHECK(node->type().is_ok()) << "Binary operation should be typed";
+  int bits = std::max(
+      interpreter::bit_width(node->left_value().type().value_or_die()),
+      interpreter::bit_width(node->right_value().type().value_or_die()));
+  auto result = interpreter::evaluate_operation(op, left.value_or_die(),
+                                                right.value_or_die(), bits);
+  if (result.is_ok())
+    replacement_ = make_constant(node->location(),
+                                 node->type().value_or_die(),
+                                 result.value_or_die());
+}
+
+void ConstantFolder::visit(ast::FunctionCall* node) {
+  // The base is the function, it can't be folded.
+  std::vector<std::int64_t> arguments;
+  for (auto& argument : node->arguments()) {
+    fold(&argument);
+    auto value = constant_value(argument.get());
+    if (value.is_ok()) arguments.push_back(value.value_or_die());
+  }
+
+  // Only the calls to pure functions are evaluated: they are the ones that
+  // are meant to be, the others could take a long time to fail.
+  if (!node->function().is_ok() ||
+      arguments.size() != node->arguments().size())
+    return;
+  auto function = node->function().value_or_die();
+  CHECK(node->type().is_ok()) << "Function call should be typed";
+  const auto& type = node->type().value_or_die();
+  if (!function->is_pure() ||
+      type.get_declaration() == &ast::types::void_type)
+    return;
+  auto result = interpreter_->call(function, std::move(arguments));
+  if (result.is_ok())
+    replacement_ = make_constant(node->location(), type, result.value_or_die());
+}
+
+void ConstantFolder::visit(ast::VariableReference* node) {
+  CHECK(node->is_resolved()) << "Variable was not resolved";
+  auto constant = constants_.find(node->resolution().value_or_die());
+  if (constant == std::end(constants_)) return;
+  CHECK(node->type().is_ok()) << "Variable reference should be typed";
+  replacement_ = make_constant(node->location(), node->type().value_or_die(),
+                               constant->second);
+}
+
+bool ConstantFolder::compute(std::unique_ptr<ast::Value>* value,
+                             const ast::LocalVariableDeclaration& declaration) {
+  if (constant_value(value->get()).is_ok()) return true;
+  // Any function can be called to compute a constant.
+  auto constant = interpreter_->evaluate(value->get());
+  if (!constant.is_ok()) {
+    const char* kind =
+        declaration.is_constant() ? "constant" : "global variable";
+    add_error((*value)->location(), std::string("The value of the ") + kind +
+                                        " `" + declaration.id().to_string() +
+                                        "' can't be computed at compile time");
+    return false;
+  }
+  *value = make_constant((*value)->location(),
+                         (*value)->type().value_or_die(),
+                         constant.value_or_die());
+  return true;
+}
+
+void ConstantFolder::visit(ast::LocalVariableDeclaration* node) {
+  if (!node->value().is_ok()) return;
+  auto& value = node->value().value_or_die();
+  fold(&value);
+  // The constants and the global variables are initialized with constants.
+  // The interpreter only has scalars: for an array, they are its elements.
+  // The code generation rejects the other arrays and slices that are not.
+  if (node->is_constant() || !in_function_) {
+    if (value->node_type() == ast::NodeType::ARRAY_LITERAL) {
+      for (auto& element : static_cast<ast::ArrayLiteral&>(*value).elements()) {
+        if (!compute(&element, *node)) return;
+      }
+      return;
+    }
+    auto type = value->type().value_or_die().get_declaration();
+    if (ast::types::element_type(type) == nullptr && !compute(&value, *node))
+      return;
+  }
+  auto constant = constant_value(value.get());
+  if (constant.is_ok() && !node->is_mutable())
+    constants_[node] = constant.value_or_die();
+}
+
+void ConstantFolder::visit(ast::FunctionDeclaration* node) {
+  in_function_ = true;
+  ASTVisitor::visit(node);
+  in_function_ = false;
+}
+
+void ConstantFolder::visit(ast::Module* node) {
+  interpreter_ = std::make_unique<interpreter::Interpreter>(node);
+  ASTVisitor::visit(node);
+}
+
+void ConstantFolder::visit(ast::ReturnStatement* node) {
+  if (node->value().is_ok()) fold(&node->value().value_or_die());
+}
+
+void ConstantFolder::visit(ast::ValueStatement* node) { fold(&node->value()); }
+
+void ConstantFolder::visit(ast::Assignment* node) {
+  if (node->index().is_ok()) fold(&node->index().value_or_die());
+  fold(&node->value());
+}
+
+void ConstantFolder::visit(ast::ArrayLiteral* node) {
+  for (auto& element : node->elements()) fold(&element);
+}
+
+void ConstantFolder::visit(ast::ArrayIndex* node) {
+  fold(&node->base());
+  fold(&node->index());
+}
+
+void ConstantFolder::visit(ast::ArraySlice* node) {
+  fold(&node->base());
+  if (node->begin().is_ok()) fold(&node->begin().value_or_die());
+  if (node->end().is_ok()) fold(&node->end().value_or_die());
+}
+
+void ConstantFolder::visit(ast::ArrayLength* node) {
+  fold(&node->base());
+  // The length of an array is in its type: the variable is not needed.
+  auto array = ast::types::as_array(
+      node->base()->type().value_or_die().get_declaration());
+  if (array != nullptr &&
+      node->base()->node_type() == ast::NodeType::VARIABLE_REFERENCE)
+    replacement_ =
+        make_constant(node->location(), ast::Type(&ast::types::int64),
+                      static_cast<std::int64_t>(array->size()));
+}
+
+void ConstantFolder::visit(ast::WhileBlock* node) {
+  fold(&node->condition());
+  visit(node->body().get());
+}
+
+void ConstantFolder::visit(ast::ForBlock* node) {
+  fold(&node->begin());
+  fold(&node->end());
+  visit(node->body().get());
+}
+
+void ConstantFolder::visit(ast::IfStatement* node) {
+  fold(&node->condition());
+  // The enclosing block keeps only the branch that is taken.
+  if (constant_value(node->condition().get()).is_ok()) return;
+  visit(node->body().get());
+  if (node->else_statement().is_ok())
+    visit(node->else_statement().value_or_die().get());
+}
+
+void ConstantFolder::visit(ast::BlockStatement* node) {
+  // The statements are only moved once they are all folded: the interpreter
+  // may run the function meanwhile, it must see all of it.
+  for (const auto& statement : node->statements()) {
+    statement->accept(*this);
+    if (statement->node_type() != ast::NodeType::IF_STATEMENT) continue;
+    auto if_statement = static_cast<ast::IfStatement*>(statement.get());
+    auto condition = constant_value(if_statement->condition().get());
+    if (!condition.is_ok()) continue;
+    auto branch = taken_branch(if_statement, condition.value_or_die());
+    if (branch != nullptr) visit(branch);
+  }
+
+  ast::BlockStatement::StatementList statements;
+  for (auto& statement : node->statements()) {
+    // The code after a return that we inlined is unreachable.
+    if (!statements.empty() && always_returns(statements.back().get()))
+      break;
+    switch (statement->node_type()) {
+      case ast::NodeType::IF_STATEMENT: {
+        auto if_statement = static_cast<ast::IfStatement*>(statement.get());
+        auto condition = constant_value(if_statement->condition().get());
+        if (!condition.is_ok()) break;
+        auto branch = taken_branch(if_statement, condition.value_or_die());
+        // The names are already resolved, the scope of the branch doesn't
+        // matter anymore.
+        if (branch != nullptr) {
+          for (auto& branch_statement : branch->statements())
+            statements.push_back(std::move(branch_statement));
+        }
+        continue;
+      }
+      case ast::NodeType::WHILE_BLOCK: {
+        // The body never runs.
+        auto& condition =
+            static_cast<ast::WhileBlock&>(*statement).condition();
+        auto value = constant_value(condition.get());
+        if (value.is_ok() && value.value_or_die() == 0) continue;
+        break;
+      }
+      case ast::NodeType::VALUE_STATEMENT: {
+        // A constant has no effect.
+        auto& value = static_cast<ast::ValueStatement&>(*statement).value();
+        if (constant_value(value.get()).is_ok()) continue;
+        break;
+      }
+      case ast::NodeType::LOCAL_VARIABLE_DECLARATION: {
+        // All the references to the variable were inlined.
+        auto declaration = static_cast<ast::Declaration*>(statement.get());
+        if (constants_.count(declaration) != 0) continue;
+        break;
+      }
+      default:
+        break;
+    }
+    statements.push_back(std::move(statement));
+  }
+  node->statements() = std::move(statements);
+}
+
+}  // namespace transform
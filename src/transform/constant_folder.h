@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include "ast/value.h"
+#include "interpreter/interpreter.h"
+#include "util/option.h"
+#include "visitor/error_visitor.h"
+#include "visitor/visitor.h"
+
+namespace transform {
+
+/// Evaluate the operations on constants, inline the `val` variables with a
+/// constant value and the lengths of the arrays, replace the `if` statements
+/// with a constant condition by the branch that is taken, and remove the
+/// `while` loops that never run.
+///
+/// The calls to `pure` functions with constant arguments are evaluated by the
+/// interpreter, as well as the values of the `constant` declarations and of
+/// the global variables, which are errors if they can't be computed.
+///
+/// The integer operations have the semantics of the generated code: the
+/// operands are extended to the widest of them, and the result wraps around.
+/// The divisions by zero are left for the runtime.
+///
+/// Assumes that the types are checked and the returns added: it only makes
+/// less IR to generate and to optimize.
+class ConstantFolder : public ast::VisitorWithErrors<> {
+ public:
+  void visit(ast::ArrayIndex* node) override;
+  void visit(ast::ArrayLength* node) override;
+  void visit(ast::ArrayLiteral* node) override;
+  void visit(ast::ArraySlice* node) override;
+  void visit(ast::Assignment* node) override;
+  void visit(ast::BinaryOp* node) override;
+  void visit(ast::BlockStatement* node) override;
+  void visit(ast::ForBlock* node) override;
+  void visit(ast::FunctionCall* node) override;
+  void visit(ast::FunctionDeclaration* node) override;
+  void visit(ast::IfStatement* node) override;
+  void visit(ast::LocalVariableDeclaration* node) override;
+  void visit(ast::Module* node) override;
+  void visit(ast::ReturnStatement* node) override;
+  void visit(ast::ValueStatement* node) override;
+  void visit(ast::VariableReference* node) override;
+  void visit(ast::WhileBlock* node) override;
+
+ private:
+  /// Visit the value, and replace it by its folded version.
+  void fold(std::unique_ptr<ast::Value>* value);
+  /// Replace the value by the constant computed by the interpreter, for the
+  /// declaration. False, with an error, if it can't be computed.
+  bool compute(std::unique_ptr<ast::Value>* value,
+               const ast::LocalVariableDeclaration& declaration);
+
+  // Folded version of the last visited value, if it changed.
+  Option<std::unique_ptr<ast::Value>> replacement_ = none;
+  // Value of the `val` variables with a constant value.
+  std::unordered_map<const ast::Declaration*, std::int64_t> constants_;
+  std::unique_ptr<interpreter::Interpreter> interpreter_;
+  bool in_function_ = false;
+};
+}  // namespace transform
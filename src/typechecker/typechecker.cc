@@ -1,12 +1,25 @@
 #include "typechecker/typechecker.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/array_type.h"
+#include "ast/assignment.h"
 #include "ast/base_types.h"
 #include "ast/binary_operation.h"
 #include "ast/boolean_constant.h"
 #include "ast/builtin_type.h"
+#include "ast/for_block.h"
+#include "ast/function_call.h"
 #include "ast/function_declaration.h"
 #include "ast/int_constant.h"
+#include "ast/local_variable_declaration.h"
 #include "ast/return_statement.h"
+#include "ast/variable_declaration.h"
 #include "ast/variable_reference.h"
 
 namespace typechecker {
@@ -41,10 +54,6 @@ bool is_integer_operator(ast::BinaryOperator op) {
     case BinaryOperator::BITOR:
     case BinaryOperator::BITXOR:
     case BinaryOperator::BITAND:
-    case BinaryOperator::GREATER:
-    case BinaryOperator::GREATER_OR_EQUAL:
-    case BinaryOperator::LESS:
-    case BinaryOperator::LESS_OR_EQUAL:
     case BinaryOperator::BITSHIFT_LEFT:
     case BinaryOperator::BITSHIFT_RIGHT:
     case BinaryOperator::PLUS:
@@ -59,10 +68,137 @@ bool is_integer_operator(ast::BinaryOperator op) {
   }
 }
 
+bool is_comparison_operator(ast::BinaryOperator op) {
+  using ast::BinaryOperator;
+  switch (op) {
+    case BinaryOperator::GREATER:
+    case BinaryOperator::GREATER_OR_EQUAL:
+    case BinaryOperator::LESS:
+    case BinaryOperator::LESS_OR_EQUAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool is_equality_operator(ast::BinaryOperator op) {
+  using ast::BinaryOperator;
+  return op == BinaryOperator::EQUAL || op == BinaryOperator::DIFFERENT;
+}
+
+// Whether the values have a type. Those that don't had an error, reported on
+// them or on the declaration they refer to: their parents are skipped, like
+// after the errors of their children.
+bool have_types(std::initializer_list<ast::Value*> values) {
+  return std::all_of(values.begin(), values.end(),
+                     [](ast::Value* value) { return value->type().is_ok(); });
+}
+
+// Whether the value can be used where the type is expected: the integers are
+// converted to any width, and so are the elements of the array literals,
+// which take the expected type.
+bool convert_to(ast::Value* value, const Type& type) {
+  const auto& value_type = value->type().value_or_die();
+  if (value_type == type || (is_integer(value_type) && is_integer(type)))
+    return true;
+  auto array = ast::types::as_array(type.get_declaration());
+  auto value_array = ast::types::as_array(value_type.get_declaration());
+  if (value->node_type() != ast::NodeType::ARRAY_LITERAL ||
+      array == nullptr || value_array == nullptr ||
+      array->size() != value_array->size() ||
+      !is_integer(Type(array->element())) ||
+      !is_integer(Type(value_array->element())))
+    return false;
+  value->type() = Type(type.get_declaration());
+  return true;
+}
+
+const ast::TypeDeclaration* TypeChecker::get_element_type(ast::Value* array) {
+  const auto& type = array->type().value_or_die();
+  auto element = ast::types::element_type(type.get_declaration());
+  if (element == nullptr)
+    add_error(array->location(),
+              "Expected an array or a slice, got `" + type.to_string() + "'");
+  return element;
+}
+
+bool TypeChecker::points_to_frame(ast::Value* slice) {
+  switch (slice->node_type()) {
+    case ast::NodeType::ARRAY_SLICE: {
+      auto base = static_cast<ast::ArraySlice*>(slice)->base().get();
+      auto base_type = base->type().value_or_die().get_declaration();
+      if (ast::types::as_slice(base_type) != nullptr)
+        return points_to_frame(base);
+      // An array that is not a variable is copied on the stack.
+      if (base->node_type() != ast::NodeType::VARIABLE_REFERENCE) return true;
+      auto& resolution =
+          static_cast<ast::VariableReference*>(base)->resolution();
+      return frame_declarations_.count(resolution.value_or_die()) != 0;
+    }
+    case ast::NodeType::VARIABLE_REFERENCE: {
+      auto& resolution =
+          static_cast<ast::VariableReference*>(slice)->resolution();
+      return frame_slices_.count(resolution.value_or_die()) != 0;
+    }
+    case ast::NodeType::FUNCTION_CALL:
+      // The function may return one of the slices it is given.
+      for (auto& argument :
+           static_cast<ast::FunctionCall*>(slice)->arguments()) {
+        auto type = argument->type().value_or_die().get_declaration();
+        if (ast::types::as_slice(type) != nullptr &&
+            points_to_frame(argument.get()))
+          return true;
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+void TypeChecker::check_escaping_slices() {
+  // The slice variables given a slice of the frame, directly or through
+  // other variables.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto& slice_value : slice_values_) {
+      if (slice_value.first == nullptr ||
+          frame_slices_.count(slice_value.first) != 0 ||
+          !points_to_frame(slice_value.second))
+        continue;
+      frame_slices_.insert(slice_value.first);
+      changed = true;
+    }
+  }
+  for (const auto& slice_value : slice_values_) {
+    if (slice_value.first != nullptr || !points_to_frame(slice_value.second))
+      continue;
+    add_error(slice_value.second->location(),
+              "The returned slice points to an array of the function, which "
+              "doesn't outlive it");
+    return;
+  }
+}
+
+bool TypeChecker::check_index(ast::Value* index) {
+  const auto& type = index->type().value_or_die();
+  if (is_integer(type)) return true;
+  add_error(index->location(),
+            "The index must be an integer, got `" + type.to_string() + "'");
+  return false;
+}
+
 void TypeChecker::visit(ast::VariableReference* node) {
   assert(node->is_resolved() && "Variable was not resolved");
+  if (node->resolution().value_or_die()->node_type() ==
+      ast::NodeType::FUNCTION_DECLARATION) {
+    add_error(node->location(), "The function `" + node->id().to_string() +
+                                    "' can only be called");
+    return;
+  }
   const auto& declaration_type = node->resolution().value_or_die()->type();
-  assert(declaration_type.is_ok() && "Declaration did not have a type");
+  // The value of the declaration had an error.
+  if (!declaration_type.is_ok()) return;
   node->type() = Type(declaration_type.value_or_die().get_declaration());
 }
 
@@ -77,11 +213,7 @@ void TypeChecker::visit(ast::IntConstant* node) {
 void TypeChecker::visit(ast::BinaryOp* node) {
   // Visit sub-trees.
   ASTVisitor::visit(node);
-  // At this point, all the names are resolved.
-  assert(node->left_value().type().is_ok() &&
-         "Left value type is not resolved");
-  assert(node->right_value().type().is_ok() &&
-         "Right value type is not resolved");
+  if (!have_types({&node->left_value(), &node->right_value()})) return;
   const auto& left_type = node->left_value().type().value_or_die();
   const auto& right_type = node->right_value().type().value_or_die();
   if (is_integer_operator(node->operation()) && is_integer(left_type) &&
@@ -95,6 +227,13 @@ void TypeChecker::visit(ast::BinaryOp* node) {
   } else if (is_boolean_operator(node->operation()) && is_boolean(left_type) &&
              is_boolean(right_type)) {
     node->type() = &ast::types::boolean;
+  } else if (is_comparison_operator(node->operation()) &&
+             is_integer(left_type) && is_integer(right_type)) {
+    node->type() = &ast::types::boolean;
+  } else if (is_equality_operator(node->operation()) &&
+             ((is_integer(left_type) && is_integer(right_type)) ||
+              (is_boolean(left_type) && is_boolean(right_type)))) {
+    node->type() = &ast::types::boolean;
   } else {
     add_error(node->location(), "Invalid operand types for binary operation `" +
                                     to_string(node->operation()) + "': `" +
@@ -103,11 +242,260 @@ void TypeChecker::visit(ast::BinaryOp* node) {
   }
 }
 
-void TypeChecker::visit(ast::ReturnStatement* node) {
+void TypeChecker::visit(ast::FunctionCall* node) {
+  size_t num_errors = error_list().errors().size();
+  // The base is not visited: it is not a value.
+  for (const auto& argument : node->arguments()) {
+    argument->accept(*this);
+    if (!have_types({argument.get()})) return;
+  }
+  if (num_errors < error_list().errors().size()) return;
+
+  if (!node->function().is_ok()) {
+    add_error(node->base().location(), "Only functions can be called");
+    return;
+  }
+  auto function = node->function().value_or_die();
+  const auto& name = function->id().to_string();
+  if (!function->type().is_ok()) {
+    add_error(node->location(), "The return type of the recursive function `" +
+                                    name + "' must be declared");
+    return;
+  }
+  const auto& parameters = function->arguments();
+  if (parameters.size() != node->arguments().size()) {
+    add_error(node->location(),
+              "Wrong number of arguments for `" + name + "': expected " +
+                  std::to_string(parameters.size()) + ", got " +
+                  std::to_string(node->arguments().size()));
+    return;
+  }
+  for (std::size_t i = 0; i < parameters.size(); ++i) {
+    if (!parameters[i]->type().is_ok()) continue;
+    const auto& parameter_type = parameters[i]->type().value_or_die();
+    const auto& argument = node->arguments()[i];
+    // Integers are converted to the width of the parameter.
+    if (!convert_to(argument.get(), parameter_type)) {
+      add_error(argument->location(),
+                "Invalid argument type for `" + name + "': expected `" +
+                    parameter_type.to_string() + "', got `" +
+                    argument->type().value_or_die().to_string() + "'");
+      return;
+    }
+  }
+  node->type() = Type(function->type().value_or_die().get_declaration());
+}
+
+void TypeChecker::visit(ast::LocalVariableDeclaration* node) {
+  if (in_function_) frame_declarations_.insert(node);
+  if (!node->value().is_ok()) return;
+  size_t num_errors = error_list().errors().size();
+  auto& value = node->value().value_or_die();
+  value->accept(*this);
+  if (num_errors < error_list().errors().size() || !have_types({value.get()}))
+    return;
+
+  if (!node->type().is_ok()) {
+    // Without a type, the variable has the type of its value.
+    node->type() = Type(value->type().value_or_die().get_declaration());
+  } else if (!convert_to(value.get(), node->type().value_or_die())) {
+    add_error(value->location(),
+              "Invalid type for `" + node->id().to_string() + "': expected `" +
+                  node->type().value_or_die().to_string() + "', got `" +
+                  value->type().value_or_die().to_string() + "'");
+    return;
+  }
+  auto type = node->type().value_or_die().get_declaration();
+  if (in_function_ && ast::types::as_slice(type) != nullptr)
+    slice_values_.emplace_back(node, value.get());
+}
+
+void TypeChecker::visit(ast::ArrayLiteral* node) {
   size_t num_errors = error_list().errors().size();
   ASTVisitor::visit(node);
   if (num_errors < error_list().errors().size()) return;
+  for (const auto& value : node->elements()) {
+    if (!have_types({value.get()})) return;
+  }
 
+  const ast::TypeDeclaration* element = nullptr;
+  for (const auto& value : node->elements()) {
+    const auto& type = value->type().value_or_die();
+    if (!is_integer(type) && !is_boolean(type)) {
+      add_error(value->location(),
+                "The elements of an array must be integers or booleans, got `" +
+                    type.to_string() + "'");
+      return;
+    }
+    if (element == nullptr) {
+      element = type.get_declaration();
+    } else if (is_integer(type) && is_integer(Type(element))) {
+      // The widest of the integers, like for a binary operation.
+      element = width_to_int_type(
+          std::max(ast::types::int_type_to_width(element).value_or_die(),
+                   ast::types::int_type_to_width(type.get_declaration())
+                       .value_or_die()));
+    } else if (type.get_declaration() != element) {
+      add_error(value->location(),
+                "The elements of an array must have the same type, got `" +
+                    Type(element).to_string() + "' and `" + type.to_string() +
+                    "'");
+      return;
+    }
+  }
+  node->type() = Type(ast::types::array_of(element, node->elements().size()));
+}
+
+void TypeChecker::visit(ast::ArrayIndex* node) {
+  size_t num_errors = error_list().errors().size();
+  ASTVisitor::visit(node);
+  if (num_errors < error_list().errors().size() ||
+      !have_types({node->base().get(), node->index().get()}))
+    return;
+
+  auto element = get_element_type(node->base().get());
+  if (element == nullptr || !check_index(node->index().get())) return;
+  auto array = ast::types::as_array(
+      node->base()->type().value_or_die().get_declaration());
+  if (array != nullptr &&
+      node->index()->node_type() == ast::NodeType::INT_CONSTANT) {
+    auto index = static_cast<ast::IntConstant&>(*node->index()).value();
+    if (index < 0 || static_cast<std::uint64_t>(index) >= array->size()) {
+      add_error(node->index()->location(),
+                "The index " + std::to_string(index) +
+                    " is out of the bounds of `" + array->id().to_string() +
+                    "'");
+      return;
+    }
+  }
+  node->type() = Type(element);
+}
+
+void TypeChecker::visit(ast::ArraySlice* node) {
+  size_t num_errors = error_list().errors().size();
+  ASTVisitor::visit(node);
+  if (num_errors < error_list().errors().size() ||
+      !have_types({node->base().get()}) ||
+      (node->begin().is_ok() &&
+       !have_types({node->begin().value_or_die().get()})) ||
+      (node->end().is_ok() && !have_types({node->end().value_or_die().get()})))
+    return;
+
+  auto element = get_element_type(node->base().get());
+  if (element == nullptr) return;
+  if (node->begin().is_ok() && !check_index(node->begin().value_or_die().get()))
+    return;
+  if (node->end().is_ok() && !check_index(node->end().value_or_die().get()))
+    return;
+  node->type() = Type(ast::types::slice_of(element));
+}
+
+void TypeChecker::visit(ast::ArrayLength* node) {
+  size_t num_errors = error_list().errors().size();
+  ASTVisitor::visit(node);
+  if (num_errors < error_list().errors().size() ||
+      !have_types({node->base().get()}))
+    return;
+
+  if (get_element_type(node->base().get()) == nullptr) return;
+  node->type() = Type(&ast::types::int64);
+}
+
+void TypeChecker::visit(ast::Assignment* node) {
+  size_t num_errors = error_list().errors().size();
+  ASTVisitor::visit(node);
+  if (num_errors < error_list().errors().size() ||
+      !have_types({&node->target(), node->value().get()}) ||
+      (node->index().is_ok() &&
+       !have_types({node->index().value_or_die().get()})))
+    return;
+
+  auto& target = node->target();
+  // The functions were rejected when visiting the reference.
+  auto variable = static_cast<ast::VariableDeclaration*>(
+      target.resolution().value_or_die());
+  if (!variable->is_mutable()) {
+    add_error(node->location(), "The variable `" + target.id().to_string() +
+                                    "' is not mutable, it can't be assigned");
+    return;
+  }
+  Type assigned_type = target.type().value_or_die();
+  if (node->index().is_ok()) {
+    auto declaration = assigned_type.get_declaration();
+    if (ast::types::as_slice(declaration) != nullptr) {
+      add_error(node->location(), "The elements of the slice `" +
+                                      target.id().to_string() +
+                                      "' can't be assigned");
+      return;
+    }
+    auto array = ast::types::as_array(declaration);
+    if (array == nullptr) {
+      add_error(target.location(), "Expected an array, got `" +
+                                       assigned_type.to_string() + "'");
+      return;
+    }
+    if (!check_index(node->index().value_or_die().get())) return;
+    assigned_type = Type(array->element());
+  }
+  // Integers are converted to the width of the variable.
+  if (!convert_to(node->value().get(), assigned_type)) {
+    add_error(node->value()->location(),
+              "Invalid assigned type for `" + target.id().to_string() +
+                  "': expected `" + assigned_type.to_string() + "', got `" +
+                  node->value()->type().value_or_die().to_string() + "'");
+    return;
+  }
+  if (in_function_ &&
+      ast::types::as_slice(assigned_type.get_declaration()) != nullptr)
+    slice_values_.emplace_back(variable, node->value().get());
+}
+
+void TypeChecker::visit(ast::ForBlock* node) {
+  size_t num_errors = error_list().errors().size();
+  node->begin()->accept(*this);
+  node->end()->accept(*this);
+  if (num_errors < error_list().errors().size() ||
+      !have_types({node->begin().get(), node->end().get()}))
+    return;
+
+  const auto& begin_type = node->begin()->type().value_or_die();
+  const auto& end_type = node->end()->type().value_or_die();
+  if (!is_integer(begin_type) || !is_integer(end_type)) {
+    add_error(node->begin()->location(),
+              "The bounds of the range must be integers, got `" +
+                  begin_type.to_string() + "' and `" + end_type.to_string() +
+                  "'");
+    return;
+  }
+  auto& variable_type = node->variable()->type();
+  if (!variable_type.is_ok()) {
+    // The widest of the bounds, like for a binary operation.
+    variable_type = width_to_int_type(std::max(
+        ast::types::int_type_to_width(begin_type.get_declaration())
+            .value_or_die(),
+        ast::types::int_type_to_width(end_type.get_declaration())
+            .value_or_die()));
+  } else if (!is_integer(variable_type.value_or_die())) {
+    add_error(node->variable()->location(),
+              "The loop variable must be an integer, got `" +
+                  variable_type.value_or_die().to_string() + "'");
+    return;
+  }
+  node->body()->accept(*this);
+}
+
+void TypeChecker::visit(ast::ReturnStatement* node) {
+  size_t num_errors = error_list().errors().size();
+  ASTVisitor::visit(node);
+  if (num_errors < error_list().errors().size() ||
+      (node->value().is_ok() &&
+       !have_types({node->value().value_or_die().get()})))
+    return;
+
+  // An array literal takes the type returned by the function.
+  if (function_return_type_.is_ok() && node->value().is_ok())
+    convert_to(node->value().value_or_die().get(),
+               function_return_type_.value_or_die());
   const Type value_type = [&]() {
     if (node->value().is_ok()) {
       const auto& maybe_type = node->value().value_or_die()->type();
@@ -127,6 +515,8 @@ void TypeChecker::visit(ast::ReturnStatement* node) {
     }
   }
   function_return_type_ = value_type;
+  if (ast::types::as_slice(value_type.get_declaration()) != nullptr)
+    slice_values_.emplace_back(nullptr, node->value().value_or_die().get());
 }
 
 void TypeChecker::visit(ast::FunctionDeclaration* node) {
@@ -134,11 +524,20 @@ void TypeChecker::visit(ast::FunctionDeclaration* node) {
   size_t num_errors = error_list().errors().size();
 
   function_return_type_ = node->type();
+  in_function_ = true;
+  frame_declarations_.clear();
+  frame_slices_.clear();
+  slice_values_.clear();
+  for (const auto& argument : node->arguments())
+    frame_declarations_.insert(argument.get());
   // Visit the children.
   ASTVisitor::visit(node);
+  in_function_ = false;
   if (num_errors < error_list().errors().size())
     // Errors while processing the body.
     return;
+  check_escaping_slices();
+  if (num_errors < error_list().errors().size()) return;
   // Visit all the statements, looking for return statements, collect the
   // types.
   if (node->type().is_ok()) return;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "ast/ast.h"
@@ -13,15 +15,43 @@ class TypeChecker : public ast::VisitorWithErrors<> {
  public:
   using ErrorList = ast::ErrorList<ast::VisitorError>;
 
+  void visit(ast::ArrayIndex* node) override;
+  void visit(ast::ArrayLength* node) override;
+  void visit(ast::ArrayLiteral* node) override;
+  void visit(ast::ArraySlice* node) override;
+  void visit(ast::Assignment* node) override;
   void visit(ast::BooleanConstant* node) override;
   void visit(ast::IntConstant* node) override;
   void visit(ast::BinaryOp* node) override;
+  void visit(ast::ForBlock* node) override;
+  void visit(ast::FunctionCall* node) override;
   void visit(ast::FunctionDeclaration* node) override;
+  void visit(ast::LocalVariableDeclaration* node) override;
   void visit(ast::ReturnStatement* node) override;
   void visit(ast::VariableReference* node) override;
 
  private:
+  /// The type of the elements of the array or slice, or nullptr with an error
+  /// if it is not one.
+  const ast::TypeDeclaration* get_element_type(ast::Value* array);
+  /// Check that the index is an integer, with an error otherwise.
+  bool check_index(ast::Value* index);
+  /// Whether the slice may point to an array of the frame of the function:
+  /// one of its variables or parameters, or a temporary copy.
+  bool points_to_frame(ast::Value* slice);
+  /// Report the returned slices that point to the frame of the function.
+  void check_escaping_slices();
+
   // We may have to turn that into a stack to support nested functions.
   Option<ast::Type> function_return_type_ = none;
+  bool in_function_ = false;
+  /// The variables and parameters of the function.
+  std::unordered_set<const ast::Declaration*> frame_declarations_;
+  /// The slice variables of the function that may point to its frame.
+  std::unordered_set<const ast::Declaration*> frame_slices_;
+  /// The slices given to the slice variables of the function, and the ones
+  /// it returns (without a variable). They are checked at its end: in a loop,
+  /// a variable can be given a slice of the frame after it is returned.
+  std::vector<std::pair<const ast::Declaration*, ast::Value*>> slice_values_;
 };
 }  // namespace typechecker
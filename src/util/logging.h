@@ -6,9 +6,13 @@
 /// Instead, use the logging utilities.
 ///
 /// Example:
-/// log(INFO) << "Answer to the universe: " << 42;
-/// log_if(WARNING, a > 9000) << "It's over 9000!";
+/// LOG(INFO) << "Answer to the universe: " << 42;
+/// LOG_IF(WARNING, a > 9000) << "It's over 9000!";
 /// CHECK(K >= 0) << "Oh, no! The temperature went under absolute 0!";
+///
+/// Prefer the macros to the functions: with the macros, the arguments are
+/// only evaluated if the message is printed, and DEBUG messages are compiled
+/// out of release builds.
 
 #include <ostream>
 
@@ -76,8 +80,46 @@ const Logger& operator<<(const Logger& out, const T& value) {
 /// Handle logging flags. Has to be called after flag parsing, but before any
 /// logging.
 void initialize_logging();
+
+/// Whether messages with the given Severity are printed at the current
+/// verbosity.
+inline bool is_enabled(Severity s) { return s <= FLAGS_verbosity; }
+
+/// Turns a Logger expression into void, so that it can be used as a branch
+/// of the conditional operator in the macros below. operator& binds less
+/// tightly than operator<< but more than ?:.
+class Voidify {
+ public:
+  void operator&(const Logger& /*unused*/) {}
+};
 }  // namespace logging
 
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGING_LIKELY(CONDITION) __builtin_expect(!!(CONDITION), 1)
+#else
+#define LOGGING_LIKELY(CONDITION) (CONDITION)
+#endif
+
+/// Whether messages with the given Severity are printed. DEBUG messages are
+/// never printed in release mode, and the check is a compile-time constant.
+#ifndef NDEBUG
+#define LOG_IS_ENABLED(SEVERITY) ::logging::is_enabled(SEVERITY)
+#else
+#define LOG_IS_ENABLED(SEVERITY) \
+  ((SEVERITY) != DEBUG && ::logging::is_enabled(SEVERITY))
+#endif
+
+/// Print messages with the given Severity. The messages are not evaluated
+/// if they are not printed.
+#define LOG(SEVERITY) LOG_IF(SEVERITY, true)
+
+/// Print messages if the condition is fulfilled. Unlike log_if, neither the
+/// condition nor the messages are evaluated if the Severity is not printed.
+#define LOG_IF(SEVERITY, CONDITION)          \
+  !(LOG_IS_ENABLED(SEVERITY) && (CONDITION)) \
+      ? (void)0                              \
+      : ::logging::Voidify() & ::log(SEVERITY)
+
 /// Print messages with the given Severity.
 logging::Logger log(Severity s);
 /// Print messages if the condition is fulfilled. The condition is evaluated
@@ -96,16 +138,20 @@ logging::Logger log_fatal();
 /// the program. Prefer to use the macro CHECK.
 logging::Logger check_or_die(bool condition);
 
-/// Macro for better reporting of failed checks.
-#define CHECK(CONDITION)                                \
-  check_or_die((CONDITION)) << __FILE__ ":" << __LINE__ \
-                            << ": Check `" #CONDITION "' failed. "
-
-/// Debug asserts. Only compiled in debug mode. In release mode, the condition
-/// is not evaluated.
+/// Macro for better reporting of failed checks. The messages are only
+/// evaluated if the check fails.
+#define CHECK(CONDITION)                                                 \
+  LOGGING_LIKELY(CONDITION)                                              \
+      ? (void)0                                                          \
+      : ::logging::Voidify() & ::log_fatal() << __FILE__ ":" << __LINE__ \
+                                             << ": Check `" #CONDITION   \
+                                                "' failed. "
+
+/// Debug asserts. Only compiled in debug mode. In release mode, neither the
+/// condition nor the messages are evaluated (but they still have to compile).
 #ifndef NDEBUG
 #define DCHECK(CONDITION) CHECK(CONDITION)
 #else
-#define DCHECK(CONDITION) no_log()
+#define DCHECK(CONDITION) while (false) CHECK(CONDITION)
 #endif
 // LCOV_EXCL_STOP
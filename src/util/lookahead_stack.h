@@ -31,7 +31,7 @@ class LookaheadStack {
   ///
   /// If required, it will call CallBack once to get the next value,
   /// potentially propagating the error.
-  MaybeError<Err> get_next() {
+  MUST_USE_RESULT MaybeError<Err> get_next() {
     if (token_stack_.size() > lookahead) {
       token_stack_.pop_front();
     }
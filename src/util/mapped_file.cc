@@ -0,0 +1,101 @@
+#include "util/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace util {
+
+namespace {
+
+GenericError system_error(const std::string& action, const std::string& path) {
+  return GenericError("Could not " + action + " " + path + ": " +
+                      std::strerror(errno));
+}
+
+/// Write all the contents: write() may write only a part of them, e.g. when
+/// interrupted by a signal.
+bool write_all(int fd, const std::string& contents) {
+  const char* data = contents.data();
+  std::size_t left = contents.size();
+  while (left > 0) {
+    ssize_t written = ::write(fd, data, left);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    left -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+}  // namespace
+
+ErrorOr<std::unique_ptr<MappedFile>> MappedFile::open(
+    const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return system_error("open", path);
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    auto error = system_error("read", path);
+    ::close(fd);
+    return std::move(error);
+  }
+  auto size = static_cast<std::size_t>(file_stat.st_size);
+  void* data = nullptr;
+  if (size > 0) {
+    data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      auto error = system_error("map", path);
+      ::close(fd);
+      return std::move(error);
+    }
+  }
+  // The mapping stays valid without the file descriptor.
+  ::close(fd);
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(path, static_cast<const char*>(data), size));
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+}
+
+MaybeError<> replace_file(const std::string& path,
+                          const std::string& contents) {
+  mode_t mode = 0644;
+  struct stat file_stat;
+  if (::stat(path.c_str(), &file_stat) == 0) {
+    mode = file_stat.st_mode & 07777;
+  } else if (errno != ENOENT) {
+    return system_error("read", path);
+  }
+  std::string temporary = path + ".XXXXXX";
+  int fd = ::mkstemp(&temporary[0]);
+  if (fd < 0) return system_error("create", temporary);
+  if (::fchmod(fd, mode) != 0 || !write_all(fd, contents)) {
+    auto error = system_error("write", temporary);
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    return std::move(error);
+  }
+  if (::close(fd) != 0) {
+    auto error = system_error("write", temporary);
+    ::unlink(temporary.c_str());
+    return std::move(error);
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    auto error = system_error("replace", path);
+    ::unlink(temporary.c_str());
+    return std::move(error);
+  }
+  return {};
+}
+
+}  // namespace util
@@ -0,0 +1,45 @@
+#pragma once
+
+/// This file contains a read-only view of a whole file, mapped in memory: the
+/// pages are only read from the disk when they are accessed, and the
+/// replacement of a file that keeps its mappings valid.
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "error/error.h"
+
+namespace util {
+
+class MappedFile {
+ public:
+  /// Map the file, or an error if it can't be opened.
+  static ErrorOr<std::unique_ptr<MappedFile>> open(const std::string& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  const char* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  const std::string& path() const { return path_; }
+
+ private:
+  MappedFile(std::string path, const char* data, std::size_t size)
+      : path_(std::move(path)), data_(data), size_(size) {}
+
+  std::string path_;
+  // Null for an empty file, which can't be mapped.
+  const char* data_;
+  std::size_t size_;
+};
+
+/// Write the contents aside, then rename them over the file: the readers of
+/// the previous file, e.g. the MappedFiles, keep reading it whole, and the
+/// files written at the same time don't interleave. The file keeps its mode,
+/// or is readable by all if it is new.
+MUST_USE_RESULT MaybeError<> replace_file(const std::string& path,
+                                          const std::string& contents);
+
+}  // namespace util
@@ -1,81 +1,182 @@
 #pragma once
 
+#include <memory>
+
 #include "util/variant.h"
 
 struct NoneType {};
 
 static constexpr NoneType none = NoneType();
 
+/// A value of T that an Option<T> can use as none, instead of storing a type
+/// index next to the value. Specialize it, like below, for the types that
+/// have a spare invalid state. An empty Option holds that value: it must be
+/// as cheap to create, copy and destroy as the index, e.g. an Identifier with
+/// an empty name made the type checker 40% slower.
+///
+/// This is for the size of the nodes that hold options, not for speed: a
+/// loop that checks options of which only some are set is slower than with
+/// the index (BM_OptionDereference).
+template <typename T>
+struct OptionNiche {
+  static constexpr bool has_niche = false;
+};
+
+/// An Option of a pointer is none when it holds nullptr.
+template <typename T>
+struct OptionNiche<T*> {
+  static constexpr bool has_niche = true;
+  static T* none_value() { return nullptr; }
+  static bool is_none(T* const& value) { return value == nullptr; }
+};
+
+template <typename T, typename Deleter>
+struct OptionNiche<std::unique_ptr<T, Deleter>> {
+  static constexpr bool has_niche = true;
+  static std::unique_ptr<T, Deleter> none_value() { return nullptr; }
+  static bool is_none(const std::unique_ptr<T, Deleter>& value) {
+    return value == nullptr;
+  }
+};
+
+namespace internals {
+
+/// The value of an Option, or NoneType, with their type index.
+template <typename Value, bool = OptionNiche<Value>::has_niche>
+class OptionStorage {
+ public:
+  OptionStorage() = default;
+  explicit OptionStorage(Value v) : variant_(std::move(v)) {}
+
+  bool is_ok() const noexcept { return variant_.template is<Value>(); }
+
+  const Value& get() const { return variant_.template get<Value>(); }
+  Value& get() { return variant_.template get<Value>(); }
+  const Value& get_unchecked() const {
+    return variant_.template get_unchecked<Value>();
+  }
+  Value consume() { return variant_.template consume<Value>(); }
+
+  void set(Value v) { variant_ = std::move(v); }
+  void reset() { variant_ = none; }
+
+ private:
+  Variant<NoneType, Value> variant_;
+};
+
+/// Only the value, which is the niche of its type when the Option is none.
+template <typename Value>
+class OptionStorage<Value, true> {
+  using Niche = OptionNiche<Value>;
+
+ public:
+  OptionStorage() = default;
+  explicit OptionStorage(Value v) : value_(std::move(v)) {}
+
+  bool is_ok() const noexcept { return !Niche::is_none(value_); }
+
+  const Value& get() const {
+    if (ERROR_UNLIKELY(!is_ok())) throw_bad_access();
+    return value_;
+  }
+  Value& get() {
+    if (ERROR_UNLIKELY(!is_ok())) throw_bad_access();
+    return value_;
+  }
+  const Value& get_unchecked() const { return value_; }
+  Value consume() {
+    Value result = std::move(get());
+    reset();
+    return result;
+  }
+
+  void set(Value v) { value_ = std::move(v); }
+  void reset() { value_ = Niche::none_value(); }
+
+ private:
+  [[noreturn]] ERROR_COLD static void throw_bad_access();
+
+  Value value_ = Niche::none_value();
+};
+
+/// Out of line: building the message would otherwise be inlined in every
+/// get(), around the one comparison of the hot path.
+template <typename Value>
+void OptionStorage<Value, true>::throw_bad_access() {
+  throw BadVariantAccess(std::string("in get<") + type_name<Value>() + ">()");
+}
+
+}  // namespace internals
+
 template <typename Value>
 class Option {
   static_assert(!std::is_reference<Value>::value,
                 "Option doesn't support references");
 
-  Variant<NoneType, Value> variant_;
+  internals::OptionStorage<Value> storage_;
 
  public:
   Option() = default;
 
   Option(const NoneType& /*unused*/) : Option() {}  // NOLINT
 
-  // We need the explicit version otherwise the compiler generates a copy
-  // constructor.
-  Option(Option&& rhs) : variant_(std::move(rhs.variant_)){};  // NOLINT
+  // Defaulted, so that Option of a trivially copyable type is trivially
+  // copyable.
+  Option(Option&& rhs) = default;
   template <typename T, typename = typename std::is_convertible<T, Value>>
-  Option(Option<T>&& rhs) : variant_(std::move(rhs.variant_)) {}  // NOLINT
+  Option(Option<T>&& rhs) {  // NOLINT
+    if (rhs.is_ok()) storage_.set(Value(std::move(rhs.value_or_die())));
+  }
 
-  // We need the explicit version otherwise the compiler generates a move
-  // constructor.
-  Option(const Option& rhs) : variant_(rhs.variant_){};  // NOLINT
+  Option(const Option& rhs) = default;
   template <typename T, typename = typename std::is_convertible<T, Value>>
-  Option(const Option<T>& rhs) : variant_(rhs.variant_) {}  // NOLINT
+  Option(const Option<T>& rhs) {  // NOLINT
+    if (rhs.is_ok()) storage_.set(Value(rhs.value_or_die()));
+  }
 
-  Option(Value v) : variant_(std::move(v)) {}  // NOLINT
+  Option(Value v) : storage_(std::move(v)) {}  // NOLINT
 
-  bool is_ok() const noexcept { return variant_.template is<Value>(); }
+  bool is_ok() const noexcept { return storage_.is_ok(); }
 
-  const Value& value_or_die() const { return variant_.template get<Value>(); }
-  Value& value_or_die() { return variant_.template get<Value>(); }
-  Value consume_value_or_die() { return variant_.template consume<Value>(); }
+  const Value& value_or_die() const { return storage_.get(); }
+  Value& value_or_die() { return storage_.get(); }
+  Value consume_value_or_die() { return storage_.consume(); }
 
   const Value& value_or(const Value& default_value) {
-    if (is_ok()) return variant_.template get_unchecked<Value>();
+    if (is_ok()) return storage_.get_unchecked();
     return default_value;
   }
 
   template <typename T, typename = typename std::is_convertible<T, Value>>
   Option& operator=(T v) {
-    variant_ = Value(std::move(v));
+    storage_.set(Value(std::move(v)));
     return *this;
   }
 
-  // Need the explicit version.
-  Option& operator=(Option&& rhs) { return operator=<Value>(std::move(rhs)); }
+  Option& operator=(Option&& rhs) = default;
 
   template <typename T, typename = typename std::is_convertible<T, Value>>
   Option& operator=(Option<T>&& rhs) {
-    if (this != &rhs) {
-      variant_ = std::move(rhs.variant_);
-    }
+    if (rhs.is_ok())
+      storage_.set(Value(std::move(rhs.value_or_die())));
+    else
+      storage_.reset();
     return *this;
   }
 
-  // Need the explicit version.
-  Option& operator=(const Option& rhs) { return operator=<Value>(rhs); }
+  Option& operator=(const Option& rhs) = default;
 
   Option& operator=(const NoneType& /*unused*/) {
-    variant_ = none;
+    storage_.reset();
     return *this;
   }
 
   template <typename T, typename = typename std::is_convertible<T, Value>>
   Option& operator=(const Option<T>& rhs) {
-    if (this != &rhs) {
-      variant_ = rhs.variant_;
-    }
+    if (rhs.is_ok())
+      storage_.set(Value(rhs.value_or_die()));
+    else
+      storage_.reset();
     return *this;
   }
-
-  template <typename T>
-  friend class Option;
 };
@@ -0,0 +1,179 @@
+#include "util/time_report.h"
+
+#include <time.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+// Count the allocations by replacing the global operator new. Each thread
+// counts its own, like the phases of a TimeReport: the compilations of
+// --jobs don't share a cache line on every allocation, nor see the
+// allocations of each other in their reports.
+
+namespace {
+thread_local std::uint64_t t_allocation_count = 0;
+thread_local std::uint64_t t_allocated_bytes = 0;
+
+void* counted_malloc(std::size_t size) noexcept {
+  ++t_allocation_count;
+  t_allocated_bytes += size;
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_new(std::size_t size) {
+  void* ptr = counted_malloc(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+}  // namespace
+
+// LCOV_EXCL_START: called depending on the standard library.
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void* operator new(std::size_t size,
+                   const std::nothrow_t& /*unused*/) noexcept {
+  return counted_malloc(size);
+}
+void* operator new[](std::size_t size,
+                     const std::nothrow_t& /*unused*/) noexcept {
+  return counted_malloc(size);
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t& /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t& /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t /*unused*/) noexcept {
+  std::free(ptr);
+}
+// LCOV_EXCL_STOP
+
+namespace util {
+
+std::uint64_t allocation_count() { return t_allocation_count; }
+
+std::uint64_t allocated_bytes() { return t_allocated_bytes; }
+
+PhaseStats& PhaseStats::operator+=(const PhaseStats& other) {
+  wall_seconds += other.wall_seconds;
+  cpu_seconds += other.cpu_seconds;
+  allocations += other.allocations;
+  allocated_bytes += other.allocated_bytes;
+  return *this;
+}
+
+thread_local TimeReport* TimeReport::active_ = nullptr;
+
+TimeReport::Sample TimeReport::Sample::now() {
+  // The CPU time of the calling thread: std::clock() is the one of the whole
+  // process, which charges a phase with the work of the other threads.
+  timespec cpu_time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time);
+  return {std::chrono::steady_clock::now(),
+          cpu_time.tv_sec + cpu_time.tv_nsec / 1e9, allocation_count(),
+          util::allocated_bytes()};
+}
+
+void TimeReport::charge(const OpenPhase& phase, const Sample& now) {
+  PhaseStats& stats = phases_[phase.index].stats;
+  stats.wall_seconds +=
+      std::chrono::duration<double>(now.wall - phase.start.wall).count();
+  stats.cpu_seconds += now.cpu_seconds - phase.start.cpu_seconds;
+  stats.allocations += now.allocations - phase.start.allocations;
+  stats.allocated_bytes += now.allocated_bytes - phase.start.allocated_bytes;
+}
+
+std::size_t TimeReport::find_or_add(const std::string& name) {
+  for (std::size_t i = 0; i < phases_.size(); ++i) {
+    if (phases_[i].name == name) return i;
+  }
+  phases_.push_back({name, PhaseStats()});
+  return phases_.size() - 1;
+}
+
+void TimeReport::begin_phase(const char* name) {
+  std::size_t index = find_or_add(name);
+  Sample now = Sample::now();
+  // Pause the enclosing phase.
+  if (!open_phases_.empty()) charge(open_phases_.back(), now);
+  // Sample again, to not count the bookkeeping.
+  open_phases_.push_back({index, Sample::now()});
+}
+
+void TimeReport::end_phase() {
+  assert(!open_phases_.empty() && "end_phase() without begin_phase()");
+  charge(open_phases_.back(), Sample::now());
+  open_phases_.pop_back();
+  // Resume the enclosing phase.
+  if (!open_phases_.empty()) open_phases_.back().start = Sample::now();
+}
+
+void TimeReport::merge(const TimeReport& other) {
+  for (const auto& phase : other.phases_) {
+    phases_[find_or_add(phase.name)].stats += phase.stats;
+  }
+}
+
+namespace {
+
+std::string format_bytes(std::uint64_t bytes) {
+  static const char* const units[] = {"B", "KiB", "MiB", "GiB"};
+  double value = bytes;
+  std::size_t unit = 0;
+  while (value >= 1024 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+    value /= 1024;
+    ++unit;
+  }
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << ' '
+     << units[unit];
+  return ss.str();
+}
+
+void print_time(std::ostream& out, double seconds, double total) {
+  double percent = total > 0 ? 100 * seconds / total : 0;
+  out << std::setw(10) << seconds << " (" << std::setprecision(1)
+      << std::setw(5) << percent << "%)" << std::setprecision(4);
+}
+
+void print_row(std::ostream& out, const PhaseStats& stats,
+               const PhaseStats& total, const std::string& name) {
+  print_time(out, stats.cpu_seconds, total.cpu_seconds);
+  print_time(out, stats.wall_seconds, total.wall_seconds);
+  out << std::setw(12) << stats.allocations << std::setw(13)
+      << format_bytes(stats.allocated_bytes) << "  " << name << '\n';
+}
+
+}  // namespace
+
+void TimeReport::print(std::ostream& out) const {
+  PhaseStats total;
+  for (const auto& phase : phases_) total += phase.stats;
+
+  const std::string rule = "===" + std::string(72, '-') + "===\n";
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(4);
+  ss << rule << "  Time report: " << title_ << '\n'
+     << rule << "  Total execution time: " << total.cpu_seconds
+     << " seconds CPU (" << total.wall_seconds << " seconds wall clock), "
+     << total.allocations << " allocations ("
+     << format_bytes(total.allocated_bytes) << ")\n\n"
+     << "    ---CPU Time---     ---Wall Time---  ---Allocs---  ---Bytes---"
+        "  --- Name ---\n";
+  for (const auto& phase : phases_) {
+    print_row(ss, phase.stats, total, phase.name);
+  }
+  print_row(ss, total, total, "Total");
+  out << ss.str() << '\n';
+}
+
+}  // namespace util
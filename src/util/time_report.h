@@ -0,0 +1,126 @@
+#pragma once
+
+/// This file contains the utilities to measure the resources used by each
+/// phase of the compilation, for --time_report.
+///
+/// Example:
+/// util::TimeReport report("foo.gh");
+/// {
+///   util::ScopedPhase phase(&report, "Parsing");
+///   parse();
+/// }
+/// report.print(std::cerr);
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "util/trace.h"
+
+namespace util {
+
+/// Number of allocations done with operator new by the calling thread since
+/// its start, and their total size.
+std::uint64_t allocation_count();
+std::uint64_t allocated_bytes();
+
+/// Resources used by a phase.
+struct PhaseStats {
+  double wall_seconds = 0;
+  double cpu_seconds = 0;
+  std::uint64_t allocations = 0;
+  std::uint64_t allocated_bytes = 0;
+
+  PhaseStats& operator+=(const PhaseStats& other);
+};
+
+/// Accumulates the resources used by each phase, and prints them as a table
+/// (like clang's -ftime-report). The phases are kept in the order in which
+/// they were first seen.
+///
+/// Phases can be nested: the resources used by the inner phase are not
+/// counted in the outer one.
+class TimeReport {
+ public:
+  explicit TimeReport(std::string title) : title_(std::move(title)) {}
+
+  /// Start or resume the phase with this name. Prefer using ScopedPhase.
+  void begin_phase(const char* name);
+  /// End the innermost phase.
+  void end_phase();
+
+  /// Add the phases of the other report to this one.
+  void merge(const TimeReport& other);
+
+  /// Print the table of the phases, and their total.
+  void print(std::ostream& out) const;
+
+  const std::string& title() const { return title_; }
+
+  /// The report in which phases that don't have access to one are recorded,
+  /// e.g. the lexing inside the parser. Null when not timing. Each thread has
+  /// its own.
+  static TimeReport* active() { return active_; }
+  static void set_active(TimeReport* report) { active_ = report; }
+
+ private:
+  struct Sample {
+    std::chrono::steady_clock::time_point wall;
+    double cpu_seconds;
+    std::uint64_t allocations;
+    std::uint64_t allocated_bytes;
+
+    static Sample now();
+  };
+
+  struct Phase {
+    std::string name;
+    PhaseStats stats;
+  };
+
+  struct OpenPhase {
+    std::size_t index;
+    Sample start;
+  };
+
+  // Add the resources used since the start of the phase to its stats.
+  void charge(const OpenPhase& phase, const Sample& now);
+  std::size_t find_or_add(const std::string& name);
+
+  std::string title_;
+  std::vector<Phase> phases_;
+  // Stack of the phases currently running; only the innermost one is charged.
+  std::vector<OpenPhase> open_phases_;
+
+  static thread_local TimeReport* active_;
+};
+
+/// RAII phase, also recorded as a trace event (see util::TraceScope). Does
+/// nothing if the report is null and there is no active Tracer, so it can be
+/// left in the code at (almost) no cost.
+class ScopedPhase {
+ public:
+  ScopedPhase(TimeReport* report, const char* name)
+      : trace_("phase", name), report_(report) {
+    if (report_ != nullptr) report_->begin_phase(name);
+  }
+
+  /// Record the phase in the active TimeReport, if any.
+  explicit ScopedPhase(const char* name)
+      : ScopedPhase(TimeReport::active(), name) {}
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+  ~ScopedPhase() {
+    if (report_ != nullptr) report_->end_phase();
+  }
+
+ private:
+  TraceScope trace_;
+  TimeReport* report_;
+};
+
+}  // namespace util
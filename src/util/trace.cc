@@ -0,0 +1,96 @@
+#include "util/trace.h"
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+namespace util {
+
+Tracer* Tracer::active_ = nullptr;
+
+int Tracer::current_thread_id() {
+  static std::atomic<int> next_id{1};
+  thread_local int id = next_id.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+double Tracer::since_start_us(TimePoint time) const {
+  return std::chrono::duration<double, std::micro>(time - start_).count();
+}
+
+void Tracer::add_event(const char* category, std::string name,
+                       TimePoint start) {
+  const double start_us = since_start_us(start);
+  const double end_us = since_start_us(std::chrono::steady_clock::now());
+  Event event{category, std::move(name), current_thread_id(), start_us,
+              end_us - start_us};
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.emplace_back(std::move(event));
+}
+
+void Tracer::set_thread_name(std::string name) {
+  int thread_id = current_thread_id();
+  std::lock_guard<std::mutex> lock(mutex_);
+  thread_names_.emplace_back(thread_id, std::move(name));
+}
+
+namespace {
+
+// Quote and escape a string for JSON.
+std::string json_string(const std::string& str) {
+  std::stringstream ss;
+  ss << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      case '\n':
+        ss << "\\n";
+        break;
+      case '\t':
+        ss << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          ss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+          ss << c;
+        }
+    }
+  }
+  ss << '"';
+  return ss.str();
+}
+
+}  // namespace
+
+void Tracer::write(std::ostream& out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  ss << R"({"name":"process_name","ph":"M","pid":1,"tid":0,)"
+     << R"("args":{"name":"gracc"}})";
+  for (const auto& thread_name : thread_names_) {
+    ss << ",\n"
+       << R"({"name":"thread_name","ph":"M","pid":1,"tid":)"
+       << thread_name.first << R"(,"args":{"name":)"
+       << json_string(thread_name.second) << "}}";
+  }
+  for (const auto& event : events_) {
+    ss << ",\n"
+       << R"({"name":)" << json_string(event.name) << R"(,"cat":)"
+       << json_string(event.category) << R"(,"ph":"X","ts":)"
+       << event.start_us << R"(,"dur":)" << event.duration_us
+       << R"(,"pid":1,"tid":)" << event.thread_id << "}";
+  }
+  ss << "\n]}\n";
+  out << ss.str();
+}
+
+}  // namespace util
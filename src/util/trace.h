@@ -0,0 +1,108 @@
+#pragma once
+
+/// This file contains the utilities to record a trace of the compilation, for
+/// --trace_out. The trace is in the Chrome trace event format, which can be
+/// loaded in chrome://tracing or Perfetto.
+///
+/// Example:
+/// util::Tracer tracer;
+/// util::Tracer::set_active(&tracer);
+/// {
+///   util::TraceScope scope("phase", "Parsing");
+///   parse();
+/// }
+/// tracer.write(out);
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace util {
+
+/// Collects the trace events. Events can be added from any thread, each
+/// thread is shown as a separate track.
+class Tracer {
+ public:
+  Tracer() : start_(std::chrono::steady_clock::now()) {}
+
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  /// Record an event that started at `start` and ends now, on the current
+  /// thread.
+  void add_event(const char* category, std::string name, TimePoint start);
+
+  /// Name the track of the current thread.
+  void set_thread_name(std::string name);
+
+  /// Write all the events as JSON.
+  void write(std::ostream& out) const;
+
+  /// The tracer in which the TraceScopes are recorded. Null when not
+  /// tracing.
+  static Tracer* active() { return active_; }
+  static void set_active(Tracer* tracer) { active_ = tracer; }
+
+  /// Small identifier of the current thread, stable for its lifetime.
+  static int current_thread_id();
+
+ private:
+  struct Event {
+    std::string category;
+    std::string name;
+    int thread_id;
+    double start_us;
+    double duration_us;
+  };
+
+  double since_start_us(TimePoint time) const;
+
+  const TimePoint start_;
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  std::vector<std::pair<int, std::string>> thread_names_;
+
+  static Tracer* active_;
+};
+
+/// RAII trace event, recorded in the active Tracer. Does nothing if there is
+/// none: in that case the name is not even copied.
+class TraceScope {
+ public:
+  TraceScope(const char* category, const char* name)
+      : tracer_(Tracer::active()) {
+    if (tracer_ != nullptr) start(category, name);
+  }
+
+  TraceScope(const char* category, const std::string& name)
+      : tracer_(Tracer::active()) {
+    if (tracer_ != nullptr) start(category, name);
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  /// Rename the event, when the name is only known at the end.
+  void set_name(const std::string& name) {
+    if (tracer_ != nullptr) name_ = name;
+  }
+
+  ~TraceScope() {
+    if (tracer_ != nullptr) tracer_->add_event(category_, name_, start_);
+  }
+
+ private:
+  void start(const char* category, std::string name) {
+    category_ = category;
+    name_ = std::move(name);
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  Tracer* tracer_;
+  const char* category_ = nullptr;
+  std::string name_;
+  Tracer::TimePoint start_;
+};
+
+}  // namespace util
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <boost/type_index.hpp>
 #include <cassert>
 #include <cstddef>  // size_t
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <new>        // operator new
@@ -13,6 +13,21 @@
 #include <typeinfo>
 #include <utility>
 
+/// Branch prediction hint for the error checks: errors are the cold path.
+#if defined(__GNUC__) || defined(__clang__)
+#define ERROR_UNLIKELY(CONDITION) __builtin_expect(!!(CONDITION), 0)
+#else
+#define ERROR_UNLIKELY(CONDITION) (CONDITION)
+#endif
+
+/// Keep a function that reports an error out of the callers, and out of
+/// their hot code.
+#if defined(__GNUC__) || defined(__clang__)
+#define ERROR_COLD __attribute__((cold, noinline))
+#else
+#define ERROR_COLD
+#endif
+
 class BadVariantAccess : public std::logic_error {
  public:
   explicit BadVariantAccess(const std::string& what_arg)
@@ -120,55 +135,256 @@ struct StaticMax<arg1, arg2, others...> {
                                      : StaticMax<arg2, others...>::value;
 };
 
+/// Index type stored in a Variant: a single byte is enough for all the
+/// variants we use, the largest value being reserved for "invalid".
+template <std::size_t num_types>
+using StorageIndex =
+    typename std::conditional<(num_types <
+                               std::numeric_limits<std::uint8_t>::max()),
+                              std::uint8_t, TypeIndex>::type;
+
+/// Name of a type, for diagnostics. Doesn't need RTTI.
+template <typename T>
+std::string type_name() {
+  // Looks like "std::string internals::type_name() [with T = int; ...]" with
+  // GCC, and "std::string internals::type_name() [T = int]" with clang.
+  const std::string name = __PRETTY_FUNCTION__;
+  const auto begin = name.find("T = ");
+  if (begin == std::string::npos) return name;  // LCOV_EXCL_LINE
+  auto end = name.find(';', begin);
+  if (end == std::string::npos) end = name.rfind(']');
+  return name.substr(begin + 4, end - begin - 4);
+}
+
+/// Operations applied to the alternative designated by a type index.
+struct DestroyOp {
+  void* data;
+  template <typename T>
+  void apply() const {
+    static_cast<T*>(data)->~T();
+  }
+};
+
+struct MoveOp {
+  void* old_value;
+  void* new_value;
+  template <typename T>
+  void apply() const {
+    new (new_value) T(std::move(*static_cast<T*>(old_value)));
+  }
+};
+
+struct CopyOp {
+  const void* old_value;
+  void* new_value;
+  template <typename T>
+  void apply() const {
+    new (new_value) T(*static_cast<const T*>(old_value));
+  }
+};
+
+/// Type at a given position in Types, or void if out of range.
+template <std::size_t position, typename... Types>
+struct NthType {
+  using type = void;
+};
+
+template <typename First, typename... Types>
+struct NthType<0, First, Types...> {
+  using type = First;
+};
+
+template <std::size_t position, typename First, typename... Types>
+struct NthType<position, First, Types...> {
+  using type = typename NthType<position - 1, Types...>::type;
+};
+
+template <bool in_range>
+struct ApplyAt {
+  template <typename T, typename Op>
+  static void apply(const Op& op) {
+    op.template apply<T>();
+  }
+};
+
+template <>
+struct ApplyAt<false> {
+  // LCOV_EXCL_START: never called
+  template <typename T, typename Op>
+  static void apply(const Op& /*unused*/) {}
+  // LCOV_EXCL_STOP
+};
+
+/// Applies an operation to the alternative designated by a type index, with a
+/// switch that the compiler turns into a jump table (and that can be inlined).
+/// Variants with more alternatives than the switch has cases go through a
+/// table of function pointers instead.
+///
+/// The type indices are reversed (the last type has index 0), and an
+/// invalid index is a no-op.
 template <typename... Types>
-struct VariantHelper;
+struct VariantDispatch {
+  static constexpr std::size_t num_types = sizeof...(Types);
+  static constexpr std::size_t num_cases = 8;
 
-template <typename T, typename... Types>
-struct VariantHelper<T, Types...> {
-  static void destroy(const TypeIndex type_index_, void* data_) {
-    if (type_index_ == sizeof...(Types)) {
-      reinterpret_cast<T*>(data_)->~T();  // NOLINT
-    } else {
-      VariantHelper<Types...>::destroy(type_index_, data_);
-    }
+  static void destroy(const TypeIndex type_index, void* data) {
+    visit(type_index, DestroyOp{data});
   }
 
   static void move(const TypeIndex old_type_index, void* old_value,
                    void* new_value) {
-    if (old_type_index == sizeof...(Types)) {
-      new (new_value) T(std::move(*reinterpret_cast<T*>(old_value)));  // NOLINT
-    } else {
-      VariantHelper<Types...>::move(old_type_index, old_value, new_value);
-    }
+    visit(old_type_index, MoveOp{old_value, new_value});
   }
 
   static void copy(const TypeIndex old_type_index, const void* old_value,
                    void* new_value) {
-    if (old_type_index == sizeof...(Types)) {
-      new (new_value) T(*reinterpret_cast<const T*>(old_value));  // NOLINT
-    } else {
-      VariantHelper<Types...>::copy(old_type_index, old_value, new_value);
+    visit(old_type_index, CopyOp{old_value, new_value});
+  }
+
+ private:
+  template <std::size_t position, typename Op>
+  static void apply_at(const Op& op) {
+    ApplyAt<(position < num_types)>::template apply<
+        typename NthType<position, Types...>::type>(op);
+  }
+
+  template <typename T, typename Op>
+  static void apply_to(const Op& op) {
+    op.template apply<T>();
+  }
+
+  template <typename Op>
+  static void visit(const TypeIndex type_index, const Op& op) {
+    if (type_index >= num_types) return;
+    const std::size_t position = num_types - 1 - type_index;
+    switch (position) {
+      case 0:
+        return apply_at<0>(op);
+      case 1:
+        return apply_at<1>(op);
+      case 2:
+        return apply_at<2>(op);
+      case 3:
+        return apply_at<3>(op);
+      case 4:
+        return apply_at<4>(op);
+      case 5:
+        return apply_at<5>(op);
+      case 6:
+        return apply_at<6>(op);
+      case 7:
+        return apply_at<7>(op);
+      default:
+        if (num_types > num_cases) {
+          static constexpr void (*const table[])(const Op&) = {
+              &apply_to<Types, Op>...};
+          table[position](op);
+        }
     }
   }
 };
 
-template <>
-struct VariantHelper<> {
-  // LCOV_EXCL_START: never called
-  static void destroy(const TypeIndex /*unused*/, void* /*unused*/) {}
-  static void move(const TypeIndex /*unused*/, void* /*unused*/,
-                   void* /*unused*/) {}
-  static void copy(const TypeIndex /*unused*/, const void* /*unused*/,
-                   void* /*unused*/) {}
-  // LCOV_EXCL_STOP
+/// Raw storage of a Variant: the type index and the aligned buffer.
+template <typename... Types>
+struct VariantData {
+  using Index = StorageIndex<sizeof...(Types)>;
+  static constexpr Index invalid_index = std::numeric_limits<Index>::max();
+  static constexpr std::size_t data_size = StaticMax<sizeof(Types)...>::value;
+  static constexpr std::size_t data_align =
+      StaticMax<alignof(Types)...>::value;
+  using DataType = typename std::aligned_storage<data_size, data_align>::type;
+
+  VariantData() noexcept : type_index_(invalid_index) {}
+
+  Index type_index_;
+  DataType data_;
+};
+
+/// Storage with a trivial destructor when all the alternatives have one.
+template <bool trivially_destructible, typename... Types>
+struct VariantStorage : VariantData<Types...> {
+  void destroy() noexcept {}
+};
+
+template <typename... Types>
+struct VariantStorage<false, Types...> : VariantData<Types...> {
+  VariantStorage() = default;
+  VariantStorage(const VariantStorage&) = default;
+  VariantStorage(VariantStorage&&) noexcept = default;
+  VariantStorage& operator=(const VariantStorage&) = default;
+  VariantStorage& operator=(VariantStorage&&) noexcept = default;
+  ~VariantStorage() noexcept { destroy(); }
+
+  void destroy() noexcept {
+    VariantDispatch<Types...>::destroy(this->type_index_, &this->data_);
+  }
+};
+
+template <typename... Types>
+using VariantStorageFor = VariantStorage<
+    Conjunction<std::is_trivially_destructible<Types>...>::value, Types...>;
+
+/// Copy and move operations: plain memberwise copies when all the
+/// alternatives are trivially copyable, dispatched on the type index
+/// otherwise.
+template <bool trivially_copyable, typename... Types>
+struct VariantCopyBase : VariantStorageFor<Types...> {};
+
+template <typename... Types>
+struct VariantCopyBase<false, Types...> : VariantStorageFor<Types...> {
+  using Dispatch = VariantDispatch<Types...>;
+  using Base = VariantStorageFor<Types...>;
+
+  VariantCopyBase() = default;
+
+  VariantCopyBase(const VariantCopyBase& old) : Base() {
+    Dispatch::copy(old.type_index_, &old.data_, &this->data_);
+    this->type_index_ = old.type_index_;
+  }
+
+  VariantCopyBase(VariantCopyBase&& old) noexcept(
+      Conjunction<std::is_nothrow_move_constructible<Types>...>::value)
+      : Base() {
+    Dispatch::move(old.type_index_, &old.data_, &this->data_);
+    this->type_index_ = old.type_index_;
+  }
+
+  VariantCopyBase& operator=(const VariantCopyBase& rhs) {
+    if (this == &rhs) return *this;
+    this->destroy();
+    this->type_index_ = this->invalid_index;
+    Dispatch::copy(rhs.type_index_, &rhs.data_, &this->data_);
+    this->type_index_ = rhs.type_index_;
+    return *this;
+  }
+
+  VariantCopyBase& operator=(VariantCopyBase&& rhs) noexcept {
+    if (this == &rhs) return *this;
+    this->destroy();
+    this->type_index_ = this->invalid_index;
+    Dispatch::move(rhs.type_index_, &rhs.data_, &this->data_);
+    this->type_index_ = rhs.type_index_;
+    return *this;
+  }
+
+  ~VariantCopyBase() = default;
 };
 
+template <typename... Types>
+using VariantBase = VariantCopyBase<
+    Conjunction<std::is_trivially_copyable<Types>...>::value, Types...>;
+
 }  // namespace internals
 
 struct NoInit {};
 
+/// Tagged union of Types.
+///
+/// The type index is a single byte for up to 254 alternatives. Copy, move
+/// and destruction go through jump tables, and are trivial when all the
+/// alternatives are trivial.
 template <typename... Types>
-class Variant {
+class Variant : private internals::VariantBase<Types...> {
   static_assert(sizeof...(Types) > 0,
                 "Template parameter type list of Variant can not be empty.");
   static_assert(!internals::Disjunction<std::is_reference<Types>...>::value,
@@ -180,30 +396,28 @@ class Variant {
       sizeof...(Types) < std::numeric_limits<internals::TypeIndex>::max(),
       "Internal index type must be able to accommodate all alternatives.");
 
- private:
-  static constexpr std::size_t data_size =
-      internals::StaticMax<sizeof(Types)...>::value;
-  static constexpr std::size_t data_align =
-      internals::StaticMax<alignof(Types)...>::value;
-
  public:
   using TypesTuple = std::tuple<Types...>;
 
  private:
   using FirstType = typename std::tuple_element<0, TypesTuple>::type;
-  using DataType = typename std::aligned_storage<data_size, data_align>::type;
-  using HelperType = internals::VariantHelper<Types...>;
+  using Base = internals::VariantBase<Types...>;
+  using Dispatch = internals::VariantDispatch<Types...>;
+  using Base::destroy;
+  using Base::invalid_index;
+  using Base::type_index_;
+  using Base::data_;
 
  public:
-  Variant() noexcept(std::is_nothrow_default_constructible<FirstType>::value)
-      : type_index_(sizeof...(Types)-1) {
+  Variant() noexcept(std::is_nothrow_default_constructible<FirstType>::value) {
     static_assert(std::is_default_constructible<FirstType>::value,
                   "First type in Variant must be default constructible to "
                   "allow default construction of Variant.");
     new (&data_) FirstType();
+    type_index_ = sizeof...(Types)-1;
   }
 
-  Variant(NoInit) noexcept : type_index_(internals::invalid_value) {}  // NOLINT
+  Variant(NoInit) noexcept {}  // NOLINT
 
   template <typename T, typename Traits = internals::ValueTraits<T, Types...>,
             typename Enable = typename std::enable_if<
@@ -212,43 +426,31 @@ class Variant {
                               typename Traits::ValueType>::value>::type>
   Variant(T&& val)  // NOLINT
       noexcept(std::is_nothrow_constructible<typename Traits::TargetType,
-                                             T&&>::value)
-      : type_index_(Traits::index) {
+                                             T&&>::value) {
     new (&data_) typename Traits::TargetType(std::forward<T>(val));
+    type_index_ = Traits::index;
   }
 
-  // We need the explicit version otherwise the compiler generates a copy
-  // constructor.
-  Variant(const Variant& old)  // NOLINT
-      : type_index_(old.type_index_) {
-    HelperType::copy(old.type_index_, &old.data_, &data_);
-  }
+  Variant(const Variant& old) = default;
 
   template <typename... Ts,
             typename = typename std::enable_if<internals::Disjunction<
                 std::is_constructible<Ts>...>::value>::type>
-  Variant(const Variant<Ts...>& old)  // NOLINT
-      : type_index_(old.type_index_) {
-    HelperType::copy(old.type_index_, &old.data_, &data_);
+  Variant(const Variant<Ts...>& old) {  // NOLINT
+    Dispatch::copy(old.type_index_, &old.data_, &data_);
+    type_index_ = old.type_index_;
   }
 
-  // We need the explicit version otherwise the compiler generates a move
-  // constructor.
-  Variant(Variant&& old)  // NOLINT
-      noexcept(internals::Conjunction<
-               std::is_nothrow_move_constructible<Types>...>::value)
-      : type_index_(old.type_index_) {
-    HelperType::move(old.type_index_, &old.data_, &data_);
-  }
+  Variant(Variant&& old) = default;
 
   template <typename... Ts,
             typename = typename std::enable_if<internals::Disjunction<
                 std::is_convertible<Ts, Types>...>::value>::type>
   Variant(Variant<Ts...>&& old)  // NOLINT
       noexcept(internals::Conjunction<
-               std::is_nothrow_move_constructible<Types>...>::value)
-      : type_index_(old.type_index_) {
-    HelperType::move(old.type_index_, &old.data_, &data_);
+               std::is_nothrow_move_constructible<Types>...>::value) {
+    Dispatch::move(old.type_index_, &old.data_, &data_);
+    type_index_ = old.type_index_;
   }
 
  private:
@@ -256,29 +458,26 @@ class Variant {
             typename = typename std::enable_if<internals::Disjunction<
                 std::is_constructible<Ts>...>::value>::type>
   void copy_assign(const Variant<Ts...>& rhs) {
-    HelperType::destroy(type_index_, &data_);
-    type_index_ = internals::invalid_value;
-    HelperType::copy(rhs.type_index_, &rhs.data_, &data_);
+    destroy();
+    type_index_ = invalid_index;
+    Dispatch::copy(rhs.type_index_, &rhs.data_, &data_);
     type_index_ = rhs.type_index_;
   }
 
   void move_assign(Variant&& rhs) {
-    HelperType::destroy(type_index_, &data_);
-    type_index_ = internals::invalid_value;
-    HelperType::move(rhs.type_index_, &rhs.data_, &data_);
+    destroy();
+    type_index_ = invalid_index;
+    Dispatch::move(rhs.type_index_, &rhs.data_, &data_);
     type_index_ = rhs.type_index_;
   }
 
   template <typename T>
   std::string type_name() const {
-    return boost::typeindex::type_id<T>().pretty_name();
+    return internals::type_name<T>();
   }
 
  public:
-  // Need the explicit version.
-  Variant& operator=(Variant&& other) noexcept {
-    return operator=<Types...>(std::move(other));
-  }
+  Variant& operator=(Variant&& other) = default;
 
   template <typename... Ts,
             typename = typename std::enable_if<internals::Disjunction<
@@ -288,10 +487,7 @@ class Variant {
     return *this;
   }
 
-  // Need the explicit version.
-  Variant& operator=(const Variant& other) noexcept {
-    return operator=<Types...>(other);
-  }
+  Variant& operator=(const Variant& other) = default;
 
   template <typename... Ts,
             typename = typename std::enable_if<internals::Disjunction<
@@ -325,12 +521,12 @@ class Variant {
     return type_index_ == internals::DirectType<T, Types...>::index;
   }
 
-  bool valid() const { return type_index_ != internals::invalid_value; }
+  bool valid() const { return type_index_ != invalid_index; }
 
   template <typename T, typename... Args>
   void set(Args&&... args) {
-    HelperType::destroy(type_index_, &data_);
-    type_index_ = internals::invalid_value;
+    destroy();
+    type_index_ = invalid_index;
     new (&data_) T(std::forward<Args>(args)...);
     type_index_ = internals::DirectType<T, Types...>::index;
   }
@@ -384,8 +580,8 @@ class Variant {
                              internals::invalid_value)>::type* = nullptr>
   T consume_unchecked() {
     T res = std::move(*reinterpret_cast<T*>(&data_));  // NOLINT
-    HelperType::destroy(type_index_, &data_);
-    type_index_ = internals::invalid_value;
+    destroy();
+    type_index_ = invalid_index;
     return std::move(res);
   }
 
@@ -454,8 +650,8 @@ class Variant {
     auto res = std::move(
         (*reinterpret_cast<std::reference_wrapper<T>*>(&data_))  // NOLINT
             .get());
-    HelperType::destroy(type_index_, &data_);
-    type_index_ = internals::invalid_value;
+    destroy();
+    type_index_ = invalid_index;
     return std::move(res);
   }
 
@@ -471,15 +667,7 @@ class Variant {
         sizeof...(Types)-internals::DirectType<T, Types...>::index - 1);
   }
 
-  ~Variant() noexcept  // no-throw destructor
-  {
-    HelperType::destroy(type_index_, &data_);
-  }
-
  private:
-  internals::TypeIndex type_index_;
-  DataType data_;
-
   template <typename... Ts>
   friend class Variant;
 };
@@ -18,6 +18,7 @@ class VisitorError : public GenericError {
   }
 
   const lexer::Range& location() { return range_; }
+  const lexer::Range* range() const override { return &range_; }
 
  private:
   lexer::Range range_;
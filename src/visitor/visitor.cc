@@ -1,13 +1,22 @@
 #include "visitor/visitor.h"
 
+#include "ast/array_access.h"
+#include "ast/array_literal.h"
+#include "ast/assignment.h"
 #include "ast/binary_operation.h"
 #include "ast/block_statement.h"
+#include "ast/for_block.h"
+#include "ast/function_call.h"
 #include "ast/function_declaration.h"
 #include "ast/if_statement.h"
+#include "ast/import_statement.h"
 #include "ast/local_variable_declaration.h"
+#include "ast/loop_control_statement.h"
 #include "ast/module.h"
 #include "ast/return_statement.h"
 #include "ast/value_statement.h"
+#include "ast/while_block.h"
+#include "util/trace.h"
 
 namespace ast {
 
@@ -15,15 +24,49 @@ namespace ast {
 // type. If the type is changed to an abstract one, it will fail to compile, so
 // we are safe.
 
-void ASTVisitor::visit(Assignment* /*unused*/) {}
+void ASTVisitor::visit(ArrayIndex* node) {
+  node->base()->accept(*this);
+  node->index()->accept(*this);
+}
+void ASTVisitor::visit(ArrayLength* node) { node->base()->accept(*this); }
+void ASTVisitor::visit(ArrayLiteral* node) {
+  for (const auto& element : node->elements()) {
+    element->accept(*this);
+  }
+}
+void ASTVisitor::visit(ArraySlice* node) {
+  node->base()->accept(*this);
+  if (node->begin().is_ok()) node->begin().value_or_die()->accept(*this);
+  if (node->end().is_ok()) node->end().value_or_die()->accept(*this);
+}
+void ASTVisitor::visit(ArrayType* /*unused*/) {}
+void ASTVisitor::visit(Assignment* node) {
+  visit(&node->target());
+  if (node->index().is_ok()) node->index().value_or_die()->accept(*this);
+  node->value()->accept(*this);
+}
 void ASTVisitor::visit(BooleanConstant* /*unused*/) {}
 void ASTVisitor::visit(BinaryOp* node) {
   node->left_value().accept(*this);
   node->right_value().accept(*this);
 }
+void ASTVisitor::visit(BreakStatement* /*unused*/) {}
 void ASTVisitor::visit(BuiltinType* /*unused*/) {}
+void ASTVisitor::visit(ContinueStatement* /*unused*/) {}
+void ASTVisitor::visit(ForBlock* node) {
+  // The bounds are evaluated before the variable is declared.
+  node->begin()->accept(*this);
+  node->end()->accept(*this);
+  visit(node->variable());
+  visit(node->body().get());
+}
 void ASTVisitor::visit(FunctionArgumentDeclaration* /*unused*/) {}
-void ASTVisitor::visit(FunctionCall* /*unused*/) {}
+void ASTVisitor::visit(FunctionCall* node) {
+  node->base().accept(*this);
+  for (const auto& argument : node->arguments()) {
+    argument->accept(*this);
+  }
+}
 void ASTVisitor::visit(FunctionDeclaration* node) {
   for (const auto& argument : node->arguments()) {
     visit(argument.get());
@@ -38,14 +81,18 @@ void ASTVisitor::visit(IfStatement* node) {
     visit(node->else_statement().value_or_die().get());
 }
 
+void ASTVisitor::visit(ImportStatement* /*unused*/) {}
 void ASTVisitor::visit(IntConstant* /*unused*/) {}
 void ASTVisitor::visit(Module* node) {
-  for (const auto& declaration : node->top_level_declarations())
+  for (const auto& declaration : node->top_level_declarations()) {
+    util::TraceScope trace("declaration", declaration_name(*declaration));
     declaration->accept(*this);
+  }
 }
 void ASTVisitor::visit(ReturnStatement* node) {
   if (node->value().is_ok()) node->value().value_or_die()->accept(*this);
 }
+void ASTVisitor::visit(SliceType* /*unused*/) {}
 void ASTVisitor::visit(LocalVariableDeclaration* node) {
   if (node->value().is_ok()) node->value().value_or_die()->accept(*this);
 }
@@ -59,4 +106,9 @@ void ASTVisitor::visit(BlockStatement* node) {
 
 void ASTVisitor::visit(ValueStatement* node) { node->value()->accept(*this); }
 
+void ASTVisitor::visit(WhileBlock* node) {
+  node->condition()->accept(*this);
+  visit(node->body().get());
+}
+
 }  // namespace ast
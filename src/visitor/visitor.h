@@ -8,21 +8,32 @@ class IfStatement;
 
 class ASTVisitor {
  public:
+  virtual void visit(ArrayIndex* node);
+  virtual void visit(ArrayLength* node);
+  virtual void visit(ArrayLiteral* node);
+  virtual void visit(ArraySlice* node);
+  virtual void visit(ArrayType* node);
   virtual void visit(Assignment* node);
   virtual void visit(BinaryOp* node);
   virtual void visit(BlockStatement* node);
   virtual void visit(BooleanConstant* node);
+  virtual void visit(BreakStatement* node);
   virtual void visit(BuiltinType* node);
+  virtual void visit(ContinueStatement* node);
+  virtual void visit(ForBlock* node);
   virtual void visit(FunctionArgumentDeclaration* node);
   virtual void visit(FunctionCall* node);
   virtual void visit(FunctionDeclaration* node);
   virtual void visit(IfStatement* node);
+  virtual void visit(ImportStatement* node);
   virtual void visit(IntConstant* node);
   virtual void visit(LocalVariableDeclaration* node);
   virtual void visit(Module* node);
   virtual void visit(ReturnStatement* node);
+  virtual void visit(SliceType* node);
   virtual void visit(ValueStatement* node);
   virtual void visit(VariableReference* node);
+  virtual void visit(WhileBlock* node);
 };
 
 }  // namespace ast
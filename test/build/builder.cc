@@ -0,0 +1,339 @@
+#include "build/builder.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "build/graph.h"
+#include "build/imports.h"
+#include "test_utils/utils.h"
+
+namespace {
+
+/// Compiles the sources to their interface, made of their lines that contain
+/// "public", and fails on the sources that contain "error". The interfaces
+/// are imported from the directory of the source.
+class FakeCompiler : public build::Compiler {
+ public:
+  bool compile(const std::string& source,
+               std::vector<build::ImportRecord>* imports) override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      compiled_.push_back(build::module_name(source));
+    }
+    if (on_compile) on_compile(source);
+    std::ifstream input(source);
+    std::ostringstream interface;
+    std::string line;
+    bool success = true;
+    for (const auto& module : build::scan_imports(source)) {
+      build::ImportRecord import;
+      import.module = module;
+      import.path =
+          source.substr(0, source.rfind('/') + 1) + module + ".gh.ghi";
+      if (access(import.path.c_str(), F_OK) != 0) return false;
+      imports->push_back(import);
+    }
+    while (std::getline(input, line)) {
+      if (line.find("public") != std::string::npos) interface << line << '\n';
+      if (line.find("error") != std::string::npos) success = false;
+    }
+    if (!success) return false;
+    std::ofstream(interface_path(source)) << interface.str();
+    std::ofstream(source + ".ll") << "IR\n";
+    return true;
+  }
+
+  std::string interface_path(const std::string& source) const override {
+    return source + ".ghi";
+  }
+
+  std::vector<std::string> outputs(const std::string& source) const override {
+    return {source + ".ll", interface_path(source)};
+  }
+
+  /// Called with each compiled source, e.g. to change the files meanwhile.
+  std::function<void(const std::string&)> on_compile;
+
+  /// The modules compiled since the last call, sorted.
+  std::vector<std::string> take_compiled() {
+    std::sort(std::begin(compiled_), std::end(compiled_));
+    return std::move(compiled_);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> compiled_;
+};
+
+/// The sources and the database are in a temporary directory.
+class BuilderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/build_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    directory_ = directory;
+    options_.database = directory_ + "/db";
+    options_.configuration = "test";
+    options_.jobs = 4;
+  }
+
+  void TearDown() override {
+    for (const auto& source : sources_) {
+      for (const auto& file : compiler_.outputs(source)) unlink(file.c_str());
+      unlink(source.c_str());
+    }
+    for (const auto& file : interfaces_) unlink(file.c_str());
+    unlink(options_.database.c_str());
+    rmdir(directory_.c_str());
+  }
+
+  /// The interface of a module out of the build.
+  void write_interface(const std::string& module, const std::string& content) {
+    auto path = directory_ + "/" + module + ".gh.ghi";
+    interfaces_.push_back(path);
+    std::ofstream(path) << content;
+  }
+
+  void write(const std::string& module, const std::string& content) {
+    auto path = directory_ + "/" + module + ".gh";
+    if (std::find(std::begin(sources_), std::end(sources_), path) ==
+        std::end(sources_))
+      sources_.push_back(path);
+    std::ofstream(path) << content;
+  }
+
+  build::BuildSummary build() {
+    auto summary = build::run_build(sources_, options_, &compiler_);
+    EXPECT_TRUE(summary.is_ok());
+    return summary.is_ok() ? summary.value_or_die() : build::BuildSummary();
+  }
+
+  /// math <- geometry <- main, and util alone.
+  void write_project() {
+    write("math", "public fun square;\nfun helper;\n");
+    write("geometry", "import math;\npublic fun area;\n");
+    write("main", "import geometry;\nimport math;\nfun main;\n");
+    write("util", "public fun log;\n");
+  }
+
+  std::string directory_;
+  std::vector<std::string> sources_;
+  std::vector<std::string> interfaces_;
+  build::BuildOptions options_;
+  FakeCompiler compiler_;
+};
+
+using Modules = std::vector<std::string>;
+
+TEST_F(BuilderTest, SecondBuildCompilesNothing) {
+  write_project();
+  auto summary = build();
+  EXPECT_EQ(4, summary.compiled);
+  EXPECT_EQ(0, summary.failed);
+  EXPECT_EQ(Modules({"geometry", "main", "math", "util"}),
+            compiler_.take_compiled());
+
+  summary = build();
+  EXPECT_EQ(0, summary.compiled);
+  EXPECT_EQ(4, summary.up_to_date);
+  EXPECT_EQ(Modules(), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, SameContentIsNotCompiled) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  // Touched, with another modification time.
+  write("math", "public fun square;\nfun helper;\n");
+  build();
+  EXPECT_EQ(Modules(), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, SameInterfaceCompilesOnlyTheFile) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  write("math", "public fun square;\nfun other_helper;\n");
+  auto summary = build();
+  EXPECT_EQ(1, summary.compiled);
+  EXPECT_EQ(3, summary.up_to_date);
+  EXPECT_EQ(Modules({"math"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, NewInterfaceCompilesTheDependents) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  write("math", "public fun square;\npublic fun helper;\n");
+  build();
+  EXPECT_EQ(Modules({"geometry", "main", "math"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, MissingOutputIsCompiled) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  unlink((directory_ + "/util.gh.ll").c_str());
+  build();
+  EXPECT_EQ(Modules({"util"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, FailureSkipsTheDependents) {
+  write_project();
+  write("geometry", "import math;\nerror;\n");
+  auto summary = build();
+  EXPECT_EQ(2, summary.compiled);
+  EXPECT_EQ(2, summary.failed);
+  EXPECT_EQ(Modules({"geometry", "math", "util"}), compiler_.take_compiled());
+
+  // The failed file is compiled again, and then its dependents.
+  write("geometry", "import math;\npublic fun area;\n");
+  summary = build();
+  EXPECT_EQ(2, summary.compiled);
+  EXPECT_EQ(2, summary.up_to_date);
+  EXPECT_EQ(Modules({"geometry", "main"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, NewConfigurationCompilesEverything) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  options_.configuration = "test -O2";
+  build();
+  EXPECT_EQ(Modules({"geometry", "main", "math", "util"}),
+            compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, NewImportIsFollowed) {
+  write_project();
+  build();
+  compiler_.take_compiled();
+  write("util", "import math;\npublic fun log;\n");
+  write("math", "public fun square;\npublic fun cube;\n");
+  options_.jobs = 1;
+  build();
+  EXPECT_EQ(Modules({"geometry", "main", "math", "util"}),
+            compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, NewExternalInterfaceCompilesTheImporters) {
+  write_project();
+  write_interface("external", "public fun io;\n");
+  write("util", "import external;\npublic fun log;\n");
+  build();
+  compiler_.take_compiled();
+  build();
+  EXPECT_EQ(Modules(), compiler_.take_compiled());
+
+  write_interface("external", "public fun io;\npublic fun file;\n");
+  auto summary = build();
+  EXPECT_EQ(1, summary.compiled);
+  EXPECT_EQ(3, summary.up_to_date);
+  EXPECT_EQ(Modules({"util"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, ExternalInterfaceIsHashedOncePerBuild) {
+  write_project();
+  write_interface("external", "public fun io;\n");
+  write("util", "import external;\npublic fun log;\n");
+  write("logger", "import external;\npublic fun trace;\n");
+  build();
+  write_interface("external", "public fun io;\npublic fun file;\n");
+  compiler_.take_compiled();
+
+  // The importers are compiled with the interface hashed before, not with
+  // the one changed during the build: they are compiled again next time.
+  compiler_.on_compile = [this](const std::string& /*source*/) {
+    std::ofstream(interfaces_[0]) << "public fun io;\npublic fun pipe;\n";
+  };
+  build();
+  EXPECT_EQ(Modules({"logger", "util"}), compiler_.take_compiled());
+  compiler_.on_compile = nullptr;
+  build();
+  EXPECT_EQ(Modules({"logger", "util"}), compiler_.take_compiled());
+  build();
+  EXPECT_EQ(Modules(), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, RemovedExternalInterfaceIsCompiled) {
+  write_project();
+  write_interface("external", "public fun io;\n");
+  write("util", "import external;\npublic fun log;\n");
+  build();
+  compiler_.take_compiled();
+  unlink(interfaces_[0].c_str());
+  auto summary = build();
+  EXPECT_EQ(1, summary.failed);
+  EXPECT_EQ(Modules({"util"}), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, ImportCycle) {
+  write("a", "import b;\n");
+  write("b", "import c;\n");
+  write("c", "import a;\n");
+  auto summary = build::run_build(sources_, options_, &compiler_);
+  ASSERT_FALSE(summary.is_ok());
+  EXPECT_NE(std::string::npos,
+            summary.error_or_die().to_string().find("The imports have a cycle"));
+  EXPECT_EQ(Modules(), compiler_.take_compiled());
+}
+
+TEST_F(BuilderTest, MissingSource) {
+  write("a", "");
+  sources_.push_back(directory_ + "/missing.gh");
+  auto summary = build::run_build(sources_, options_, &compiler_);
+  ASSERT_FALSE(summary.is_ok());
+  EXPECT_NE(std::string::npos,
+            summary.error_or_die().to_string().find("Could not find"));
+}
+
+TEST_F(BuilderTest, ScanImports) {
+  write("main",
+        "// The imports.\nimport geometry;\nimport math;\n"
+        "fun main() = 3;\nimport late;\n");
+  EXPECT_EQ(Modules({"geometry", "math"}), build::scan_imports(sources_[0]));
+  EXPECT_EQ("main", build::module_name(sources_[0]));
+}
+
+TEST(BuildGraphTest, Priorities) {
+  std::vector<build::Source> sources(4);
+  sources[0].path = "src/math.gh";
+  sources[0].cost = 10;
+  sources[1].path = "src/geometry.gh";
+  sources[1].imports = {"math", "external"};
+  sources[1].cost = 5;
+  sources[2].path = "main.gh";
+  sources[2].imports = {"geometry"};
+  sources[3].path = "util.gh";
+  sources[3].cost = 100;
+  auto graph = build::BuildGraph::create(std::move(sources));
+  ASSERT_TRUE(graph.is_ok());
+  const auto& value = graph.value_or_die();
+  EXPECT_EQ(16, value.priority(0));
+  EXPECT_EQ(6, value.priority(1));
+  EXPECT_EQ(1, value.priority(2));
+  EXPECT_EQ(100, value.priority(3));
+  EXPECT_EQ(std::vector<build::BuildGraph::Node>({0}), value.dependencies(1));
+  EXPECT_EQ(std::vector<build::BuildGraph::Node>({2}), value.dependents(1));
+}
+
+TEST(BuildGraphTest, DuplicateModule) {
+  std::vector<build::Source> sources(2);
+  sources[0].path = "a/math.gh";
+  sources[1].path = "b/math.gh";
+  auto graph = build::BuildGraph::create(std::move(sources));
+  ASSERT_FALSE(graph.is_ok());
+  EXPECT_NE(std::string::npos,
+            graph.error_or_die().to_string().find(
+                "The module `math' is defined in a/math.gh and in b/math.gh"));
+}
+
+}  // namespace
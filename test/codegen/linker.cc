@@ -0,0 +1,73 @@
+#include "codegen/linker.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/IR/LLVMContext.h"
+
+#include "codegen/codegen.h"
+#include "test_utils/codegen.h"
+#include "test_utils/utils.h"
+
+namespace {
+
+const char k_library[] = R"(
+public pure fun square(val x : Int64) : Int64 = x * x;
+public fun unused() : Int64 = 2;
+fun helper() : Int64 = 3;
+val table = [1, 2];
+)";
+
+const char k_program[] = R"(
+extern pure fun square(val x : Int64) : Int64;
+fun helper() : Int64 = 4;
+val table = [5, 6, 7];
+fun main() : Int64 = square(helper()) + table[2];
+)";
+
+}  // namespace
+
+TEST(Linker, LinksTheExternFunctions) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules;
+  modules.push_back(
+      codegen::generate_module("library.gh", k_library, &context));
+  modules.push_back(
+      codegen::generate_module("program.gh", k_program, &context));
+  std::string errors;
+  llvm::raw_string_ostream errors_stream(errors);
+  auto program =
+      codegen::link_program(std::move(modules), {"main"}, &errors_stream);
+  ASSERT_NE(nullptr, program);
+  EXPECT_EQ("", errors_stream.str());
+
+  // The extern declaration is resolved, only main is still exported.
+  auto square = program->getFunction("square");
+  ASSERT_NE(nullptr, square);
+  EXPECT_FALSE(square->isDeclaration());
+  EXPECT_TRUE(square->hasLocalLinkage());
+  EXPECT_TRUE(program->getFunction("unused")->hasLocalLinkage());
+  EXPECT_FALSE(program->getFunction("main")->hasLocalLinkage());
+  // The private functions and global variables don't clash.
+  EXPECT_NE(nullptr, program->getFunction("helper"));
+  EXPECT_NE(nullptr, program->getFunction("helper.1"));
+  EXPECT_NE(nullptr, program->getGlobalVariable("table", true));
+}
+
+TEST(Linker, DuplicatePublicFunction) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  std::vector<std::unique_ptr<llvm::Module>> modules;
+  modules.push_back(
+      codegen::generate_module("library.gh", k_library, &context));
+  modules.push_back(codegen::generate_module(
+      "other.gh", "public fun unused() : Int64 = 3;", &context));
+  std::string errors;
+  llvm::raw_string_ostream errors_stream(errors);
+  EXPECT_EQ(nullptr, codegen::link_program(std::move(modules), {"main"},
+                                           &errors_stream));
+  EXPECT_EQ("The function `unused' is defined in library.gh and in other.gh\n",
+            errors_stream.str());
+}
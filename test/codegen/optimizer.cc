@@ -0,0 +1,203 @@
+#include "codegen/optimizer.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "codegen/codegen.h"
+#include "test_utils/codegen.h"
+#include "test_utils/utils.h"
+#include "util/time_report.h"
+#include "util/trace.h"
+
+namespace {
+
+const char k_branches[] = R"(
+public fun classify(val x : Int64) : Int64 {
+  if (x < 10) {
+    return 1;
+  } else if (x < 100) {
+    return 2;
+  }
+  return 3;
+}
+)";
+
+const char k_loop[] = R"(
+public fun triangle(val n : Int64) : Int64 {
+  mut total : Int64 = 0;
+  for (i in 0..n) {
+    total += i;
+  }
+  return total;
+}
+)";
+
+std::string optimized_ir(llvm::Module* module) {
+  codegen::optimize(module, 2);
+  std::string ir;
+  llvm::raw_string_ostream out(ir);
+  out << *module;
+  return out.str();
+}
+
+#ifdef LLVM_PROFDATA
+/// Merge the counts of the function into the indexed profile, with
+/// llvm-profdata. The hash of its control flow graph and its number of
+/// counters are those of the instrumented module.
+bool write_profile(llvm::Module* instrumented, const std::string& function,
+                   std::initializer_list<uint64_t> counts,
+                   const std::string& path) {
+  auto data = instrumented->getGlobalVariable("__profd_" + function, true);
+  auto counters =
+      instrumented->getGlobalVariable("__profc_" + function, true);
+  if (data == nullptr || counters == nullptr) return false;
+  auto hash = llvm::cast<llvm::ConstantInt>(
+      data->getInitializer()->getAggregateElement(1u));
+  if (counters->getValueType()->getArrayNumElements() != counts.size()) {
+    return false;
+  }
+
+  // The text format, at the IR level.
+  std::string text = path + ".proftext";
+  {
+    std::ofstream out(text);
+    out << ":ir\n" << function << '\n' << hash->getZExtValue() << '\n'
+        << counts.size() << '\n';
+    for (auto count : counts) out << count << '\n';
+  }
+  std::string command =
+      std::string(LLVM_PROFDATA) + " merge -o " + path + " " + text;
+  bool merged = std::system(command.c_str()) == 0;
+  unlink(text.c_str());
+  return merged;
+}
+#endif
+
+}  // namespace
+
+TEST(Optimizer, PassesAreTimedAndTraced) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  auto expected = optimized_ir(
+      codegen::generate_module("loop.gh", k_loop, &context).get());
+
+  util::TimeReport report("loop.gh");
+  util::Tracer tracer;
+  util::TimeReport::set_active(&report);
+  util::Tracer::set_active(&tracer);
+  auto ir = optimized_ir(
+      codegen::generate_module("loop.gh", k_loop, &context).get());
+  util::TimeReport::set_active(nullptr);
+  util::Tracer::set_active(nullptr);
+
+  // The markers around the passes change nothing.
+  EXPECT_EQ(expected, ir);
+  std::ostringstream printed_report;
+  report.print(printed_report);
+  std::ostringstream trace;
+  tracer.write(trace);
+  // A function pass, a loop pass and a call graph pass.
+  for (const char* pass :
+       {"Combine redundant instructions", "Rotate Loops",
+        "Function Integration/Inlining"}) {
+    EXPECT_NE(std::string::npos, printed_report.str().find(pass)) << pass;
+    EXPECT_NE(std::string::npos, trace.str().find(pass)) << pass;
+  }
+}
+
+TEST(Optimizer, ProfileGenerate) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  auto module = codegen::generate_module("branches.gh", k_branches, &context);
+  auto classify = module->getFunction("classify");
+  EXPECT_TRUE(classify->doesNotAccessMemory());
+
+  codegen::ProfileOptions options;
+  options.generate = true;
+  std::string errors;
+  llvm::raw_string_ostream errors_stream(errors);
+  EXPECT_TRUE(codegen::apply_profile(module.get(), options, &errors_stream));
+  EXPECT_EQ("", errors_stream.str());
+  // The counters are globals, written by the function.
+  EXPECT_NE(nullptr, module->getGlobalVariable("__profc_classify", true));
+  EXPECT_FALSE(classify->onlyReadsMemory());
+}
+
+TEST(Optimizer, ProfileUseMissingFile) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  auto module = codegen::generate_module("branches.gh", k_branches, &context);
+
+  codegen::ProfileOptions options;
+  options.use = "does_not_exist.profdata";
+  std::string errors;
+  llvm::raw_string_ostream errors_stream(errors);
+  EXPECT_FALSE(codegen::apply_profile(module.get(), options, &errors_stream));
+  EXPECT_EQ("Could not read the profile does_not_exist.profdata\n",
+            errors_stream.str());
+}
+
+#ifdef LLVM_PROFDATA
+TEST(Optimizer, ProfileUse) {
+  codegen::LLVMInitializer llvm_init;
+  llvm::LLVMContext context;
+  auto instrumented =
+      codegen::generate_module("branches.gh", k_branches, &context);
+  codegen::ProfileOptions generate;
+  generate.generate = true;
+  std::string errors;
+  llvm::raw_string_ostream errors_stream(errors);
+  ASSERT_TRUE(
+      codegen::apply_profile(instrumented.get(), generate, &errors_stream));
+
+  char directory[] = "/tmp/profile_test_XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(directory));
+  std::string path = std::string(directory) + "/branches.profdata";
+  // Of 100 calls, 5 return 1, 15 return 2 and 80 return 3.
+  ASSERT_TRUE(
+      write_profile(instrumented.get(), "classify", {5, 15, 80}, path));
+
+  auto module = codegen::generate_module("branches.gh", k_branches, &context);
+  codegen::ProfileOptions use;
+  use.use = path;
+  EXPECT_TRUE(codegen::apply_profile(module.get(), use, &errors_stream));
+  unlink(path.c_str());
+  rmdir(directory);
+  EXPECT_EQ("", errors_stream.str());
+
+  auto classify = module->getFunction("classify");
+  auto entry_count = classify->getEntryCount();
+  ASSERT_TRUE(entry_count.hasValue());
+  EXPECT_EQ(100u, entry_count->getCount());
+  // The weights of the taken and not taken sides of the two branches.
+  std::ostringstream weights;
+  for (auto& block : *classify) {
+    auto branch = llvm::dyn_cast<llvm::BranchInst>(block.getTerminator());
+    if (branch == nullptr || !branch->isConditional()) continue;
+    auto profile = branch->getMetadata(llvm::LLVMContext::MD_prof);
+    ASSERT_NE(nullptr, profile);
+    EXPECT_EQ("branch_weights",
+              llvm::cast<llvm::MDString>(profile->getOperand(0))->getString());
+    for (unsigned i = 1; i < profile->getNumOperands(); ++i) {
+      weights << llvm::mdconst::extract<llvm::ConstantInt>(
+                     profile->getOperand(i))
+                     ->getZExtValue()
+              << (i + 1 < profile->getNumOperands() ? " " : "\n");
+    }
+  }
+  EXPECT_EQ("5 95\n15 80\n", weights.str());
+}
+#endif
@@ -211,3 +211,16 @@ TEST(ErrorTest, ReturnIfErrorError) {
   ASSERT_FALSE(res.is_ok());
   EXPECT_EQ("No int", res.error_or_die().to_string());
 }
+
+ErrorOr<int, SpecificError> return_specific_error() { return SpecificError{}; }
+
+MaybeError<> propagate_specific_error() {
+  RETURN_IF_ERROR(return_specific_error());
+  return {};
+}
+
+TEST(ErrorTest, ReturnIfErrorKeepsErrorType) {
+  auto res = propagate_specific_error();
+  ASSERT_FALSE(res.is_ok());
+  EXPECT_EQ("success", res.error_or_die().to_string());
+}
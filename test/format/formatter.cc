@@ -0,0 +1,104 @@
+#include "format/formatter.h"
+
+#include <string>
+
+#include "test_utils/utils.h"
+
+namespace {
+
+std::string format_or_die(const std::string& source) {
+  std::string formatted;
+  auto result = format::format_source(source, "main.gh", {}, &formatted);
+  EXPECT_TRUE(result.is_ok()) << result.to_string();
+  return formatted;
+}
+
+}  // namespace
+
+TEST(FormatterTest, Formats) {
+  EXPECT_EQ(
+      "fun f(val x: Int64) : Int64 {\n"
+      "  if (x > 2) {\n"
+      "    return x;\n"
+      "  }\n"
+      "  return 2;\n"
+      "}\n",
+      format_or_die("fun   f(val x:Int64):Int64{if((x>2))return x;\n"
+                    "return 2;}"));
+}
+
+TEST(FormatterTest, KeepsTheComments) {
+  EXPECT_EQ(
+      "// The header.\n"
+      "import math;\n"
+      "fun f() : Int64 {\n"
+      "  // Before.\n"
+      "  val x : Int64 = 3;  // After.\n"
+      "  while (true) {\n"
+      "    // Empty.\n"
+      "  }\n"
+      "  return x;\n"
+      "}\n"
+      "// The end.\n",
+      format_or_die("// The header.\n"
+                    "import math;\n"
+                    "fun f() : Int64 {  // Before.\n"
+                    "  val x : Int64 = 3;  // After.\n"
+                    "  while (true) {\n"
+                    "  // Empty.\n"
+                    "  }\n"
+                    "  return x;\n"
+                    "}\n"
+                    "// The end.\n"));
+}
+
+TEST(FormatterTest, Formatted) {
+  const std::string source =
+      "val x : Int64 = (1 + 2) * 3;  // Nine.\n"
+      "fun g() = f(x, [1, 2]);\n";
+  EXPECT_EQ(source, format_or_die(source));
+}
+
+TEST(FormatterTest, KeepsTheCompoundAssignmentsAndTheBlankLines) {
+  const std::string source =
+      "fun f(mut x: Int64) : Int64 {\n"
+      "  x += 2 * (x - 1);\n"
+      "  x -= x - (1 - 2);\n"
+      "  x ^= (x * 2) | (x |> 3);\n"
+      "\n"
+      "  // After a blank line.\n"
+      "  if (x > 2 || x < 1) {\n"
+      "    return (x + 1) * x;\n"
+      "  }\n"
+      "\n"
+      "  return x;\n"
+      "}\n"
+      "\n"
+      "fun g() = f(1);\n";
+  EXPECT_EQ(source, format_or_die(source));
+}
+
+TEST(FormatterTest, OneBlankLine) {
+  EXPECT_EQ(
+      "fun f() : Int64 {\n"
+      "  g();\n"
+      "\n"
+      "  return 1;\n"
+      "}\n",
+      format_or_die("fun f() : Int64 {\n"
+                    "\n"
+                    "  g();\n"
+                    "\n"
+                    "\n"
+                    "  return 1;\n"
+                    "\n"
+                    "}\n"));
+}
+
+TEST(FormatterTest, ParseError) {
+  std::string formatted;
+  auto result = format::format_source("fun f( = 2;", "main.gh", {}, &formatted);
+  ASSERT_FALSE(result.is_ok());
+  EXPECT_NE(std::string::npos,
+            result.error_or_die().to_string().find("main.gh"));
+}
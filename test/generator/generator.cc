@@ -0,0 +1,116 @@
+#include "generator/generator.h"
+
+#include "gtest/gtest.h"
+
+#include "ast/module.h"
+#include "name_resolution/visitor.h"
+#include "parser/parser.h"
+#include "transform/add_return.h"
+#include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
+
+namespace generator {
+
+using testing::AssertionFailure;
+using testing::AssertionResult;
+using testing::AssertionSuccess;
+
+namespace {
+
+template <typename Visitor>
+AssertionResult run_pass(ast::Module* module) {
+  Visitor visitor;
+  module->accept(visitor);
+  if (!visitor.error_list().errors().empty())
+    return AssertionFailure()
+           << visitor.error_list().errors().front().to_string();
+  return AssertionSuccess();
+}
+
+/// Parse the program, and if `analyze` is set, run the name resolution, type
+/// checking and return insertion.
+AssertionResult is_valid(const std::string& program, bool analyze) {
+  auto lexer = lexer::from_string(program);
+  parser::Parser parser(&lexer);
+  auto result = parser.parse();
+  if (!result.is_ok())
+    return AssertionFailure() << result.to_string() << "\nIn:\n" << program;
+  if (!analyze) return AssertionSuccess();
+  ast::Module* module = result.value_or_die().get();
+  transform::FunctionValueBodyTransformer transformer;
+  module->accept(transformer);
+  auto status = run_pass<name_resolution::NameResolver>(module);
+  if (status) status = run_pass<typechecker::TypeChecker>(module);
+  if (status) status = run_pass<transform::VoidFunctionReturnAdder>(module);
+  if (!status) return status << "\nIn:\n" << program;
+  return AssertionSuccess();
+}
+
+}  // namespace
+
+TEST(GeneratorTest, SameSeedSameProgram) {
+  Options options;
+  options.seed = 42;
+  EXPECT_EQ(generate(options), generate(options));
+  Options other = options;
+  other.seed = 43;
+  EXPECT_NE(generate(options), generate(other));
+}
+
+TEST(GeneratorTest, Size) {
+  Options options;
+  options.size = 10000;
+  const auto program = generate(options);
+  EXPECT_GE(program.size(), 10000u);
+  EXPECT_LT(program.size(), 20000u);
+}
+
+TEST(GeneratorTest, FunctionCount) {
+  Options options;
+  options.functions = 17;
+  const auto program = generate(options);
+  int functions = 0;
+  for (auto pos = program.find("fun "); pos != std::string::npos;
+       pos = program.find("fun ", pos + 1))
+    ++functions;
+  EXPECT_EQ(17, functions);
+}
+
+TEST(GeneratorTest, NoErrors) {
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    Options options;
+    options.seed = seed;
+    options.functions = 10;
+    EXPECT_TRUE(is_valid(generate(options), /*analyze=*/true));
+  }
+}
+
+TEST(GeneratorTest, NoErrorsWithoutCalls) {
+  for (std::uint32_t seed = 0; seed < 20; ++seed) {
+    Options options;
+    options.seed = seed;
+    options.functions = 10;
+    options.function_calls = false;
+    EXPECT_TRUE(is_valid(generate(options), /*analyze=*/true));
+  }
+}
+
+TEST(GeneratorTest, Knobs) {
+  Options options;
+  options.functions = 10;
+  options.function_calls = false;
+  options.max_nesting_depth = 0;
+  options.max_expression_depth = 0;
+  options.min_identifier_length = 20;
+  options.mean_identifier_length = 20;
+  options.max_identifier_length = 20;
+  const auto program = generate(options);
+  EXPECT_EQ(std::string::npos, program.find("if ("));
+  EXPECT_EQ(std::string::npos, program.find(" + "));
+  EXPECT_TRUE(is_valid(program, /*analyze=*/true));
+  // Any global or function name.
+  const auto name_start = program.find("fun ") + 4;
+  EXPECT_EQ(20u, program.find('(', name_start) - name_start);
+}
+
+}  // namespace generator
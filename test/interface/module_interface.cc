@@ -0,0 +1,204 @@
+#include "interface/module_interface.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "ast/array_type.h"
+#include "ast/builtin_type.h"
+#include "ast/function_declaration.h"
+#include "ast/module.h"
+#include "interface/writer.h"
+#include "lexer/lexer.h"
+#include "name_resolution/visitor.h"
+#include "parser/parser.h"
+#include "test_utils/utils.h"
+#include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
+
+namespace {
+
+const char k_library[] = R"(
+public pure fun square(val x : Int64) : Int64 = x * x;
+public fun sum(val xs : [Int32], mut total : Int64) : Int64 {
+  for (i in 0..xs.length) {
+    total += xs[i];
+  }
+  return total;
+}
+public fun zeros() : [Bool; 3] = [false, false, false];
+fun helper() : Int64 = 3;
+)";
+
+const char k_program[] = R"(
+import math;
+val xs : [Int32; 3] = [1, 2, 3];
+fun main() : Int64 = square(sum(xs[..], 4));
+)";
+
+/// The interfaces are written in a temporary directory.
+class ModuleInterfaceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/ghi_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    directory_ = directory;
+  }
+
+  void TearDown() override {
+    for (const auto& file : files_) unlink(file.c_str());
+    rmdir(directory_.c_str());
+  }
+
+  std::string path(const std::string& module) {
+    files_.push_back(directory_ + "/" + module + ".ghi");
+    return files_.back();
+  }
+
+  /// Parse the source, and check its names and its types with the loader.
+  std::unique_ptr<ast::Module> check(const std::string& source,
+                                     interface::InterfaceLoader* loader,
+                                     std::string* errors) {
+    auto lexer = lexer::from_string(source);
+    parser::Parser parser(&lexer);
+    auto result = parser.parse();
+    EXPECT_TRUE(result.is_ok()) << result.to_string();
+    auto module = result.consume_value_or_die();
+    transform::FunctionValueBodyTransformer value_body;
+    module->accept(value_body);
+    name_resolution::NameResolver resolver;
+    resolver.set_interface_loader(loader);
+    module->accept(resolver);
+    for (const auto& error : resolver.error_list().errors())
+      *errors += error.to_string() + "\n";
+    if (!errors->empty()) return module;
+    typechecker::TypeChecker type_checker;
+    module->accept(type_checker);
+    for (const auto& error : type_checker.error_list().errors())
+      *errors += error.to_string() + "\n";
+    return module;
+  }
+
+  /// Write the interface of the source, as the module.
+  void write(const std::string& source, const std::string& module) {
+    std::string errors;
+    auto library = check(source, nullptr, &errors);
+    ASSERT_EQ("", errors);
+    std::ofstream out(path(module), std::ios::binary);
+    interface::write_interface(*library, &out);
+  }
+
+  std::string directory_;
+  std::vector<std::string> files_;
+};
+
+}  // namespace
+
+TEST_F(ModuleInterfaceTest, ImportsThePublicFunctions) {
+  write(k_library, "math");
+  interface::InterfaceLoader loader({directory_});
+  std::string errors;
+  auto program = check(k_program, &loader, &errors);
+  EXPECT_EQ("", errors);
+
+  auto math = loader.load("math");
+  ASSERT_TRUE(math.is_ok());
+  EXPECT_EQ(3u, math.value_or_die()->function_count());
+  // Loaded once.
+  EXPECT_EQ(math.value_or_die(), loader.load("math").value_or_die());
+}
+
+TEST_F(ModuleInterfaceTest, DecodesTheSignatures) {
+  write(k_library, "math");
+  auto interface = interface::ModuleInterface::open(path("math"));
+  ASSERT_TRUE(interface.is_ok()) << interface.to_string();
+  auto& math = *interface.value_or_die();
+
+  auto square = math.lookup("square").value_or_die();
+  ASSERT_NE(nullptr, square);
+  EXPECT_TRUE(square->is_extern());
+  EXPECT_TRUE(square->is_pure());
+  EXPECT_EQ(&ast::types::int64,
+            square->type().value_or_die().get_declaration());
+  // Decoded once.
+  EXPECT_EQ(square, math.lookup("square").value_or_die());
+
+  auto sum = math.lookup("sum").value_or_die();
+  ASSERT_NE(nullptr, sum);
+  EXPECT_FALSE(sum->is_pure());
+  ASSERT_EQ(2u, sum->arguments().size());
+  auto& xs = *sum->arguments()[0];
+  EXPECT_EQ("xs", xs.id().to_string());
+  EXPECT_FALSE(xs.is_mutable());
+  EXPECT_EQ(ast::types::slice_of(&ast::types::int32),
+            xs.type().value_or_die().get_declaration());
+  EXPECT_TRUE(sum->arguments()[1]->is_mutable());
+
+  auto zeros = math.lookup("zeros").value_or_die();
+  ASSERT_NE(nullptr, zeros);
+  EXPECT_EQ(ast::types::array_of(&ast::types::boolean, 3),
+            zeros->type().value_or_die().get_declaration());
+
+  // Only the public functions are exported.
+  EXPECT_EQ(nullptr, math.lookup("helper").value_or_die());
+  EXPECT_EQ(nullptr, math.lookup("main").value_or_die());
+}
+
+TEST_F(ModuleInterfaceTest, UnknownFunction) {
+  write(k_library, "math");
+  interface::InterfaceLoader loader({directory_});
+  std::string errors;
+  check("import math;\nfun main() : Int64 = cube(2);\n", &loader, &errors);
+  EXPECT_NE(std::string::npos, errors.find("No variable named `cube'"))
+      << errors;
+}
+
+TEST_F(ModuleInterfaceTest, MissingModule) {
+  interface::InterfaceLoader loader({directory_});
+  std::string errors;
+  check(k_program, &loader, &errors);
+  EXPECT_NE(std::string::npos,
+            errors.find("Could not find the interface of the module `math'"))
+      << errors;
+}
+
+TEST_F(ModuleInterfaceTest, NotAnInterface) {
+  std::ofstream(path("math")) << "fun main() : Int64 = 3;\n";
+  auto interface = interface::ModuleInterface::open(path("math"));
+  ASSERT_FALSE(interface.is_ok());
+  EXPECT_EQ("The file " + path("math") + " is not a module interface",
+            interface.error_or_die().to_string());
+}
+
+TEST_F(ModuleInterfaceTest, Truncated) {
+  write(k_library, "math");
+  // The header and the index are complete, but not the records.
+  auto file = path("math");
+  ASSERT_EQ(0, truncate(file.c_str(), 16 + 3 * 12 + 4));
+  auto interface = interface::ModuleInterface::open(file);
+  ASSERT_FALSE(interface.is_ok());
+  EXPECT_EQ("The interface " + file + " is corrupted",
+            interface.error_or_die().to_string());
+}
+
+TEST_F(ModuleInterfaceTest, CorruptedRecord) {
+  write(k_library, "math");
+  auto file = path("math");
+  {
+    // The record of `square', the first function, is out of the file.
+    std::fstream out(file, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(16 + 8);
+    out << "\xff\xff\xff\xff";
+  }
+  auto interface = interface::ModuleInterface::open(file);
+  ASSERT_TRUE(interface.is_ok()) << interface.to_string();
+  auto square = interface.value_or_die()->lookup("square");
+  ASSERT_FALSE(square.is_ok());
+  EXPECT_EQ("The interface " + file + " is corrupted",
+            square.error_or_die().to_string());
+  // The other functions can still be used.
+  EXPECT_TRUE(interface.value_or_die()->lookup("sum").is_ok());
+}
@@ -154,6 +154,9 @@ TEST(LexerTest, Numbers) {
       "0+0 + 1", {TokenType::INT, TokenType::PLUS, TokenType::INT,
                   TokenType::PLUS, TokenType::INT},
       {"0", "+", "0", "+", "1"}));
+  auto zero = string_to_tokens("0");
+  ASSERT_TRUE(zero.is_ok()) << zero.error_or_die();
+  EXPECT_EQ(0, zero.value_or_die().front().int_value());
 }
 
 // Tests of comments.
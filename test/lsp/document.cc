@@ -0,0 +1,135 @@
+#include "lsp/document.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "generator/generator.h"
+#include "gtest/gtest.h"
+
+namespace lsp {
+
+namespace {
+
+const char k_program[] = R"(// Sums.
+fun sum(val a : Int64, val b : Int64) : Int64 {
+  return a + b;
+}
+
+fun twice(val n : Int64) = sum(n, n);
+
+fun main() : Int64 {
+  val x = twice(2);
+  return x;
+}
+)";
+
+bool never() { return false; }
+
+/// The diagnostics, one per line, to compare them.
+std::string diagnostics(Document* document) {
+  EXPECT_TRUE(document->analyze(never));
+  std::ostringstream out;
+  for (const auto& diagnostic : document->diagnostics()) {
+    out << diagnostic.begin.line << ':' << diagnostic.begin.character << '-'
+        << diagnostic.end.line << ':' << diagnostic.end.character << ' '
+        << (diagnostic.is_error ? "error" : "warning") << ": "
+        << diagnostic.message << '\n';
+  }
+  return out.str();
+}
+
+}  // namespace
+
+TEST(DocumentTest, Chunks) {
+  Document document(k_program, {});
+  EXPECT_EQ(3u, document.chunk_count());
+  EXPECT_EQ(12, document.line_count());
+  EXPECT_EQ("", diagnostics(&document));
+}
+
+TEST(DocumentTest, OnlyParsesTheEditedChunk) {
+  Document document(k_program, {});
+  document.edit({9, 9}, {9, 9}, "y + ");
+  // The last function, from the blank line before it.
+  EXPECT_EQ(6, document.parsed_lines());
+  EXPECT_EQ("9:9-9:10 error: No variable named `y'\n", diagnostics(&document));
+
+  // The next chunks move.
+  document.edit({0, 0}, {0, 0}, "\n\n");
+  EXPECT_EQ(6, document.parsed_lines());
+  EXPECT_EQ("11:9-11:10 error: No variable named `y'\n",
+            diagnostics(&document));
+  document.edit({11, 9}, {11, 13}, "");
+  EXPECT_EQ("", diagnostics(&document));
+  EXPECT_EQ(std::string("\n\n") + k_program, document.text());
+}
+
+TEST(DocumentTest, ParseError) {
+  Document document(k_program, {});
+  // Without its closing brace, sum goes on until the next function.
+  document.edit({3, 0}, {4, 0}, "");
+  EXPECT_EQ("10:0-10:1 error: Could not parse as a statement\n",
+            diagnostics(&document));
+  document.edit({3, 0}, {3, 0}, "}\n");
+  EXPECT_EQ("", diagnostics(&document));
+  EXPECT_EQ(k_program, document.text());
+}
+
+TEST(DocumentTest, FixedByTheNextChunk) {
+  Document document(k_program, {});
+  document.edit({3, 0}, {3, 1}, "");
+  EXPECT_NE("", diagnostics(&document));
+  // The brace is back, at the start of the next chunk.
+  document.edit({4, 0}, {4, 0}, "}");
+  EXPECT_EQ("", diagnostics(&document));
+}
+
+TEST(DocumentTest, ImportsFirst) {
+  Document document(k_program, {});
+  document.edit({5, 0}, {5, 0}, "import math;");
+  EXPECT_EQ(
+      "5:0-5:12 error: The imports must be before the declarations\n"
+      "5:7-5:11 error: Could not find the interface of the module `math'\n",
+      diagnostics(&document));
+}
+
+TEST(DocumentTest, Cancelled) {
+  Document document(k_program, {});
+  EXPECT_FALSE(document.analyze([]() { return true; }));
+  document.edit({9, 9}, {9, 9}, "y + ");
+  EXPECT_EQ("9:9-9:10 error: No variable named `y'\n", diagnostics(&document));
+}
+
+TEST(DocumentTest, SameAsAFullParse) {
+  generator::Options options;
+  options.seed = 7;
+  options.functions = 30;
+  std::ostringstream program;
+  generator::Generator(options).generate(&program);
+  Document document(program.str(), {});
+
+  // Random edits, that break the program and fix it, with the diagnostics
+  // of the whole text after each.
+  std::mt19937 random(42);
+  const std::vector<std::string> insertions = {"\n", "}", "{", "x + ", ";",
+                                               "\n\nfun f() = 3;\n", " "};
+  for (int i = 0; i < 200; ++i) {
+    Position begin{static_cast<int>(random() % document.line_count()),
+                   static_cast<int>(random() % 20)};
+    Position end = begin;
+    std::string text;
+    if (random() % 2 == 0)
+      end.character += static_cast<int>(random() % 5);
+    else
+      text = insertions[random() % insertions.size()];
+    document.edit(begin, end, text);
+    Document full(document.text(), {});
+    ASSERT_EQ(diagnostics(&full), diagnostics(&document))
+        << "After edit " << i << ":\n"
+        << document.text();
+  }
+}
+
+}  // namespace lsp
@@ -0,0 +1,50 @@
+#include "lsp/json.h"
+
+#include "gtest/gtest.h"
+
+namespace lsp {
+
+TEST(JsonTest, Parse) {
+  auto parsed = Json::parse(
+      R"( {"id": 12, "params": {"list": [true, false, null, -1.5e2]},
+           "text": "a\"b\\c\nd\u00e9\ud83d\ude00"} )");
+  ASSERT_TRUE(parsed.is_ok()) << parsed.to_string();
+  const auto& json = parsed.value_or_die();
+  EXPECT_EQ(12, json["id"].number());
+  const auto& list = json["params"]["list"].array();
+  ASSERT_EQ(4u, list.size());
+  EXPECT_TRUE(list[0].boolean());
+  EXPECT_FALSE(list[1].boolean());
+  EXPECT_TRUE(list[2].is_null());
+  EXPECT_EQ(-150, list[3].number());
+  EXPECT_EQ("a\"b\\c\nd\xc3\xa9\xf0\x9f\x98\x80", json["text"].string());
+  // The missing members are null.
+  EXPECT_TRUE(json["missing"]["member"].is_null());
+  EXPECT_FALSE(json.has("missing"));
+}
+
+TEST(JsonTest, Write) {
+  Json json = Json::Object{
+      {"id", 3},
+      {"list", Json::Array{1.5, "x\n\x01", nullptr, true}},
+      {"empty", Json::Object{}}};
+  EXPECT_EQ(R"({"id":3,"list":[1.5,"x\n\u0001",null,true],"empty":{}})",
+            json.to_string());
+  EXPECT_EQ(json, Json::parse(json.to_string()).value_or_die());
+}
+
+TEST(JsonTest, Errors) {
+  for (const char* text :
+       {"", "{", "[1,]", "{\"a\" 1}", "\"abc", "nul", "1 2", "{1: 2}",
+        "\"\\x\"", "+1"}) {
+    EXPECT_FALSE(Json::parse(text).is_ok()) << text;
+  }
+  EXPECT_EQ("Expected `,' or `]' at offset 3 of the JSON text",
+            Json::parse("[1 2]").error_or_die().to_string());
+}
+
+TEST(JsonTest, TooDeep) {
+  EXPECT_FALSE(Json::parse(std::string(10000, '[')).is_ok());
+}
+
+}  // namespace lsp
@@ -0,0 +1,160 @@
+#include "lsp/server.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "lsp/protocol.h"
+
+namespace lsp {
+
+namespace {
+
+/// Run the server on the messages, and return its messages.
+std::vector<Json> run(const std::vector<std::string>& messages,
+                      int expected_exit_code = 0) {
+  std::stringstream in;
+  for (const auto& message : messages)
+    write_message(Json::parse(message).value_or_die(), &in);
+  std::stringstream out;
+  Server server(&in, &out, {});
+  EXPECT_EQ(expected_exit_code, server.run());
+  std::vector<Json> output;
+  while (true) {
+    auto content = read_content(&out);
+    if (!content.is_ok()) break;
+    output.push_back(Json::parse(content.value_or_die()).value_or_die());
+  }
+  return output;
+}
+
+const char k_initialize[] =
+    R"({"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {}})";
+const char k_shutdown[] =
+    R"({"jsonrpc": "2.0", "id": 2, "method": "shutdown"})";
+const char k_exit[] = R"({"jsonrpc": "2.0", "method": "exit"})";
+
+}  // namespace
+
+TEST(ServerTest, Session) {
+  auto output = run({
+      k_initialize,
+      R"({"jsonrpc": "2.0", "method": "initialized", "params": {}})",
+      R"({"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {
+          "textDocument": {"uri": "file:///tmp/main.gh", "version": 1,
+                           "text": "fun f() : Int64 {\n  return x;\n}\n"}}})",
+      R"({"jsonrpc": "2.0", "method": "textDocument/didChange", "params": {
+          "textDocument": {"uri": "file:///tmp/main.gh", "version": 2},
+          "contentChanges": [{"range": {"start": {"line": 1, "character": 9},
+                                        "end": {"line": 1, "character": 10}},
+                              "text": "2"}]}})",
+      R"({"jsonrpc": "2.0", "id": 7, "method": "textDocument/hover"})",
+      k_shutdown,
+      k_exit,
+  });
+  ASSERT_LE(4u, output.size());
+  EXPECT_EQ(1, output.front()["id"].number());
+  EXPECT_EQ(2, output.front()["result"]["capabilities"]["textDocumentSync"]
+                                       ["change"]
+                                           .number());
+  // The last diagnostics are published before the shutdown, the first ones
+  // may be cancelled by the change.
+  const auto& diagnostics = output[output.size() - 2];
+  EXPECT_EQ("textDocument/publishDiagnostics",
+            diagnostics["method"].string());
+  EXPECT_EQ(2, diagnostics["params"]["version"].number());
+  EXPECT_TRUE(diagnostics["params"]["diagnostics"].array().empty());
+  EXPECT_EQ(R"({"jsonrpc":"2.0","id":2,"result":null})",
+            output.back().to_string());
+  bool unknown = false;
+  for (const auto& message : output)
+    unknown = unknown || (message["id"].number() == 7 &&
+                          message["error"]["code"].number() == -32601);
+  EXPECT_TRUE(unknown);
+}
+
+TEST(ServerTest, Diagnostics) {
+  auto output = run({
+      k_initialize,
+      R"({"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {
+          "textDocument": {"uri": "file:///tmp/main.gh", "version": 3,
+                           "text": "fun f() : Int64 {\n  return x;\n}\n"}}})",
+      k_shutdown,
+      k_exit,
+  });
+  ASSERT_EQ(3u, output.size());
+  EXPECT_EQ(
+      R"({"jsonrpc":"2.0","method":"textDocument/publishDiagnostics",)"
+      R"("params":{"uri":"file:///tmp/main.gh","version":3,"diagnostics":[)"
+      R"({"range":{"start":{"line":1,"character":9},)"
+      R"("end":{"line":1,"character":10}},"severity":1,"source":"gracc",)"
+      R"("message":"No variable named `x'"}]}})",
+      output[1].to_string());
+}
+
+TEST(ServerTest, TypeErrors) {
+  // The parents of a value with a type error are skipped.
+  auto output = run({
+      k_initialize,
+      R"({"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {
+          "textDocument": {"uri": "file:///tmp/main.gh", "version": 1,
+                           "text": "fun f() : Int64 {\n)"
+      R"(  val x = true + 1;\n  return x + 2;\n}\n"}}})",
+      k_shutdown,
+      k_exit,
+  });
+  ASSERT_EQ(3u, output.size());
+  EXPECT_EQ(
+      R"({"jsonrpc":"2.0","method":"textDocument/publishDiagnostics",)"
+      R"("params":{"uri":"file:///tmp/main.gh","version":1,"diagnostics":[)"
+      R"({"range":{"start":{"line":1,"character":10},)"
+      R"("end":{"line":1,"character":18}},"severity":1,"source":"gracc",)"
+      R"("message":"Invalid operand types for binary operation `+': )"
+      R"(`Bool' and `Int64'"}]}})",
+      output[1].to_string());
+}
+
+TEST(ServerTest, Close) {
+  auto output = run({
+      k_initialize,
+      R"({"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {
+          "textDocument": {"uri": "untitled:1", "version": 1,
+                           "text": "fun f() = x;"}}})",
+      R"({"jsonrpc": "2.0", "method": "textDocument/didClose", "params": {
+          "textDocument": {"uri": "untitled:1"}}})",
+      k_shutdown,
+      k_exit,
+  });
+  // The diagnostics of the closed document are cleared.
+  ASSERT_LE(3u, output.size());
+  EXPECT_EQ(
+      R"({"jsonrpc":"2.0","method":"textDocument/publishDiagnostics",)"
+      R"("params":{"uri":"untitled:1","diagnostics":[]}})",
+      output[output.size() - 2].to_string());
+}
+
+TEST(ServerTest, ExitWithoutShutdown) {
+  auto output = run({k_initialize, k_exit}, 1);
+  EXPECT_EQ(1u, output.size());
+}
+
+TEST(ServerTest, NotInitialized) {
+  auto output = run({k_shutdown}, 1);
+  ASSERT_EQ(1u, output.size());
+  EXPECT_EQ(-32002, output[0]["error"]["code"].number());
+}
+
+TEST(ServerTest, InvalidMessage) {
+  std::stringstream in("Content-Length: 3\r\n\r\n{]}");
+  std::stringstream out;
+  Server server(&in, &out, {});
+  EXPECT_EQ(1, server.run());
+  auto content = read_content(&out);
+  ASSERT_TRUE(content.is_ok());
+  auto reply = Json::parse(content.value_or_die()).value_or_die();
+  EXPECT_TRUE(reply["id"].is_null());
+  EXPECT_EQ(-32700, reply["error"]["code"].number());
+}
+
+}  // namespace lsp
@@ -2,9 +2,17 @@
 
 #include "gtest/gtest.h"
 
+#include "test_utils/timing.h"
+
 int main(int argc, char** argv) {
+  // The resource tests are instantiated from --test_resource_folder in
+  // InitGoogleTest, so our flags have to be parsed first. The gtest flags are
+  // left for InitGoogleTest.
+  gflags::AllowCommandLineReparsing();
+  gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/false);
   ::testing::InitGoogleTest(&argc, argv);
-  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  ::testing::UnitTest::GetInstance()->listeners().Append(
+      new test::ResourceTimingListener());
   int ret = RUN_ALL_TESTS();
   gflags::ShutDownCommandLineFlags();
   return ret;
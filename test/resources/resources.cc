@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "ast/module.h"
 #include "codegen/codegen.h"
@@ -14,6 +17,7 @@
 #include "test_utils/lexing.h"
 #include "test_utils/utils.h"
 #include "transform/add_return.h"
+#include "transform/constant_folder.h"
 #include "transform/function_value_body.h"
 #include "typechecker/typechecker.h"
 #include "visitor/error_visitor.h"
@@ -268,12 +272,18 @@ Variant<AssertionResult, std::string> get_transformed_ir(
   codegen::CodeGenerator generator(filename);
   result.value_or_die()->accept(generator);
 
+  if (!generator.error_list().errors().empty()) {
+    return codegen_error_message(
+        generator.error_list().errors().front().to_string());
+  }
   if (!generator.error_list().warnings().empty()) {
     return codegen_error_message(
         generator.error_list().warnings().front().to_string());
   }
 
   llvm::raw_string_ostream out(ir);
+  if (!generator.verify(&out))
+    return codegen_error_message("Invalid module: " + out.str());
   generator.print(out);
   return crop_llvm_header(ir);
 }
@@ -341,62 +351,87 @@ AssertionResult transformer_test(const std::string& filename) {
   return AssertionSuccess();
 }
 
-template <TestFunction tester>
-AssertionResult test_all_files_in_dir(const std::string& directory) {
-  if (FLAGS_test_resource_folder.empty())
-    return AssertionFailure() << "Could not find test resources\n"
-                                 "Please give --test_resource_folder flag";
-  return test::walk_directory(
-      (FLAGS_test_resource_folder + "/" + directory).c_str(), tester);
+/// The .gh files of a resource directory, relative to --test_resource_folder
+/// (e.g. "parser/if_statement.gh"). It is called when the tests are
+/// instantiated, after the flags are parsed (see test/main.cc).
+std::vector<std::string> resource_files(const std::string& directory) {
+  std::vector<std::string> files;
+  if (FLAGS_test_resource_folder.empty()) return files;
+  for (const auto& file :
+       list_files(FLAGS_test_resource_folder + "/" + directory)) {
+    if (ends_with(file, ".gh")) files.push_back(directory + "/" + file);
+  }
+  return files;
 }
 
-TEST(ResourcesTest, Lexer) {
-  EXPECT_TRUE(test_all_files_in_dir<test_lexer_resource>("lexer"));
+/// Name of the test of a resource file: its path, with only alphanumeric
+/// characters.
+std::string resource_test_name(
+    const testing::TestParamInfo<std::string>& info) {
+  std::string name = info.param;
+  std::replace_if(name.begin(), name.end(),
+                  [](unsigned char c) { return !std::isalnum(c); }, '_');
+  return name;
 }
 
-TEST(ResourcesTest, Parser) {
-  EXPECT_TRUE(test_all_files_in_dir<test_parser_resource>("parser"));
+/// Each resource file is a separate test, to be able to shard them.
+class ResourceTest : public testing::TestWithParam<std::string> {
+ protected:
+  std::string path() const {
+    return FLAGS_test_resource_folder + "/" + GetParam();
+  }
+};
+
+#define RESOURCE_TEST(NAME, DIRECTORY, TESTER)                            \
+  class NAME : public ResourceTest {};                                    \
+  TEST_P(NAME, Passes) { EXPECT_TRUE(TESTER(path())); }                   \
+  INSTANTIATE_TEST_CASE_P(Resources, NAME,                                \
+                          testing::ValuesIn(resource_files(DIRECTORY)), \
+                          resource_test_name)
+
+TEST(ResourcesTest, ResourceFolder) {
+  EXPECT_FALSE(FLAGS_test_resource_folder.empty())
+      << "Could not find test resources\n"
+         "Please give --test_resource_folder flag";
 }
 
-TEST(ResourcesTest, PrettyPrinter) {
-  EXPECT_TRUE(test_all_files_in_dir<test_pretty_printer>("pretty_printer"));
-}
+RESOURCE_TEST(LexerResourceTest, "lexer", test_lexer_resource);
 
-TEST(ResourcesTest, FunctionValueBodyTransformer) {
-  EXPECT_TRUE(test_all_files_in_dir<
+RESOURCE_TEST(ParserResourceTest, "parser", test_parser_resource);
+
+RESOURCE_TEST(PrettyPrinterResourceTest, "pretty_printer",
+              test_pretty_printer);
+
+RESOURCE_TEST(FunctionValueBodyTransformerResourceTest,
+              "transformer/function_value_body",
               transformer_test<get_transformed_pretty_printed_file<
-                  transform::FunctionValueBodyTransformer>>>(
-      "transformer/function_value_body"));
-}
+                  transform::FunctionValueBodyTransformer>>);
 
-TEST(ResourcesTest, VoidFunctionReturnAdder) {
-  EXPECT_TRUE(
-      (test_all_files_in_dir<
-          transformer_test<get_transformed_pretty_printed_file<
-              name_resolution::NameResolver, typechecker::TypeChecker,
-              transform::VoidFunctionReturnAdder>>>("transformer/add_return")));
-}
+RESOURCE_TEST(VoidFunctionReturnAdderResourceTest, "transformer/add_return",
+              (transformer_test<get_transformed_pretty_printed_file<
+                   name_resolution::NameResolver, typechecker::TypeChecker,
+                   transform::VoidFunctionReturnAdder>>));
 
-TEST(ResourcesTest, CodeGenerator) {
-  EXPECT_TRUE((test_all_files_in_dir<transformer_test<get_transformed_ir<
+RESOURCE_TEST(ConstantFolderResourceTest, "transformer/constant_folder",
+              (transformer_test<get_transformed_pretty_printed_file<
                    transform::FunctionValueBodyTransformer,
                    name_resolution::NameResolver, typechecker::TypeChecker,
-                   transform::VoidFunctionReturnAdder>>>("ir")));
-}
+                   transform::VoidFunctionReturnAdder,
+                   transform::ConstantFolder>>));
 
-TEST(ResourcesTest, NameResolver) {
-  EXPECT_TRUE(
-      test_all_files_in_dir<transformer_test<
-          get_transformed_pretty_printed_file<name_resolution::NameResolver>>>(
-          "name_resolution"));
-}
+RESOURCE_TEST(CodeGeneratorResourceTest, "ir",
+              (transformer_test<get_transformed_ir<
+                   transform::FunctionValueBodyTransformer,
+                   name_resolution::NameResolver, typechecker::TypeChecker,
+                   transform::VoidFunctionReturnAdder>>));
+
+RESOURCE_TEST(NameResolverResourceTest, "name_resolution",
+              transformer_test<get_transformed_pretty_printed_file<
+                  name_resolution::NameResolver>>);
 
-TEST(ResourcesTest, TypeChecker) {
-  EXPECT_TRUE((test_all_files_in_dir<
-               transformer_test<get_transformed_pretty_printed_file<
+RESOURCE_TEST(TypeCheckerResourceTest, "type_checker",
+              (transformer_test<get_transformed_pretty_printed_file<
                    transform::FunctionValueBodyTransformer,
-                   name_resolution::NameResolver, typechecker::TypeChecker>>>(
-      "type_checker")));
-}
+                   name_resolution::NameResolver, typechecker::TypeChecker>>));
 
 }  // namespace test
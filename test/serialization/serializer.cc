@@ -0,0 +1,216 @@
+#include "serialization/reader.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "ast/function_declaration.h"
+#include "ast/module.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "pretty_printer/pretty_printer.h"
+#include "serialization/writer.h"
+#include "test_utils/utils.h"
+#include "transform/function_value_body.h"
+
+namespace {
+
+const char k_program[] = R"(
+import math;
+constant size : Int64 = 3;
+val xs : [Int32; 3] = [1, 2, 3];
+extern fun print(val x : Int64) : Void;
+public pure fun sum(val ys : [Int32], mut total : Int64) : Int64 {
+  for (i in 0..ys.length) {
+    total += ys[i];
+  }
+  return total;
+}
+fun main() : Int64 {
+  mut i : Int64 = 0;
+  mut zs : [Bool; 2] = [true, false];
+  while (i < 10) {
+    if (i == 3 || zs[0]) {
+      i += 2;
+      continue;
+    } else {
+      zs[1] = i > 4;
+    }
+    if (i >= 8) {
+      break;
+    }
+    i = i + 1;
+  }
+  print(sum(xs[1..], i));
+  return sum(xs[..2], square(size));
+}
+fun value() = 4 * 2;
+)";
+
+/// The ASTs are written in a temporary directory.
+class SerializerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/gha_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    path_ = std::string(directory) + "/main.gha";
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    rmdir(path_.substr(0, path_.rfind('/')).c_str());
+  }
+
+  std::unique_ptr<ast::Module> parse(const std::string& source) {
+    auto lexer = lexer::from_string(source);
+    parser::Parser parser(&lexer);
+    auto result = parser.parse();
+    EXPECT_TRUE(result.is_ok()) << result.to_string();
+    return result.consume_value_or_die();
+  }
+
+  void write(ast::Module* module, std::uint64_t hash = 42) {
+    std::ofstream out(path_, std::ios::binary);
+    serialization::write_ast(module, hash, &out);
+  }
+
+  /// Overwrite the bytes of the file at this offset.
+  void patch(std::size_t offset, const std::string& bytes) {
+    std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(static_cast<std::streamoff>(offset));
+    out << bytes;
+  }
+
+  static std::string print(ast::Module* module) {
+    std::ostringstream out;
+    ast::PrettyPrinterVisitor printer(out);
+    module->accept(printer);
+    return out.str();
+  }
+
+  std::string path_;
+};
+
+}  // namespace
+
+TEST_F(SerializerTest, RoundTrip) {
+  auto module = parse(k_program);
+  write(module.get(), 1234);
+
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_TRUE(serialized.is_ok()) << serialized.to_string();
+  EXPECT_EQ(1234u, serialized.value_or_die()->source_hash());
+  auto decoded = serialized.value_or_die()->to_module("main.gh");
+  ASSERT_TRUE(decoded.is_ok()) << decoded.to_string();
+  EXPECT_EQ(print(module.get()), print(decoded.value_or_die().get()));
+}
+
+TEST_F(SerializerTest, TransformedRoundTrip) {
+  auto module = parse(k_program);
+  transform::FunctionValueBodyTransformer value_body;
+  module->accept(value_body);
+  write(module.get());
+
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_TRUE(serialized.is_ok()) << serialized.to_string();
+  auto decoded = serialized.value_or_die()->to_module("main.gh");
+  ASSERT_TRUE(decoded.is_ok()) << decoded.to_string();
+  EXPECT_EQ(print(module.get()), print(decoded.value_or_die().get()));
+}
+
+TEST_F(SerializerTest, KeepsTheRanges) {
+  write(parse("fun first() = 1;\n  fun second() = 2;\n").get());
+  auto decoded = serialization::SerializedAST::open(path_)
+                     .value_or_die()
+                     ->to_module("moved/main.gh")
+                     .consume_value_or_die();
+  const auto& declarations = decoded->top_level_declarations();
+  ASSERT_EQ(2u, declarations.size());
+  auto second = static_cast<ast::FunctionDeclaration*>(declarations[1].get());
+  EXPECT_EQ("moved/main.gh", second->location().file);
+  EXPECT_EQ(2, second->location().begin.line);
+  EXPECT_EQ(3, second->location().begin.column);
+  const auto& id = second->id().location();
+  EXPECT_EQ("moved/main.gh", id.file);
+  EXPECT_EQ(2, id.begin.line);
+  EXPECT_EQ(7, id.begin.column);
+  EXPECT_EQ(12, id.end.column);
+}
+
+TEST_F(SerializerTest, WalksTheMappedNodes) {
+  write(parse("fun f(val x : Int64) = x;\nfun g() = f(2);\n").get());
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_TRUE(serialized.is_ok()) << serialized.to_string();
+  auto root = serialized.value_or_die()->root();
+  using Kind = serialization::format::Kind;
+  EXPECT_EQ(Kind::MODULE, root.kind());
+  ASSERT_EQ(2u, root.child_count());
+
+  auto f = root.child(0);
+  EXPECT_EQ(Kind::FUNCTION_DECLARATION, f.kind());
+  EXPECT_EQ("f", f.child(0).name());
+  // No return type, a value body, and one argument.
+  ASSERT_EQ(4u, f.child_count());
+  EXPECT_FALSE(f.has_child(1));
+  EXPECT_EQ(Kind::VARIABLE_REFERENCE, f.child(2).kind());
+  EXPECT_EQ(Kind::FUNCTION_ARGUMENT_DECLARATION, f.child(3).kind());
+  EXPECT_EQ("Int64", f.child(3).child(1).name());
+
+  auto call = root.child(1).child(2);
+  EXPECT_EQ(Kind::FUNCTION_CALL, call.kind());
+  EXPECT_EQ(2u, call.child(1).value());
+  // The names are interned.
+  EXPECT_EQ(f.child(0).value(), call.child(0).child(0).value());
+}
+
+TEST_F(SerializerTest, NotASerializedAST) {
+  std::ofstream(path_) << "fun main() : Int64 = 3;\n";
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_FALSE(serialized.is_ok());
+  EXPECT_EQ("The file " + path_ + " is not a serialized AST",
+            serialized.error_or_die().to_string());
+}
+
+TEST_F(SerializerTest, OtherVersion) {
+  write(parse(k_program).get());
+  patch(4, std::string("\x07\0\0\0", 4));
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_FALSE(serialized.is_ok());
+  EXPECT_EQ("The AST " + path_ + " has the version 7, expected 2",
+            serialized.error_or_die().to_string());
+}
+
+TEST_F(SerializerTest, Truncated) {
+  write(parse(k_program).get());
+  ASSERT_EQ(0, truncate(path_.c_str(), 200));
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_FALSE(serialized.is_ok());
+  EXPECT_EQ("The AST " + path_ + " is corrupted",
+            serialized.error_or_die().to_string());
+}
+
+TEST_F(SerializerTest, NotATree) {
+  write(parse("fun f() = 1;\n").get());
+  // The first child of the function is the root.
+  patch(32 + 32 * 4, std::string("\0\0\0\0", 4));
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_FALSE(serialized.is_ok());
+  EXPECT_EQ("The AST " + path_ + " is corrupted",
+            serialized.error_or_die().to_string());
+}
+
+TEST_F(SerializerTest, WrongKind) {
+  write(parse("fun f() = 1;\n").get());
+  // The body of the function is a `break`.
+  patch(32 + 32 * 3, "\x0c");
+  auto serialized = serialization::SerializedAST::open(path_);
+  ASSERT_TRUE(serialized.is_ok()) << serialized.to_string();
+  auto decoded = serialized.value_or_die()->to_module("main.gh");
+  ASSERT_FALSE(decoded.is_ok());
+  EXPECT_EQ("The AST " + path_ + " is corrupted",
+            decoded.error_or_die().to_string());
+}
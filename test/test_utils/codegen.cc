@@ -0,0 +1,36 @@
+#include "test_utils/codegen.h"
+
+#include "codegen/codegen.h"
+#include "lexer/lexer.h"
+#include "name_resolution/visitor.h"
+#include "parser/parser.h"
+#include "test_utils/utils.h"
+#include "transform/add_return.h"
+#include "transform/function_value_body.h"
+#include "typechecker/typechecker.h"
+
+namespace codegen {
+
+std::unique_ptr<llvm::Module> generate_module(const std::string& name,
+                                              const std::string& source,
+                                              llvm::LLVMContext* context) {
+  auto lexer = lexer::from_string(source);
+  parser::Parser parser(&lexer);
+  auto result = parser.parse();
+  EXPECT_TRUE(result.is_ok()) << result.to_string();
+  auto module = result.value_or_die().get();
+  transform::FunctionValueBodyTransformer value_body;
+  module->accept(value_body);
+  name_resolution::NameResolver resolver;
+  module->accept(resolver);
+  typechecker::TypeChecker type_checker;
+  module->accept(type_checker);
+  EXPECT_TRUE(type_checker.error_list().errors().empty());
+  transform::VoidFunctionReturnAdder return_adder;
+  module->accept(return_adder);
+  CodeGenerator generator(name, context);
+  module->accept(generator);
+  return generator.release_module();
+}
+
+}  // namespace codegen
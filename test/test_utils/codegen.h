@@ -0,0 +1,15 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+namespace codegen {
+/// Check and generate the IR of the source, in the context. The errors are
+/// test failures.
+std::unique_ptr<llvm::Module> generate_module(const std::string& name,
+                                              const std::string& source,
+                                              llvm::LLVMContext* context);
+}  // namespace codegen
@@ -4,44 +4,52 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-#include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 
 namespace test {
 
-testing::AssertionResult walk_directory(const char* folder,
-                                        const TestFunction& tester) {
+namespace {
+
+void list_files_rec(const std::string& folder, const std::string& prefix,
+                    std::vector<std::string>* files) {
   DIR* dir;
   struct dirent* ent;
-  if ((dir = opendir(folder)) == nullptr) {
+  if ((dir = opendir(folder.c_str())) == nullptr) {
     perror("opendir");
     exit(1);
   }
-  /* print all the files and directories within directory */
   while ((ent = readdir(dir)) != nullptr) {
     if (ent->d_name[0] == '.') continue;
-    std::string full_name = ent->d_name;
-    full_name = folder + ("/" + full_name);
+    const std::string name = ent->d_name;
+    const std::string full_name = folder + "/" + name;
     struct stat statbuf;
     if (stat(full_name.c_str(), &statbuf) == -1) {
       perror("stat");
       exit(1);
     }
-    testing::AssertionResult res(true);
     switch (statbuf.st_mode & S_IFMT) {
       case S_IFDIR:
-        res = walk_directory(full_name.c_str(), tester);
-        if (!res) return res;
+        list_files_rec(full_name, prefix + name + "/", files);
         break;
       case S_IFREG:
-        res = tester(full_name);
-        if (!res) return res << "\nIn file: " << full_name << '\n';
+        files->push_back(prefix + name);
         break;
       default:
         break;
     }
   }
   closedir(dir);
-  return testing::AssertionSuccess();
+}
+
+}  // namespace
+
+std::vector<std::string> list_files(const std::string& folder) {
+  std::vector<std::string> files;
+  list_files_rec(folder, "", &files);
+  std::sort(files.begin(), files.end());
+  return files;
 }
 
 }  // namespace test
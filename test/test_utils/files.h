@@ -1,14 +1,12 @@
 #pragma once
 
-#include <functional>
-
-#include "gtest/gtest.h"
+#include <string>
+#include <vector>
 
 namespace test {
 
-using TestFunction = testing::AssertionResult (*)(const std::string&);
-
-testing::AssertionResult walk_directory(const char* folder,
-                                        const TestFunction& tester);
+/// Return the regular files in the folder and in all its subfolders, relative
+/// to the folder, in alphabetical order. Hidden files are skipped.
+std::vector<std::string> list_files(const std::string& folder);
 
 }  // namespace test
@@ -0,0 +1,41 @@
+#include "test_utils/timing.h"
+
+#include <algorithm>
+#include <iostream>
+
+DEFINE_bool(resource_timing, false,
+            "Print the time taken by the test of each resource file");
+DEFINE_int32(slow_resource_ms, 200,
+             "Flag the resource files whose test takes longer than this");
+
+namespace test {
+
+void ResourceTimingListener::OnTestEnd(const testing::TestInfo& test_info) {
+  // Only the tests of resource files have a parameter (see
+  // test/resources/resources.cc).
+  if (test_info.value_param() == nullptr) return;
+  timings_.emplace_back(
+      std::string(test_info.test_case_name()) + ": " + test_info.value_param(),
+      test_info.result()->elapsed_time());
+}
+
+void ResourceTimingListener::OnTestProgramEnd(
+    const testing::UnitTest& /*unused*/) {
+  std::sort(timings_.begin(), timings_.end(),
+            [](const auto& left, const auto& right) {
+              return left.second > right.second;
+            });
+  bool printed_header = false;
+  for (const auto& timing : timings_) {
+    const bool is_slow = timing.second > FLAGS_slow_resource_ms;
+    if (!is_slow && !FLAGS_resource_timing) break;
+    if (!printed_header) {
+      std::cout << "\nTime spent per resource file:\n";
+      printed_header = true;
+    }
+    std::cout << "  " << timing.second << " ms\t" << timing.first
+              << (is_slow ? "  <- SLOW" : "") << '\n';
+  }
+}
+
+}  // namespace test
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_bool(resource_timing);
+DECLARE_int32(slow_resource_ms);
+
+namespace test {
+
+/// Reports the time spent on each resource file test. At the end of the
+/// tests, prints the resources slower than --slow_resource_ms, or all of them
+/// with --resource_timing, from the slowest.
+class ResourceTimingListener : public testing::EmptyTestEventListener {
+ public:
+  void OnTestEnd(const testing::TestInfo& test_info) override;
+  void OnTestProgramEnd(const testing::UnitTest& unit_test) override;
+
+ private:
+  // Resource file, and time in milliseconds.
+  std::vector<std::pair<std::string, testing::TimeInMillis>> timings_;
+};
+
+}  // namespace test
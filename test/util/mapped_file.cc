@@ -0,0 +1,73 @@
+#include "util/mapped_file.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+/// The files are written in a temporary directory.
+class ReplaceFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char directory[] = "/tmp/replace_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    directory_ = directory;
+    path_ = directory_ + "/file";
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    rmdir(directory_.c_str());
+  }
+
+  std::string read() {
+    auto file = util::MappedFile::open(path_);
+    EXPECT_TRUE(file.is_ok());
+    if (!file.is_ok() || file.value_or_die()->size() == 0) return "";
+    return std::string(file.value_or_die()->data(),
+                       file.value_or_die()->size());
+  }
+
+  mode_t mode() {
+    struct stat status;
+    EXPECT_EQ(0, stat(path_.c_str(), &status));
+    return status.st_mode & 07777;
+  }
+
+  std::string directory_;
+  std::string path_;
+};
+
+}  // namespace
+
+TEST_F(ReplaceFileTest, NewFile) {
+  EXPECT_TRUE(util::replace_file(path_, "first").is_ok());
+  EXPECT_EQ("first", read());
+  EXPECT_EQ(0644u, mode());
+}
+
+TEST_F(ReplaceFileTest, KeepsTheMappingsAndTheMode) {
+  ASSERT_TRUE(util::replace_file(path_, "first").is_ok());
+  ASSERT_EQ(0, chmod(path_.c_str(), 0755));
+  auto previous = util::MappedFile::open(path_);
+  ASSERT_TRUE(previous.is_ok());
+
+  std::string large(1 << 20, 'x');
+  EXPECT_TRUE(util::replace_file(path_, large).is_ok());
+  EXPECT_EQ(large, read());
+  EXPECT_EQ(0755u, mode());
+  EXPECT_EQ("first", std::string(previous.value_or_die()->data(),
+                                 previous.value_or_die()->size()));
+}
+
+TEST_F(ReplaceFileTest, MissingDirectory) {
+  auto replaced = util::replace_file(directory_ + "/missing/file", "");
+  ASSERT_FALSE(replaced.is_ok());
+  EXPECT_EQ(0u, replaced.error_or_die().to_string().find(
+                    "Could not create " + directory_ + "/missing/file."));
+}
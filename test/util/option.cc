@@ -0,0 +1,52 @@
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+
+#include "util/option.h"
+
+// The types with a niche need no type index.
+static_assert(sizeof(Option<int*>) == sizeof(int*), "");
+static_assert(sizeof(Option<std::unique_ptr<int>>) == sizeof(int*), "");
+static_assert(std::is_trivially_copyable<Option<const int*>>::value, "");
+
+TEST(OptionTest, Pointer) {
+  int value = 3;
+  Option<int*> pointer;
+  EXPECT_FALSE(pointer.is_ok());
+  EXPECT_THROW(pointer.value_or_die(), BadVariantAccess);
+  pointer = &value;
+  ASSERT_TRUE(pointer.is_ok());
+  EXPECT_EQ(&value, pointer.value_or_die());
+  // nullptr is none.
+  pointer = static_cast<int*>(nullptr);
+  EXPECT_FALSE(pointer.is_ok());
+  pointer = &value;
+  pointer = none;
+  EXPECT_FALSE(pointer.is_ok());
+  EXPECT_EQ(&value, pointer.value_or(&value));
+}
+
+TEST(OptionTest, UniquePointer) {
+  Option<std::unique_ptr<int>> pointer = std::make_unique<int>(3);
+  ASSERT_TRUE(pointer.is_ok());
+  Option<std::unique_ptr<int>> moved = std::move(pointer);
+  EXPECT_FALSE(pointer.is_ok());
+  ASSERT_TRUE(moved.is_ok());
+  EXPECT_EQ(3, *moved.value_or_die());
+  auto value = moved.consume_value_or_die();
+  EXPECT_FALSE(moved.is_ok());
+  EXPECT_EQ(3, *value);
+}
+
+TEST(OptionTest, Conversion) {
+  struct Base {
+    virtual ~Base() = default;
+  };
+  struct Derived : Base {};
+  Option<std::unique_ptr<Base>> base = Option<std::unique_ptr<Derived>>(none);
+  EXPECT_FALSE(base.is_ok());
+  base = Option<std::unique_ptr<Derived>>(std::make_unique<Derived>());
+  EXPECT_TRUE(base.is_ok());
+}
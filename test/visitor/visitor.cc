@@ -21,6 +21,11 @@ fun test3() {
   test();
   return;
 }
+fun test4(val xs : [Int32], mut ys : [Int64; 2]) {
+  ys = [1, 2];
+  ys[0] = xs[1];
+  test4(xs[1..xs.length], ys);
+}
 )";
 
 TEST(Visitor, TestVisitor) {
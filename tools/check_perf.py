@@ -0,0 +1,179 @@
+#!/usr/bin/env python
+"""Compare the throughput of the benchmarks against a stored baseline.
+
+Runs gracc_bench several times, and compares the median throughput
+(bytes/s) of each benchmark with the baseline. A benchmark has regressed if
+its median dropped by more than the threshold, and by more than the noise
+(measured with the median absolute deviation, MAD) of both runs.
+
+Usage:
+  check_perf.py --benchmark=build/bench/gracc_bench --baseline=baseline.json
+  check_perf.py --benchmark=... --baseline=baseline.json --update
+"""
+
+from __future__ import division, print_function
+
+import argparse
+import collections
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# The throughput that is compared.
+METRIC = 'bytes_per_second'
+# The benchmarks of the stages that are gated: lexer, parser and codegen.
+DEFAULT_FILTER = 'BM_(Lex|Parse|Codegen)/'
+# Scale the MAD to be comparable to a standard deviation (for a normal
+# distribution).
+MAD_TO_SIGMA = 1.4826
+# A regression must be larger than this many times the noise.
+NOISE_FACTOR = 3
+
+
+def median(values):
+    values = sorted(values)
+    middle = len(values) // 2
+    if len(values) % 2:
+        return values[middle]
+    return (values[middle - 1] + values[middle]) / 2
+
+
+def mad(values):
+    center = median(values)
+    return median([abs(value - center) for value in values])
+
+
+def summarize(samples):
+    return collections.OrderedDict(
+        (name, {'median': median(values), 'mad': mad(values),
+                'samples': values})
+        for name, values in samples.items())
+
+
+def run_benchmarks(benchmark, benchmark_filter, repetitions):
+    """Run the benchmarks, and return the samples of the metric for each."""
+    fd, out = tempfile.mkstemp(suffix='.json')
+    os.close(fd)
+    try:
+        subprocess.check_call([
+            benchmark,
+            '--benchmark_filter=' + benchmark_filter,
+            '--benchmark_repetitions=%d' % repetitions,
+            '--benchmark_out=' + out,
+            '--benchmark_out_format=json',
+        ])
+        with open(out) as results:
+            return read_samples(json.load(results))
+    finally:
+        os.remove(out)
+
+
+def is_aggregate(benchmark):
+    if 'aggregate_name' in benchmark or \
+            benchmark.get('run_type') == 'aggregate':
+        return True
+    # Older versions of Google Benchmark only have the suffix.
+    return benchmark['name'].endswith(('_mean', '_median', '_stddev', '_cv'))
+
+
+def read_samples(results):
+    samples = collections.OrderedDict()
+    for benchmark in results['benchmarks']:
+        if is_aggregate(benchmark) or METRIC not in benchmark:
+            continue
+        name = benchmark.get('run_name', benchmark['name'])
+        samples.setdefault(name, []).append(benchmark[METRIC])
+    return samples
+
+
+def compare(baseline, current, threshold, benchmark_filter):
+    """Print the table of the differences, and return the regressions."""
+    regressions = []
+    rows = [('Benchmark', 'Baseline', 'Current', 'Change', 'Noise', '')]
+    names = list(current) + [
+        name for name in baseline
+        if name not in current and re.search(benchmark_filter, name)]
+    for name in names:
+        if name not in current:
+            rows.append((name, '', '', '', '', 'missing'))
+            continue
+        if name not in baseline:
+            rows.append((name, '', format_rate(current[name]['median']), '',
+                         '', 'new'))
+            continue
+        base = baseline[name]
+        cur = current[name]
+        change = (cur['median'] - base['median']) / base['median'] * 100
+        noise = NOISE_FACTOR * MAD_TO_SIGMA * \
+            (base['mad'] ** 2 + cur['mad'] ** 2) ** 0.5 / base['median'] * 100
+        status = ''
+        if -change > threshold and -change > noise:
+            status = 'REGRESSION'
+            regressions.append(name)
+        elif change > threshold and change > noise:
+            status = 'improvement'
+        rows.append((name, format_rate(base['median']),
+                     format_rate(cur['median']), '%+.1f%%' % change,
+                     '%.1f%%' % noise, status))
+    widths = [max(len(row[i]) for row in rows) for i in range(len(rows[0]))]
+    for row in rows:
+        print('  '.join(cell.ljust(width)
+                        for cell, width in zip(row, widths)).rstrip())
+    return regressions
+
+
+def format_rate(bytes_per_second):
+    return '%.2f MB/s' % (bytes_per_second / 1e6)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--benchmark', required=True,
+                        help='Path to the gracc_bench executable')
+    parser.add_argument('--baseline', required=True,
+                        help='Path to the baseline JSON file')
+    parser.add_argument('--threshold', type=float, default=5,
+                        help='Maximum allowed drop of throughput, in percents')
+    parser.add_argument('--repetitions', type=int, default=10,
+                        help='Number of runs of each benchmark')
+    parser.add_argument('--filter', default=DEFAULT_FILTER,
+                        help='Regex of the benchmarks to run')
+    parser.add_argument('--update', action='store_true',
+                        help='Write the results to the baseline instead of '
+                        'comparing them')
+    args = parser.parse_args()
+
+    current = summarize(run_benchmarks(args.benchmark, args.filter,
+                                       args.repetitions))
+    if not current:
+        print('No benchmark matched ' + args.filter)
+        return 1
+
+    if args.update:
+        with open(args.baseline, 'w') as baseline_file:
+            json.dump(collections.OrderedDict(
+                [('metric', METRIC), ('benchmarks', current)]),
+                baseline_file, indent=2, separators=(',', ': '))
+            baseline_file.write('\n')
+        print('Baseline written to ' + args.baseline)
+        return 0
+
+    with open(args.baseline) as baseline_file:
+        baseline = json.load(
+            baseline_file,
+            object_pairs_hook=collections.OrderedDict)['benchmarks']
+    print()
+    regressions = compare(baseline, current, args.threshold, args.filter)
+    if regressions:
+        print('\n%d benchmark(s) regressed by more than %g%%: %s' %
+              (len(regressions), args.threshold, ', '.join(regressions)))
+        return 1
+    print('\nNo regression of more than %g%%.' % args.threshold)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -11,7 +11,7 @@ PROJECT_DIR=$(readlink -f "${CURRENT_DIR}/..")
 
 FORMAT_CMD="clang-format -style=Google"
 
-FIND_CMD="find ${PROJECT_DIR}/src/ ${PROJECT_DIR}/test/ -name "*.h" -or -name "*.cc" -type f"
+FIND_CMD="find ${PROJECT_DIR}/src/ ${PROJECT_DIR}/test/ ${PROJECT_DIR}/bench/ -name "*.h" -or -name "*.cc" -type f"
 
 if [ "$#" -eq 1 ]
 then
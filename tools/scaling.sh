@@ -0,0 +1,39 @@
+#! /bin/sh
+
+# Compile generated programs of increasing size (1K to 100M by default) and
+# print the time taken by gracc for each of them, to check that the compiler
+# scales linearly with the size of its input.
+
+if [ "$#" -lt 1 ] || [ "$#" -gt 2 ]
+then
+  echo "Usage: $0 BUILD_DIR [MAX_SIZE]"
+  echo "MAX_SIZE is one of 1K, 10K, 100K, 1M, 10M, 100M (default)."
+  exit 1
+fi
+
+BUILD_DIR=$(readlink -f "$1")
+MAX_SIZE=${2:-100M}
+GRACC="${BUILD_DIR}/src/gracc"
+GENERATOR="${BUILD_DIR}/src/gh-gen"
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf "%10s %12s %10s %10s\n" "Size" "Bytes" "Seconds" "MB/s"
+for SIZE in 1K 10K 100K 1M 10M 100M
+do
+  INPUT="${WORK_DIR}/scaling_${SIZE}.gh"
+  "${GENERATOR}" --size="${SIZE}" --out="${INPUT}" || exit 1
+  BYTES=$(wc -c < "${INPUT}")
+  START=$(date +%s.%N)
+  "${GRACC}" "${INPUT}" > /dev/null || exit 1
+  END=$(date +%s.%N)
+  echo "${SIZE} ${BYTES} ${START} ${END}" | awk '{
+    seconds = $4 - $3;
+    printf "%10s %12d %10.3f %10.2f\n", $1, $2, seconds, $2 / seconds / 1e6
+  }'
+  rm -f "${WORK_DIR}"/*
+  if [ "${SIZE}" = "${MAX_SIZE}" ]
+  then
+    break
+  fi
+done